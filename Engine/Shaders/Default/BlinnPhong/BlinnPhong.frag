@@ -1,7 +1,13 @@
 #version 450
+#ifdef BINDLESS_TEXTURES
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
 
 layout(location = 0) in vec3 inWorldPos;
 layout(location = 1) in vec3 inWorldNormal;
+#ifdef BINDLESS_TEXTURES
+layout(location = 2) in vec2 inUV;
+#endif
 
 layout(location = 0) out vec4 outColor;
 
@@ -32,16 +38,42 @@ layout(set = 2, binding = 0) uniform UboMaterial {
     Material material;
 } uboMaterial;
 
+#ifdef BINDLESS_TEXTURES
+// The bindless descriptor table, see BindlessDescriptorTable
+layout(set = 3, binding = 0) uniform texture2D textures[];
+layout(set = 3, binding = 1) uniform sampler samplers[];
+
+// Same block as BlinnPhong.vert, only the indices are read here
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    vec4 pos_offset;
+    vec4 pos_scale;
+    uint baseColorTexture;
+    uint baseColorSampler;
+    uvec2 padding;
+} pushConstants;
+
+const uint invalidIndex = 0xFFFFFFFFu;
+#endif
+
 
 void main() {
     vec3 norm = normalize(inWorldNormal);
     vec3 viewDir = normalize(uboScene.cameraPos - inWorldPos);
     vec3 lightDir = normalize(uboLight.light.position - inWorldPos);
 
-    vec3 ambient = uboLight.light.ambientStrength * uboLight.light.color * uboMaterial.material.ambient;
+    vec3 albedo = vec3(1.0);
+#ifdef BINDLESS_TEXTURES
+    if (pushConstants.baseColorTexture != invalidIndex && pushConstants.baseColorSampler != invalidIndex) {
+        albedo = texture(sampler2D(textures[nonuniformEXT(pushConstants.baseColorTexture)],
+                                   samplers[nonuniformEXT(pushConstants.baseColorSampler)]), inUV).rgb;
+    }
+#endif
+
+    vec3 ambient = uboLight.light.ambientStrength * uboLight.light.color * uboMaterial.material.ambient * albedo;
 
     float diffFactor = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diffFactor * uboLight.light.color * uboMaterial.material.diffuse;
+    vec3 diffuse = diffFactor * uboLight.light.color * uboMaterial.material.diffuse * albedo;
 
     vec3 halfwayDir = normalize(lightDir + viewDir);
     float specFactor = pow(max(dot(norm, halfwayDir), 0.0), uboMaterial.material.shininess);
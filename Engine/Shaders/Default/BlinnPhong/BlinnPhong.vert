@@ -1,13 +1,22 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "../Common/VertexDecode.glsl"
 
 // -- 输入 --
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec2 inTexCoord; // Optional
+// 格式由子网格的 ShaderVariant 决定 (QUANTIZED_POSITION, OCT_NORMAL)
+layout(location = 0) in VERTEX_POSITION_TYPE inPosition;
+layout(location = 1) in VERTEX_NORMAL_TYPE inNormal;
+#ifdef BINDLESS_TEXTURES
+layout(location = 2) in vec2 inUV;
+#endif
 
 // -- 输出到片元着色器 --
 layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outWorldNormal;
+#ifdef BINDLESS_TEXTURES
+layout(location = 2) out vec2 outUV;
+#endif
 
 // -- UBO: 每帧更新 --
 layout(set = 0, binding = 0) uniform UboScene {
@@ -18,15 +27,29 @@ layout(set = 0, binding = 0) uniform UboScene {
 // -- Push Constants: 每个物体更新 --
 layout(push_constant) uniform PushConstants {
     mat4 model;
+    // 量化位置的反量化参数: position = pos_offset + pos_scale * q
+    vec4 pos_offset;
+    vec4 pos_scale;
+    // 无绑定描述符表中的纹理与采样器索引, 由片元着色器读取
+    uint baseColorTexture;
+    uint baseColorSampler;
+    uvec2 padding;
 } pushConstants;
 
 void main() {
+    vec3 position = decode_position(inPosition, pushConstants.pos_offset.xyz, pushConstants.pos_scale.xyz);
+    vec3 normal = decode_normal(inNormal);
+
     // 计算世界空间中的顶点位置
-    outWorldPos = vec3(pushConstants.model * vec4(inPosition, 1.0));
+    outWorldPos = vec3(pushConstants.model * vec4(position, 1.0));
 
     // 使用法线矩阵正确变换法线，并传递到片元着色器
     // 法线矩阵是模型矩阵的左上3x3部分的逆转置矩阵
-    outWorldNormal = transpose(inverse(mat3(pushConstants.model))) * inNormal;
+    outWorldNormal = transpose(inverse(mat3(pushConstants.model))) * normal;
+
+#ifdef BINDLESS_TEXTURES
+    outUV = inUV;
+#endif
 
     // 计算最终的裁剪空间位置
     gl_Position = uboScene.projection * uboScene.view * vec4(outWorldPos, 1.0);
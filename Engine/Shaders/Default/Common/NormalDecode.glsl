@@ -0,0 +1,19 @@
+// Normal map sampling for textures cooked by sg::TextureCooker.
+// Normal maps are stored as two channels (BC5, or ASTC with xy in rg), z is rebuilt from the unit length.
+//
+// Usage:
+//   #extension GL_GOOGLE_include_directive : require
+//   #include "../Common/NormalDecode.glsl"
+//   vec3 n = decode_normal_map(texture(normal_texture, uv));
+
+#ifndef NORMAL_DECODE_GLSL
+#define NORMAL_DECODE_GLSL
+
+vec3 decode_normal_map(vec4 texel)
+{
+    vec2 xy = texel.xy * 2.0 - 1.0;
+    float z = sqrt(max(1.0 - dot(xy, xy), 0.0));
+    return vec3(xy, z);
+}
+
+#endif
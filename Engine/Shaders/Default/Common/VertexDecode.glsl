@@ -0,0 +1,91 @@
+// Decode helpers for the compact vertex layouts written by GLTFLoader (see sg::VertexLayout).
+// The defines come from the submesh ShaderVariant:
+//   QUANTIZED_POSITION  position is RGBA16_UNORM, rebuilt with pos_offset + pos_scale * q
+//   OCT_NORMAL          normal is octahedral RG16_SNORM
+//   OCT_TANGENT         tangent is octahedral RG16_SNORM, handedness in the sign of y
+//   HALF_TEXCOORD       uv is RG16_SFLOAT, already expanded by the input assembler
+//   UNORM8_SKIN         joints are uvec4 (RGBA8/16_UINT), weights and colors RGBA8_UNORM
+//
+// Usage:
+//   #extension GL_GOOGLE_include_directive : require
+//   #include "../Common/VertexDecode.glsl"
+//   layout(location = 0) in VERTEX_POSITION_TYPE inPosition;
+//   vec3 position = decode_position(inPosition, pos_offset, pos_scale);
+
+#ifndef VERTEX_DECODE_GLSL
+#define VERTEX_DECODE_GLSL
+
+#ifdef QUANTIZED_POSITION
+#define VERTEX_POSITION_TYPE vec4
+#else
+#define VERTEX_POSITION_TYPE vec3
+#endif
+
+#ifdef OCT_NORMAL
+#define VERTEX_NORMAL_TYPE vec2
+#else
+#define VERTEX_NORMAL_TYPE vec3
+#endif
+
+#ifdef OCT_TANGENT
+#define VERTEX_TANGENT_TYPE vec2
+#else
+#define VERTEX_TANGENT_TYPE vec4
+#endif
+
+#ifdef UNORM8_SKIN
+#define VERTEX_JOINT_TYPE uvec4
+#else
+#define VERTEX_JOINT_TYPE vec4
+#endif
+
+vec2 sign_not_zero(vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec3 oct_decode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * sign_not_zero(n.xy);
+    }
+    return normalize(n);
+}
+
+vec3 decode_position(VERTEX_POSITION_TYPE value, vec3 pos_offset, vec3 pos_scale)
+{
+#ifdef QUANTIZED_POSITION
+    return pos_offset + pos_scale * value.xyz;
+#else
+    return value;
+#endif
+}
+
+vec3 decode_normal(VERTEX_NORMAL_TYPE value)
+{
+#ifdef OCT_NORMAL
+    return oct_decode(value);
+#else
+    return value;
+#endif
+}
+
+vec4 decode_tangent(VERTEX_TANGENT_TYPE value)
+{
+#ifdef OCT_TANGENT
+    float handedness = value.y < 0.0 ? -1.0 : 1.0;
+    vec2 e = vec2(value.x, abs(value.y) * 2.0 - 1.0);
+    return vec4(oct_decode(e), handedness);
+#else
+    return value;
+#endif
+}
+
+vec4 decode_joints(VERTEX_JOINT_TYPE value)
+{
+    return vec4(value);
+}
+
+#endif
@@ -0,0 +1,59 @@
+#version 450
+
+// BlinnPhong.frag with the material looked up per instance
+
+layout(location = 0) in vec3 inWorldPos;
+layout(location = 1) in vec3 inWorldNormal;
+layout(location = 2) flat in uint inMaterial;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform UboScene {
+    mat4 projection;
+    mat4 view;
+    vec3 cameraPos;
+} uboScene;
+
+struct Light {
+    vec3 position;
+    vec3 color;
+    float ambientStrength;
+};
+
+layout(set = 1, binding = 0) uniform UboLight {
+    Light light;
+} uboLight;
+
+struct Material {
+    vec4 ambient;
+    vec4 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Materials {
+    Material materials[];
+};
+
+void main() {
+    Material material = materials[inMaterial];
+
+    vec3 norm = normalize(inWorldNormal);
+    vec3 viewDir = normalize(uboScene.cameraPos - inWorldPos);
+    vec3 lightDir = normalize(uboLight.light.position - inWorldPos);
+
+    vec3 ambient = uboLight.light.ambientStrength * uboLight.light.color * material.ambient.rgb;
+
+    float diffFactor = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diffFactor * uboLight.light.color * material.diffuse.rgb;
+
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float specFactor = pow(max(dot(norm, halfwayDir), 0.0), material.shininess);
+    vec3 specular = specFactor * uboLight.light.color * material.specular;
+
+    if (diffFactor == 0.0) {
+        specular = vec3(0.0);
+    }
+
+    outColor = vec4(ambient + diffuse + specular, 1.0);
+}
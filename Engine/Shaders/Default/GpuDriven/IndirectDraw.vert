@@ -0,0 +1,44 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// BlinnPhong.vert for draws generated by Cull.comp, the instance comes from the first instance of the draw
+// The mesh arena stores full precision vertices, the decode is the identity unless a variant defines a format
+
+#include "../Common/VertexDecode.glsl"
+
+layout(location = 0) in VERTEX_POSITION_TYPE inPosition;
+layout(location = 1) in VERTEX_NORMAL_TYPE inNormal;
+
+layout(location = 0) out vec3 outWorldPos;
+layout(location = 1) out vec3 outWorldNormal;
+layout(location = 2) flat out uint outMaterial;
+
+layout(set = 0, binding = 0) uniform UboScene {
+    mat4 projection;
+    mat4 view;
+} uboScene;
+
+struct Instance {
+    mat4 model;
+    uint mesh;
+    uint material;
+    uint padding0;
+    uint padding1;
+};
+
+layout(std430, set = 2, binding = 1) readonly buffer Instances {
+    Instance instances[];
+};
+
+void main() {
+    Instance instance = instances[gl_InstanceIndex];
+
+    vec3 position = decode_position(inPosition, vec3(0.0), vec3(1.0));
+    vec3 normal = decode_normal(inNormal);
+
+    outWorldPos = vec3(instance.model * vec4(position, 1.0));
+    outWorldNormal = transpose(inverse(mat3(instance.model))) * normal;
+    outMaterial = instance.material;
+
+    gl_Position = uboScene.projection * uboScene.view * vec4(outWorldPos, 1.0);
+}
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Timer/Timer.hpp"
+
+namespace benchmark
+{
+    struct SuiteOptions
+    {
+        /// Only the cases whose name contains the filter run
+        std::string filter;
+
+        /// The report is written there as JSON, nothing is written if empty
+        std::string output_path;
+
+        /// Report of an earlier run the medians are compared against, no comparison if empty
+        std::string baseline_path;
+
+        /// Relative slowdown of a median that counts as a regression
+        double threshold{0.10};
+
+        /// Slowdowns below this many milliseconds are timer noise, never regressions
+        double noise_floor_ms{0.005};
+
+        /// A case runs until both minimums are reached
+        double min_time_ms{250.0};
+
+        uint32_t min_iterations{10};
+
+        /// ... but stops after this long, once it has a few samples
+        double max_time_ms{10000.0};
+
+        uint32_t max_iterations{100000};
+
+        /// Directory of the assets the import cases read, the project Assets directory if empty
+        std::string assets_path;
+
+        bool list_only{false};
+    };
+
+    /**
+     * @brief Times of one case in milliseconds per call
+     */
+    struct CaseResult
+    {
+        std::string name;
+
+        uint32_t iterations{0};
+
+        /// Units of work one call does, e.g. bodies or draws, 0 if the case has no such unit
+        uint64_t items{0};
+
+        double min{0.0};
+
+        double mean{0.0};
+
+        double p50{0.0};
+
+        double p90{0.0};
+
+        double p99{0.0};
+
+        double max{0.0};
+    };
+
+    /**
+     * @brief Parses the arguments shared by the suites
+     * @return false on an unknown or incomplete argument, the usage is printed then
+     */
+    inline bool parse_options(int argc, char **argv, SuiteOptions &options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+
+            if (arg == "--list")
+            {
+                options.list_only = true;
+            }
+            else if (arg == "--filter" && has_value)
+            {
+                options.filter = argv[++i];
+            }
+            else if (arg == "--out" && has_value)
+            {
+                options.output_path = argv[++i];
+            }
+            else if (arg == "--baseline" && has_value)
+            {
+                options.baseline_path = argv[++i];
+            }
+            else if (arg == "--threshold" && has_value)
+            {
+                options.threshold = std::atof(argv[++i]);
+            }
+            else if (arg == "--min-time" && has_value)
+            {
+                options.min_time_ms = std::atof(argv[++i]);
+            }
+            else if (arg == "--min-iterations" && has_value)
+            {
+                options.min_iterations = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+            }
+            else if (arg == "--assets" && has_value)
+            {
+                options.assets_path = argv[++i];
+            }
+            else
+            {
+                std::fprintf(stderr,
+                             "Usage: %s [--list] [--filter text] [--out report.json] [--baseline report.json]\n"
+                             "       [--threshold 0.10] [--min-time ms] [--min-iterations n] [--assets dir]\n",
+                             argv[0]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Runs named cases without a window or a GPU and reports percentiles of their call times
+     *        The report is JSON so runs can be archived and diffed. Given the report of an earlier run as
+     *        baseline, every median that got slower than the threshold is a regression and run() returns 1,
+     *        which fails the CI job running the suite.
+     */
+    class Suite
+    {
+    public:
+        using Func = std::function<void()>;
+
+        /// Builds the data of a case and returns the call that is timed, only called if the case runs
+        using Setup = std::function<Func()>;
+
+        explicit Suite(std::string name) :
+            name{std::move(name)}
+        {
+        }
+
+        void add(std::string case_name, uint64_t items, Setup setup)
+        {
+            cases.push_back({std::move(case_name), items, std::move(setup)});
+        }
+
+        /**
+         * @return 0 on success, 1 if a case regressed against the baseline, 2 if a file could not be read or written
+         */
+        int run(const SuiteOptions &options)
+        {
+            if (options.list_only)
+            {
+                for (auto &test_case : cases)
+                {
+                    std::printf("%s\n", test_case.name.c_str());
+                }
+                return 0;
+            }
+
+            nlohmann::json baseline;
+            if (!options.baseline_path.empty() && !read_json(options.baseline_path, baseline))
+            {
+                return 2;
+            }
+
+            std::printf("%s, %u hardware threads\n", name.c_str(), std::thread::hardware_concurrency());
+
+            std::vector<CaseResult> results;
+            for (auto &test_case : cases)
+            {
+                if (!options.filter.empty() && test_case.name.find(options.filter) == std::string::npos)
+                {
+                    continue;
+                }
+
+                results.push_back(measure(test_case, options));
+
+                auto &result = results.back();
+                std::printf("%-52s p50 %10.4f ms  p90 %10.4f ms  p99 %10.4f ms  (%u runs)\n", result.name.c_str(),
+                            result.p50, result.p90, result.p99, result.iterations);
+            }
+
+            nlohmann::json report = to_json(results);
+
+            int status = 0;
+            if (!baseline.is_null())
+            {
+                report["comparison"] = compare(results, baseline, options);
+
+                for (auto &entry : report["comparison"])
+                {
+                    if (entry["status"] == "regressed")
+                    {
+                        status = 1;
+                    }
+                }
+            }
+
+            if (!options.output_path.empty())
+            {
+                std::ofstream file{options.output_path, std::ios::trunc};
+                if (!(file << report.dump(2) << '\n'))
+                {
+                    std::fprintf(stderr, "Failed to write the report %s\n", options.output_path.c_str());
+                    return 2;
+                }
+                std::printf("Report written to %s\n", options.output_path.c_str());
+            }
+
+            return status;
+        }
+
+    private:
+        struct Case
+        {
+            std::string name;
+
+            uint64_t items;
+
+            Setup setup;
+        };
+
+        /// Nearest rank percentile of sorted times
+        static double percentile(const std::vector<double> &sorted, double fraction)
+        {
+            auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+            return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+        }
+
+        static CaseResult measure(Case &test_case, const SuiteOptions &options)
+        {
+            auto func = test_case.setup();
+
+            // The first call warms the caches and lets the case allocate what it reuses
+            func();
+
+            std::vector<double> times;
+            double total = 0.0;
+
+            while (times.size() < options.max_iterations &&
+                   (times.size() < options.min_iterations || total < options.min_time_ms) &&
+                   !(total >= options.max_time_ms && times.size() >= 3))
+            {
+                vkb::Timer timer;
+                timer.start();
+                func();
+                double time = timer.stop<vkb::Timer::Milliseconds>();
+
+                times.push_back(time);
+                total += time;
+            }
+
+            std::sort(times.begin(), times.end());
+
+            CaseResult result;
+            result.name = test_case.name;
+            result.iterations = static_cast<uint32_t>(times.size());
+            result.items = test_case.items;
+            result.min = times.front();
+            result.mean = total / static_cast<double>(times.size());
+            result.p50 = percentile(times, 0.50);
+            result.p90 = percentile(times, 0.90);
+            result.p99 = percentile(times, 0.99);
+            result.max = times.back();
+            return result;
+        }
+
+        nlohmann::json to_json(const std::vector<CaseResult> &results) const
+        {
+            char date[32];
+            std::time_t now = std::time(nullptr);
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+            nlohmann::json report;
+            report["suite"] = name;
+            report["format"] = 1;
+            report["date"] = date;
+#ifdef NDEBUG
+            report["build"] = "release";
+#else
+            report["build"] = "debug";
+#endif
+            report["hardware_threads"] = std::thread::hardware_concurrency();
+            report["unit"] = "ms";
+
+            auto &cases_json = report["results"] = nlohmann::json::array();
+            for (auto &result : results)
+            {
+                nlohmann::json entry;
+                entry["name"] = result.name;
+                entry["iterations"] = result.iterations;
+                entry["items"] = result.items;
+                entry["min"] = result.min;
+                entry["mean"] = result.mean;
+                entry["p50"] = result.p50;
+                entry["p90"] = result.p90;
+                entry["p99"] = result.p99;
+                entry["max"] = result.max;
+                if (result.items > 0)
+                {
+                    entry["ns_per_item"] = result.p50 * 1000000.0 / static_cast<double>(result.items);
+                }
+                cases_json.push_back(std::move(entry));
+            }
+
+            return report;
+        }
+
+        /// Compares the medians, the tails of a shared CI machine are too noisy to gate on
+        static nlohmann::json compare(const std::vector<CaseResult> &results, const nlohmann::json &baseline,
+                                      const SuiteOptions &options)
+        {
+            std::unordered_map<std::string, double> baseline_medians;
+            if (baseline.contains("results"))
+            {
+                for (auto &entry : baseline["results"])
+                {
+                    baseline_medians[entry.value("name", "")] = entry.value("p50", 0.0);
+                }
+            }
+
+            std::printf("\nCompared with %s, threshold %.0f%%\n", options.baseline_path.c_str(), options.threshold * 100.0);
+
+            auto comparison = nlohmann::json::array();
+            uint32_t regressions = 0;
+
+            for (auto &result : results)
+            {
+                nlohmann::json entry;
+                entry["name"] = result.name;
+                entry["p50"] = result.p50;
+
+                auto it = baseline_medians.find(result.name);
+                if (it == baseline_medians.end() || it->second <= 0.0)
+                {
+                    entry["status"] = "new";
+                    std::printf("%-52s %10s -> %10.4f ms  new\n", result.name.c_str(), "", result.p50);
+                    comparison.push_back(std::move(entry));
+                    continue;
+                }
+
+                double change = result.p50 / it->second - 1.0;
+                double delta = result.p50 - it->second;
+
+                const char *status = "unchanged";
+                if (change > options.threshold && delta > options.noise_floor_ms)
+                {
+                    status = "regressed";
+                    regressions++;
+                }
+                else if (change < -options.threshold && -delta > options.noise_floor_ms)
+                {
+                    status = "improved";
+                }
+
+                entry["baseline_p50"] = it->second;
+                entry["change"] = change;
+                entry["status"] = status;
+                comparison.push_back(std::move(entry));
+
+                std::printf("%-52s %10.4f -> %10.4f ms  %+6.1f%%  %s\n", result.name.c_str(), it->second, result.p50,
+                            change * 100.0, status);
+            }
+
+            std::printf("%u regressions\n", regressions);
+            return comparison;
+        }
+
+        static bool read_json(const std::string &path, nlohmann::json &json)
+        {
+            std::ifstream file{path};
+            if (!file)
+            {
+                std::fprintf(stderr, "Failed to open the baseline %s\n", path.c_str());
+                return false;
+            }
+
+            json = nlohmann::json::parse(file, nullptr, false);
+            if (json.is_discarded())
+            {
+                std::fprintf(stderr, "The baseline %s is not valid JSON\n", path.c_str());
+                return false;
+            }
+
+            return true;
+        }
+
+        std::string name;
+
+        std::vector<Case> cases;
+    };
+} // namespace benchmark
@@ -0,0 +1,223 @@
+// Binds the frame uniforms, the object uniforms and three material textures per draw and flushes the descriptor state
+// the way CommandBuffer::flush_descriptor_state does without the Vulkan calls: GatheredDescriptors writes the dirty
+// bindings into the flat DescriptorInfo array of the set and RenderFrame::request_descriptor_set looks the set up in
+// its cache. Reports the CPU time per frame, the first frame allocates and writes the descriptor sets and is left out.
+// Runs on the first GPU, nothing is submitted.
+//
+// Usage: DescriptorFlushBenchmark [draw count] [frames]
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <volk.h>
+
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Core/CommandPool.hpp"
+#include "Framework/Core/Debug.hpp"
+#include "Framework/Core/DescriptorSetLayout.hpp"
+#include "Framework/Core/Image.hpp"
+#include "Framework/Core/ImageView.hpp"
+#include "Framework/Core/Instance.hpp"
+#include "Framework/Core/Sampler.hpp"
+#include "Framework/Core/ShaderModule.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Misc/ResourceBindingState.hpp"
+#include "Framework/Rendering/RenderFrame.hpp"
+#include "Framework/Rendering/RenderTarget.hpp"
+#include "Timer/Timer.hpp"
+
+namespace
+{
+    constexpr uint32_t buffer_count = 64;
+
+    constexpr uint32_t texture_count = 256;
+
+    constexpr uint32_t set_count = 2;
+
+    constexpr VkDeviceSize object_uniform_size = 256;
+
+    vkb::ShaderResource make_resource(vkb::ShaderResourceType type, uint32_t set, uint32_t binding, const std::string &name)
+    {
+        vkb::ShaderResource resource{};
+        resource.stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        resource.type = type;
+        resource.mode = vkb::ShaderResourceMode::Static;
+        resource.set = set;
+        resource.binding = binding;
+        resource.array_size = 1;
+        resource.name = name;
+        return resource;
+    }
+
+    /**
+     * The descriptor state of one command buffer, the resources stay alive for the whole benchmark
+     */
+    class DescriptorFlush
+    {
+    public:
+        explicit DescriptorFlush(vkb::VulkanDevice &device) :
+            render_frame{device, nullptr}
+        {
+            // Set 0 holds the frame uniforms, set 1 the object uniforms and three material textures
+            layouts[0] = std::make_unique<vkb::DescriptorSetLayout>(
+                device, 0, std::vector<vkb::ShaderModule *>{},
+                std::vector<vkb::ShaderResource>{make_resource(vkb::ShaderResourceType::BufferUniform, 0, 0, "frame")});
+            layouts[1] = std::make_unique<vkb::DescriptorSetLayout>(
+                device, 1, std::vector<vkb::ShaderModule *>{},
+                std::vector<vkb::ShaderResource>{make_resource(vkb::ShaderResourceType::BufferUniform, 1, 0, "object"),
+                                                 make_resource(vkb::ShaderResourceType::ImageSampler, 1, 1, "base_color"),
+                                                 make_resource(vkb::ShaderResourceType::ImageSampler, 1, 2, "normal"),
+                                                 make_resource(vkb::ShaderResourceType::ImageSampler, 1, 3, "occlusion")});
+
+            buffers.reserve(buffer_count);
+            for (uint32_t i = 0; i < buffer_count; i++)
+            {
+                buffers.push_back(std::make_unique<vkb::Buffer>(device, 64 * object_uniform_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                                                VMA_MEMORY_USAGE_GPU_ONLY, 0));
+            }
+
+            images.reserve(texture_count);
+            image_views.reserve(texture_count);
+            for (uint32_t i = 0; i < texture_count; i++)
+            {
+                images.push_back(std::make_unique<vkb::Image>(device, VkExtent3D{4, 4, 1}, VK_FORMAT_R8G8B8A8_UNORM,
+                                                              VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY));
+                image_views.push_back(std::make_unique<vkb::ImageView>(*images.back(), VK_IMAGE_VIEW_TYPE_2D));
+            }
+
+            VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+            sampler_info.magFilter = VK_FILTER_LINEAR;
+            sampler_info.minFilter = VK_FILTER_LINEAR;
+            sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+            sampler = std::make_unique<vkb::Sampler>(device, sampler_info);
+        }
+
+        void draw(uint32_t draw_index)
+        {
+            state.bind_buffer(*buffers[0], 0, object_uniform_size, 0, 0, 0);
+            state.bind_buffer(*buffers[1 + draw_index % (buffer_count - 1)], (draw_index % 64) * object_uniform_size,
+                              object_uniform_size, 1, 0, 0);
+            for (uint32_t binding = 1; binding < 4; binding++)
+            {
+                state.bind_image(*image_views[(draw_index / 4 * 3 + binding) % texture_count], *sampler, 1, binding, 0);
+            }
+
+            flush();
+        }
+
+        size_t get_descriptor_set_count() const
+        {
+            return descriptor_set_count;
+        }
+
+    private:
+        void flush()
+        {
+            uint32_t dirty_sets = state.get_dirty_sets();
+
+            for (uint32_t set = 0; set < set_count; set++)
+            {
+                if (!(dirty_sets & (1u << set)))
+                {
+                    continue;
+                }
+
+                auto &gathered = gathered_sets[set];
+                gathered.gather(state.get_resource_set(set), *layouts[set]);
+
+                state.clear_dirty(set);
+
+                VkDescriptorSet descriptor_set = render_frame.request_descriptor_set(*layouts[set], gathered.descriptor_infos, false);
+                if (descriptor_set != last_descriptor_sets[set])
+                {
+                    last_descriptor_sets[set] = descriptor_set;
+                    descriptor_set_count++;
+                }
+            }
+        }
+
+        std::array<std::unique_ptr<vkb::DescriptorSetLayout>, set_count> layouts;
+
+        std::vector<std::unique_ptr<vkb::Buffer>> buffers;
+
+        std::vector<std::unique_ptr<vkb::Image>> images;
+
+        std::vector<std::unique_ptr<vkb::ImageView>> image_views;
+
+        std::unique_ptr<vkb::Sampler> sampler;
+
+        /// Declared after the layouts and resources, its descriptor sets are freed first
+        vkb::RenderFrame render_frame;
+
+        vkb::ResourceBindingState state;
+
+        std::array<vkb::GatheredDescriptors, set_count> gathered_sets;
+
+        std::array<VkDescriptorSet, set_count> last_descriptor_sets{};
+
+        /// Descriptor set changes, stops the flushes from being optimized away
+        size_t descriptor_set_count{0};
+    };
+
+    void report(const std::string &label, std::vector<double> times)
+    {
+        std::sort(times.begin(), times.end());
+        double median = times[times.size() / 2];
+
+        std::printf("%-24s min %8.3f ms  median %8.3f ms\n", label.c_str(), times.front(), median);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t draw_count = argc > 1 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[1]))) : 20000;
+    uint32_t frames = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 50;
+
+    try
+    {
+        VK_CHECK_RESULT(volkInitialize());
+
+        vkb::Instance instance{"DescriptorFlushBenchmark"};
+        vkb::VulkanDevice device{instance.get_first_gpu(), VK_NULL_HANDLE, std::make_unique<vkb::DummyDebugUtils>()};
+
+        std::printf("Descriptor flush benchmark, %u draws, %u frames, GPU %s\n", draw_count, frames,
+                    device.get_gpu().get_properties().deviceName);
+
+        DescriptorFlush flush{device};
+
+        std::vector<double> times;
+        for (uint32_t i = 0; i < frames + 1; i++)
+        {
+            vkb::Timer timer;
+            timer.start();
+
+            for (uint32_t draw = 0; draw < draw_count; draw++)
+            {
+                flush.draw(draw);
+            }
+
+            double time = timer.stop<vkb::Timer::Milliseconds>();
+            if (i > 0)
+            {
+                times.push_back(time);
+            }
+        }
+
+        report(std::to_string(draw_count) + " draws", times);
+        std::printf("%zu descriptor set changes\n", flush.get_descriptor_set_count());
+
+        device.wait_idle();
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "Benchmark failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// Runs CpuDrawCuller, the reference of Cull.comp, over a grid of instances in front of a camera with a wall
+// covering the middle of the screen, and reports the cost of culling and how many of the draws survive
+// frustum and occlusion culling. Stands in for the GPU path on machines without a device.
+//
+// Usage: DrawCullingBenchmark [instance count] [iterations]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Framework/Rendering/DrawCulling.hpp"
+#include "Timer/Timer.hpp"
+
+namespace
+{
+    constexpr uint32_t depth_width = 1920;
+
+    constexpr uint32_t depth_height = 1080;
+
+    constexpr uint32_t mesh_count = 16;
+
+    /// Distance of the occluding wall from the camera
+    constexpr float wall_distance = 20.0f;
+
+    template <typename Func>
+    void measure(const std::string& label, uint32_t iterations, Func&& func)
+    {
+        std::vector<double> times;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            vkb::Timer timer;
+            timer.start();
+            func();
+            times.push_back(timer.stop<vkb::Timer::Milliseconds>());
+        }
+
+        std::sort(times.begin(), times.end());
+        double total = 0.0;
+        for (auto time : times)
+        {
+            total += time;
+        }
+
+        std::printf("%-40s min %9.3f ms  median %9.3f ms  avg %9.3f ms\n", label.c_str(), times.front(),
+                    times[times.size() / 2], total / times.size());
+    }
+
+    /// Reversed depth of a point straight ahead of the camera
+    float depth_at(const glm::mat4& projection, float distance)
+    {
+        glm::vec4 clip = projection * glm::vec4{0.0f, 0.0f, -distance, 1.0f};
+        return clip.z / clip.w;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t instance_count = argc > 1 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[1]))) : 100000;
+    uint32_t iterations = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 20;
+
+    // Reversed depth like sg::PerspectiveCamera, far and near swapped
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), static_cast<float>(depth_width) / depth_height, 1000.0f, 0.1f);
+    glm::mat4 view = glm::lookAt(glm::vec3{0.0f, 2.0f, 0.0f}, glm::vec3{0.0f, 2.0f, -1.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+
+    std::vector<vkb::GpuMesh> meshes(mesh_count);
+    for (uint32_t i = 0; i < mesh_count; i++)
+    {
+        meshes[i].first_index = i * 3000;
+        meshes[i].index_count = 3000;
+        meshes[i].bounding_sphere = glm::vec4{0.0f, 0.0f, 0.0f, 0.5f + 0.05f * i};
+    }
+
+    // A square grid on the ground around the camera, most of it behind or beside the view
+    auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(instance_count))));
+    float spacing = 2.0f;
+
+    std::vector<vkb::GpuInstance> instances(instance_count);
+    for (uint32_t i = 0; i < instance_count; i++)
+    {
+        float x = (static_cast<float>(i % side) - side * 0.5f) * spacing;
+        float z = (static_cast<float>(i / side) - side * 0.5f) * spacing;
+        instances[i].model = glm::translate(glm::mat4{1.0f}, glm::vec3{x, 0.0f, z});
+        instances[i].mesh = i % mesh_count;
+    }
+
+    // The wall covers the middle half of the screen, the rest is cleared to the far plane
+    std::vector<float> depth(static_cast<size_t>(depth_width) * depth_height, 0.0f);
+    float wall_depth = depth_at(projection, wall_distance);
+    for (uint32_t y = depth_height / 4; y < depth_height * 3 / 4; y++)
+    {
+        for (uint32_t x = depth_width / 4; x < depth_width * 3 / 4; x++)
+        {
+            depth[static_cast<size_t>(y) * depth_width + x] = wall_depth;
+        }
+    }
+
+    vkb::CullUniform uniform;
+    uniform.view_projection = projection * view;
+    uniform.previous_view_projection = uniform.view_projection;
+    auto planes = vkb::extract_frustum_planes(uniform.view_projection);
+    std::copy(planes.begin(), planes.end(), uniform.frustum_planes);
+    uniform.instance_count = instance_count;
+
+    std::printf("Draw culling benchmark, %u instances, %u iterations\n", instance_count, iterations);
+
+    std::unique_ptr<vkb::CpuDepthPyramid> pyramid;
+    measure("depth pyramid " + std::to_string(depth_width) + "x" + std::to_string(depth_height), iterations, [&]
+    {
+        pyramid = std::make_unique<vkb::CpuDepthPyramid>(depth, depth_width, depth_height);
+    });
+
+    auto level_size = pyramid->get_level_size(0);
+    uniform.pyramid_size = glm::vec2{level_size};
+    uniform.pyramid_levels = pyramid->get_level_count();
+
+    vkb::CpuDrawCuller culler;
+    std::vector<VkDrawIndexedIndirectCommand> draws;
+    draws.reserve(instance_count);
+
+    for (bool occlusion : {false, true})
+    {
+        uniform.occlusion_enabled = occlusion ? 1 : 0;
+
+        measure(occlusion ? "frustum and occlusion" : "frustum", iterations, [&]
+        {
+            culler.cull(uniform, meshes, instances, pyramid.get(), draws);
+        });
+
+        const auto& stats = culler.get_stats();
+        std::printf("    tested %u  frustum culled %u  occlusion culled %u  drawn %u (%.1f%%)\n", stats.tested,
+                    stats.frustum_culled, stats.occlusion_culled, stats.drawn, 100.0 * stats.drawn / stats.tested);
+    }
+
+    return 0;
+}
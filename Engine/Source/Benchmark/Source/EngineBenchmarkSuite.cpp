@@ -0,0 +1,630 @@
+// Regression suite of the engine subsystems that run without a window or a GPU: physics broadphase, narrowphase
+// and solver scaling, transform propagation, animation sampling, glTF, mesh and image import, mip generation and
+// cache key hashing. Synthetic data is generated with fixed seeds, the import cases read the models and textures
+// of the Assets directory. Descriptor state flushing needs real descriptor set layouts, DescriptorFlushBenchmark
+// measures it on a GPU.
+//
+// Every case reports percentiles of its call time. --out writes them as JSON, --baseline compares the medians
+// against such a report and exits with 1 if one got slower than --threshold, so CI can keep a baseline per
+// machine and fail on regressions.
+//
+// Usage: EngineBenchmarkSuite [--list] [--filter text] [--out report.json] [--baseline report.json]
+//                             [--threshold 0.10] [--min-time ms] [--min-iterations n] [--assets dir]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BenchmarkSuite.hpp"
+
+#include "Broadphase.h"
+#include "Contact.h"
+#include "Intersections.h"
+#include "Math/LCP.h"
+
+#include "Framework/Common/ResourceKey.hpp"
+#include "Import/GLTFLoader.hpp"
+#include "Misc/FileLoader.hpp"
+#include "Misc/Hash.hpp"
+#include "Misc/Paths.hpp"
+#include "SceneGraph/Components/Image/MipGenerator.h"
+#include "SceneGraph/Components/Image/Stb.h"
+#include "SceneGraph/Node.h"
+#include "SceneGraph/Scripts/Animation.h"
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    /// Keeps the optimizer from dropping the work of a case
+    volatile float sink = 0.0f;
+
+    constexpr float physics_dt = 1.0f / 60.0f;
+
+    struct PhysicsScene
+    {
+        ShapeSphere sphere{0.5f};
+
+        std::vector<Body> bodies;
+
+        std::vector<collisionPair_t> pairs;
+
+        std::vector<contact_t> contacts;
+    };
+
+    /// Unit spheres packed densely enough in a cube that most of them touch a few others
+    std::shared_ptr<PhysicsScene> make_physics_scene(uint32_t body_count)
+    {
+        auto scene = std::make_shared<PhysicsScene>();
+
+        std::mt19937 rng{body_count};
+        float extent = std::cbrt(static_cast<float>(body_count)) * 1.2f;
+        std::uniform_real_distribution<float> position{0.0f, extent};
+        std::uniform_real_distribution<float> velocity{-2.0f, 2.0f};
+
+        scene->bodies.resize(body_count);
+        for (auto &body : scene->bodies)
+        {
+            body.m_position = Vec3{position(rng), position(rng), position(rng)};
+            body.m_linearVelocity = Vec3{velocity(rng), velocity(rng), velocity(rng)};
+            body.m_angularVelocity.Zero();
+            body.m_invMass = 1.0f;
+            body.m_elasticity = 0.5f;
+            body.m_friction = 0.5f;
+            body.m_shape = &scene->sphere;
+        }
+
+        return scene;
+    }
+
+    void find_contacts(PhysicsScene &scene)
+    {
+        BroadPhase(scene.bodies.data(), static_cast<int>(scene.bodies.size()), scene.pairs, physics_dt);
+
+        scene.contacts.clear();
+        for (auto &pair : scene.pairs)
+        {
+            contact_t contact;
+            if (Intersect(&scene.bodies[pair.a], &scene.bodies[pair.b], physics_dt, contact))
+            {
+                scene.contacts.push_back(contact);
+            }
+        }
+    }
+
+    void add_physics_cases(benchmark::Suite &suite)
+    {
+        for (uint32_t body_count : {256u, 1024u, 4096u})
+        {
+            const std::string size = std::to_string(body_count);
+
+            suite.add("physics/broadphase/" + size, body_count, [body_count]
+            {
+                auto scene = make_physics_scene(body_count);
+                return [scene]
+                {
+                    BroadPhase(scene->bodies.data(), static_cast<int>(scene->bodies.size()), scene->pairs, physics_dt);
+                };
+            });
+
+            suite.add("physics/narrowphase/" + size, body_count, [body_count]
+            {
+                auto scene = make_physics_scene(body_count);
+                find_contacts(*scene);
+                return [scene]
+                {
+                    // Intersect steps the bodies to the time of impact and back
+                    contact_t contact;
+                    uint32_t hits = 0;
+                    for (auto &pair : scene->pairs)
+                    {
+                        hits += Intersect(&scene->bodies[pair.a], &scene->bodies[pair.b], physics_dt, contact) ? 1 : 0;
+                    }
+                    sink = static_cast<float>(hits);
+                };
+            });
+
+            suite.add("physics/solver/" + size, body_count, [body_count]
+            {
+                auto scene = make_physics_scene(body_count);
+                find_contacts(*scene);
+                auto initial_bodies = std::make_shared<std::vector<Body>>(scene->bodies);
+                return [scene, initial_bodies]
+                {
+                    // The contacts point into bodies, assigning keeps the storage
+                    std::copy(initial_bodies->begin(), initial_bodies->end(), scene->bodies.begin());
+                    for (auto &contact : scene->contacts)
+                    {
+                        ResolveContact(contact);
+                    }
+                };
+            });
+        }
+
+        for (int size : {12, 48, 96})
+        {
+            suite.add("physics/lcp_gauss_seidel/" + std::to_string(size), size, [size]
+            {
+                // Diagonally dominant like the Jacobian products of a constraint solver
+                auto a = std::make_shared<MatN>(size);
+                auto b = std::make_shared<VecN>(size);
+                for (int i = 0; i < size; i++)
+                {
+                    for (int j = 0; j < size; j++)
+                    {
+                        a->rows[i][j] = i == j ? static_cast<float>(size) : 1.0f / static_cast<float>(1 + i + j);
+                    }
+                    (*b)[i] = static_cast<float>(i % 7) - 3.0f;
+                }
+                return [a, b]
+                {
+                    VecN x = LCP_GaussSeidel(*a, *b);
+                    sink = x[0];
+                };
+            });
+        }
+    }
+
+    /// Nodes of a tree where every node has branching children, the root first
+    std::vector<std::unique_ptr<vkb::sg::Node>> make_node_tree(uint32_t node_count, uint32_t branching)
+    {
+        std::vector<std::unique_ptr<vkb::sg::Node>> nodes;
+        nodes.reserve(node_count);
+
+        for (uint32_t i = 0; i < node_count; i++)
+        {
+            nodes.push_back(std::make_unique<vkb::sg::Node>(i, "Node " + std::to_string(i)));
+            nodes.back()->get_transform().set_translation(glm::vec3{1.0f, 0.0f, 0.0f});
+
+            if (i > 0)
+            {
+                auto &parent = *nodes[(i - 1) / branching];
+                nodes.back()->set_parent(parent);
+                parent.add_child(*nodes.back());
+            }
+        }
+
+        return nodes;
+    }
+
+    void add_scene_cases(benchmark::Suite &suite)
+    {
+        for (uint32_t node_count : {1024u, 16384u})
+        {
+            suite.add("scene/transform_propagation/" + std::to_string(node_count), node_count, [node_count]
+            {
+                auto nodes = std::make_shared<std::vector<std::unique_ptr<vkb::sg::Node>>>(make_node_tree(node_count, 4));
+                auto angle = std::make_shared<float>(0.0f);
+                return [nodes, angle]
+                {
+                    // Every node moves, like a fully animated hierarchy
+                    *angle += 0.01f;
+                    glm::quat rotation = glm::angleAxis(*angle, glm::vec3{0.0f, 1.0f, 0.0f});
+                    for (auto &node : *nodes)
+                    {
+                        node->get_transform().set_rotation(rotation);
+                    }
+
+                    float sum = 0.0f;
+                    for (auto &node : *nodes)
+                    {
+                        sum += node->get_transform().get_world_matrix()[3][0];
+                    }
+                    sink = sum;
+                };
+            });
+        }
+
+        struct AnimationCase
+        {
+            const char *name;
+            vkb::sg::AnimationType type;
+        };
+
+        for (auto animation_case : {AnimationCase{"linear", vkb::sg::AnimationType::Linear},
+                                    AnimationCase{"cubic_spline", vkb::sg::AnimationType::CubicSpline}})
+        {
+            constexpr uint32_t node_count = 512;
+            constexpr uint32_t key_count = 120;
+            constexpr float duration = 4.0f;
+
+            // A translation and a rotation channel per node
+            suite.add(std::string{"scene/animation_sampling/"} + animation_case.name, node_count * 2, [animation_case]
+            {
+                struct State
+                {
+                    std::vector<std::unique_ptr<vkb::sg::Node>> nodes;
+
+                    vkb::sg::Animation animation;
+                };
+
+                auto state = std::make_shared<State>();
+                state->nodes = make_node_tree(node_count, 8);
+
+                std::mt19937 rng{42};
+                std::uniform_real_distribution<float> value{-1.0f, 1.0f};
+
+                // Cubic splines store an in tangent, the value and an out tangent per key
+                uint32_t outputs_per_key = animation_case.type == vkb::sg::AnimationType::CubicSpline ? 3 : 1;
+
+                for (auto &node : state->nodes)
+                {
+                    for (auto target : {vkb::sg::AnimationTarget::Translation, vkb::sg::AnimationTarget::Rotation})
+                    {
+                        vkb::sg::AnimationSampler sampler;
+                        sampler.type = animation_case.type;
+                        for (uint32_t key = 0; key < key_count; key++)
+                        {
+                            sampler.inputs.push_back(duration * key / (key_count - 1));
+                            for (uint32_t output = 0; output < outputs_per_key; output++)
+                            {
+                                glm::vec4 v{value(rng), value(rng), value(rng), value(rng)};
+                                sampler.outputs.push_back(target == vkb::sg::AnimationTarget::Rotation ? glm::normalize(v) : v);
+                            }
+                        }
+                        state->animation.add_channel(*node, target, sampler);
+                    }
+                }
+                state->animation.update_times(0.0f, duration);
+
+                return [state]
+                {
+                    state->animation.update(1.0f / 60.0f);
+                };
+            });
+        }
+    }
+
+    std::vector<fs::path> find_files(const fs::path &directory, const std::vector<std::string> &extensions, bool recursive)
+    {
+        std::vector<fs::path> files;
+
+        auto matches = [&](const fs::path &path)
+        {
+            auto extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+        };
+
+        std::error_code error;
+        if (recursive)
+        {
+            for (auto &entry : fs::recursive_directory_iterator(directory, error))
+            {
+                if (entry.is_regular_file() && matches(entry.path()))
+                {
+                    files.push_back(entry.path());
+                }
+            }
+        }
+        else
+        {
+            for (auto &entry : fs::directory_iterator(directory, error))
+            {
+                if (entry.is_regular_file() && matches(entry.path()))
+                {
+                    files.push_back(entry.path());
+                }
+            }
+        }
+
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    bool load_gltf(const fs::path &path, tinygltf::Model &model)
+    {
+        tinygltf::TinyGLTF loader;
+        std::string error;
+        std::string warning;
+
+        bool loaded = path.extension() == ".glb"
+                          ? loader.LoadBinaryFromFile(&model, &error, &warning, path.string())
+                          : loader.LoadASCIIFromFile(&model, &error, &warning, path.string());
+        if (!loaded)
+        {
+            std::fprintf(stderr, "Failed to load %s: %s\n", path.string().c_str(), error.c_str());
+        }
+        return loaded;
+    }
+
+    /// Copies an accessor out of its buffer view into tightly packed floats, like the loader packs vertices
+    void read_floats(const tinygltf::Model &model, int accessor_index, std::vector<float> &values)
+    {
+        values.clear();
+        if (accessor_index < 0)
+        {
+            return;
+        }
+
+        auto &accessor = model.accessors[accessor_index];
+        auto &view = model.bufferViews[accessor.bufferView];
+        auto &buffer = model.buffers[view.buffer];
+
+        auto components = static_cast<size_t>(tinygltf::GetNumComponentsInType(accessor.type));
+        size_t element_size = components * sizeof(float);
+        size_t stride = view.byteStride ? view.byteStride : element_size;
+        const uint8_t *data = buffer.data.data() + view.byteOffset + accessor.byteOffset;
+
+        values.resize(accessor.count * components);
+        for (size_t i = 0; i < accessor.count; i++)
+        {
+            std::memcpy(values.data() + i * components, data + i * stride, element_size);
+        }
+    }
+
+    void read_indices(const tinygltf::Model &model, int accessor_index, std::vector<uint32_t> &indices)
+    {
+        indices.clear();
+        if (accessor_index < 0)
+        {
+            return;
+        }
+
+        auto &accessor = model.accessors[accessor_index];
+        auto &view = model.bufferViews[accessor.bufferView];
+        const uint8_t *data = model.buffers[view.buffer].data.data() + view.byteOffset + accessor.byteOffset;
+
+        indices.resize(accessor.count);
+        for (size_t i = 0; i < accessor.count; i++)
+        {
+            switch (accessor.componentType)
+            {
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                    indices[i] = data[i];
+                    break;
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                    indices[i] = reinterpret_cast<const uint16_t *>(data)[i];
+                    break;
+                default:
+                    indices[i] = reinterpret_cast<const uint32_t *>(data)[i];
+                    break;
+            }
+        }
+    }
+
+    int find_attribute(const tinygltf::Primitive &primitive, const char *name)
+    {
+        auto it = primitive.attributes.find(name);
+        return it != primitive.attributes.end() ? it->second : -1;
+    }
+
+    void add_import_cases(benchmark::Suite &suite, const fs::path &assets)
+    {
+        for (auto &path : find_files(assets / "Models", {".gltf", ".glb"}, true))
+        {
+            const std::string stem = path.stem().string();
+
+            suite.add("import/gltf_parse/" + stem, 0, [path]
+            {
+                return [path]
+                {
+                    tinygltf::Model model;
+                    load_gltf(path, model);
+                };
+            });
+
+            tinygltf::Model model;
+            if (!load_gltf(path, model))
+            {
+                continue;
+            }
+
+            uint64_t vertex_count = 0;
+            for (auto &mesh : model.meshes)
+            {
+                for (auto &primitive : mesh.primitives)
+                {
+                    int position = find_attribute(primitive, "POSITION");
+                    vertex_count += position >= 0 ? model.accessors[position].count : 0;
+                }
+            }
+
+            suite.add("import/mesh_attributes/" + stem, vertex_count, [path]
+            {
+                auto model = std::make_shared<tinygltf::Model>();
+                load_gltf(path, *model);
+
+                auto positions = std::make_shared<std::vector<float>>();
+                auto normals = std::make_shared<std::vector<float>>();
+                auto uvs = std::make_shared<std::vector<float>>();
+                auto indices = std::make_shared<std::vector<uint32_t>>();
+
+                return [model, positions, normals, uvs, indices]
+                {
+                    for (auto &mesh : model->meshes)
+                    {
+                        for (auto &primitive : mesh.primitives)
+                        {
+                            read_floats(*model, find_attribute(primitive, "POSITION"), *positions);
+                            read_floats(*model, find_attribute(primitive, "NORMAL"), *normals);
+                            read_floats(*model, find_attribute(primitive, "TEXCOORD_0"), *uvs);
+                            read_indices(*model, primitive.indices, *indices);
+                        }
+                    }
+                };
+            });
+        }
+
+        // The loose textures and the first one of every texture pack directory
+        std::vector<fs::path> textures = find_files(assets / "Textures", {".png", ".jpg"}, false);
+
+        std::error_code error;
+        for (auto &entry : fs::directory_iterator(assets / "Textures", error))
+        {
+            if (!entry.is_directory())
+            {
+                continue;
+            }
+            for (auto &pack_entry : fs::directory_iterator(entry.path(), error))
+            {
+                auto pack_textures = find_files(pack_entry.path(), {".png", ".jpg"}, true);
+                if (pack_entry.is_directory() && !pack_textures.empty())
+                {
+                    textures.push_back(pack_textures.front());
+                }
+            }
+        }
+
+        for (auto &path : textures)
+        {
+            suite.add("import/image_decode/" + path.parent_path().filename().string() + "/" + path.filename().string(), 0, [path]
+            {
+                auto data = std::make_shared<std::vector<uint8_t>>(FileLoader::ReadFileBinary(path));
+                return [data, path]
+                {
+                    vkb::sg::Stb image{path.filename().string(), *data, vkb::sg::Image::Color};
+                    sink = static_cast<float>(image.get_data().size());
+                };
+            });
+        }
+    }
+
+    void add_image_cases(benchmark::Suite &suite)
+    {
+        constexpr uint32_t size = 2048;
+
+        for (auto filter : {vkb::sg::MipFilter::Box, vkb::sg::MipFilter::Kaiser})
+        {
+            for (bool parallel : {false, true})
+            {
+                std::string name = std::string{"image/mip_generation/"} + std::to_string(size) +
+                                   (filter == vkb::sg::MipFilter::Box ? "/box" : "/kaiser") + (parallel ? "/jobs" : "/1_thread");
+
+                suite.add(name, static_cast<uint64_t>(size) * size, [filter, parallel]
+                {
+                    std::mt19937 rng{1234};
+                    std::uniform_int_distribution<int> byte{0, 255};
+
+                    auto source = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(size) * size * 4);
+                    for (auto &value : *source)
+                    {
+                        value = static_cast<uint8_t>(byte(rng));
+                    }
+
+                    vkb::sg::MipGenerationOptions options;
+                    options.filter = filter;
+                    options.parallel = parallel;
+
+                    auto data = std::make_shared<std::vector<uint8_t>>();
+                    auto mipmaps = std::make_shared<std::vector<vkb::sg::Mipmap>>();
+
+                    return [source, data, mipmaps, options]
+                    {
+                        *data = *source;
+                        mipmaps->clear();
+                        vkb::sg::MipGenerator::generate(*data, VK_FORMAT_R8G8B8A8_SRGB, {size, size, 1}, *mipmaps, options);
+                    };
+                });
+            }
+        }
+    }
+
+    void add_cache_cases(benchmark::Suite &suite)
+    {
+        // Small keys, a shader module and a large blob
+        for (size_t byte_count : {64u, 4096u, 1u << 20})
+        {
+            suite.add("cache/hash64/" + std::to_string(byte_count) + "_bytes", byte_count, [byte_count]
+            {
+                auto bytes = std::make_shared<std::vector<uint8_t>>(byte_count);
+                for (size_t i = 0; i < byte_count; i++)
+                {
+                    (*bytes)[i] = static_cast<uint8_t>(i * 31);
+                }
+
+                // Enough calls per sample for the timer to resolve the small sizes
+                size_t repeats = std::max<size_t>(1, (1u << 20) / byte_count);
+                return [bytes, repeats]
+                {
+                    uint64_t hash = 0;
+                    for (size_t i = 0; i < repeats; i++)
+                    {
+                        hash = Hash::Hash64(bytes->data(), bytes->size(), hash);
+                    }
+                    sink = static_cast<float>(hash & 0xff);
+                };
+            });
+        }
+
+        constexpr uint32_t lookups = 10000;
+
+        // Packed like request_resource packs a graphics pipeline state, looked up in a warm cache
+        suite.add("cache/resource_key_lookup/pipeline_state", lookups, []
+        {
+            constexpr uint32_t state_count = 4096;
+
+            auto fill_key = [](vkb::ResourceKey &key, uint32_t state)
+            {
+                key.clear();
+                key.write(static_cast<uint64_t>(0x1000 + state % 64));
+                key.write(static_cast<uint64_t>(0x2000 + state % 8));
+                for (uint32_t field = 0; field < 36; field++)
+                {
+                    key.write(state * 2654435761u + field);
+                }
+            };
+
+            auto cache = std::make_shared<std::unordered_map<vkb::ResourceKey, uint32_t, vkb::ResourceKeyHash>>();
+            vkb::ResourceKey key;
+            for (uint32_t state = 0; state < state_count; state++)
+            {
+                fill_key(key, state);
+                cache->emplace(key, state);
+            }
+
+            auto lookup_key = std::make_shared<vkb::ResourceKey>();
+            return [cache, lookup_key, fill_key]
+            {
+                uint32_t found = 0;
+                for (uint32_t i = 0; i < lookups; i++)
+                {
+                    fill_key(*lookup_key, (i * 7919u) % state_count);
+                    found += cache->count(*lookup_key) ? 1 : 0;
+                }
+                sink = static_cast<float>(found);
+            };
+        });
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    benchmark::SuiteOptions options;
+    if (!benchmark::parse_options(argc, argv, options))
+    {
+        return 2;
+    }
+
+    fs::path assets = options.assets_path;
+    if (assets.empty())
+    {
+        try
+        {
+            assets = Paths::GetAssetPath();
+        }
+        catch (const std::exception &e)
+        {
+            std::fprintf(stderr, "%s, the import cases are skipped, pass --assets\n", e.what());
+        }
+    }
+
+    benchmark::Suite suite{"EngineBenchmarkSuite"};
+    add_physics_cases(suite);
+    add_scene_cases(suite);
+    if (!assets.empty())
+    {
+        add_import_cases(suite, assets);
+    }
+    add_image_cases(suite);
+    add_cache_cases(suite);
+
+    return suite.run(options);
+}
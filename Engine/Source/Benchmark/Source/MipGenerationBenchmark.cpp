@@ -0,0 +1,155 @@
+// Measures the CPU mip chain generation of sg::MipGenerator on 4K and 8K textures,
+// single threaded and spread over the JobSystem workers, against the previous stb resize loop.
+//
+// Usage: MipGenerationBenchmark [iterations]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/packing.hpp>
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize.h"
+
+#include "SceneGraph/Components/Image.h"
+#include "SceneGraph/Components/Image/MipGenerator.h"
+#include "SubSystems/JobSystem.hpp"
+#include "Timer/Timer.hpp"
+
+namespace
+{
+    struct Case
+    {
+        const char* name;
+        VkFormat format;
+        uint32_t pixel_size;
+    };
+
+    std::vector<uint8_t> make_texture(uint32_t size, const Case& test_case)
+    {
+        std::mt19937 rng{1234};
+        std::vector<uint8_t> data(static_cast<size_t>(size) * size * test_case.pixel_size);
+
+        if (test_case.format == VK_FORMAT_R16G16B16A16_SFLOAT)
+        {
+            std::uniform_real_distribution<float> dist{0.0f, 4.0f};
+            auto texels = reinterpret_cast<uint16_t*>(data.data());
+            for (size_t i = 0; i < data.size() / 2; i++)
+            {
+                texels[i] = glm::packHalf1x16(dist(rng));
+            }
+        }
+        else
+        {
+            std::uniform_int_distribution<int> dist{0, 255};
+            for (auto& byte : data)
+            {
+                byte = static_cast<uint8_t>(dist(rng));
+            }
+        }
+
+        return data;
+    }
+
+    /// The loop Image::generate_mipmaps used before: gamma space, 8-bit RGBA only, single threaded
+    void generate_with_stb(std::vector<uint8_t>& data, uint32_t size)
+    {
+        uint32_t width = size;
+        uint32_t height = size;
+        size_t offset = 0;
+        while (width > 1 || height > 1)
+        {
+            uint32_t next_width = std::max(1u, width / 2);
+            uint32_t next_height = std::max(1u, height / 2);
+            size_t next_offset = data.size();
+            data.resize(next_offset + static_cast<size_t>(next_width) * next_height * 4);
+
+            stbir_resize_uint8(data.data() + offset, width, height, 0, data.data() + next_offset, next_width,
+                               next_height, 0, 4);
+
+            offset = next_offset;
+            width = next_width;
+            height = next_height;
+        }
+    }
+
+    template <typename Func>
+    void measure(const std::string& label, uint32_t iterations, Func&& func)
+    {
+        std::vector<double> times;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            vkb::Timer timer;
+            timer.start();
+            func();
+            times.push_back(timer.stop<vkb::Timer::Milliseconds>());
+        }
+
+        std::sort(times.begin(), times.end());
+        double total = 0.0;
+        for (auto time : times)
+        {
+            total += time;
+        }
+
+        std::printf("%-48s min %9.2f ms  median %9.2f ms  avg %9.2f ms\n", label.c_str(), times.front(),
+                    times[times.size() / 2], total / times.size());
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = argc > 1 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[1]))) : 3;
+
+    auto thread_count = JobSystem::GetInstance().GetWorkerCount() + 1;
+
+    const Case cases[] = {
+        {"rgba8 srgb", VK_FORMAT_R8G8B8A8_SRGB, 4},
+        {"rgba16 float", VK_FORMAT_R16G16B16A16_SFLOAT, 8},
+    };
+
+    std::printf("Mip generation benchmark, %u iterations, %u threads\n", iterations, thread_count);
+
+    for (uint32_t size : {4096u, 8192u})
+    {
+        for (auto& test_case : cases)
+        {
+            const auto source = make_texture(size, test_case);
+            const std::string prefix = std::to_string(size) + " " + test_case.name;
+
+            if (test_case.format == VK_FORMAT_R8G8B8A8_SRGB)
+            {
+                measure(prefix + " stb (gamma space)", iterations, [&]
+                {
+                    auto data = source;
+                    generate_with_stb(data, size);
+                });
+            }
+
+            for (auto filter : {vkb::sg::MipFilter::Box, vkb::sg::MipFilter::Kaiser})
+            {
+                const std::string filter_name = filter == vkb::sg::MipFilter::Box ? " box" : " kaiser";
+
+                for (bool threaded : {false, true})
+                {
+                    vkb::sg::MipGenerationOptions options;
+                    options.filter = filter;
+                    options.parallel = threaded;
+
+                    measure(prefix + filter_name + (threaded ? " jobs" : " 1 thread"), iterations, [&]
+                    {
+                        auto data = source;
+                        std::vector<vkb::sg::Mipmap> mipmaps;
+                        vkb::sg::MipGenerator::generate(data, test_case.format, {size, size, 1}, mipmaps, options);
+                    });
+                }
+            }
+        }
+    }
+
+    return 0;
+}
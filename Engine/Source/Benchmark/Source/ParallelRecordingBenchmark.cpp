@@ -0,0 +1,282 @@
+// Records a render pass of 50k Blinn-Phong draws through RenderPipeline, inline on one thread and split into
+// 1 to 16 secondary command buffers recorded on the JobSystem workers, and reports the CPU time of recording the pass.
+// Runs headless on the first GPU, the frames are submitted but nothing is presented. Built with
+// CYRENGINE_COUNT_ALLOCATIONS it also reports the heap allocations of a whole frame and fails unless they are zero
+// once warmed up.
+//
+// Usage: ParallelRecordingBenchmark [draw count] [frames]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <volk.h>
+
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/Debug.hpp"
+#include "Framework/Core/Instance.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Platform/Window.hpp"
+#include "Framework/Rendering/ParallelCommandRecorder.hpp"
+#include "Framework/Rendering/RenderContext.hpp"
+#include "Framework/Rendering/RenderPipeline.hpp"
+#include "Framework/Rendering/RenderTarget.hpp"
+#include "Framework/Rendering/Subpasses/DrawListSubpass.hpp"
+#include "Memory/AllocationCounter.hpp"
+#include "Timer/Timer.hpp"
+
+namespace
+{
+    constexpr uint32_t max_thread_count = 16;
+
+    constexpr uint32_t material_count = 16;
+
+    /// RenderContext only reads the extent of a window without a surface
+    class HeadlessWindow final : public vkb::Window
+    {
+    public:
+        HeadlessWindow() :
+            vkb::Window{make_properties()}
+        {
+        }
+
+        VkSurfaceKHR CreateSurface(vkb::Instance& instance) override
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        VkSurfaceKHR CreateSurface(VkInstance instance, VkPhysicalDevice physical_device) override
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        bool ShouldClose() override
+        {
+            return false;
+        }
+
+        void Close() override
+        {
+        }
+
+        float GetDpiFactor() const override
+        {
+            return 1.0f;
+        }
+
+        std::vector<const char*> GetRequiredSurfaceExtensions() const override
+        {
+            return {};
+        }
+
+    private:
+        static Properties make_properties()
+        {
+            Properties properties;
+            properties.title = "ParallelRecordingBenchmark";
+            properties.mode = Mode::Headless;
+            properties.extent = {1920, 1080};
+            return properties;
+        }
+    };
+
+    std::unique_ptr<vkb::Buffer> make_buffer(vkb::VulkanDevice& device, VkBufferUsageFlags usage, const void* data, size_t size)
+    {
+        auto buffer = std::make_unique<vkb::Buffer>(device, size, usage, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        buffer->update(data, size);
+        return buffer;
+    }
+
+    /// Fills the draw list with a grid of cubes, sorted by material like a real scene would be
+    void fill_draw_list(vkb::DrawListSubpass& subpass, uint32_t mesh, uint32_t draw_count)
+    {
+        std::vector<uint32_t> materials;
+        for (uint32_t i = 0; i < material_count; i++)
+        {
+            float shade = static_cast<float>(i) / material_count;
+            materials.push_back(subpass.add_material({{0.1f, 0.1f, 0.1f, 0.0f}, {shade, 0.5f, 1.0f - shade, 0.0f}, {0.5f, 0.5f, 0.5f}, 32.0f}));
+        }
+
+        auto& items = subpass.get_draw_items();
+        items.clear();
+        items.reserve(draw_count);
+
+        uint32_t side = 1;
+        while (side * side < draw_count)
+        {
+            side++;
+        }
+
+        for (uint32_t i = 0; i < draw_count; i++)
+        {
+            vkb::DrawListSubpass::DrawItem item;
+            item.mesh = mesh;
+            item.material = materials[i * material_count / draw_count];
+            item.model = glm::translate(glm::mat4{1.0f}, glm::vec3{static_cast<float>(i % side) * 2.0f, 0.0f, static_cast<float>(i / side) * 2.0f});
+            item.model = glm::scale(item.model, glm::vec3{0.5f});
+            items.push_back(item);
+        }
+    }
+
+    struct FrameResults
+    {
+        /// Recording time of each frame in milliseconds
+        std::vector<double> times;
+
+        /// Heap allocations of each frame, begin and submit included
+        std::vector<uint64_t> allocations;
+    };
+
+    /// Records and submits frames, the measurements are reserved up front so they allocate nothing meanwhile
+    FrameResults run_frames(vkb::RenderContext& render_context, vkb::RenderPipeline& pipeline, uint32_t frames)
+    {
+        FrameResults results;
+        results.times.reserve(frames);
+        results.allocations.reserve(frames);
+
+        // The first frames create the pipelines and descriptor sets of every thread and grow the frame arenas
+        for (uint32_t frame = 0; frame < frames + 2; frame++)
+        {
+            uint64_t allocation_count = AllocationCounter::GetCount();
+
+            auto command_buffer = render_context.begin();
+
+            vkb::Timer timer;
+            timer.start();
+
+            command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            pipeline.draw(*command_buffer, render_context.get_active_frame().get_render_target());
+            command_buffer->end_render_pass();
+            command_buffer->end();
+
+            double time = timer.stop<vkb::Timer::Milliseconds>();
+
+            render_context.submit(command_buffer);
+            command_buffer.reset();
+
+            if (frame > 1)
+            {
+                results.times.push_back(time);
+                results.allocations.push_back(AllocationCounter::GetCount() - allocation_count);
+            }
+        }
+
+        return results;
+    }
+
+    /**
+     * @return false when a warmed up frame allocated on the heap, counting allocations has to be enabled
+     */
+    bool report(const std::string& label, FrameResults results, double baseline)
+    {
+        auto& times = results.times;
+        std::sort(times.begin(), times.end());
+        double median = times[times.size() / 2];
+
+        std::printf("%-24s min %8.2f ms  median %8.2f ms  speedup %5.2fx", label.c_str(), times.front(), median,
+                    baseline > 0.0 ? baseline / median : 1.0);
+
+        uint64_t max_allocations = 0;
+        if (AllocationCounter::IsEnabled())
+        {
+            auto& allocations = results.allocations;
+            max_allocations = *std::max_element(allocations.begin(), allocations.end());
+            std::printf("  max heap allocations per frame %llu", static_cast<unsigned long long>(max_allocations));
+        }
+
+        std::printf("\n");
+
+        if (max_allocations > 0)
+        {
+            std::fprintf(stderr, "%s: a warmed up frame made %llu heap allocations, expected none\n", label.c_str(),
+                         static_cast<unsigned long long>(max_allocations));
+            return false;
+        }
+
+        return true;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t draw_count = argc > 1 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[1]))) : 50000;
+    uint32_t frames = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 20;
+
+    try
+    {
+        VK_CHECK_RESULT(volkInitialize());
+
+        vkb::Instance instance{"ParallelRecordingBenchmark"};
+        vkb::VulkanDevice device{instance.get_first_gpu(), VK_NULL_HANDLE, std::make_unique<vkb::DummyDebugUtils>()};
+
+        HeadlessWindow window;
+        vkb::RenderContext render_context{device, VK_NULL_HANDLE, window};
+        render_context.prepare(max_thread_count, vkb::RenderTarget::DEFAULT_CREATE_FUNC);
+
+        const std::vector<vkb::DrawListSubpass::Vertex> vertices = {
+            {{-1, -1, 1}, {0, 0, 1}, {0, 0}}, {{1, -1, 1}, {0, 0, 1}, {1, 0}}, {{1, 1, 1}, {0, 0, 1}, {1, 1}}, {{-1, 1, 1}, {0, 0, 1}, {0, 1}},
+            {{1, -1, -1}, {0, 0, -1}, {0, 0}}, {{-1, -1, -1}, {0, 0, -1}, {1, 0}}, {{-1, 1, -1}, {0, 0, -1}, {1, 1}}, {{1, 1, -1}, {0, 0, -1}, {0, 1}}};
+        const std::vector<uint32_t> indices = {0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4, 1, 4, 7, 7, 2, 1,
+                                               5, 0, 3, 3, 6, 5, 3, 2, 7, 7, 6, 3, 5, 4, 1, 1, 0, 5};
+
+        auto vertex_buffer = make_buffer(device, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data(), vertices.size() * sizeof(vertices[0]));
+        auto index_buffer = make_buffer(device, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data(), indices.size() * sizeof(indices[0]));
+
+        auto subpass = std::make_unique<vkb::DrawListSubpass>(render_context);
+        auto& draw_list = *subpass;
+
+        uint32_t mesh = draw_list.add_mesh({vertex_buffer.get(), index_buffer.get(), static_cast<uint32_t>(indices.size())});
+        fill_draw_list(draw_list, mesh, draw_count);
+
+        const auto& extent = render_context.get_surface_extent();
+        draw_list.set_scene({vkb::vulkan_style_projection(glm::perspective(glm::radians(60.0f), static_cast<float>(extent.width) / extent.height, 0.1f, 1000.0f)),
+                             glm::lookAt(glm::vec3{-20.0f, 40.0f, -20.0f}, glm::vec3{100.0f, 0.0f, 100.0f}, glm::vec3{0.0f, 1.0f, 0.0f}),
+                             glm::vec4{-20.0f, 40.0f, -20.0f, 1.0f}});
+        draw_list.set_light({{0.0f, 100.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, 0.1f});
+
+        vkb::RenderPipeline pipeline;
+        pipeline.add_subpass(std::move(subpass));
+
+        std::vector<VkClearValue> clear_value(2);
+        clear_value[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+        clear_value[1].depthStencil = {1.0f, 0};
+        pipeline.set_clear_value(clear_value);
+
+        std::printf("Parallel recording benchmark, %u draws, %u frames, GPU %s\n", draw_count, frames,
+                    device.get_gpu().get_properties().deviceName);
+
+        auto inline_results = run_frames(render_context, pipeline, frames);
+        auto inline_times = inline_results.times;
+        std::sort(inline_times.begin(), inline_times.end());
+        double baseline = inline_times[inline_times.size() / 2];
+        bool allocation_free = report("inline", inline_results, baseline);
+
+        for (uint32_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2)
+        {
+            vkb::ParallelCommandRecorder recorder{thread_count};
+            pipeline.set_command_recorder(&recorder);
+
+            allocation_free &= report(std::to_string(thread_count) + " chunks", run_frames(render_context, pipeline, frames), baseline);
+
+            pipeline.set_command_recorder(nullptr);
+        }
+
+        device.wait_idle();
+
+        if (!allocation_free)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "Benchmark failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
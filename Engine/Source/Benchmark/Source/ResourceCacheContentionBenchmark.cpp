@@ -0,0 +1,190 @@
+// Measures lookups into the resource cache from 16 recording threads while some of the requests miss and
+// build a new resource, comparing the previous single mutex per resource type against ConcurrentResourceMap.
+// Builds spin for a configurable time to stand in for vkCreateGraphicsPipelines.
+//
+// Usage: ResourceCacheContentionBenchmark [build microseconds] [requests per thread]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Framework/Misc/ConcurrentResourceMap.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t thread_count = 16;
+
+    /// Keys every thread keeps requesting, built before the measurement
+    constexpr size_t warm_keys = 512;
+
+    /// One request in miss_interval builds a key nobody requested before
+    constexpr uint32_t miss_interval = 200;
+
+    struct Resource
+    {
+        explicit Resource(size_t key, uint32_t build_us) : key{key}
+        {
+            auto end = Clock::now() + std::chrono::microseconds(build_us);
+            while (Clock::now() < end)
+            {
+            }
+        }
+
+        size_t key;
+    };
+
+    /// The previous ResourceCache: one lock per resource type held for the whole request, including the build
+    class LockedMap
+    {
+    public:
+        Resource &request(size_t key, uint32_t build_us)
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+
+            auto it = resources.find(key);
+            if (it != resources.end())
+            {
+                return *it->second;
+            }
+
+            return *resources.emplace(key, std::make_unique<Resource>(key, build_us)).first->second;
+        }
+
+    private:
+        std::mutex mutex;
+
+        std::unordered_map<size_t, std::unique_ptr<Resource>> resources;
+    };
+
+    class ShardedMap
+    {
+    public:
+        Resource &request(size_t key, uint32_t build_us)
+        {
+            // Packed the way request_resource packs its parameters
+            vkb::ResourceKey resource_key;
+            resource_key.write(key);
+            resource_key.write(build_us);
+
+            return resources.get_or_create(
+                resource_key, [&]() { return std::make_unique<Resource>(key, build_us); }, [](Resource &) {});
+        }
+
+    private:
+        vkb::ConcurrentResourceMap<Resource> resources;
+    };
+
+    struct Result
+    {
+        double seconds{0.0};
+
+        /// Latency of requests that hit an existing resource
+        std::vector<double> hit_us;
+    };
+
+    template <class Map>
+    Result run(uint32_t build_us, uint32_t requests)
+    {
+        Map map;
+        for (size_t key = 0; key < warm_keys; key++)
+        {
+            map.request(key, 0);
+        }
+
+        std::vector<std::vector<double>> hit_us(thread_count);
+        std::atomic<uint32_t> ready{0};
+        std::atomic<size_t> checksum{0};
+
+        auto worker = [&](uint32_t thread_index)
+        {
+            std::mt19937 rng{thread_index};
+            std::uniform_int_distribution<size_t> warm{0, warm_keys - 1};
+            auto &latencies = hit_us[thread_index];
+            latencies.reserve(requests);
+            size_t sum = 0;
+
+            ready++;
+            while (ready < thread_count)
+            {
+                std::this_thread::yield();
+            }
+
+            for (uint32_t i = 0; i < requests; i++)
+            {
+                if (i % miss_interval == miss_interval - 1)
+                {
+                    // Unique per thread and request, half of them shared with the next thread to exercise waiting
+                    size_t key = warm_keys + ((thread_index / 2) * requests + i);
+                    sum += map.request(key, build_us).key;
+                    continue;
+                }
+
+                auto start = Clock::now();
+                sum += map.request(warm(rng), build_us).key;
+                latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            }
+
+            checksum += sum;
+        };
+
+        auto start = Clock::now();
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < thread_count; i++)
+        {
+            threads.emplace_back(worker, i);
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        Result result;
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (auto &latencies : hit_us)
+        {
+            result.hit_us.insert(result.hit_us.end(), latencies.begin(), latencies.end());
+        }
+        std::sort(result.hit_us.begin(), result.hit_us.end());
+
+        return result;
+    }
+
+    void print(const std::string &label, const Result &result, uint32_t requests)
+    {
+        auto percentile = [&](double p)
+        {
+            return result.hit_us[static_cast<size_t>(p * (result.hit_us.size() - 1))];
+        };
+
+        double total = static_cast<double>(thread_count) * requests;
+        std::printf("%-24s %8.1f ms  %7.2f Mreq/s  hit p50 %8.2f us  p99 %8.2f us  max %9.2f us\n", label.c_str(),
+                    result.seconds * 1000.0, total / result.seconds / 1e6, percentile(0.5), percentile(0.99),
+                    result.hit_us.back());
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t build_us = argc > 1 ? static_cast<uint32_t>(std::max(0, std::atoi(argv[1]))) : 500;
+    uint32_t requests = argc > 2 ? static_cast<uint32_t>(std::max<int>(miss_interval, std::atoi(argv[2]))) : 20000;
+
+    std::printf("Resource cache contention, %u threads, %u requests each, 1 in %u builds for %u us\n", thread_count,
+                requests, miss_interval, build_us);
+
+    print("single mutex", run<LockedMap>(build_us, requests), requests);
+    print("sharded, off-lock build", run<ShardedMap>(build_us, requests), requests);
+
+    return 0;
+}
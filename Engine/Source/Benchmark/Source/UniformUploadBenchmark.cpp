@@ -0,0 +1,136 @@
+// Allocates and writes one uniform block per object, through the BufferPool blocks RenderFrame used before and
+// through the per-frame RingBufferAllocator, and reports the CPU time per frame of each.
+// Runs on the first GPU, nothing is submitted.
+//
+// Usage: UniformUploadBenchmark [object count] [frames]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <volk.h>
+
+#include "Framework/Core/Debug.hpp"
+#include "Framework/Core/Instance.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Misc/BufferPool.hpp"
+#include "Framework/Misc/RingBufferAllocator.hpp"
+#include "Timer/Timer.hpp"
+
+namespace
+{
+    /// A typical per-object block, model matrix, normal matrix and a few material parameters
+    struct alignas(16) ObjectUniform
+    {
+        float model[16];
+        float normal[16];
+        float color[4];
+        float params[4];
+    };
+
+    template <typename Func>
+    std::vector<double> run_frames(uint32_t frames, Func &&frame)
+    {
+        std::vector<double> times;
+
+        // The first frame creates the blocks
+        for (uint32_t i = 0; i < frames + 1; i++)
+        {
+            vkb::Timer timer;
+            timer.start();
+
+            frame();
+
+            double time = timer.stop<vkb::Timer::Milliseconds>();
+            if (i > 0)
+            {
+                times.push_back(time);
+            }
+        }
+
+        return times;
+    }
+
+    void report(const std::string &label, std::vector<double> times, double baseline)
+    {
+        std::sort(times.begin(), times.end());
+        double median = times[times.size() / 2];
+
+        std::printf("%-24s min %8.3f ms  median %8.3f ms  speedup %5.2fx\n", label.c_str(), times.front(), median,
+                    baseline > 0.0 ? baseline / median : 1.0);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t object_count = argc > 1 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[1]))) : 10000;
+    uint32_t frames = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 50;
+
+    try
+    {
+        VK_CHECK_RESULT(volkInitialize());
+
+        vkb::Instance instance{"UniformUploadBenchmark"};
+        vkb::VulkanDevice device{instance.get_first_gpu(), VK_NULL_HANDLE, std::make_unique<vkb::DummyDebugUtils>()};
+
+        std::vector<ObjectUniform> objects(object_count);
+        for (uint32_t i = 0; i < object_count; i++)
+        {
+            objects[i].color[0] = static_cast<float>(i) / object_count;
+        }
+
+        std::printf("Uniform upload benchmark, %u objects of %zu bytes, %u frames, GPU %s\n", object_count, sizeof(ObjectUniform), frames,
+                    device.get_gpu().get_properties().deviceName);
+
+        vkb::BufferPool buffer_pool{device, 256 * 1024, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT};
+        auto pool_times = run_frames(frames, [&]()
+        {
+            buffer_pool.reset();
+
+            vkb::BufferBlock *block = nullptr;
+            for (auto &object : objects)
+            {
+                if (!block || !block->can_allocate(sizeof(ObjectUniform)))
+                {
+                    block = &buffer_pool.request_buffer_block(sizeof(ObjectUniform));
+                }
+
+                // Through the Buffer, with a flush per write like RenderFrame allocations had
+                auto allocation = block->allocate(sizeof(ObjectUniform));
+                allocation.update(object);
+            }
+        });
+
+        std::sort(pool_times.begin(), pool_times.end());
+        double baseline = pool_times[pool_times.size() / 2];
+        report("buffer pool", pool_times, baseline);
+
+        vkb::RingBufferAllocator ring_allocator{device, 1};
+        report("ring allocator", run_frames(frames, [&]()
+        {
+            ring_allocator.reset();
+
+            for (auto &object : objects)
+            {
+                auto allocation = ring_allocator.allocate(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ObjectUniform), 0);
+                allocation.update(object);
+            }
+
+            ring_allocator.flush();
+        }), baseline);
+
+        auto stats = ring_allocator.get_stats();
+        std::printf("ring allocator: %llu bytes mapped, high-water mark %llu bytes, grown %u times\n",
+                    static_cast<unsigned long long>(stats.capacity), static_cast<unsigned long long>(stats.high_water_mark), stats.grow_count);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "Benchmark failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
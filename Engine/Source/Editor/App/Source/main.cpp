@@ -6,15 +6,60 @@
 #include <unordered_map>
 #include "Engine.hpp"
 #include "Editor.hpp"
+#include "Logging/Logger.hpp"
+#include "Misc/AssetArchive.hpp"
+#include "Misc/Paths.hpp"
 
 int main(int argc, char **argv)
 {
+    // Packs the Assets directory into Assets.pak next to it, which the engine mounts under the loose files
+    if (argc > 1 && std::string(argv[1]) == "--pack-assets")
+    {
+        Logger::Init();
+        int result = 0;
+        try
+        {
+            std::filesystem::path assets{Paths::GetAssetPath()};
+            AssetArchive::Build(assets, assets.parent_path() / "Assets.pak");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Failed to pack the assets: " << e.what() << std::endl;
+            result = 1;
+        }
+        Logger::Shutdown();
+        return result;
+    }
+
     std::filesystem::path ExecutablePath(argv[0]);
     std::filesystem::path ConfigFilePath = ExecutablePath.parent_path() / "CyREditor.ini";
     Engine *engine = new Engine();
 
     engine->StartEngine(ConfigFilePath.generic_string());
 
+    // --scene <path> draws a glTF scene under the editor, --compact-vertices loads it with quantized attributes,
+    // --gpu-driven culls and draws it on the GPU and --validate-culling checks that culling against the CPU
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg{argv[i]};
+        if (arg == "--scene" && i + 1 < argc)
+        {
+            engine->GetConfig().ScenePath = argv[++i];
+        }
+        else if (arg == "--compact-vertices")
+        {
+            engine->GetConfig().CompactVertices = true;
+        }
+        else if (arg == "--gpu-driven")
+        {
+            engine->GetConfig().GpuDrivenRendering = true;
+        }
+        else if (arg == "--validate-culling")
+        {
+            engine->GetConfig().ValidateCulling = true;
+        }
+    }
+
     engine->Initialize();
 
     Editor *editor = new Editor();
@@ -10,6 +10,18 @@ struct EngineConfig
 {
     int MaxFPS = 60;
     bool EnableVSync = true;
+
+    /// glTF scene drawn under the editor, relative to the Assets directory
+    std::string ScenePath;
+
+    /// Quantized vertex attributes for the scene, decoded in the vertex shader
+    bool CompactVertices = false;
+
+    /// Culls and draws the scene on the GPU
+    bool GpuDrivenRendering = false;
+
+    /// Checks the GPU culling of the scene against the CPU reference every frame
+    bool ValidateCulling = false;
 };
 
 class Engine
@@ -32,6 +44,9 @@ public:
     void SetMaxFPS(int fps) { MaxFPS = fps; }
     std::string GetEngineStatus() const;
 
+    /// Read by Initialize, settings changed after it have no effect
+    EngineConfig& GetConfig() { return mConfig; }
+
 protected:
     void LogicalTick(float DeltaTime);
     bool RendererTick(float DeltaTime);
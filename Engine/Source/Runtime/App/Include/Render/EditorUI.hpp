@@ -49,4 +49,5 @@ protected:
     void RenderProjectBrowser();
     void RenderConsole();
     void RenderViewport(bool off);
+    void RenderProfiler();
 };
@@ -1,12 +1,21 @@
 #pragma once
 
+
 #include <volk.h>
 
 #include "EditorUI.hpp"
+#include "SceneRenderer.hpp"
+#include "Framework/Core/BindlessDescriptorTable.hpp"
 #include "Framework/Core/Instance.hpp"
+#include "Framework/Core/PipelineCache.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Misc/GpuProfiler.hpp"
+#include "Framework/Misc/UploadManager.hpp"
+#include "Framework/Rendering/ParallelCommandRecorder.hpp"
 #include "Framework/Rendering/RenderContext.hpp"
+#include "Framework/Rendering/RenderGraph.hpp"
 #include "Framework/Rendering/RenderPipeline.hpp"
+#include "SubSystems/JobSystem.hpp"
 
 
 namespace vkb::sg
@@ -18,6 +27,18 @@ struct ApplicationOptions
 {
     bool benchmark_enabled{false};
     vkb::Window* window{nullptr};
+
+    /// glTF scene drawn under the editor UI, relative to the Assets directory, nothing is drawn when empty
+    std::string scene_path;
+
+    /// Loads the scene with quantized vertex attributes instead of the full float layout
+    bool compact_vertices{false};
+
+    /// Culls and draws the scene on the GPU with IndirectDrawSubpass, when the GPU supports it
+    bool gpu_driven{false};
+
+    /// Checks the GPU culling against CpuDrawCuller every frame, logs the mismatches
+    bool validate_culling{false};
 };
 
 class RenderSystem
@@ -44,6 +65,22 @@ public:
     void UpdateDebugWindow();
     void Finish();
 
+    /**
+     * @brief Loads the pipeline cache, the shader variants and the resource stream of earlier runs from the cache directory
+     *        The variants are compiled and the recorded resources created on the JobSystem workers, WaitForWarmup() joins them
+     */
+    void LoadPipelineCache();
+
+    /**
+     * @brief Blocks until the resources of the last run exist, called before the first frame is recorded, a failed warmup is logged
+     */
+    void WaitForWarmup();
+
+    /**
+     * @brief Writes the pipeline cache, the shader variants and the resource stream for the next run, the device must be idle
+     */
+    void SavePipelineCache();
+
     void SetViewportAndScissor(vkb::CommandBuffer const& command_buffer, VkExtent2D const& extent);
 
     void CreateRenderContext();
@@ -130,6 +167,45 @@ public:
     vkb::RenderPipeline const& GetRenderPipeline() const { return *render_pipeline; }
     vkb::RenderPipeline& GetRenderPipeline() { return *render_pipeline; }
 
+private:
+    /**
+     * @brief Records the subpasses of the render pipeline on one thread per render frame thread
+     */
+    std::unique_ptr<vkb::ParallelCommandRecorder> command_recorder;
+
+    /**
+     * @brief Declares the passes of a frame and records the barriers between them
+     */
+    std::unique_ptr<vkb::RenderGraph> render_graph;
+
+    /// Swapchain generation the render graph was compiled for, its render targets hold the views of the swapchain images
+    uint32_t render_graph_swapchain_generation{0};
+
+    /**
+     * @brief Timestamps of the frame and of the render graph passes, reported to the Profiler
+     */
+    std::unique_ptr<vkb::GpuProfiler> gpu_profiler;
+
+    /**
+     * @brief Every texture, sampler and storage buffer in one descriptor set, null when descriptor indexing is not supported
+     */
+    std::unique_ptr<vkb::BindlessDescriptorTable> bindless_table;
+
+    bool bindless_supported{false};
+
+    /// IndirectDrawSubpass::request_features succeeded
+    bool indirect_draw_supported{false};
+
+    /**
+     * @brief Streams loaded data to the GPU on the transfer queue, its ownership acquires are recorded at the start of every frame
+     */
+    std::unique_ptr<vkb::UploadManager> upload_manager;
+
+    /**
+     * @brief Draws the scene of the options under the editor UI, null when no scene was loaded
+     */
+    std::unique_ptr<SceneRenderer> scene_renderer;
+
 private:
     /**
      * @brief Holds all scene information
@@ -179,6 +255,12 @@ private:
 
     std::unique_ptr<vkb::DebugUtils> debug_utils;
 
+    /** @brief Driver pipeline cache used by every pipeline of the resource cache */
+    std::unique_ptr<vkb::PipelineCache> pipeline_cache;
+
+    /** @brief Replay of the resources recorded in the last run */
+    JobCounter resource_warmup;
+
 public:
     std::unordered_map<const char*, bool> const& GetDeviceExtensions() const;
     std::unordered_map<const char*, bool> const& GetInstanceExtensions() const;
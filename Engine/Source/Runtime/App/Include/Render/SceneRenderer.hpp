@@ -0,0 +1,121 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <volk.h>
+
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Rendering/RenderGraph.hpp"
+#include "Framework/Rendering/Subpasses/DrawListSubpass.hpp"
+#include "Framework/Rendering/Subpasses/IndirectDrawSubpass.hpp"
+#include "SceneGraph/Components/VertexLayout.h"
+
+namespace vkb
+{
+    class MeshArena;
+    class RenderContext;
+    class TextureStreamer;
+    class UploadManager;
+
+    namespace sg
+    {
+        class Camera;
+        class Material;
+        class Scene;
+        class SubMesh;
+    } // namespace sg
+} // namespace vkb
+
+/**
+ * @brief Draws a glTF scene into the backbuffer, before the editor UI is drawn over it
+ *        The scene is loaded once and its submeshes become the meshes of a DrawListSubpass, every frame
+ *        AddPasses() declares the scene pass in the render graph with a transient depth buffer.
+ *        The mips of the scene images are streamed in for the visible submeshes before the scene pass. With a bindless
+ *        table the base color textures are sampled through the slots the loader registered.
+ *        GPU driven, the submeshes are copied into a MeshArena and drawn by an IndirectDrawSubpass, culled on the GPU
+ *        against the frustum and the depth pyramid of the previous frame.
+ */
+class SceneRenderer
+{
+public:
+    explicit SceneRenderer(vkb::RenderContext& render_context);
+
+    ~SceneRenderer();
+
+    SceneRenderer(const SceneRenderer&) = delete;
+
+    SceneRenderer& operator=(const SceneRenderer&) = delete;
+
+    /**
+     * @brief Loads the scene and builds its draw list, throws when the file cannot be loaded
+     * @param path glTF file relative to the Assets directory
+     * @param vertex_layout Formats of the vertex buffers, decoded by BlinnPhong.vert
+     * @param upload_manager Uploads the meshes and images on the transfer queue, null uploads them on the graphics queue
+     * @param gpu_driven Draws with IndirectDrawSubpass, its features have to be enabled on the device
+     */
+    void Load(const std::string& path, const vkb::sg::VertexLayout& vertex_layout,
+              vkb::UploadManager* upload_manager = nullptr, bool gpu_driven = false);
+
+    /**
+     * @brief Checks the draws of the GPU culling against CpuDrawCuller every frame, only used when GPU driven
+     */
+    void SetCullValidation(bool enabled);
+
+    bool HasScene() const;
+
+    /**
+     * @brief Fits the camera to the target, updates the uniforms of the frame and requests the mips it needs
+     */
+    void Update(const VkExtent2D& extent);
+
+    /**
+     * @brief Declares the texture streaming pass and the scene pass, which clears the backbuffer and draws the scene into it
+     *        GPU driven, the culling pass comes before the scene pass and the depth pyramid pass after it.
+     */
+    void AddPasses(vkb::RenderGraph& render_graph, vkb::RenderGraphImage backbuffer, const VkExtent2D& extent);
+
+private:
+    /**
+     * @brief Describes the position, normal and texture coordinate streams of a submesh for BlinnPhong.vert
+     * @return false when the submesh cannot be drawn by the subpass
+     */
+    bool CreateMesh(const vkb::sg::SubMesh& submesh, vkb::DrawListSubpass::Mesh& mesh) const;
+
+    uint32_t GetMaterial(const vkb::sg::Material* material);
+
+    /**
+     * @brief Places the default camera so it sees the whole scene
+     */
+    void FrameScene();
+
+    vkb::RenderContext& render_context;
+
+    std::unique_ptr<vkb::sg::Scene> scene;
+
+    std::unique_ptr<vkb::DrawListSubpass> draw_list;
+
+    /// Geometry of every submesh when GPU driven, destroyed after the subpass that draws it
+    std::unique_ptr<vkb::MeshArena> mesh_arena;
+
+    std::unique_ptr<vkb::IndirectDrawSubpass> indirect_draw;
+
+    /// Streams the mips of the scene images, they are unregistered before the scene is destroyed
+    std::unique_ptr<vkb::TextureStreamer> texture_streamer;
+
+    /// Normal of submeshes without normals, read with a zero stride
+    std::unique_ptr<vkb::Buffer> default_normal;
+
+    /// Texture coordinate of submeshes without them, read with a zero stride
+    std::unique_ptr<vkb::Buffer> default_texcoord;
+
+    std::unordered_map<const vkb::sg::Material*, uint32_t> materials;
+
+    vkb::sg::Camera* camera{nullptr};
+
+    VkFormat depth_format{VK_FORMAT_UNDEFINED};
+
+    /// World space bounds of the scene, center in xyz and radius in w
+    glm::vec4 bounding_sphere{0.0f, 0.0f, 0.0f, 1.0f};
+};
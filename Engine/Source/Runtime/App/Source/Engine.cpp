@@ -1,14 +1,44 @@
 #include "Engine.hpp"
 #include "GlobalContext.hpp"
 #include "Logging/Logger.hpp"
+#include "Misc/Paths.hpp"
+#include "Misc/VirtualFileSystem.hpp"
+#include "Profiler/Profiler.hpp"
 #include <iostream>
 #include <atomic>
 #include <chrono>
 #include "Render/RenderSystem.hpp"
+#include "SubSystems/JobSystem.hpp"
 #include <algorithm>
+#include <filesystem>
 
 const float Engine::FPSAlpha = 1.f / 100;
 
+namespace
+{
+    /// Assets.pak next to the Assets directory when it was built, with the loose files mounted over it
+    void MountAssets()
+    {
+        auto& vfs = VirtualFileSystem::GetInstance();
+        try
+        {
+            std::filesystem::path assets{Paths::GetAssetPath()};
+
+            auto archive = assets.parent_path() / "Assets.pak";
+            if (std::filesystem::exists(archive))
+            {
+                vfs.MountArchive("", archive);
+            }
+
+            vfs.MountDirectory("", assets);
+        }
+        catch (const std::exception& e)
+        {
+            LOGE("Failed to mount the assets: {}", e.what());
+        }
+    }
+} // namespace
+
 void Engine::LogicalTick(float DeltaTime)
 {
 }
@@ -78,6 +108,10 @@ void Engine::SetIsIconify(bool bIsIconify)
 void Engine::StartEngine(const std::string& ConfigFilePath)
 {
     Logger::Init();
+    // Created here so the calling thread becomes the main thread of the job system
+    JobSystem::GetInstance();
+    Profiler::GetInstance().SetThreadName("Main");
+    MountAssets();
     GRuntimeGlobalContext.StartSystems(ConfigFilePath);
     LOG_INFO("Engine started")
 }
@@ -85,7 +119,9 @@ void Engine::StartEngine(const std::string& ConfigFilePath)
 void Engine::ShutdownEngine()
 {
     GRuntimeGlobalContext.ShutdownSystems();
+    JobSystem::GetInstance().Shutdown();
     LOG_INFO("Engine exit")
+    Logger::Shutdown();
 }
 
 void Engine::Initialize()
@@ -93,6 +129,10 @@ void Engine::Initialize()
     ApplicationOptions app_options;
     app_options.benchmark_enabled = false;
     app_options.window = GRuntimeGlobalContext.windowSystem.get();
+    app_options.scene_path = mConfig.ScenePath;
+    app_options.compact_vertices = mConfig.CompactVertices;
+    app_options.gpu_driven = mConfig.GpuDrivenRendering;
+    app_options.validate_culling = mConfig.ValidateCulling;
     GRuntimeGlobalContext.windowSystem->RegisterOnWindowIconifyFunc([this](bool bIsIconify)
         {
             if (this != nullptr)
@@ -116,6 +156,12 @@ void Engine::Run()
 
 bool Engine::TickOneFrame(float DeltaTime)
 {
+    Profiler::GetInstance().BeginFrame();
+    PROFILE_SCOPE("Tick");
+    PROFILE_PLOT("Frame time (ms)", DeltaTime * 1000.0f);
+
+    JobSystem::GetInstance().ProcessMainThreadJobs();
+
     LogicalTick(DeltaTime);
     CalculateFPS(DeltaTime);
 
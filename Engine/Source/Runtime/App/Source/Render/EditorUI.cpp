@@ -1,10 +1,17 @@
 #include "Render/EditorUI.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <map>
 #include "Framework/Core/VulkanTools.hpp"
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_vulkan.h"
 #include "GlobalContext.hpp"
 #include "Framework/Core/RenderPass.hpp"
+#include "Misc/Paths.hpp"
+#include "Profiler/Profiler.hpp"
 
 EditorUIManager::EditorUIManager(vkb::VulkanDevice& device)
     : vulkanDevice(device), descriptorPool(vks::DescriptorPoolBuilder(device.GetHandle())
@@ -94,6 +101,7 @@ void EditorUIManager::Draw(VkCommandBuffer command_buffer)
     RenderProjectBrowser();
     RenderConsole();
     RenderViewport(false);
+    RenderProfiler();
 
     ImGui::Render();
 
@@ -403,3 +411,177 @@ void EditorUIManager::RenderViewport(bool off)
 
     ImGui::End();
 }
+
+namespace ProfilerState
+{
+    bool paused = false;
+    Profiler::Capture capture;
+    std::vector<float> frame_times;
+    // One history per plotted value, filled with the samples newer than last_plot_time
+    std::map<std::string, std::vector<float>> plots;
+    uint64_t last_plot_time = 0;
+
+    constexpr size_t plot_history = 240;
+    constexpr size_t max_zone_rows = 300;
+    // Frames of events copied from the profiler each frame, the GPU zones arrive a few frames late
+    constexpr size_t captured_frames = 8;
+}
+
+void EditorUIManager::RenderProfiler()
+{
+    ImGui::Begin("Profiler");
+
+    auto& profiler = Profiler::GetInstance();
+
+    bool enabled = profiler.IsEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled))
+    {
+        profiler.SetEnabled(enabled);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Pause", &ProfilerState::paused);
+    ImGui::SameLine();
+    if (ImGui::Button("Save Trace"))
+    {
+        auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        char file_name[64];
+        std::strftime(file_name, sizeof(file_name), "trace_%Y%m%d_%H%M%S.json", std::localtime(&now));
+        profiler.WriteChromeTrace(std::filesystem::path{Paths::GetAssetPath()}.parent_path() / "Traces" / file_name);
+    }
+
+    if (!ProfilerState::paused)
+    {
+        auto frames = profiler.GetFrames();
+        uint64_t since = frames.size() > ProfilerState::captured_frames
+                             ? frames[frames.size() - ProfilerState::captured_frames].start
+                             : 0;
+        ProfilerState::capture = profiler.CaptureEvents(since);
+
+        ProfilerState::frame_times.clear();
+        for (auto& frame : ProfilerState::capture.frames)
+        {
+            ProfilerState::frame_times.push_back(static_cast<float>(frame.end - frame.start) / 1000000.0f);
+        }
+
+        uint64_t newest_plot = ProfilerState::last_plot_time;
+        for (auto& track : ProfilerState::capture.tracks)
+        {
+            for (auto& event : track.events)
+            {
+                if (event.type != ProfileEventType::Plot || event.start <= ProfilerState::last_plot_time)
+                {
+                    continue;
+                }
+                auto& history = ProfilerState::plots[event.name];
+                if (history.size() >= ProfilerState::plot_history)
+                {
+                    history.erase(history.begin());
+                }
+                history.push_back(static_cast<float>(event.value));
+                newest_plot = std::max(newest_plot, event.start);
+            }
+        }
+        ProfilerState::last_plot_time = newest_plot;
+    }
+
+    auto& capture = ProfilerState::capture;
+    if (capture.frames.empty())
+    {
+        ImGui::Text("No frame was profiled yet.");
+        ImGui::End();
+        return;
+    }
+
+    auto& frame_times = ProfilerState::frame_times;
+    float average = 0.0f;
+    for (float time : frame_times)
+    {
+        average += time;
+    }
+    average /= static_cast<float>(frame_times.size());
+
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "last %.2f ms, average %.2f ms", frame_times.back(), average);
+    ImGui::PlotLines("Frame (ms)", frame_times.data(), static_cast<int>(frame_times.size()), 0, overlay, 0.0f,
+                     average * 3.0f, ImVec2(0, 60));
+
+    if (ImGui::CollapsingHeader("Plots"))
+    {
+        for (auto& [name, history] : ProfilerState::plots)
+        {
+            snprintf(overlay, sizeof(overlay), "%.6g", history.empty() ? 0.0 : history.back());
+            ImGui::PlotLines(name.c_str(), history.data(), static_cast<int>(history.size()), 0, overlay, FLT_MAX,
+                             FLT_MAX, ImVec2(0, 40));
+        }
+    }
+
+    // The zones that began in the last frame, tracks without any (like the GPU, which is read back frames
+    // later) show their latest root zone instead
+    auto& last_frame = capture.frames.back();
+    std::vector<const ProfileEvent*> zones;
+
+    for (auto& track : capture.tracks)
+    {
+        if (!ImGui::CollapsingHeader(track.name.c_str(), ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            continue;
+        }
+
+        uint64_t window_start = last_frame.start;
+        uint64_t window_end = last_frame.end;
+
+        auto in_window = [&](const ProfileEvent& event)
+        {
+            return event.type == ProfileEventType::Zone && event.start >= window_start && event.start < window_end;
+        };
+
+        if (std::none_of(track.events.begin(), track.events.end(), in_window))
+        {
+            const ProfileEvent* latest_root = nullptr;
+            for (auto& event : track.events)
+            {
+                if (event.type == ProfileEventType::Zone && event.depth == 0 &&
+                    (!latest_root || event.start > latest_root->start))
+                {
+                    latest_root = &event;
+                }
+            }
+            if (!latest_root)
+            {
+                continue;
+            }
+            window_start = latest_root->start;
+            window_end = latest_root->end + 1;
+        }
+
+        zones.clear();
+        for (auto& event : track.events)
+        {
+            if (in_window(event))
+            {
+                zones.push_back(&event);
+            }
+        }
+        std::sort(zones.begin(), zones.end(), [](const ProfileEvent* a, const ProfileEvent* b)
+        {
+            return a->start != b->start ? a->start < b->start : a->depth < b->depth;
+        });
+
+        ImGui::PushID(static_cast<int>(track.id));
+        size_t rows = std::min(zones.size(), ProfilerState::max_zone_rows);
+        for (size_t i = 0; i < rows; i++)
+        {
+            auto& zone = *zones[i];
+            ImGui::Text("%*s%s", zone.depth * 2, "", zone.name);
+            ImGui::SameLine(std::max(200.0f, ImGui::GetWindowWidth() - 110.0f));
+            ImGui::Text("%8.3f ms", static_cast<double>(zone.end - zone.start) / 1000000.0);
+        }
+        if (zones.size() > rows)
+        {
+            ImGui::Text("... %zu more zones", zones.size() - rows);
+        }
+        ImGui::PopID();
+    }
+
+    ImGui::End();
+}
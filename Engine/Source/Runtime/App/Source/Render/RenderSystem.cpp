@@ -1,18 +1,40 @@
 #include "Render/RenderSystem.hpp"
 
+#include <algorithm>
+#include <filesystem>
+
 #include "Framework/Core/CommandBuffer.hpp"
 #include "Framework/Core/Queue.hpp"
+#include "Framework/Misc/PipelineCompiler.hpp"
 #include "Framework/Platform/Window.hpp"
 #include "Framework/Rendering/RenderFrame.hpp"
+#include "Framework/Rendering/RenderGraph.hpp"
 #include "Framework/Rendering/Subpass.hpp"
+#include "Framework/Rendering/Subpasses/IndirectDrawSubpass.hpp"
+#include "Misc/FileLoader.hpp"
+#include "Misc/Paths.hpp"
+#include "Profiler/Profiler.hpp"
 #include "Render/EditorUI.hpp"
+#include "SceneGraph/Components/Image/TextureCooker.h"
+#include "SubSystems/GlslCompiler.hpp"
+#include "SubSystems/JobSystem.hpp"
 
 RenderSystem::~RenderSystem()
 {
     Finish();
+    SavePipelineCache();
+    scene_renderer.reset();
+    upload_manager.reset();
     wRenderpass.reset();
     EditorUI.reset();
+    render_graph.reset();
+    gpu_profiler.reset();
     render_context.reset();
+    if (device)
+    {
+        device->get_resource_cache().set_bindless_table(nullptr);
+    }
+    bindless_table.reset();
     device.reset();
 
     if (surface)
@@ -81,6 +103,29 @@ bool RenderSystem::Prepare(const ApplicationOptions& options)
         gpu.get_mutable_requested_features().textureCompressionASTC_LDR = true;
     }
 
+    if (gpu.get_features().textureCompressionBC)
+    {
+        gpu.get_mutable_requested_features().textureCompressionBC = true;
+    }
+
+    // Cook textures into the block format family the GPU samples natively
+    {
+        auto cooker_settings = vkb::sg::TextureCooker::get_settings();
+        if (gpu.get_features().textureCompressionBC)
+        {
+            cooker_settings.target = vkb::sg::TextureCooker::Target::BC;
+        }
+        else if (gpu.get_features().textureCompressionASTC_LDR)
+        {
+            cooker_settings.target = vkb::sg::TextureCooker::Target::ASTC;
+        }
+        else
+        {
+            cooker_settings.enabled = false;
+        }
+        vkb::sg::TextureCooker::set_settings(cooker_settings);
+    }
+
     RequestGpuFeatures(gpu);
 
     // Creating vulkan device, specifying the swapchain extension always
@@ -93,6 +138,24 @@ bool RenderSystem::Prepare(const ApplicationOptions& options)
             AddDeviceExtension(VK_KHR_DISPLAY_SWAPCHAIN_EXTENSION_NAME, /*optional=*/true);
         }
     }
+
+    // Bindless resources, the renderer falls back to per-draw descriptor sets without them
+    bindless_supported = vkb::BindlessDescriptorTable::request_features(gpu);
+    if (bindless_supported)
+    {
+        AddDeviceExtension(VK_KHR_MAINTENANCE3_EXTENSION_NAME, /*optional=*/true);
+        AddDeviceExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, /*optional=*/true);
+    }
+
+    // GPU-driven draws, IndirectDrawSubpass submits one draw per instance without the count extension
+    indirect_draw_supported = vkb::IndirectDrawSubpass::request_features(gpu);
+    if (indirect_draw_supported)
+    {
+        AddDeviceExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, /*optional=*/true);
+    }
+
+    // Places the GPU zones of the profiler exactly on the CPU timeline
+    AddDeviceExtension(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME, /*optional=*/true);
     // TODO
 #ifdef VKB_ENABLE_PORTABILITY
     // VK_KHR_portability_subset must be enabled if present in the implementation (e.g on macOS/iOS with beta extensions enabled)
@@ -133,8 +196,37 @@ bool RenderSystem::Prepare(const ApplicationOptions& options)
     }
     device = CreateDevice(gpu);
     //VULKAN_HPP_DEFAULT_DISPATCHER.init(device->GetHandle());
+
+    // Registered before any pipeline layout is created, including the ones the warmup replays
+    if (bindless_supported && device->is_enabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+    {
+        bindless_table = std::make_unique<vkb::BindlessDescriptorTable>(*device);
+        device->get_resource_cache().set_bindless_table(bindless_table.get());
+    }
+
+    LoadPipelineCache();
+
+    // Pipelines first requested while recording are compiled in the background instead of stalling the frame
+    // Half of the workers at most, the others stay free for the work of the frame
+    uint32_t worker_count = JobSystem::GetInstance().GetWorkerCount();
+    device->get_resource_cache().set_async_pipeline_compilation(std::max(1u, worker_count / 2));
     CreateRenderContext();
-    render_context->prepare(1, vkb::RenderTarget::ONE_IMAGE_FUNC);
+
+    // Every frame keeps command, descriptor and buffer pools per recording thread
+    uint32_t recording_thread_count = std::clamp(worker_count + 1, 1u, 16u);
+    render_context->prepare(recording_thread_count, vkb::RenderTarget::ONE_IMAGE_FUNC);
+    if (recording_thread_count > 1)
+    {
+        command_recorder = std::make_unique<vkb::ParallelCommandRecorder>(recording_thread_count);
+    }
+
+    render_graph = std::make_unique<vkb::RenderGraph>(*device, static_cast<uint32_t>(render_context->get_render_frames().size()));
+
+    gpu_profiler = std::make_unique<vkb::GpuProfiler>(*device, static_cast<uint32_t>(render_context->get_render_frames().size()));
+    if (gpu_profiler->is_supported())
+    {
+        render_graph->set_gpu_profiler(gpu_profiler.get());
+    }
 
     // stats = std::make_unique<vkb::stats::HPPStats>(*render_context);
 
@@ -143,13 +235,41 @@ bool RenderSystem::Prepare(const ApplicationOptions& options)
 
     std::set<VkImageUsageFlagBits> usage = {VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT};
     GetRenderContext().update_swapchain(usage);
+    render_graph_swapchain_generation = render_context->get_swapchain_generation();
+
+    upload_manager = std::make_unique<vkb::UploadManager>(*device);
+
+    if (!options.scene_path.empty())
+    {
+        bool gpu_driven = options.gpu_driven && indirect_draw_supported;
+        if (options.gpu_driven && !gpu_driven)
+        {
+            LOGW("The GPU has no multiDrawIndirect or drawIndirectFirstInstance, the scene is drawn from the CPU");
+        }
+
+        scene_renderer = std::make_unique<SceneRenderer>(*render_context);
+        try
+        {
+            scene_renderer->Load(options.scene_path, options.compact_vertices
+                                                         ? vkb::sg::VertexLayout::compact()
+                                                         : vkb::sg::VertexLayout::full(),
+                                 upload_manager.get(), gpu_driven);
+            scene_renderer->SetCullValidation(options.validate_culling);
+        }
+        catch (const std::exception& e)
+        {
+            LOGE("Failed to load the scene {}: {}", options.scene_path, e.what());
+            scene_renderer.reset();
+        }
+    }
 
     EditorUI = std::make_unique<EditorUIManager>(*device);
 
+    // The editor UI is drawn over the scene when there is one
     auto rp = vks::RenderPassBuilder(device->GetHandle())
               .addAttachment(
                   render_context->get_format(), VK_SAMPLE_COUNT_1_BIT,
-                  VK_ATTACHMENT_LOAD_OP_CLEAR,
+                  scene_renderer ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR,
                   VK_ATTACHMENT_STORE_OP_STORE,
                   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) //Type conversions are all explicit.
@@ -236,36 +356,39 @@ std::unique_ptr<vkb::VulkanDevice> RenderSystem::CreateDevice(vkb::PhysicalDevic
 
 void RenderSystem::Draw(vkb::CommandBuffer& command_buffer, vkb::RenderTarget& render_target)
 {
-    auto& views = render_target.get_views();
-
+    // A recreated swapchain can keep its extent and format, the compiled graph would keep framebuffers of destroyed views
+    if (render_graph_swapchain_generation != render_context->get_swapchain_generation())
     {
-        // Image 0 is the swapchain
-        vkb::ImageMemoryBarrier memory_barrier{};
-        memory_barrier.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
-        memory_barrier.new_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        memory_barrier.src_access_mask = 0;
-        memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-        memory_barrier.src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-        command_buffer.image_memory_barrier(views[0], memory_barrier);
-        render_target.set_layout(0, memory_barrier.new_layout);
+        render_graph->clear();
+        render_graph_swapchain_generation = render_context->get_swapchain_generation();
     }
 
-    // draw_renderpass is a virtual function, thus we have to call that, instead of directly calling draw_renderpass_impl!
-    DrawRenderpass(command_buffer, render_target);
+    // The graph derives the transitions of the swapchain image, it is compiled once and replayed while the passes stay the same
+    render_graph->reset();
 
-    {
-        vkb::ImageMemoryBarrier memory_barrier{};
-        memory_barrier.old_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        memory_barrier.new_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-        memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-        memory_barrier.src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    // Image 0 is the swapchain, acquired by a semaphore wait at the color attachment output stage
+    auto backbuffer = render_graph->import_image("Backbuffer", render_target.get_views()[0],
+                                                 VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
-        command_buffer.image_memory_barrier(views[0], memory_barrier);
-        render_target.set_layout(0, memory_barrier.new_layout);
+    if (scene_renderer)
+    {
+        scene_renderer->AddPasses(*render_graph, backbuffer, render_target.get_extent());
     }
+
+    // The editor UI begins its own render pass, so the backbuffer is declared as a use instead of an attachment
+    render_graph->add_pass("EditorUI", vkb::RenderGraphPass::Type::Graphics)
+                .use(backbuffer, vkb::RenderGraphAccess::ColorAttachment)
+                .set_execute([this, &render_target](vkb::CommandBuffer& cb)
+                {
+                    // draw_renderpass is a virtual function, thus we have to call that, instead of directly calling draw_renderpass_impl!
+                    DrawRenderpass(cb, render_target);
+                });
+
+    render_graph->compile();
+    render_graph->execute(command_buffer);
+
+    render_target.set_layout(0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 }
 
 void RenderSystem::Render(vkb::CommandBuffer& command_buffer)
@@ -305,11 +428,22 @@ void RenderSystem::DrawRenderpass(vkb::CommandBuffer& command_buffer, vkb::Rende
 
 void RenderSystem::Update(float delta_time)
 {
+    WaitForWarmup();
+
+    if (bindless_table)
+    {
+        bindless_table->next_frame();
+    }
+
     UpdateScene(delta_time);
 
     //update_gui(delta_time);
 
-    auto command_buffer = render_context->begin();
+    std::shared_ptr<vkb::CommandBuffer> command_buffer;
+    {
+        PROFILE_SCOPE("Wait for frame");
+        command_buffer = render_context->begin();
+    }
 
     // Collect the performance data for the sample graphs
     //update_stats(delta_time);
@@ -317,16 +451,44 @@ void RenderSystem::Update(float delta_time)
     command_buffer->begin(VkCommandBufferUsageFlagBits::VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
     //stats->begin_sampling(*command_buffer);
 
-    Draw(*command_buffer, render_context->get_active_frame().get_render_target());
+    {
+        PROFILE_SCOPE("Record");
+        gpu_profiler->begin_frame(*command_buffer, render_context->get_active_frame_index());
+        vkb::ScopedGpuZone frame_zone{gpu_profiler.get(), *command_buffer, "Frame"};
+
+        // Resources uploaded on the transfer queue become usable by the passes of this frame
+        upload_manager->acquire(*command_buffer);
+
+        Draw(*command_buffer, render_context->get_active_frame().get_render_target());
+    }
 
     //stats->end_sampling(*command_buffer);
     command_buffer->end();
 
-    render_context->submit(command_buffer);
+    {
+        PROFILE_SCOPE("Submit");
+        render_context->submit(command_buffer);
+    }
+
+    if (auto* compiler = device->get_resource_cache().get_pipeline_compiler())
+    {
+        auto stats = compiler->next_frame();
+        PROFILE_PLOT("Pipelines pending", stats.pending);
+        if (stats.pending > 0 || stats.waited_draws > 0)
+        {
+            LOGD("Pipelines compiling: {} pending, {} queued, {} completed, {} fallback draws, {} waited draws",
+                 stats.pending, stats.queued, stats.completed, stats.fallback_draws, stats.waited_draws);
+        }
+    }
 }
 
 void RenderSystem::UpdateScene(float delta_time)
 {
+    if (scene_renderer)
+    {
+        scene_renderer->Update(render_context->get_surface_extent());
+    }
+
     /*if (scene)
     {
         // Update scripts
@@ -390,6 +552,134 @@ void RenderSystem::Finish()
     }
 }
 
+namespace
+{
+    std::filesystem::path GetPipelineCacheDirectory()
+    {
+        return std::filesystem::path{Paths::GetAssetPath()}.parent_path() / "Cache" / "Pipelines";
+    }
+
+    std::vector<uint8_t> ReadCacheFile(const std::filesystem::path& path)
+    {
+        try
+        {
+            if (std::filesystem::exists(path))
+            {
+                return FileLoader::ReadFileBinary(path);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            LOGW("Ignoring cache file {}: {}", path.string(), e.what());
+        }
+
+        return {};
+    }
+}
+
+void RenderSystem::LoadPipelineCache()
+{
+    auto directory = GetPipelineCacheDirectory();
+
+    // Shader variants compiled at runtime are kept next to the pipeline cache, keyed by their source and defines
+    auto& glsl_compiler = GlslCompiler::GetInstance();
+    glsl_compiler.SetCacheDirectory(directory.parent_path() / "Shaders");
+    glsl_compiler.AddIncludeDirectory(Paths::GetShaderPath());
+
+    pipeline_cache = std::make_unique<vkb::PipelineCache>(*device, ReadCacheFile(directory / "pipeline_cache.bin"));
+    device->get_resource_cache().set_pipeline_cache(pipeline_cache->get_handle());
+
+    // Every variant used by earlier runs, compiled before the replay so none of its modules compile on demand
+    auto& variant_usage = device->get_resource_cache().get_variant_usage();
+    auto variants = ReadCacheFile(directory / "shader_variants.bin");
+    if (!variants.empty() && !variant_usage.load(variants))
+    {
+        LOGW("Shader variant list of the last run is outdated, it is rebuilt during this run");
+    }
+
+    auto resources = ReadCacheFile(directory / "resources.bin");
+    if (resources.empty() && variant_usage.get_variants().empty())
+    {
+        return;
+    }
+
+    JobSystem::GetInstance().Run([this, resources = std::move(resources)]()
+    {
+        auto& resource_cache = device->get_resource_cache();
+
+        resource_cache.get_variant_usage().precompile();
+
+        auto stats = GlslCompiler::GetInstance().GetStats();
+        LOGI("Shader variants precompiled: {} compiled, {} from the disk cache, {} failed", stats.compiled,
+             stats.disk_hits, stats.failed);
+
+        if (!resources.empty() && !resource_cache.warmup(resources))
+        {
+            LOGW("Resource cache of the last run is outdated, it is rebuilt during this run");
+        }
+    }, &resource_warmup);
+}
+
+void RenderSystem::WaitForWarmup()
+{
+    if (!resource_warmup.IsDone())
+    {
+        // A failed warmup only means the rest is compiled on demand
+        try
+        {
+            JobSystem::GetInstance().Wait(resource_warmup);
+            LOGI("Resource cache warmup finished");
+        }
+        catch (const std::exception& e)
+        {
+            LOGW("Resource cache warmup failed: {}", e.what());
+        }
+    }
+}
+
+void RenderSystem::SavePipelineCache()
+{
+    if (!device || !pipeline_cache)
+    {
+        return;
+    }
+
+    // The replay and background compilations may still be running when the application quits during loading
+    try
+    {
+        JobSystem::GetInstance().Wait(resource_warmup);
+    }
+    catch (const std::exception& e)
+    {
+        LOGW("Resource cache warmup failed: {}", e.what());
+    }
+    if (auto* compiler = device->get_resource_cache().get_pipeline_compiler())
+    {
+        compiler->wait_idle();
+    }
+
+    auto directory = GetPipelineCacheDirectory();
+
+    try
+    {
+        auto pipeline_data = pipeline_cache->serialize();
+        FileLoader::WriteFileBinary(directory / "pipeline_cache.bin", pipeline_data.data(), pipeline_data.size());
+
+        auto resource_data = device->get_resource_cache().serialize();
+        FileLoader::WriteFileBinary(directory / "resources.bin", resource_data.data(), resource_data.size());
+
+        auto variant_data = device->get_resource_cache().get_variant_usage().serialize();
+        FileLoader::WriteFileBinary(directory / "shader_variants.bin", variant_data.data(), variant_data.size());
+    }
+    catch (const std::exception& e)
+    {
+        LOGW("Failed to save the pipeline cache: {}", e.what());
+    }
+
+    device->get_resource_cache().set_pipeline_cache(VK_NULL_HANDLE);
+    pipeline_cache.reset();
+}
+
 
 void RenderSystem::SetViewportAndScissor(vkb::CommandBuffer const& command_buffer, VkExtent2D const& extent)
 {
@@ -474,6 +764,11 @@ void RenderSystem::SetRenderContext(std::unique_ptr<vkb::RenderContext>&& rc)
 void RenderSystem::SetRenderPipeline(std::unique_ptr<vkb::RenderPipeline>&& rp)
 {
     render_pipeline.reset(rp.release());
+
+    if (render_pipeline)
+    {
+        render_pipeline->set_command_recorder(command_recorder.get());
+    }
 }
 
 void RenderSystem::AddDeviceExtension(const char* extension, bool optional)
@@ -0,0 +1,473 @@
+#include "Render/SceneRenderer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Core/BindlessDescriptorTable.hpp"
+#include "Framework/Misc/MeshArena.hpp"
+#include "Framework/Misc/ResourceCache.hpp"
+#include "Framework/Rendering/RenderContext.hpp"
+#include "Import/GLTFLoader.hpp"
+#include "Logging/Logger.hpp"
+#include "Profiler/Profiler.hpp"
+#include "SceneGraph/Node.h"
+#include "SceneGraph/Scene.h"
+#include "SceneGraph/Components/Image.h"
+#include "SceneGraph/Components/Light.h"
+#include "SceneGraph/Components/Mesh.h"
+#include "SceneGraph/Components/Pbr_Material.h"
+#include "SceneGraph/Components/PerspectiveCamera.h"
+#include "SceneGraph/Components/Sampler.h"
+#include "SceneGraph/Components/SubMesh.h"
+#include "Streaming/TextureStreamer.h"
+
+SceneRenderer::SceneRenderer(vkb::RenderContext& render_context) :
+    render_context{render_context}
+{
+    auto& device = render_context.get_device();
+
+    depth_format = vkb::get_suitable_depth_format(device.get_gpu().get_handle(), true);
+
+    const glm::vec3 normal{0.0f, 0.0f, 1.0f};
+    default_normal = std::make_unique<vkb::Buffer>(device, sizeof(normal), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                   VMA_MEMORY_USAGE_CPU_TO_GPU);
+    default_normal->update(&normal, sizeof(normal));
+    default_normal->SetDebugName("Default normal");
+
+    const glm::vec2 texcoord{0.0f};
+    default_texcoord = std::make_unique<vkb::Buffer>(device, sizeof(texcoord), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                     VMA_MEMORY_USAGE_CPU_TO_GPU);
+    default_texcoord->update(&texcoord, sizeof(texcoord));
+    default_texcoord->SetDebugName("Default texcoord");
+}
+
+SceneRenderer::~SceneRenderer()
+{
+    // The scene buffers may still be read by frames in flight
+    render_context.get_device().wait_idle();
+
+    draw_list.reset();
+    indirect_draw.reset();
+    mesh_arena.reset();
+
+    if (scene && texture_streamer)
+    {
+        for (auto* image : scene->get_components<vkb::sg::Image>())
+        {
+            texture_streamer->unregister_image(*image);
+        }
+    }
+    texture_streamer.reset();
+
+    // The loader gave every image and sampler of the scene a slot
+    if (auto* bindless_table = render_context.get_device().get_resource_cache().get_bindless_table(); scene && bindless_table)
+    {
+        for (auto* image : scene->get_components<vkb::sg::Image>())
+        {
+            if (image->get_bindless_handle().is_valid())
+            {
+                bindless_table->release_texture(image->get_bindless_handle());
+            }
+        }
+
+        for (auto* sampler : scene->get_components<vkb::sg::Sampler>())
+        {
+            if (sampler->bindless_handle.is_valid())
+            {
+                bindless_table->release_sampler(sampler->bindless_handle);
+            }
+        }
+    }
+
+    scene.reset();
+}
+
+void SceneRenderer::Load(const std::string& path, const vkb::sg::VertexLayout& vertex_layout,
+                         vkb::UploadManager* upload_manager, bool gpu_driven)
+{
+    auto& device = render_context.get_device();
+
+    // Only the tail levels are uploaded by the loader, the rest is streamed in once it is seen
+    texture_streamer = std::make_unique<vkb::TextureStreamer>(device);
+
+    vkb::GLTFLoader loader{device};
+    loader.set_vertex_layout(vertex_layout);
+    loader.set_texture_streamer(texture_streamer.get());
+    loader.set_upload_manager(upload_manager);
+    loader.set_build_mesh_arena(gpu_driven);
+
+    scene = loader.read_scene_from_file(path);
+    if (!scene)
+    {
+        throw std::runtime_error("Failed to load the scene " + path);
+    }
+
+    if (gpu_driven)
+    {
+        mesh_arena = loader.take_mesh_arena();
+        if (!mesh_arena)
+        {
+            throw std::runtime_error("The scene " + path + " has no triangle lists to draw GPU driven");
+        }
+
+        indirect_draw = std::make_unique<vkb::IndirectDrawSubpass>(render_context, *mesh_arena);
+        indirect_draw->set_debug_name("Scene");
+        indirect_draw->get_depth_stencil_state().depth_compare_op = VK_COMPARE_OP_GREATER_OR_EQUAL;
+        indirect_draw->prepare();
+    }
+    else
+    {
+        draw_list = std::make_unique<vkb::DrawListSubpass>(render_context);
+        draw_list->set_debug_name("Scene");
+
+        // Reversed depth like the scene graph cameras
+        draw_list->get_depth_stencil_state().depth_compare_op = VK_COMPARE_OP_GREATER_OR_EQUAL;
+        draw_list->set_bindless_textures(device.get_resource_cache().get_bindless_table() != nullptr);
+        draw_list->prepare();
+    }
+
+    std::unordered_map<const vkb::sg::SubMesh*, uint32_t> meshes;
+
+    glm::vec3 scene_min{std::numeric_limits<float>::max()};
+    glm::vec3 scene_max{std::numeric_limits<float>::lowest()};
+
+    std::vector<vkb::DrawListSubpass::DrawItem> draw_items;
+
+    for (auto* mesh : scene->get_components<vkb::sg::Mesh>())
+    {
+        const auto& bounds = mesh->get_bounds();
+        bool has_bounds = glm::all(glm::lessThanEqual(bounds.get_min(), bounds.get_max()));
+
+        for (auto* node : mesh->get_nodes())
+        {
+            glm::mat4 world = node->get_transform().get_world_matrix();
+
+            if (has_bounds)
+            {
+                for (uint32_t corner = 0; corner < 8; corner++)
+                {
+                    glm::vec3 local{corner & 1 ? bounds.get_max().x : bounds.get_min().x,
+                                    corner & 2 ? bounds.get_max().y : bounds.get_min().y,
+                                    corner & 4 ? bounds.get_max().z : bounds.get_min().z};
+                    glm::vec3 position = glm::vec3(world * glm::vec4(local, 1.0f));
+                    scene_min = glm::min(scene_min, position);
+                    scene_max = glm::max(scene_max, position);
+                }
+            }
+
+            for (auto* submesh : mesh->get_submeshes())
+            {
+                if (indirect_draw)
+                {
+                    if (submesh->arena_mesh == ~0u)
+                    {
+                        continue;
+                    }
+
+                    meshes.emplace(submesh, submesh->arena_mesh);
+                    indirect_draw->get_instances().push_back({world, submesh->arena_mesh, GetMaterial(submesh->get_material())});
+                    continue;
+                }
+
+                auto it = meshes.find(submesh);
+                if (it == meshes.end())
+                {
+                    vkb::DrawListSubpass::Mesh draw_mesh;
+                    if (!CreateMesh(*submesh, draw_mesh))
+                    {
+                        LOGW("Submesh {} is not drawn, it has no positions or no indices", submesh->get_name());
+                        meshes.emplace(submesh, std::numeric_limits<uint32_t>::max());
+                        continue;
+                    }
+                    it = meshes.emplace(submesh, draw_list->add_mesh(draw_mesh)).first;
+                }
+
+                if (it->second == std::numeric_limits<uint32_t>::max())
+                {
+                    continue;
+                }
+
+                draw_items.push_back({it->second, GetMaterial(submesh->get_material()), world});
+            }
+        }
+    }
+
+    // Fewer rebinds, the draws of a material and mesh are recorded together
+    std::sort(draw_items.begin(), draw_items.end(), [](const auto& a, const auto& b)
+    {
+        return a.material != b.material ? a.material < b.material : a.mesh < b.mesh;
+    });
+
+    size_t draw_count = indirect_draw ? indirect_draw->get_instances().size() : draw_items.size();
+    if (draw_list)
+    {
+        draw_list->get_draw_items() = std::move(draw_items);
+    }
+
+    if (glm::all(glm::lessThanEqual(scene_min, scene_max)))
+    {
+        bounding_sphere = glm::vec4{(scene_min + scene_max) * 0.5f, std::max(glm::length(scene_max - scene_min) * 0.5f, 0.01f)};
+    }
+
+    FrameScene();
+
+    LOGI("Loaded scene {}: {} draws of {} meshes, {} materials{}", path, draw_count, meshes.size(), materials.size(),
+         indirect_draw ? ", GPU driven" : vertex_layout.is_compact() ? ", compact vertices" : "");
+}
+
+void SceneRenderer::SetCullValidation(bool enabled)
+{
+    if (indirect_draw)
+    {
+        indirect_draw->set_cull_validation(enabled);
+    }
+}
+
+bool SceneRenderer::HasScene() const
+{
+    return draw_list || indirect_draw;
+}
+
+void SceneRenderer::Update(const VkExtent2D& extent)
+{
+    if (!HasScene() || !camera)
+    {
+        return;
+    }
+
+    if (auto* perspective = dynamic_cast<vkb::sg::PerspectiveCamera*>(camera))
+    {
+        perspective->set_aspect_ratio(static_cast<float>(extent.width) / static_cast<float>(std::max(extent.height, 1u)));
+    }
+
+    glm::mat4 view = camera->get_view();
+    glm::vec3 camera_position = glm::vec3(glm::inverse(view)[3]);
+
+    vkb::DrawListSubpass::SceneUniform scene_uniform{vkb::vulkan_style_projection(camera->get_projection()), view,
+                                                     glm::vec4{camera_position, 1.0f}};
+
+    // The first light of the scene, directional lights are placed far away against their direction
+    vkb::DrawListSubpass::LightUniform light{glm::vec4{camera_position, 1.0f}, glm::vec3{1.0f}, 0.1f};
+    auto lights = scene->get_components<vkb::sg::Light>();
+    if (!lights.empty() && lights[0]->get_node())
+    {
+        auto* scene_light = lights[0];
+        glm::mat4 world = scene_light->get_node()->get_transform().get_world_matrix();
+        const auto& properties = scene_light->get_properties();
+
+        glm::vec3 position = glm::vec3(world[3]);
+        if (scene_light->get_light_type() == vkb::sg::LightType::Directional)
+        {
+            glm::vec3 direction = glm::normalize(glm::vec3(world * glm::vec4{0.0f, 0.0f, -1.0f, 0.0f}));
+            position = glm::vec3(bounding_sphere) - direction * bounding_sphere.w * 10.0f;
+        }
+
+        light.position = glm::vec4{position, 1.0f};
+        light.color = properties.color * std::min(properties.intensity, 1.0f);
+    }
+    if (indirect_draw)
+    {
+        indirect_draw->set_scene(scene_uniform);
+        indirect_draw->set_light(light);
+    }
+    else
+    {
+        draw_list->set_scene(scene_uniform);
+        draw_list->set_light(light);
+    }
+
+    // Streamed images move to a new bindless slot when they are reallocated
+    if (draw_list)
+    {
+        for (auto& [material, index] : materials)
+        {
+            if (auto* pbr = dynamic_cast<const vkb::sg::PBRMaterial*>(material))
+            {
+                auto indices = pbr->get_bindless_indices();
+                draw_list->set_material_textures(index, {indices.base_color, indices.sampler});
+            }
+        }
+    }
+
+    texture_streamer->request_visible(*scene, *camera, extent);
+}
+
+void SceneRenderer::AddPasses(vkb::RenderGraph& render_graph, vkb::RenderGraphImage backbuffer, const VkExtent2D& extent)
+{
+    if (!HasScene())
+    {
+        return;
+    }
+
+    // Copies into images the graph does not track, the pass is kept although nothing in the graph reads it
+    render_graph.add_pass("TextureStreaming", vkb::RenderGraphPass::Type::Transfer)
+                .set_side_effect(true)
+                .set_execute([this](vkb::CommandBuffer& command_buffer)
+                {
+                    texture_streamer->update(command_buffer);
+                    PROFILE_PLOT("Streamed textures (MB)", texture_streamer->get_stats().resident_bytes / (1024.0 * 1024.0));
+                });
+
+    vkb::RenderGraphImageDesc depth_desc;
+    depth_desc.extent = extent;
+    depth_desc.format = depth_format;
+    auto depth = render_graph.create_image("Scene depth", depth_desc);
+
+    VkClearValue color_clear{};
+    color_clear.color = {{0.1f, 0.1f, 0.1f, 1.0f}};
+
+    VkClearValue depth_clear{};
+    depth_clear.depthStencil = {0.0f, 0};
+
+    if (!indirect_draw)
+    {
+        render_graph.add_pass("Scene", vkb::RenderGraphPass::Type::Graphics)
+                    .add_color_attachment(backbuffer, {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE}, color_clear)
+                    .set_depth_attachment(depth, {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE}, depth_clear)
+                    .set_execute([this](vkb::CommandBuffer& command_buffer)
+                    {
+                        draw_list->draw(command_buffer);
+                    });
+        return;
+    }
+
+    // Writes the draw buffers the subpass owns, the graph does not see them
+    render_graph.add_pass("Cull", vkb::RenderGraphPass::Type::Compute)
+                .set_side_effect(true)
+                .set_execute([this](vkb::CommandBuffer& command_buffer)
+                {
+                    indirect_draw->cull(command_buffer);
+                });
+
+    render_graph.add_pass("Scene", vkb::RenderGraphPass::Type::Graphics)
+                .add_color_attachment(backbuffer, {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE}, color_clear)
+                .set_depth_attachment(depth, {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE}, depth_clear)
+                .set_execute([this](vkb::CommandBuffer& command_buffer)
+                {
+                    indirect_draw->draw(command_buffer);
+                });
+
+    // The pyramid is read by the culling of the next frame
+    render_graph.add_pass("DepthPyramid", vkb::RenderGraphPass::Type::Compute)
+                .use(depth, vkb::RenderGraphAccess::SampledImage)
+                .set_side_effect(true)
+                .set_execute([this, &render_graph, depth](vkb::CommandBuffer& command_buffer)
+                {
+                    indirect_draw->build_depth_pyramid(command_buffer, render_graph.get_image_view(depth));
+                });
+}
+
+bool SceneRenderer::CreateMesh(const vkb::sg::SubMesh& submesh, vkb::DrawListSubpass::Mesh& mesh) const
+{
+    if (!submesh.index_buffer || submesh.vertex_indices == 0)
+    {
+        return false;
+    }
+
+    std::vector<const vkb::Buffer*> buffers;
+
+    // Locations of BlinnPhong.vert, the compact layout interleaves them in "vertex_buffer"
+    const char* attribute_names[] = {"position", "normal", "texcoord_0"};
+    for (uint32_t location = 0; location < 3; location++)
+    {
+        vkb::sg::VertexAttribute attribute;
+        const vkb::Buffer* buffer = nullptr;
+
+        if (submesh.get_attribute(attribute_names[location], attribute))
+        {
+            auto it = submesh.vertex_buffers.find(attribute_names[location]);
+            if (it == submesh.vertex_buffers.end())
+            {
+                it = submesh.vertex_buffers.find("vertex_buffer");
+            }
+            buffer = it != submesh.vertex_buffers.end() ? &it->second : nullptr;
+        }
+
+        if (!buffer)
+        {
+            if (location == 0)
+            {
+                return false;
+            }
+
+            buffer = location == 1 ? default_normal.get() : default_texcoord.get();
+            attribute.format = location == 1 ? VK_FORMAT_R32G32B32_SFLOAT : VK_FORMAT_R32G32_SFLOAT;
+            attribute.stride = 0;
+            attribute.offset = 0;
+        }
+
+        auto binding = static_cast<uint32_t>(std::find(buffers.begin(), buffers.end(), buffer) - buffers.begin());
+        if (binding == buffers.size())
+        {
+            buffers.push_back(buffer);
+            mesh.vertex_input_state.bindings.push_back({binding, attribute.stride, VK_VERTEX_INPUT_RATE_VERTEX});
+        }
+
+        mesh.vertex_input_state.attributes.push_back({location, binding, attribute.format, attribute.offset});
+    }
+
+    mesh.vertex_buffer = buffers[0];
+    mesh.extra_vertex_buffers.assign(buffers.begin() + 1, buffers.end());
+    mesh.index_buffer = submesh.index_buffer.get();
+    mesh.index_count = submesh.vertex_indices;
+    mesh.index_type = submesh.index_type;
+    mesh.shader_variant = submesh.get_shader_variant();
+    mesh.position_offset = submesh.position_dequantization.offset;
+    mesh.position_scale = submesh.position_dequantization.scale;
+
+    return true;
+}
+
+uint32_t SceneRenderer::GetMaterial(const vkb::sg::Material* material)
+{
+    auto it = materials.find(material);
+    if (it != materials.end())
+    {
+        return it->second;
+    }
+
+    // Blinn-Phong approximation of the metallic roughness factors
+    glm::vec4 base_color{0.8f, 0.8f, 0.8f, 1.0f};
+    float roughness = 1.0f;
+    if (auto* pbr = dynamic_cast<const vkb::sg::PBRMaterial*>(material))
+    {
+        base_color = pbr->base_color_factor;
+        roughness = pbr->roughness_factor;
+    }
+
+    vkb::DrawListSubpass::MaterialUniform uniform;
+    uniform.ambient = base_color;
+    uniform.diffuse = base_color;
+    uniform.specular = glm::vec3{0.5f * (1.0f - roughness)};
+    uniform.shininess = glm::mix(128.0f, 4.0f, roughness);
+
+    uint32_t index = indirect_draw ? indirect_draw->add_material(uniform) : draw_list->add_material(uniform);
+    materials.emplace(material, index);
+    return index;
+}
+
+void SceneRenderer::FrameScene()
+{
+    auto* camera_node = scene->find_node("default_camera");
+    if (!camera_node || !camera_node->has_component<vkb::sg::Camera>())
+    {
+        LOGW("The scene has no default camera, it is not drawn");
+        return;
+    }
+
+    camera = &camera_node->get_component<vkb::sg::Camera>();
+
+    // Looks down -z at the bounds from far enough to see all of them
+    float distance = bounding_sphere.w * 2.5f;
+    camera_node->get_transform().set_translation(glm::vec3(bounding_sphere) + glm::vec3{0.0f, 0.0f, distance});
+    camera_node->get_transform().set_rotation(glm::quat{1.0f, 0.0f, 0.0f, 0.0f});
+
+    if (auto* perspective = dynamic_cast<vkb::sg::PerspectiveCamera*>(camera))
+    {
+        perspective->set_near_plane(std::max(distance - bounding_sphere.w * 2.0f, distance * 0.01f));
+        perspective->set_far_plane(distance + bounding_sphere.w * 2.0f);
+    }
+}
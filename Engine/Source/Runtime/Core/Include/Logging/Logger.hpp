@@ -1,12 +1,19 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/rotating_file_sink.h>
-#include <spdlog/async.h>
 #include "spdlog/fmt/fmt.h"
 
 enum class LogLevel
@@ -20,43 +27,295 @@ enum class LogLevel
     LogOFF = spdlog::level::off
 };
 
+/**
+ * Calls below this level are compiled out, their arguments are never evaluated.
+ * Defaults to debug in debug builds and info in release builds, the CYRENGINE_LOG_LEVEL
+ * CMake cache variable overrides it with a LogLevel value (0 trace ... 6 off).
+ */
+#ifndef CYR_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define CYR_LOG_ACTIVE_LEVEL 2
+#else
+#define CYR_LOG_ACTIVE_LEVEL 1
+#endif
+#endif
+
+/**
+ * Messages of one subsystem, with a runtime level of its own and a budget of messages per second.
+ * Messages over the budget are dropped and counted, the count is logged once the next second starts.
+ * Errors and criticals are never dropped. Channels are meant to be statics of the subsystem's files.
+ */
+class LogChannel
+{
+public:
+    explicit LogChannel(const char *name, uint32_t max_per_second = 0, LogLevel level = LogLevel::LogTRACE);
+
+    LogChannel(const LogChannel &) = delete;
+
+    LogChannel &operator=(const LogChannel &) = delete;
+
+    const char *GetName() const { return name_; }
+
+    void SetLevel(LogLevel level) { level_.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+    /// 0 disables the rate limit
+    void SetRateLimit(uint32_t max_per_second) { max_per_second_.store(max_per_second, std::memory_order_relaxed); }
+
+    /**
+     * Checks the level and takes one message from the budget of the current second
+     */
+    bool Admit(LogLevel level);
+
+private:
+    const char *name_;
+
+    std::atomic<int> level_;
+
+    std::atomic<uint32_t> max_per_second_;
+
+    /// Second the budget is counted for, since the steady clock epoch
+    std::atomic<int64_t> window_{0};
+
+    std::atomic<uint32_t> count_{0};
+
+    std::atomic<uint32_t> suppressed_{0};
+};
+
+/**
+ * Where a log call is, filled in by the LOG macros
+ */
+struct LogSite
+{
+    spdlog::source_loc location;
+
+    const LogChannel *channel{nullptr};
+
+    /// Prefixes the message with file and line, for the LOG_*_P macros
+    bool print_location{false};
+};
+
+/**
+ * A message waiting in the queue of its thread. The arguments are captured in storage in binary form
+ * and formatted by the logging thread, arguments that cannot be copied safely are formatted by the
+ * calling thread and stored as a string.
+ */
+struct LogRecord
+{
+    static constexpr size_t StorageSize = 192;
+
+    using FormatFunc = void (*)(const LogRecord &record, fmt::memory_buffer &out);
+
+    using DestroyFunc = void (*)(LogRecord &record);
+
+    spdlog::log_clock::time_point time;
+
+    LogSite site;
+
+    size_t thread_id{0};
+
+    LogLevel level{LogLevel::LogINFO};
+
+    fmt::string_view format;
+
+    FormatFunc format_func{nullptr};
+
+    DestroyFunc destroy_func{nullptr};
+
+    alignas(std::max_align_t) unsigned char storage[StorageSize];
+};
+
 class Logger
 {
 public:
+    /**
+     * @param async Formats and writes the messages on a background thread, the calling threads only queue
+     *              them. Without it every message is formatted and written by the calling thread.
+     */
     static void Init(const std::string& name = "Logger",
                      LogLevel level = LogLevel::LogINFO,
                      const std::string& filepath = "",
-                     bool async = false,
+                     bool async = true,
                      size_t max_file_size = 1024 * 1024 * 5,
                      size_t max_files = 3);
 
-    static std::shared_ptr<spdlog::logger> GetLogger() { return logger_; }
+    /**
+     * Writes the queued messages and stops the logging thread, later messages are written synchronously
+     */
+    static void Shutdown();
+
+    static const std::shared_ptr<spdlog::logger> &GetLogger() { return logger_; }
 
     static void SetLevel(LogLevel level);
 
-    static void Flush()
+    static bool ShouldLog(LogLevel level, LogChannel *channel)
     {
-        if (logger_)
-            logger_->flush();
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed) && (!channel || channel->Admit(level));
+    }
+
+    /**
+     * Waits until every message queued so far is written and flushes the sinks
+     */
+    static void Flush();
+
+    template <typename... Args>
+    static void Log(LogLevel level, const LogSite &site, fmt::format_string<Args...> format, Args &&...args)
+    {
+        using Captured = std::tuple<typename Capture<Args>::Type...>;
+
+        if constexpr ((Capture<Args>::Deferred && ...) && sizeof(Captured) <= LogRecord::StorageSize &&
+                      alignof(Captured) <= alignof(std::max_align_t))
+        {
+            if (IsAsync())
+            {
+                // Copied before a slot is taken, nothing can throw while the slot is held
+                Captured captured{Capture<Args>::Get(std::forward<Args>(args))...};
+                if (auto *record = BeginRecord(level, site))
+                {
+                    record->format = format.get();
+                    new (record->storage) Captured(std::move(captured));
+
+                    record->format_func = [](const LogRecord &record, fmt::memory_buffer &out) {
+                        std::apply([&](const auto &...captured) {
+                            fmt::vformat_to(fmt::appender(out), record.format, fmt::make_format_args(captured...));
+                        }, *std::launder(reinterpret_cast<const Captured *>(record.storage)));
+                    };
+                    record->destroy_func = [](LogRecord &record) {
+                        std::launder(reinterpret_cast<Captured *>(record.storage))->~Captured();
+                    };
+
+                    CommitRecord(*record);
+                    return;
+                }
+
+                // The logger was shut down meanwhile
+                std::apply([&](const auto &...captured) {
+                    WriteMessage(level, site, fmt::vformat(format.get(), fmt::make_format_args(captured...)));
+                }, captured);
+                return;
+            }
+        }
+
+        auto formatEagerly = [&format](const auto &...formatArgs) {
+            return fmt::vformat(format.get(), fmt::make_format_args(formatArgs...));
+        };
+        WriteMessage(level, site, formatEagerly(NullSafe(args)...));
+    }
+
+    /**
+     * A single argument is the message itself, like spdlog takes it
+     */
+    template <typename T>
+    static void Log(LogLevel level, const LogSite &site, const T &message)
+    {
+        if constexpr (std::is_convertible_v<const T &, std::string_view>)
+        {
+            WriteMessage(level, site, std::string{std::string_view{message}});
+        }
+        else
+        {
+            WriteMessage(level, site, fmt::format("{}", message));
+        }
     }
 
 private:
+    /**
+     * How an argument is kept until it is formatted. Numbers and enums are copied, strings are copied into
+     * a std::string. Anything else may point into memory the caller frees, the message is formatted eagerly.
+     */
+    template <typename T, typename D = std::decay_t<T>>
+    struct Capture
+    {
+        static constexpr bool IsString = std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view> ||
+                                         std::is_same_v<D, const char *> || std::is_same_v<D, char *>;
+
+        static constexpr bool Deferred = std::is_arithmetic_v<D> || std::is_enum_v<D> || IsString ||
+                                         std::is_same_v<D, const void *> || std::is_same_v<D, void *>;
+
+        using Type = std::conditional_t<IsString, std::string, D>;
+
+        static Type Get(T &&value)
+        {
+            // String literals decay to D but are arrays, only real pointers can be null
+            if constexpr (IsString && std::is_pointer_v<std::remove_reference_t<T>>)
+            {
+                return value ? Type{value} : Type{"(null)"};
+            }
+            else if constexpr (IsString)
+            {
+                return Type{std::string_view{value}};
+            }
+            else
+            {
+                return value;
+            }
+        }
+    };
+
+    /**
+     * fmt throws on null C strings, they are printed as "(null)" instead
+     */
+    template <typename T>
+    static const T &NullSafe(const T &value) { return value; }
+
+    static const char *NullSafe(const char *value) { return value ? value : "(null)"; }
+
+    static const char *NullSafe(char *value) { return value ? value : "(null)"; }
+
+    static bool IsAsync() { return async_.load(std::memory_order_acquire); }
+
+    /**
+     * Slot in the queue of the calling thread, waits while the queue is full. Every slot returned
+     * must be committed, Shutdown waits for that before it writes the last records.
+     * @return nullptr once the logger is synchronous, the message is then written by the caller
+     */
+    static LogRecord *BeginRecord(LogLevel level, const LogSite &site);
+
+    static void CommitRecord(LogRecord &record);
+
+    /**
+     * Queues the formatted message, or writes it when the logger is synchronous
+     */
+    static void WriteMessage(LogLevel level, const LogSite &site, std::string message);
+
     static std::shared_ptr<spdlog::logger> logger_;
+
+    static std::atomic<int> level_;
+
+    static std::atomic<bool> async_;
+
+    /// Threads between BeginRecord and CommitRecord
+    static std::atomic<int> producers_;
 };
 
-#define LOG_TRACE(...) SPDLOG_LOGGER_TRACE(Logger::GetLogger(), __VA_ARGS__);
-#define LOG_DEBUG(...) SPDLOG_LOGGER_DEBUG(Logger::GetLogger(), __VA_ARGS__);
-#define LOG_INFO(...) SPDLOG_LOGGER_INFO(Logger::GetLogger(), __VA_ARGS__);
-#define LOG_WARN(...) SPDLOG_LOGGER_WARN(Logger::GetLogger(), __VA_ARGS__);
-#define LOG_ERROR(...) SPDLOG_LOGGER_ERROR(Logger::GetLogger(), __VA_ARGS__);
-#define LOG_CRITICAL(...) SPDLOG_LOGGER_CRITICAL(Logger::GetLogger(), __VA_ARGS__);
-
-#define LOG_TRACE_P(...) SPDLOG_LOGGER_TRACE(Logger::GetLogger(), "[{}:{}] {}", __FILE__, __LINE__, fmt::format(__VA_ARGS__));
-#define LOG_DEBUG_P(...) SPDLOG_LOGGER_DEBUG(Logger::GetLogger(), "[{}:{}] {}", __FILE__, __LINE__, fmt::format(__VA_ARGS__));
-#define LOG_INFO_P(...) SPDLOG_LOGGER_INFO(Logger::GetLogger(), "[{}:{}] {}", __FILE__, __LINE__, fmt::format(__VA_ARGS__));
-#define LOG_WARN_P(...) SPDLOG_LOGGER_WARN(Logger::GetLogger(), "[{}:{}] {}", __FILE__, __LINE__, fmt::format(__VA_ARGS__));
-#define LOG_ERROR_P(...) SPDLOG_LOGGER_ERROR(Logger::GetLogger(), "[{}:{}] {}", __FILE__, __LINE__, fmt::format(__VA_ARGS__));
-#define LOG_CRITICAL_P(...) SPDLOG_LOGGER_CRITICAL(Logger::GetLogger(), "[{}:{}] {}", __FILE__, __LINE__, fmt::format(__VA_ARGS__));
+#define CYR_LOG(level, channel, print_location, ...)                                                                  \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if constexpr (static_cast<int>(level) >= CYR_LOG_ACTIVE_LEVEL)                                                 \
+        {                                                                                                              \
+            if (Logger::ShouldLog(level, channel))                                                                     \
+            {                                                                                                          \
+                Logger::Log(level, LogSite{spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, channel, print_location}, \
+                            __VA_ARGS__);                                                                              \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while (false)
+
+#define LOG_TRACE(...) CYR_LOG(LogLevel::LogTRACE, nullptr, false, __VA_ARGS__);
+#define LOG_DEBUG(...) CYR_LOG(LogLevel::LogDEBUG, nullptr, false, __VA_ARGS__);
+#define LOG_INFO(...) CYR_LOG(LogLevel::LogINFO, nullptr, false, __VA_ARGS__);
+#define LOG_WARN(...) CYR_LOG(LogLevel::LogWARN, nullptr, false, __VA_ARGS__);
+#define LOG_ERROR(...) CYR_LOG(LogLevel::LogERROR, nullptr, false, __VA_ARGS__);
+#define LOG_CRITICAL(...) CYR_LOG(LogLevel::LogCRITICAL, nullptr, false, __VA_ARGS__);
+
+#define LOG_TRACE_P(...) CYR_LOG(LogLevel::LogTRACE, nullptr, true, __VA_ARGS__);
+#define LOG_DEBUG_P(...) CYR_LOG(LogLevel::LogDEBUG, nullptr, true, __VA_ARGS__);
+#define LOG_INFO_P(...) CYR_LOG(LogLevel::LogINFO, nullptr, true, __VA_ARGS__);
+#define LOG_WARN_P(...) CYR_LOG(LogLevel::LogWARN, nullptr, true, __VA_ARGS__);
+#define LOG_ERROR_P(...) CYR_LOG(LogLevel::LogERROR, nullptr, true, __VA_ARGS__);
+#define LOG_CRITICAL_P(...) CYR_LOG(LogLevel::LogCRITICAL, nullptr, true, __VA_ARGS__);
+
+/// Logs to a LogChannel, e.g. LOG_CHANNEL(import_log, DEBUG, "Loaded {}", name)
+#define LOG_CHANNEL(channel, level, ...) CYR_LOG(LogLevel::Log##level, &(channel), false, __VA_ARGS__);
 
 #define LOGT(...) LOG_TRACE(__VA_ARGS__)
 #define LOGD(...) LOG_DEBUG(__VA_ARGS__)
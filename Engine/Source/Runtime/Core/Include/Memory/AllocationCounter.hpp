@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Counts the heap allocations made through operator new, to check that a frame allocates nothing once warmed up.
+ * Counting needs the CYRENGINE_COUNT_ALLOCATIONS build option, which replaces the global operator new and delete
+ * in every executable linking Core.
+ * Without it IsEnabled() is false and the counts stay at zero.
+ */
+class AllocationCounter
+{
+public:
+    static bool IsEnabled();
+
+    /**
+     * @return The allocations of every thread since the start of the process
+     */
+    static uint64_t GetCount();
+
+    /**
+     * @return The allocations of the calling thread since it started
+     */
+    static uint64_t GetThreadCount();
+};
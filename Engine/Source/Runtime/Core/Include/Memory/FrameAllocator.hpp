@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+
+#include "LinearArena.hpp"
+
+/**
+ * One LinearArena per thread for temporaries that live at most until the end of the frame.
+ * BeginFrame() starts a frame, each thread resets its own arena the first time it uses it in the new frame,
+ * so an arena is only ever touched by its thread. Memory from an arena must not be kept past the next BeginFrame().
+ */
+class FrameAllocator
+{
+public:
+    /**
+     * Called once per frame by the render loop, before any temporary of the frame is allocated
+     */
+    static void BeginFrame();
+
+    static uint64_t GetFrameIndex();
+
+    /**
+     * @return The arena of the calling thread, reset first when a frame began since it was last used
+     */
+    static LinearArena &GetThreadArena();
+
+    /**
+     * @return The arena of the calling thread as a resource for std::pmr containers
+     */
+    static std::pmr::memory_resource *GetResource();
+};
+
+/**
+ * Rewinds the frame arena of the calling thread to where it was at construction.
+ * Scopes nest like a stack and give their memory back when they end instead of at the next frame,
+ * for temporaries of a call that can run many times per frame.
+ */
+class ScopedArena
+{
+public:
+    ScopedArena();
+
+    ~ScopedArena();
+
+    ScopedArena(const ScopedArena &) = delete;
+
+    ScopedArena &operator=(const ScopedArena &) = delete;
+
+    std::pmr::memory_resource *GetResource() const;
+
+private:
+    LinearArena &arena;
+
+    LinearArena::Marker marker;
+};
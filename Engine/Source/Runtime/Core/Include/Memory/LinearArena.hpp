@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Bump allocator over a list of heap blocks, usable as a std::pmr::memory_resource.
+ * Deallocation does nothing, memory comes back through Reset() or by rewinding to a Marker.
+ * When Reset() finds more than one block in use it replaces them by a single block large enough for all,
+ * so a repeating workload only allocates from the heap while it warms up. Not thread safe.
+ */
+class LinearArena : public std::pmr::memory_resource
+{
+public:
+    /**
+     * Position in the arena, markers taken before the last Reset() are ignored by Rewind()
+     */
+    struct Marker
+    {
+        uint64_t generation{0};
+
+        size_t block{0};
+
+        size_t offset{0};
+    };
+
+    struct Stats
+    {
+        /// Bytes in use since the last Reset(), block tails skipped by large requests included
+        size_t used{0};
+
+        /// Highest used since the arena was created
+        size_t peak{0};
+
+        /// Bytes of all the blocks
+        size_t capacity{0};
+
+        /// Blocks allocated from the heap since the arena was created
+        uint64_t block_allocations{0};
+    };
+
+    explicit LinearArena(size_t block_size = 64 * 1024);
+
+    LinearArena(const LinearArena &) = delete;
+
+    LinearArena &operator=(const LinearArena &) = delete;
+
+    void *Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Uninitialized storage for count elements, only for types that need no destructor
+     */
+    template <typename T>
+    T *AllocateArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena memory is released without destructors");
+        return static_cast<T *>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    Marker GetMarker() const;
+
+    /**
+     * Releases everything allocated since marker was taken
+     */
+    void Rewind(const Marker &marker);
+
+    /**
+     * Releases everything, the blocks are kept for the next allocations
+     */
+    void Reset();
+
+    Stats GetStats() const;
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+
+        size_t size{0};
+    };
+
+    void AddBlock(size_t size);
+
+    size_t GetUsed() const;
+
+    std::vector<Block> blocks;
+
+    size_t block_size;
+
+    size_t current_block{0};
+
+    size_t offset{0};
+
+    /// Sizes of the blocks before current_block
+    size_t filled{0};
+
+    size_t peak{0};
+
+    uint64_t generation{0};
+
+    uint64_t block_allocations{0};
+};
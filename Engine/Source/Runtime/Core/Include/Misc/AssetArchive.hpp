@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Misc/MappedFile.hpp"
+
+enum class ArchiveCompression : uint8_t
+{
+    None,
+    Zstd
+};
+
+struct ArchiveBuildOptions
+{
+    /// Entries are compressed with this zstd level, 0 stores everything uncompressed
+    int compressionLevel{9};
+
+    /// Compressed entries are only kept if they save at least this fraction, already compressed
+    /// formats like PNG or KTX2 are stored as they are
+    float minSavings{0.125f};
+};
+
+/**
+ * Read-only pack of asset files, opened by mapping the whole archive.
+ *
+ * Layout, little endian: a Header, the entry data, then the index at Header::indexOffset. The index
+ * is an array of Entry sorted by path hash followed by the paths they point to. Entry data is 16 byte
+ * aligned, an uncompressed entry is handed out as a slice of the mapping and never copied.
+ */
+class AssetArchive
+{
+public:
+    static constexpr uint32_t Magic = 0x4b415043; // "CPAK"
+
+    static constexpr uint32_t Version = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+
+        uint32_t version;
+
+        uint32_t entryCount;
+
+        uint32_t reserved;
+
+        uint64_t indexOffset;
+
+        uint64_t indexSize;
+    };
+
+    struct Entry
+    {
+        /// Hash::Hash64 of the normalized path
+        uint64_t pathHash;
+
+        uint64_t offset;
+
+        /// Bytes in the archive, smaller than size when compressed
+        uint64_t storedSize;
+
+        uint64_t size;
+
+        /// Hash::Hash64 of the uncompressed contents
+        uint64_t contentHash;
+
+        /// Offset of the path from the end of the entry array
+        uint32_t pathOffset;
+
+        uint16_t pathLength;
+
+        ArchiveCompression compression;
+
+        uint8_t reserved;
+    };
+
+    /**
+     * @throws std::runtime_error if the file is not a readable archive
+     */
+    static std::unique_ptr<AssetArchive> Open(const std::filesystem::path &path);
+
+    /**
+     * Packs every file below directory, the paths in the archive are relative to it
+     * @throws std::runtime_error if a file cannot be read or the archive cannot be written
+     */
+    static void Build(const std::filesystem::path &directory, const std::filesystem::path &archivePath,
+                      const ArchiveBuildOptions &options = {});
+
+    /**
+     * Forward slashes, no "." or ".." components and no leading slash, the form paths are stored in
+     */
+    static std::string NormalizePath(const std::string &path);
+
+    /**
+     * @param path A normalized path
+     * @return The entry or nullptr if the archive does not contain path
+     */
+    const Entry *Find(const std::string &path) const;
+
+    /**
+     * Uncompressed entries share the mapping of the archive, compressed ones are decompressed
+     * @throws std::runtime_error if the entry is corrupt
+     */
+    MappedFile Read(const Entry &entry) const;
+
+    std::string GetPath(const Entry &entry) const;
+
+    const std::vector<Entry> &GetEntries() const;
+
+    const std::filesystem::path &GetFilePath() const;
+
+private:
+    AssetArchive() = default;
+
+    std::filesystem::path filePath;
+
+    std::shared_ptr<const MappedFile> file;
+
+    std::vector<Entry> entries;
+
+    /// Paths of the entries, packed back to back
+    const char *paths{nullptr};
+
+    uint64_t pathsSize{0};
+};
@@ -4,6 +4,10 @@
 #include <vector>
 #include <filesystem>
 
+#include "Misc/MappedFile.hpp"
+
+class JobCounter;
+
 class FileLoader
 {
 public:
@@ -14,4 +18,25 @@ public:
     static std::string ReadFileString(const std::filesystem::path &path);
 
     static std::string ReadTextFile(const std::string &filename);
+
+    /**
+     * Maps the file without copying it, see MappedFile
+     * @throws std::runtime_error if the file cannot be opened or read
+     */
+    static MappedFile MapFile(const std::filesystem::path &path);
+
+    /**
+     * Maps the files on the JobSystem workers, files[i] receives paths[i]. Many small files are
+     * batched so a job opens several of them. Wait for counter with JobSystem::Wait, which rethrows
+     * the first failure. files is resized by the call and must not be touched until counter is done,
+     * paths is copied and can go away right after.
+     */
+    static void ReadFilesAsync(const std::vector<std::filesystem::path> &paths, std::vector<MappedFile> &files,
+                               JobCounter &counter);
+
+    /**
+     * Writes the bytes to a temporary file next to path and renames it over path,
+     * readers never observe a partially written file. Missing parent directories are created.
+     */
+    static void WriteFileBinary(const std::filesystem::path &path, const void *data, size_t size);
 };
\ No newline at end of file
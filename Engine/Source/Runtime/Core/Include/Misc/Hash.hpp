@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Hash
+{
+public:
+    /**
+     * 64-bit non-cryptographic hash of a byte range (wyhash style multiply-mix)
+     * @param data Bytes to hash
+     * @param size Number of bytes
+     * @param seed Seed mixed into the result, allows deriving independent hashes from the same data
+     * @note The result is stable across runs and platforms and can be used as a content address on disk
+     */
+    static uint64_t Hash64(const void *data, size_t size, uint64_t seed = 0);
+
+    /**
+     * Mixes a value into an existing hash
+     */
+    static uint64_t Combine(uint64_t hash, uint64_t value);
+
+    /**
+     * @return The hash as 16 lower case hex digits
+     */
+    static std::string ToHex(uint64_t hash);
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+/**
+ * Read-only contents of a file, valid as long as the MappedFile lives.
+ * Large files are memory mapped so their pages are read on first access and never copied,
+ * small files are read into a buffer of their own, which is cheaper than setting up a mapping.
+ */
+class MappedFile
+{
+public:
+    /// Files below this size are read instead of mapped
+    static constexpr size_t MapThreshold = 64 * 1024;
+
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @throws std::runtime_error if the file cannot be opened or read
+     */
+    static MappedFile Open(const std::filesystem::path &path);
+
+    /**
+     * Takes over bytes that were produced in memory, e.g. a decompressed archive entry
+     */
+    static MappedFile FromBuffer(std::vector<uint8_t> buffer);
+
+    /**
+     * Part of another file, which is kept alive as long as the slice lives
+     */
+    static MappedFile Slice(std::shared_ptr<const MappedFile> parent, size_t offset, size_t size);
+
+    /**
+     * The data of opened files is at least 4 byte aligned, SPIR-V can be read from it as uint32_t words
+     */
+    const uint8_t *Data() const;
+
+    size_t Size() const;
+
+    bool Empty() const;
+
+    bool IsMapped() const;
+
+    const uint8_t *begin() const;
+
+    const uint8_t *end() const;
+
+private:
+    void Release();
+
+    const uint8_t *data{nullptr};
+
+    size_t size{0};
+
+    /// Holds the contents of files that are not mapped
+    std::vector<uint8_t> buffer;
+
+    bool mapped{false};
+
+    /// The file a slice points into
+    std::shared_ptr<const MappedFile> parent;
+
+#if defined(_WIN32)
+    void *mapping{nullptr};
+#endif
+};
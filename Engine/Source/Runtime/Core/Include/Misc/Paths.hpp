@@ -14,6 +14,10 @@ public:
      *       On other platforms, a std::runtime_error exception will be thrown */
     static std::string GetCurrentExecutablePath();
 
+    /**
+     * The project directories are searched for on the first call and cached, later calls do no file system work
+     * @throws std::runtime_error if the directory cannot be found, the next call searches again
+     */
     static std::string GetAssetPath();
 
     static std::string GetAssetFullPath(const std::string &relativePath);
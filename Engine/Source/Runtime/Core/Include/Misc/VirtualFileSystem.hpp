@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Misc/AssetArchive.hpp"
+#include "Misc/MappedFile.hpp"
+#include "SubSystems/Singleton.h"
+
+/**
+ * Resolves asset paths against mounted directories and archives.
+ * A mount makes the files of a directory or an AssetArchive appear below a mount point, the most
+ * recently mounted one wins when several contain a path. Mounting the loose Assets directory over
+ * the packed archive lets edited files override the packed ones during development.
+ * Resolved paths are cached, a path is only looked up in the mounts the first time it is read.
+ * Absolute paths and paths no mount contains are read from disk as they are.
+ */
+class VirtualFileSystem : public Singleton<VirtualFileSystem>
+{
+    friend class Singleton<VirtualFileSystem>;
+
+public:
+    void MountDirectory(const std::string &mountPoint, const std::filesystem::path &directory);
+
+    /**
+     * @throws std::runtime_error if the file is not a readable archive
+     */
+    void MountArchive(const std::string &mountPoint, const std::filesystem::path &archivePath);
+
+    /**
+     * Removes every mount of the mount point
+     */
+    void Unmount(const std::string &mountPoint);
+
+    /**
+     * Forgets the resolved paths, for when loose files were added or removed
+     */
+    void ClearCache();
+
+    bool Exists(const std::string &path);
+
+    /**
+     * @throws std::runtime_error if the file does not exist or cannot be read
+     */
+    MappedFile Read(const std::string &path);
+
+    /**
+     * @return The file on disk behind path, empty if it is packed in an archive or does not exist
+     */
+    std::filesystem::path GetDiskPath(const std::string &path);
+
+private:
+    struct Mount
+    {
+        /// Normalized, empty for the root
+        std::string point;
+
+        std::filesystem::path directory;
+
+        std::shared_ptr<const AssetArchive> archive;
+    };
+
+    struct Location
+    {
+        std::shared_ptr<const Mount> mount;
+
+        /// Set for archive mounts
+        const AssetArchive::Entry *entry{nullptr};
+
+        /// Set for directory mounts and unmounted paths
+        std::filesystem::path diskPath;
+    };
+
+    VirtualFileSystem() = default;
+
+    void AddMount(std::shared_ptr<const Mount> mount);
+
+    /**
+     * @return false if no mount contains path and it does not exist on disk
+     */
+    bool Resolve(const std::string &path, Location &location);
+
+    std::shared_mutex mutex;
+
+    /// In mount order, searched back to front
+    std::vector<std::shared_ptr<const Mount>> mounts;
+
+    std::unordered_map<std::string, Location> resolved;
+
+    /// Incremented whenever the mounts change
+    uint64_t generation{0};
+};
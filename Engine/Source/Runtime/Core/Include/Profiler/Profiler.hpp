@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "SubSystems/Singleton.h"
+
+enum class ProfileEventType : uint8_t
+{
+    Zone,
+    Plot
+};
+
+struct ProfileEvent
+{
+    /// String literal or a name returned by Profiler::Intern
+    const char *name{nullptr};
+
+    /// Nanoseconds on the Profiler::Now() clock, start and end are equal for plots
+    uint64_t start{0};
+
+    uint64_t end{0};
+
+    double value{0.0};
+
+    /// Number of zones the zone is nested in
+    uint16_t depth{0};
+
+    ProfileEventType type{ProfileEventType::Zone};
+};
+
+/**
+ * Ring buffer of the events of one thread, or of a GPU queue. Only its thread writes events, the lock is
+ * uncontended except while Profiler::Capture copies them out. The oldest events are overwritten.
+ */
+class ProfileTrack
+{
+public:
+    const std::string &GetName() const;
+
+    uint32_t GetId() const;
+
+private:
+    friend class Profiler;
+
+    struct Counter
+    {
+        const char *name;
+
+        double value;
+    };
+
+    void Lock();
+
+    void Unlock();
+
+    void Push(const ProfileEvent &event);
+
+    std::string name;
+
+    uint32_t id{0};
+
+    std::atomic<bool> locked{false};
+
+    std::vector<ProfileEvent> events;
+
+    /// Events written since the track was created, events[write_count % size] is written next
+    uint64_t write_count{0};
+
+    /// Depth of the next zone of the thread
+    uint16_t depth{0};
+
+    /// Sums of Profiler::Count for the current frame, flushed as plots by Profiler::BeginFrame
+    std::vector<Counter> counters;
+};
+
+/**
+ * Built-in hierarchical profiler: nested CPU zones per thread, GPU zones reported by the renderer,
+ * plotted values and per frame counters. Events are kept in per thread rings and exported as Chrome trace
+ * JSON, which Perfetto and chrome://tracing open. Names are not copied, they must be string literals or interned.
+ */
+class Profiler : public Singleton<Profiler>
+{
+    friend class Singleton<Profiler>;
+
+public:
+    struct Frame
+    {
+        uint64_t start{0};
+
+        uint64_t end{0};
+    };
+
+    struct Capture
+    {
+        struct Track
+        {
+            std::string name;
+
+            uint32_t id{0};
+
+            /// Ordered by end time
+            std::vector<ProfileEvent> events;
+        };
+
+        std::vector<Frame> frames;
+
+        std::vector<Track> tracks;
+    };
+
+    /**
+     * @return Nanoseconds on a monotonic clock, the time base of every event
+     */
+    static uint64_t Now();
+
+    void SetEnabled(bool enabled);
+
+    bool IsEnabled() const;
+
+    /**
+     * Ends the current frame and starts the next one, called once per frame by the main loop
+     * The counters of the ended frame are recorded as plots.
+     */
+    void BeginFrame();
+
+    void SetThreadName(const std::string &name);
+
+    /**
+     * @return The track of the calling thread, created on first use
+     */
+    ProfileTrack &GetThreadTrack();
+
+    /**
+     * Adds a track written by something else than a thread, like the zones of a GPU queue
+     */
+    ProfileTrack &CreateTrack(const std::string &name);
+
+    /**
+     * @return The depth of the zone being opened on the calling thread
+     */
+    uint16_t BeginZone();
+
+    void EndZone(const char *name, uint64_t start, uint16_t depth);
+
+    /**
+     * Records a finished zone on track, the caller takes care of ordering the zones of a track by end time
+     */
+    void RecordZone(ProfileTrack &track, const char *name, uint64_t start, uint64_t end, uint16_t depth);
+
+    /**
+     * Records a sample of a value plotted over time
+     */
+    void Plot(const char *name, double value);
+
+    /**
+     * Adds amount to a counter of the current frame, plotted once per frame with its total
+     */
+    void Count(const char *name, double amount = 1.0);
+
+    /**
+     * @return A copy of name that lives as long as the profiler, for names built at runtime
+     */
+    const char *Intern(const std::string &name);
+
+    /**
+     * Copies the buffered events that ended at or after since
+     */
+    Capture CaptureEvents(uint64_t since = 0);
+
+    /**
+     * @return The last frames that ended, oldest first
+     */
+    std::vector<Frame> GetFrames();
+
+    /**
+     * @return Everything still buffered as Chrome trace JSON
+     */
+    std::string ExportChromeTrace();
+
+    bool WriteChromeTrace(const std::filesystem::path &path);
+
+private:
+    Profiler();
+
+    ProfileTrack &AddTrack(const std::string &name);
+
+    const uint64_t start_time;
+
+    std::atomic<bool> enabled{true};
+
+    std::mutex tracks_mutex;
+
+    std::vector<std::unique_ptr<ProfileTrack>> tracks;
+
+    std::mutex names_mutex;
+
+    std::unordered_set<std::string> names;
+
+    std::mutex frames_mutex;
+
+    /// Ring of the last frames, frames[frame_count % size] is written next
+    std::vector<Frame> frames;
+
+    uint64_t frame_count{0};
+
+    uint64_t frame_start{0};
+};
+
+/**
+ * Measures the enclosing scope as a zone of the calling thread
+ */
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char *name);
+
+    ~ProfileZone();
+
+    ProfileZone(const ProfileZone &) = delete;
+
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+    const char *name;
+
+    uint64_t start{0};
+
+    uint16_t depth{0};
+
+    bool active;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifndef CYRENGINE_DISABLE_PROFILER
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__){name}
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_PLOT(name, value) Profiler::GetInstance().Plot(name, static_cast<double>(value))
+#define PROFILE_COUNT(name, amount) Profiler::GetInstance().Count(name, static_cast<double>(amount))
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_PLOT(name, value)
+#define PROFILE_COUNT(name, amount)
+#endif
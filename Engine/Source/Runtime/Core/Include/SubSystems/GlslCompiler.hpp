@@ -1,137 +1,138 @@
-//#pragma once
-//#include <iostream>
-//#include "Singleton.h"
-//#include <glslang/Public/ShaderLang.h>
-//#include <SPIRV/GlslangToSpv.h>
-//
-//class GlslCompiler : public Singleton<GlslCompiler>
-//{
-//    friend class Singleton<GlslCompiler>;
-//
-//public:
-//    void Initialize();
-//
-//    // 获取 glslang 的默认资源限制
-//    // 这对于大多数情况都足够了
-//    const TBuiltInResource *GetDefaultResources()
-//    {
-//        static TBuiltInResource defaultResource = {
-//            /* .MaxLights = */ 32,
-//            /* .MaxClipPlanes = */ 6,
-//            /* .MaxTextureUnits = */ 32,
-//            /* .MaxTextureCoords = */ 32,
-//            /* .MaxVertexAttribs = */ 64,
-//            /* .MaxVertexUniformComponents = */ 4096,
-//            /* .MaxVaryingFloats = */ 64,
-//            /* .MaxVertexTextureImageUnits = */ 32,
-//            /* .MaxCombinedTextureImageUnits = */ 80,
-//            /* .MaxTextureImageUnits = */ 32,
-//            /* .MaxFragmentUniformComponents = */ 4096,
-//            /* .MaxDrawBuffers = */ 32,
-//            /* .MaxVertexUniformVectors = */ 128,
-//            /* .MaxVaryingVectors = */ 8,
-//            /* .MaxFragmentUniformVectors = */ 16,
-//            /* .MaxVertexOutputVectors = */ 16,
-//            /* .MaxFragmentInputVectors = */ 15,
-//            /* .MinProgramTexelOffset = */ -8,
-//            /* .MaxProgramTexelOffset = */ 7,
-//            /* .MaxClipDistances = */ 8,
-//            /* .MaxComputeWorkGroupCountX = */ 65535,
-//            /* .MaxComputeWorkGroupCountY = */ 65535,
-//            /* .MaxComputeWorkGroupCountZ = */ 65535,
-//            /* .MaxComputeWorkGroupSizeX = */ 1024,
-//            /* .MaxComputeWorkGroupSizeY = */ 1024,
-//            /* .MaxComputeWorkGroupSizeZ = */ 64,
-//            /* .MaxComputeUniformComponents = */ 1024,
-//            /* .MaxComputeTextureImageUnits = */ 16,
-//            /* .MaxComputeImageUniforms = */ 8,
-//            /* .MaxComputeAtomicCounters = */ 8,
-//            /* .MaxComputeAtomicCounterBuffers = */ 1,
-//            /* .MaxVaryingComponents = */ 60,
-//            /* .MaxVertexOutputComponents = */ 64,
-//            /* .MaxGeometryInputComponents = */ 64,
-//            /* .MaxGeometryOutputComponents = */ 128,
-//            /* .MaxFragmentInputComponents = */ 128,
-//            /* .MaxImageUnits = */ 8,
-//            /* .MaxCombinedImageUnitsAndFragmentOutputs = */ 8,
-//            /* .MaxCombinedShaderOutputResources = */ 8,
-//            /* .MaxImageSamples = */ 0,
-//            /* .MaxVertexImageUniforms = */ 0,
-//            /* .MaxTessControlImageUniforms = */ 0,
-//            /* .MaxTessEvaluationImageUniforms = */ 0,
-//            /* .MaxGeometryImageUniforms = */ 0,
-//            /* .MaxFragmentImageUniforms = */ 8,
-//            /* .MaxCombinedImageUniforms = */ 8,
-//            /* .MaxGeometryTextureImageUnits = */ 16,
-//            /* .MaxGeometryOutputVertices = */ 256,
-//            /* .MaxGeometryTotalOutputComponents = */ 1024,
-//            /* .MaxGeometryUniformComponents = */ 1024,
-//            /* .MaxGeometryVaryingComponents = */ 64,
-//            /* .MaxTessControlInputComponents = */ 128,
-//            /* .MaxTessControlOutputComponents = */ 128,
-//            /* .MaxTessControlTextureImageUnits = */ 16,
-//            /* .MaxTessControlUniformComponents = */ 1024,
-//            /* .MaxTessControlTotalOutputComponents = */ 4096,
-//            /* .MaxTessEvaluationInputComponents = */ 128,
-//            /* .MaxTessEvaluationOutputComponents = */ 128,
-//            /* .MaxTessEvaluationTextureImageUnits = */ 16,
-//            /* .MaxTessEvaluationUniformComponents = */ 1024,
-//            /* .MaxTessPatchComponents = */ 120,
-//            /* .MaxPatchVertices = */ 32,
-//            /* .MaxTessGenLevel = */ 64,
-//            /* .MaxViewports = */ 16,
-//            /* .MaxVertexAtomicCounters = */ 0,
-//            /* .MaxTessControlAtomicCounters = */ 0,
-//            /* .MaxTessEvaluationAtomicCounters = */ 0,
-//            /* .MaxGeometryAtomicCounters = */ 0,
-//            /* .MaxFragmentAtomicCounters = */ 8,
-//            /* .MaxCombinedAtomicCounters = */ 8,
-//            /* .MaxAtomicCounterBindings = */ 1,
-//            /* .MaxVertexAtomicCounterBuffers = */ 0,
-//            /* .MaxTessControlAtomicCounterBuffers = */ 0,
-//            /* .MaxTessEvaluationAtomicCounterBuffers = */ 0,
-//            /* .MaxGeometryAtomicCounterBuffers = */ 0,
-//            /* .MaxFragmentAtomicCounterBuffers = */ 1,
-//            /* .MaxCombinedAtomicCounterBuffers = */ 1,
-//            /* .MaxAtomicCounterBufferSize = */ 16384,
-//            /* .MaxTransformFeedbackBuffers = */ 4,
-//            /* .MaxTransformFeedbackInterleavedComponents = */ 64,
-//            /* .MaxCullDistances = */ 8,
-//            /* .MaxCombinedClipAndCullDistances = */ 8,
-//            /* .MaxSamples = */ 4,
-//            /* .maxMeshOutputVerticesNV = */ 256,
-//            /* .maxMeshOutputPrimitivesNV = */ 512,
-//            /* .maxMeshWorkGroupSizeX_NV = */ 32,
-//            /* .maxMeshWorkGroupSizeY_NV = */ 1,
-//            /* .maxMeshWorkGroupSizeZ_NV = */ 1,
-//            /* .maxTaskWorkGroupSizeX_NV = */ 32,
-//            /* .maxTaskWorkGroupSizeY_NV = */ 1,
-//            /* .maxTaskWorkGroupSizeZ_NV = */ 1,
-//            /* .maxMeshViewCountNV = */ 4,
-//            /* .limits = */ 1};
-//        return &defaultResource;
-//    }
-//
-//    /**
-//     * @brief 将 GLSL 着色器代码编译成 SPIR-V 字节码。
-//     *
-//     * @param glslCode GLSL 源代码字符串。
-//     * @param shaderType 着色器阶段，例如 EShLangVertex, EShLangFragment 等。
-//     * @param errorLog [out] 用于接收编译错误和警告信息的字符串。
-//     * @return std::vector<unsigned int> 编译成功后的 SPIR-V 字节码。如果编译失败，则返回一个空的 vector。
-//     */
-//    std::vector<unsigned int> CompileGLSLToSpv(const std::string &glslCode, EShLanguage shaderType, std::string &errorLog);
-//
-//private:
-//    GlslCompiler() : score_(0)
-//    {
-//        std::cout << "GameManager instance created." << std::endl;
-//    }
-//
-//    ~GlslCompiler()
-//    {
-//        std::cout << "GameManager instance destroyed." << std::endl;
-//    }
-//
-//    int score_;
-//};
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Singleton.h"
+
+/**
+ * Shader stages GlslCompiler accepts, the same order as glslang's EShLanguage
+ */
+enum class GlslStage
+{
+    Vertex,
+    TessControl,
+    TessEvaluation,
+    Geometry,
+    Fragment,
+    Compute,
+    RayGen,
+    Intersect,
+    AnyHit,
+    ClosestHit,
+    Miss,
+    Callable,
+    Task,
+    Mesh
+};
+
+/**
+ * One GLSL source to compile and its result
+ */
+struct GlslCompileJob
+{
+    GlslStage stage{GlslStage::Vertex};
+
+    /// GLSL source text
+    std::string source;
+
+    /// File the source was read from, #include "..." is resolved relative to its directory first
+    std::filesystem::path source_path;
+
+    /// Text placed before the source, usually the #define lines of a shader variant
+    std::string preamble;
+
+    std::string entry_point{"main"};
+
+    std::vector<uint32_t> spirv;
+
+    std::string info_log;
+
+    bool success{false};
+};
+
+/**
+ * Compiles GLSL to SPIR-V with glslang, safe to use from several threads at once.
+ * Every result is stored under a hash of the source, the resolved includes, the preamble, the stage,
+ * the entry point and the compiler version, in memory and in the cache directory, so a variant is
+ * only compiled again when one of them changes.
+ */
+class GlslCompiler : public Singleton<GlslCompiler>
+{
+    friend class Singleton<GlslCompiler>;
+
+public:
+    struct Stats
+    {
+        uint32_t compiled{0};
+
+        uint32_t memory_hits{0};
+
+        uint32_t disk_hits{0};
+
+        uint32_t failed{0};
+    };
+
+    /**
+     * Binaries are stored as <directory>/<key>.spv, an empty path keeps them in memory only
+     */
+    void SetCacheDirectory(const std::filesystem::path &directory);
+
+    std::filesystem::path GetCacheDirectory() const;
+
+    /**
+     * Searched for #include <...>, and for #include "..." after the directory of the including file
+     */
+    void AddIncludeDirectory(const std::filesystem::path &directory);
+
+    /**
+     * Compiles the job or takes the binary from the cache
+     * @return job.success, job.info_log holds the glslang messages on failure
+     */
+    bool Compile(GlslCompileJob &job);
+
+    /**
+     * Compiles the jobs on the JobSystem workers, the calling thread included
+     * @return true when every job succeeded
+     */
+    bool CompileAll(std::vector<GlslCompileJob> &jobs);
+
+    /**
+     * @return The cache key of the job, includes are read from disk to hash their contents
+     */
+    uint64_t ComputeKey(const GlslCompileJob &job) const;
+
+    Stats GetStats() const;
+
+private:
+    GlslCompiler();
+
+    ~GlslCompiler();
+
+    bool CompileUncached(GlslCompileJob &job, const std::vector<std::filesystem::path> &include_directories) const;
+
+    std::vector<std::filesystem::path> GetIncludeDirectories() const;
+
+    mutable std::mutex config_mutex;
+
+    std::filesystem::path cache_directory;
+
+    std::vector<std::filesystem::path> include_directories;
+
+    std::mutex memory_cache_mutex;
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> memory_cache;
+
+    std::atomic<uint32_t> compiled{0};
+
+    std::atomic<uint32_t> memory_hits{0};
+
+    std::atomic<uint32_t> disk_hits{0};
+
+    std::atomic<uint32_t> failed{0};
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Singleton.h"
+
+class JobCounter;
+
+using JobFunc = std::function<void()>;
+
+struct Job
+{
+    JobFunc func;
+
+    /// Decremented once func returned, may be null
+    JobCounter *counter{nullptr};
+};
+
+/**
+ * Counts the unfinished jobs of a group. Jobs can be scheduled to start once a counter is done,
+ * and JobSystem::Wait runs other jobs until it is. The counter must outlive its jobs.
+ */
+class JobCounter
+{
+public:
+    JobCounter() = default;
+
+    JobCounter(const JobCounter &) = delete;
+
+    JobCounter &operator=(const JobCounter &) = delete;
+
+    bool IsDone() const;
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> pending{0};
+
+    std::mutex mutex;
+
+    /// Jobs scheduled with JobSystem::RunAfter, queued when pending reaches zero
+    std::vector<Job> continuations;
+
+    /// First exception thrown by a job of the group, rethrown by JobSystem::Wait
+    std::exception_ptr exception;
+};
+
+/**
+ * Engine wide worker threads, one per hardware thread besides the main thread.
+ * Every worker owns a deque: jobs scheduled from a worker go to its own deque and are taken back
+ * newest first, idle workers steal the oldest jobs of the others. Jobs scheduled from other threads
+ * go to a shared queue. A thread waiting for a counter runs queued jobs meanwhile instead of blocking,
+ * so jobs can wait for jobs they scheduled without tying up a worker.
+ */
+class JobSystem : public Singleton<JobSystem>
+{
+    friend class Singleton<JobSystem>;
+
+public:
+    /**
+     * Queues func, counter is incremented now and decremented once func has returned
+     */
+    void Run(JobFunc func, JobCounter *counter = nullptr);
+
+    /**
+     * Queues func once dependency is done, counter is incremented now
+     */
+    void RunAfter(JobCounter &dependency, JobFunc func, JobCounter *counter = nullptr);
+
+    /**
+     * Queues func for the next ProcessMainThreadJobs(), for work that must stay on the main thread like window calls
+     */
+    void RunOnMainThread(JobFunc func, JobCounter *counter = nullptr);
+
+    /**
+     * Runs the jobs queued with RunOnMainThread, called once per frame by the main loop
+     */
+    void ProcessMainThreadJobs();
+
+    /**
+     * Runs queued jobs until counter is done, main thread jobs included when called on the main thread
+     * @throws The first exception thrown by a job counted by counter
+     */
+    void Wait(JobCounter &counter);
+
+    /**
+     * Calls func(begin, end) for the ranges of [0, count) of grain_size elements, the calling thread takes part
+     * @throws The first exception thrown by func, once every range has finished
+     */
+    void ParallelFor(uint32_t count, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)> &func);
+
+    /**
+     * @return A grain size giving every worker and the calling thread a few ranges of count elements
+     */
+    uint32_t GetGrainSize(uint32_t count, uint32_t ranges_per_thread = 4) const;
+
+    uint32_t GetWorkerCount() const;
+
+    bool IsMainThread() const;
+
+    /**
+     * Stops the workers once their current job returns. Jobs still queued and jobs scheduled from then on are not run,
+     * their counters are finished with an exception so waiting threads return
+     */
+    void Shutdown();
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+
+        std::deque<Job> jobs;
+
+        std::thread thread;
+    };
+
+    JobSystem();
+
+    ~JobSystem();
+
+    void Push(Job job);
+
+    /**
+     * Takes a job from the deque of the current worker, the shared queue or another worker, in that order
+     */
+    bool TryPop(Job &job);
+
+    bool TryPopMainThread(Job &job);
+
+    void Execute(Job &job);
+
+    /**
+     * Drops a job that will not run, its counter is finished with an exception
+     */
+    void Cancel(Job &job);
+
+    void Finish(JobCounter &counter, std::exception_ptr exception);
+
+    void WorkerLoop(uint32_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex shared_mutex;
+
+    std::deque<Job> shared_jobs;
+
+    std::mutex main_thread_mutex;
+
+    std::deque<Job> main_thread_jobs;
+
+    /// Jobs in the worker deques and the shared queue, not the main thread queue
+    std::atomic<uint32_t> queued_jobs{0};
+
+    std::atomic<uint32_t> queued_main_thread_jobs{0};
+
+    std::mutex sleep_mutex;
+
+    /// Wakes idle workers when a job is queued
+    std::condition_variable work_condition;
+
+    /// Wakes waiting threads when a counter is done
+    std::condition_variable done_condition;
+
+    /// Set by Shutdown(), checked by the pushes under the lock of their queue
+    std::atomic<bool> stopping{false};
+
+    std::thread::id main_thread_id;
+};
@@ -1,15 +1,321 @@
 #include "Logging/Logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <spdlog/details/os.h>
+
 std::shared_ptr<spdlog::logger> Logger::logger_ = nullptr;
+std::atomic<int> Logger::level_{static_cast<int>(LogLevel::LogINFO)};
+std::atomic<bool> Logger::async_{false};
+std::atomic<int> Logger::producers_{0};
+
+namespace
+{
+    /// Records per thread, a power of two
+    constexpr size_t QueueCapacity = 512;
+
+    /// Sinks are flushed at least this often while messages are written
+    constexpr auto FlushInterval = std::chrono::seconds(1);
+
+    constexpr auto WakeInterval = std::chrono::milliseconds(10);
+
+    /**
+     * Single producer, single consumer ring of records. The producer is the thread the queue belongs to,
+     * the consumer is the logging thread. Head and tail are on their own cache lines so that the two
+     * threads do not write to the same line.
+     */
+    struct LogQueue
+    {
+        alignas(64) std::atomic<size_t> head{0};
+
+        alignas(64) std::atomic<size_t> tail{0};
+
+        /// Set when the thread exits, the queue is removed once it is drained
+        alignas(64) std::atomic<bool> abandoned{false};
+
+        std::unique_ptr<LogRecord[]> records{new LogRecord[QueueCapacity]};
+    };
+
+    struct Backend
+    {
+        std::thread thread;
+
+        /// Guards the queue list, the flag and the flush generations
+        std::mutex mutex;
+
+        std::condition_variable wake;
+
+        std::condition_variable flushed;
+
+        std::vector<std::shared_ptr<LogQueue>> queues;
+
+        bool stop{false};
+
+        uint64_t flushRequested{0};
+
+        uint64_t flushDone{0};
+
+        /// Held while records are written, by the logging thread or by Shutdown
+        std::mutex drainMutex;
+    };
+
+    Backend &GetBackend()
+    {
+        // Never destroyed, threads may still log while static objects are destroyed
+        static auto *backend = new Backend();
+        return *backend;
+    }
+
+    struct LocalQueue
+    {
+        std::shared_ptr<LogQueue> queue;
+
+        ~LocalQueue()
+        {
+            if (queue)
+            {
+                queue->abandoned.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    LogQueue &GetLocalQueue()
+    {
+        thread_local LocalQueue local;
+        if (!local.queue)
+        {
+            local.queue = std::make_shared<LogQueue>();
+
+            auto &backend = GetBackend();
+            std::lock_guard<std::mutex> lock{backend.mutex};
+            backend.queues.push_back(local.queue);
+        }
+        return *local.queue;
+    }
+
+    void FormatString(const LogRecord &record, fmt::memory_buffer &out)
+    {
+        auto &message = *std::launder(reinterpret_cast<const std::string *>(record.storage));
+        out.append(message.data(), message.data() + message.size());
+    }
+
+    void DestroyString(LogRecord &record)
+    {
+        std::launder(reinterpret_cast<std::string *>(record.storage))->~basic_string();
+    }
+
+    void WriteRecord(spdlog::logger &logger, const LogRecord &record, fmt::memory_buffer &buffer)
+    {
+        try
+        {
+            buffer.clear();
+            if (record.site.channel)
+            {
+                fmt::format_to(fmt::appender(buffer), "[{}] ", record.site.channel->GetName());
+            }
+            if (record.site.print_location)
+            {
+                fmt::format_to(fmt::appender(buffer), "[{}:{}] ", record.site.location.filename, record.site.location.line);
+            }
+            record.format_func(record, buffer);
+
+            spdlog::details::log_msg msg{record.time, record.site.location, logger.name(),
+                                         static_cast<spdlog::level::level_enum>(record.level),
+                                         spdlog::string_view_t{buffer.data(), buffer.size()}};
+            msg.thread_id = record.thread_id;
+
+            for (auto &sink : logger.sinks())
+            {
+                if (sink->should_log(msg.level))
+                {
+                    sink->log(msg);
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Logging error: " << e.what() << std::endl;
+        }
+    }
+
+    void FlushSinks(spdlog::logger &logger)
+    {
+        try
+        {
+            for (auto &sink : logger.sinks())
+            {
+                sink->flush();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Logging error: " << e.what() << std::endl;
+        }
+    }
+
+    /**
+     * Writes every committed record of every queue in time order
+     * @return Whether a warning or worse was written
+     */
+    bool Drain(spdlog::logger &logger)
+    {
+        auto &backend = GetBackend();
+        std::lock_guard<std::mutex> drainLock{backend.drainMutex};
+
+        std::vector<std::shared_ptr<LogQueue>> queues;
+        {
+            std::lock_guard<std::mutex> lock{backend.mutex};
+            queues = backend.queues;
+        }
+
+        // Slots stay owned by the consumer until they are written, a full queue makes its thread wait
+        thread_local std::vector<LogRecord *> batch;
+        thread_local std::vector<size_t> tails;
+        batch.clear();
+        tails.resize(queues.size());
+
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            auto &queue = *queues[i];
+            size_t head = queue.head.load(std::memory_order_relaxed);
+            tails[i] = queue.tail.load(std::memory_order_acquire);
+            for (size_t index = head; index != tails[i]; index++)
+            {
+                batch.push_back(&queue.records[index & (QueueCapacity - 1)]);
+            }
+        }
+
+        // Each queue is in order already, the sort interleaves the threads
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](const LogRecord *a, const LogRecord *b) { return a->time < b->time; });
+
+        thread_local fmt::memory_buffer buffer;
+        bool important = false;
+        for (auto *record : batch)
+        {
+            WriteRecord(logger, *record, buffer);
+            record->destroy_func(*record);
+            important |= record->level >= LogLevel::LogWARN;
+        }
+
+        bool abandoned = false;
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            queues[i]->head.store(tails[i], std::memory_order_release);
+            abandoned |= queues[i]->abandoned.load(std::memory_order_acquire);
+        }
+
+        if (abandoned)
+        {
+            std::lock_guard<std::mutex> lock{backend.mutex};
+            backend.queues.erase(std::remove_if(backend.queues.begin(), backend.queues.end(),
+                                                [](const std::shared_ptr<LogQueue> &queue) {
+                                                    return queue->abandoned.load(std::memory_order_acquire) &&
+                                                           queue->head.load(std::memory_order_relaxed) ==
+                                                               queue->tail.load(std::memory_order_acquire);
+                                                }),
+                                 backend.queues.end());
+        }
+
+        return important;
+    }
+
+    void RunBackend(std::shared_ptr<spdlog::logger> logger)
+    {
+        auto &backend = GetBackend();
+        auto lastFlush = std::chrono::steady_clock::now();
+
+        while (true)
+        {
+            uint64_t flushTicket;
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock{backend.mutex};
+                backend.wake.wait_for(lock, WakeInterval, [&backend] {
+                    return backend.stop || backend.flushRequested != backend.flushDone;
+                });
+                flushTicket = backend.flushRequested;
+                stopping = backend.stop;
+            }
+
+            // Everything committed before the flush was requested is drained here
+            bool important = Drain(*logger);
+
+            auto now = std::chrono::steady_clock::now();
+            bool flushRequested = flushTicket != backend.flushDone;
+            if (important || flushRequested || stopping || now - lastFlush >= FlushInterval)
+            {
+                FlushSinks(*logger);
+                lastFlush = now;
+            }
+
+            if (flushRequested)
+            {
+                {
+                    std::lock_guard<std::mutex> lock{backend.mutex};
+                    backend.flushDone = flushTicket;
+                }
+                backend.flushed.notify_all();
+            }
+
+            if (stopping)
+            {
+                break;
+            }
+        }
+    }
+}
+
+LogChannel::LogChannel(const char *name, uint32_t max_per_second, LogLevel level) :
+    name_{name},
+    level_{static_cast<int>(level)},
+    max_per_second_{max_per_second}
+{
+}
+
+bool LogChannel::Admit(LogLevel level)
+{
+    if (static_cast<int>(level) < level_.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    uint32_t maxPerSecond = max_per_second_.load(std::memory_order_relaxed);
+    if (maxPerSecond == 0 || level >= LogLevel::LogERROR)
+    {
+        return true;
+    }
+
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t window = window_.load(std::memory_order_relaxed);
+    if (window != now && window_.compare_exchange_strong(window, now, std::memory_order_relaxed))
+    {
+        count_.store(0, std::memory_order_relaxed);
+        uint32_t suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0 && Logger::ShouldLog(LogLevel::LogWARN, nullptr))
+        {
+            Logger::Log(LogLevel::LogWARN, LogSite{{}, this, false}, "{} messages suppressed", suppressed);
+        }
+    }
+
+    if (count_.fetch_add(1, std::memory_order_relaxed) < maxPerSecond)
+    {
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
 
 void Logger::Init(const std::string& name, LogLevel level,
                   const std::string& filepath, bool async,
                   size_t max_file_size, size_t max_files)
 {
-    if (async)
-    {
-        spdlog::init_thread_pool(8192, 1);
-    }
+    Shutdown();
 
     std::vector<spdlog::sink_ptr> sinks;
     sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
@@ -25,39 +331,30 @@ void Logger::Init(const std::string& name, LogLevel level,
         catch (const std::exception& e)
         {
             std::cerr << "Failed to initialize file logging:" << e.what() << std::endl;
-            if (sinks.empty())
-            {
-                sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
-            }
         }
     }
 
     try
     {
-        if (async)
-        {
-            logger_ = std::make_shared<spdlog::async_logger>(
-                name,
-                sinks.begin(),
-                sinks.end(),
-                spdlog::thread_pool(),
-                spdlog::async_overflow_policy::block
-            );
-        }
-        else
-        {
-            logger_ = std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
-        }
-
-
-        logger_->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] [thread %t] %v");
+        // Only holds the sinks and the pattern, the messages are handed to the sinks directly
+        auto logger = std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
+        logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] [thread %t] %v");
+        logger->set_level(spdlog::level::trace);
+        logger_ = logger;
         SetLevel(level);
-        logger_->flush_on(spdlog::level::warn);
 
         spdlog::set_error_handler([](const std::string& msg)
         {
             std::cerr << "spdlog error: " << msg << std::endl;
         });
+
+        if (async)
+        {
+            auto &backend = GetBackend();
+            backend.stop = false;
+            backend.thread = std::thread(RunBackend, logger);
+            async_.store(true, std::memory_order_release);
+        }
     }
     catch (const std::exception& e)
     {
@@ -66,10 +363,144 @@ void Logger::Init(const std::string& name, LogLevel level,
     }
 }
 
-void Logger::SetLevel(LogLevel level)
+void Logger::Shutdown()
 {
+    auto &backend = GetBackend();
+    if (!backend.thread.joinable())
+    {
+        return;
+    }
+
+    // Threads that saw the logger asynchronous commit their records while the logging thread still
+    // drains them, later ones write synchronously
+    async_.store(false, std::memory_order_seq_cst);
+    while (producers_.load(std::memory_order_seq_cst) != 0)
+    {
+        backend.wake.notify_one();
+        std::this_thread::yield();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{backend.mutex};
+        backend.stop = true;
+    }
+    backend.wake.notify_one();
+    backend.thread.join();
+
+    // Records committed after the last drain of the logging thread
     if (logger_)
     {
-        logger_->set_level(static_cast<spdlog::level::level_enum>(level));
+        Drain(*logger_);
+        FlushSinks(*logger_);
+    }
+    backend.flushed.notify_all();
+}
+
+void Logger::SetLevel(LogLevel level)
+{
+    level_.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Logger::Flush()
+{
+    if (!IsAsync())
+    {
+        if (logger_)
+        {
+            FlushSinks(*logger_);
+        }
+        return;
+    }
+
+    auto &backend = GetBackend();
+    std::unique_lock<std::mutex> lock{backend.mutex};
+    uint64_t ticket = ++backend.flushRequested;
+    backend.wake.notify_one();
+    backend.flushed.wait(lock, [&backend, ticket] { return backend.flushDone >= ticket || backend.stop; });
+}
+
+LogRecord *Logger::BeginRecord(LogLevel level, const LogSite &site)
+{
+    // Pairs with Shutdown, which clears async_ and then waits for producers_ to drop to zero
+    producers_.fetch_add(1, std::memory_order_seq_cst);
+    if (!async_.load(std::memory_order_seq_cst))
+    {
+        producers_.fetch_sub(1, std::memory_order_release);
+        return nullptr;
+    }
+
+    auto &queue = GetLocalQueue();
+    size_t tail = queue.tail.load(std::memory_order_relaxed);
+    while (tail - queue.head.load(std::memory_order_acquire) >= QueueCapacity)
+    {
+        if (!async_.load(std::memory_order_acquire))
+        {
+            producers_.fetch_sub(1, std::memory_order_release);
+            return nullptr;
+        }
+        GetBackend().wake.notify_one();
+        std::this_thread::yield();
+    }
+
+    auto &record = queue.records[tail & (QueueCapacity - 1)];
+    record.time = spdlog::log_clock::now();
+    record.site = site;
+    record.thread_id = spdlog::details::os::thread_id();
+    record.level = level;
+    return &record;
+}
+
+void Logger::CommitRecord(LogRecord &record)
+{
+    auto &queue = GetLocalQueue();
+    queue.tail.store(queue.tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    producers_.fetch_sub(1, std::memory_order_release);
+
+    if (record.level >= LogLevel::LogCRITICAL)
+    {
+        // The process may be about to go down
+        Flush();
+    }
+    else if (record.level >= LogLevel::LogWARN)
+    {
+        GetBackend().wake.notify_one();
+    }
+}
+
+void Logger::WriteMessage(LogLevel level, const LogSite &site, std::string message)
+{
+    if (IsAsync())
+    {
+        if (auto *record = BeginRecord(level, site))
+        {
+            new (record->storage) std::string(std::move(message));
+            record->format = {};
+            record->format_func = FormatString;
+            record->destroy_func = DestroyString;
+            CommitRecord(*record);
+            return;
+        }
+    }
+
+    if (!logger_)
+    {
+        return;
+    }
+
+    LogRecord record;
+    record.time = spdlog::log_clock::now();
+    record.site = site;
+    record.thread_id = spdlog::details::os::thread_id();
+    record.level = level;
+    new (record.storage) std::string(std::move(message));
+    record.format_func = FormatString;
+
+    thread_local fmt::memory_buffer buffer;
+    WriteRecord(*logger_, record, buffer);
+    DestroyString(record);
+
+    if (level >= LogLevel::LogWARN)
+    {
+        FlushSinks(*logger_);
     }
 }
@@ -0,0 +1,188 @@
+#include "Memory/AllocationCounter.hpp"
+
+#ifdef CYRENGINE_COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> allocation_count{0};
+
+    thread_local uint64_t thread_allocation_count = 0;
+
+    void *counted_malloc(std::size_t size)
+    {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        thread_allocation_count++;
+        return std::malloc(size ? size : 1);
+    }
+
+    void *counted_aligned_malloc(std::size_t size, std::size_t alignment)
+    {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        thread_allocation_count++;
+#if defined(_MSC_VER)
+        return _aligned_malloc(size ? size : 1, alignment);
+#else
+        // aligned_alloc wants a multiple of the alignment
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    }
+
+    void aligned_free(void *p)
+    {
+#if defined(_MSC_VER)
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+} // namespace
+
+// Core is a static library, executables linking it are told to keep this symbol so the object file and the
+// replacements below are linked in even when nothing calls AllocationCounter
+extern "C"
+{
+    int cyrengine_allocation_counter_anchor = 0;
+}
+
+// The array and sized forms of the standard library forward to these
+void *operator new(std::size_t size)
+{
+    if (void *p = counted_malloc(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_malloc(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_malloc(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void *p = counted_aligned_malloc(size, static_cast<std::size_t>(alignment)))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return counted_aligned_malloc(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return counted_aligned_malloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    aligned_free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    aligned_free(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    aligned_free(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    aligned_free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    aligned_free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept
+{
+    aligned_free(p);
+}
+
+bool AllocationCounter::IsEnabled()
+{
+    return true;
+}
+
+uint64_t AllocationCounter::GetCount()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::GetThreadCount()
+{
+    return thread_allocation_count;
+}
+#else
+bool AllocationCounter::IsEnabled()
+{
+    return false;
+}
+
+uint64_t AllocationCounter::GetCount()
+{
+    return 0;
+}
+
+uint64_t AllocationCounter::GetThreadCount()
+{
+    return 0;
+}
+#endif
@@ -0,0 +1,59 @@
+#include "Memory/FrameAllocator.hpp"
+
+#include <atomic>
+
+namespace
+{
+    std::atomic<uint64_t> frame_index{0};
+
+    struct ThreadArena
+    {
+        LinearArena arena{256 * 1024};
+
+        /// Frame the arena was last reset for
+        uint64_t frame{0};
+    };
+
+    thread_local ThreadArena thread_arena;
+} // namespace
+
+void FrameAllocator::BeginFrame()
+{
+    frame_index.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t FrameAllocator::GetFrameIndex()
+{
+    return frame_index.load(std::memory_order_relaxed);
+}
+
+LinearArena &FrameAllocator::GetThreadArena()
+{
+    uint64_t frame = GetFrameIndex();
+    if (thread_arena.frame != frame)
+    {
+        thread_arena.arena.Reset();
+        thread_arena.frame = frame;
+    }
+
+    return thread_arena.arena;
+}
+
+std::pmr::memory_resource *FrameAllocator::GetResource()
+{
+    return &GetThreadArena();
+}
+
+ScopedArena::ScopedArena() : arena{FrameAllocator::GetThreadArena()}, marker{arena.GetMarker()}
+{
+}
+
+ScopedArena::~ScopedArena()
+{
+    arena.Rewind(marker);
+}
+
+std::pmr::memory_resource *ScopedArena::GetResource() const
+{
+    return &arena;
+}
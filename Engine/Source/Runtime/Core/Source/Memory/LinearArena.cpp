@@ -0,0 +1,122 @@
+#include "Memory/LinearArena.hpp"
+
+#include <algorithm>
+
+LinearArena::LinearArena(size_t block_size) : block_size{std::max<size_t>(block_size, 256)}
+{
+}
+
+void *LinearArena::Allocate(size_t size, size_t alignment)
+{
+    size = std::max<size_t>(size, 1);
+
+    for (;;)
+    {
+        if (current_block < blocks.size())
+        {
+            auto &block = blocks[current_block];
+
+            auto base = reinterpret_cast<uintptr_t>(block.data.get());
+            size_t aligned = ((base + offset + alignment - 1) & ~(uintptr_t{alignment} - 1)) - base;
+
+            if (aligned + size <= block.size)
+            {
+                offset = aligned + size;
+                peak = std::max(peak, GetUsed());
+                return block.data.get() + aligned;
+            }
+
+            // The tail of the block stays unused until the next Reset()
+            filled += block.size;
+            current_block++;
+            offset = 0;
+            continue;
+        }
+
+        AddBlock(std::max(block_size, size + alignment));
+    }
+}
+
+LinearArena::Marker LinearArena::GetMarker() const
+{
+    return {generation, current_block, offset};
+}
+
+void LinearArena::Rewind(const Marker &marker)
+{
+    if (marker.generation != generation || marker.block > current_block ||
+        (marker.block == current_block && marker.offset > offset))
+    {
+        return;
+    }
+
+    current_block = marker.block;
+    offset = marker.offset;
+
+    filled = 0;
+    for (size_t i = 0; i < current_block; i++)
+    {
+        filled += blocks[i].size;
+    }
+}
+
+void LinearArena::Reset()
+{
+    if (blocks.size() > 1)
+    {
+        size_t capacity = 0;
+        for (auto &block : blocks)
+        {
+            capacity += block.size;
+        }
+
+        blocks.clear();
+        AddBlock(capacity);
+    }
+
+    current_block = 0;
+    offset = 0;
+    filled = 0;
+    generation++;
+}
+
+LinearArena::Stats LinearArena::GetStats() const
+{
+    Stats stats;
+    stats.used = GetUsed();
+    stats.peak = peak;
+    stats.block_allocations = block_allocations;
+
+    for (auto &block : blocks)
+    {
+        stats.capacity += block.size;
+    }
+
+    return stats;
+}
+
+void *LinearArena::do_allocate(size_t bytes, size_t alignment)
+{
+    return Allocate(bytes, alignment);
+}
+
+void LinearArena::do_deallocate(void *, size_t, size_t)
+{
+}
+
+bool LinearArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+void LinearArena::AddBlock(size_t size)
+{
+    // Not value initialized, new[] alone leaves the bytes as they are
+    blocks.push_back({std::unique_ptr<std::byte[]>{new std::byte[size]}, size});
+    block_allocations++;
+}
+
+size_t LinearArena::GetUsed() const
+{
+    return current_block < blocks.size() ? filled + offset : filled;
+}
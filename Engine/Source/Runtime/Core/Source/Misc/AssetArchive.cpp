@@ -0,0 +1,269 @@
+#include "Misc/AssetArchive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <zstd.h>
+
+#include "Logging/Logger.hpp"
+#include "Misc/Hash.hpp"
+
+static_assert(sizeof(AssetArchive::Header) == 32, "The header is part of the file format");
+static_assert(sizeof(AssetArchive::Entry) == 48, "The entries are part of the file format");
+
+namespace
+{
+    constexpr uint64_t DataAlignment = 16;
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool EntryLess(const AssetArchive::Entry &a, const AssetArchive::Entry &b)
+    {
+        return a.pathHash < b.pathHash;
+    }
+
+    void WritePadding(std::ofstream &file, uint64_t &offset, uint64_t alignment)
+    {
+        static const char zeros[DataAlignment] = {};
+        uint64_t aligned = AlignUp(offset, alignment);
+        file.write(zeros, static_cast<std::streamsize>(aligned - offset));
+        offset = aligned;
+    }
+} // namespace
+
+std::unique_ptr<AssetArchive> AssetArchive::Open(const std::filesystem::path &path)
+{
+    std::unique_ptr<AssetArchive> archive{new AssetArchive};
+    archive->filePath = path;
+    archive->file = std::make_shared<const MappedFile>(MappedFile::Open(path));
+
+    auto &file = *archive->file;
+    if (file.Size() < sizeof(Header))
+    {
+        throw std::runtime_error("Not an asset archive: " + path.string());
+    }
+
+    Header header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (header.magic != Magic || header.version != Version)
+    {
+        throw std::runtime_error("Not an asset archive or an unsupported version: " + path.string());
+    }
+
+    uint64_t entriesSize = static_cast<uint64_t>(header.entryCount) * sizeof(Entry);
+    if (header.indexOffset > file.Size() || header.indexSize > file.Size() - header.indexOffset ||
+        entriesSize > header.indexSize)
+    {
+        throw std::runtime_error("Corrupt asset archive index: " + path.string());
+    }
+
+    archive->entries.resize(header.entryCount);
+    std::memcpy(archive->entries.data(), file.Data() + header.indexOffset, entriesSize);
+
+    archive->paths = reinterpret_cast<const char *>(file.Data() + header.indexOffset + entriesSize);
+    archive->pathsSize = header.indexSize - entriesSize;
+
+    for (auto &entry : archive->entries)
+    {
+        if (entry.offset > file.Size() || entry.storedSize > file.Size() - entry.offset ||
+            static_cast<uint64_t>(entry.pathOffset) + entry.pathLength > archive->pathsSize)
+        {
+            throw std::runtime_error("Corrupt asset archive entry: " + path.string());
+        }
+    }
+
+    return archive;
+}
+
+void AssetArchive::Build(const std::filesystem::path &directory, const std::filesystem::path &archivePath,
+                         const ArchiveBuildOptions &options)
+{
+    std::vector<std::filesystem::path> files;
+    for (auto &item : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (item.is_regular_file())
+        {
+            files.push_back(item.path());
+        }
+    }
+
+    // Sorted so the same directory always produces the same archive
+    std::sort(files.begin(), files.end());
+
+    auto tempPath = archivePath;
+    tempPath += ".tmp";
+
+    if (archivePath.has_parent_path())
+    {
+        std::filesystem::create_directories(archivePath.parent_path());
+    }
+
+    std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        throw std::runtime_error("Failed to create file: " + tempPath.string());
+    }
+
+    // The header is written last, once the index offset is known
+    Header header{};
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    uint64_t offset = sizeof(header);
+
+    std::vector<Entry> entries;
+    std::string paths;
+    std::vector<uint8_t> compressed;
+
+    for (auto &filePath : files)
+    {
+        auto path = NormalizePath(std::filesystem::relative(filePath, directory).generic_string());
+        if (path.size() > UINT16_MAX)
+        {
+            throw std::runtime_error("Path too long for an asset archive: " + path);
+        }
+
+        auto contents = MappedFile::Open(filePath);
+
+        Entry entry{};
+        entry.pathHash = Hash::Hash64(path.data(), path.size());
+        entry.size = contents.Size();
+        entry.contentHash = Hash::Hash64(contents.Data(), contents.Size());
+        entry.pathOffset = static_cast<uint32_t>(paths.size());
+        entry.pathLength = static_cast<uint16_t>(path.size());
+        entry.compression = ArchiveCompression::None;
+
+        const uint8_t *stored = contents.Data();
+        size_t storedSize = contents.Size();
+
+        if (options.compressionLevel > 0 && !contents.Empty())
+        {
+            compressed.resize(ZSTD_compressBound(contents.Size()));
+            size_t result = ZSTD_compress(compressed.data(), compressed.size(), contents.Data(), contents.Size(),
+                                          options.compressionLevel);
+            if (!ZSTD_isError(result) &&
+                static_cast<float>(result) <= static_cast<float>(contents.Size()) * (1.0f - options.minSavings))
+            {
+                entry.compression = ArchiveCompression::Zstd;
+                stored = compressed.data();
+                storedSize = result;
+            }
+        }
+
+        WritePadding(output, offset, DataAlignment);
+        entry.offset = offset;
+        entry.storedSize = storedSize;
+
+        output.write(reinterpret_cast<const char *>(stored), static_cast<std::streamsize>(storedSize));
+        offset += storedSize;
+
+        paths += path;
+        entries.push_back(entry);
+    }
+
+    std::sort(entries.begin(), entries.end(), EntryLess);
+    for (size_t i = 1; i < entries.size(); i++)
+    {
+        if (entries[i].pathHash == entries[i - 1].pathHash)
+        {
+            throw std::runtime_error("Two paths of the archive have the same hash: " +
+                                     paths.substr(entries[i].pathOffset, entries[i].pathLength));
+        }
+    }
+
+    WritePadding(output, offset, DataAlignment);
+    header.magic = Magic;
+    header.version = Version;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.indexOffset = offset;
+    header.indexSize = entries.size() * sizeof(Entry) + paths.size();
+
+    output.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+    output.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+    output.seekp(0);
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.close();
+
+    if (!output)
+    {
+        throw std::runtime_error("Failed to write file: " + tempPath.string());
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, archivePath, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        throw std::runtime_error("Failed to replace file: " + archivePath.string());
+    }
+
+    LOGI("Packed {} files of {} into {}", entries.size(), directory.string(), archivePath.string());
+}
+
+std::string AssetArchive::NormalizePath(const std::string &path)
+{
+    auto normalized = std::filesystem::path{path}.lexically_normal().generic_string();
+
+    size_t start = normalized.find_first_not_of('/');
+    if (start == std::string::npos || normalized == ".")
+    {
+        return {};
+    }
+    return normalized.substr(start);
+}
+
+const AssetArchive::Entry *AssetArchive::Find(const std::string &path) const
+{
+    Entry key{};
+    key.pathHash = Hash::Hash64(path.data(), path.size());
+
+    auto it = std::lower_bound(entries.begin(), entries.end(), key, EntryLess);
+    if (it == entries.end() || it->pathHash != key.pathHash)
+    {
+        return nullptr;
+    }
+
+    // A path of another archive could share the hash
+    if (it->pathLength != path.size() || std::memcmp(paths + it->pathOffset, path.data(), path.size()) != 0)
+    {
+        return nullptr;
+    }
+
+    return &*it;
+}
+
+MappedFile AssetArchive::Read(const Entry &entry) const
+{
+    if (entry.compression == ArchiveCompression::None)
+    {
+        return MappedFile::Slice(file, entry.offset, entry.storedSize);
+    }
+
+    std::vector<uint8_t> contents(entry.size);
+    size_t result = ZSTD_decompress(contents.data(), contents.size(), file->Data() + entry.offset, entry.storedSize);
+    if (ZSTD_isError(result) || result != entry.size ||
+        Hash::Hash64(contents.data(), contents.size()) != entry.contentHash)
+    {
+        throw std::runtime_error("Corrupt entry " + GetPath(entry) + " in " + filePath.string());
+    }
+
+    return MappedFile::FromBuffer(std::move(contents));
+}
+
+std::string AssetArchive::GetPath(const Entry &entry) const
+{
+    return std::string(paths + entry.pathOffset, entry.pathLength);
+}
+
+const std::vector<AssetArchive::Entry> &AssetArchive::GetEntries() const
+{
+    return entries;
+}
+
+const std::filesystem::path &AssetArchive::GetFilePath() const
+{
+    return filePath;
+}
@@ -1,24 +1,27 @@
 #include "Misc/FileLoader.hpp"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include "SubSystems/JobSystem.hpp"
 
 std::vector<uint32_t> FileLoader::ReadShaderBinaryU32(const std::string &filename)
 {
-    // 调用ReadFileBinary获取原始二进制数据
-    std::vector<uint8_t> binaryData = ReadFileBinary(filename);
+    // 映射文件, 只拷贝一次到结果中
+    auto file = MapFile(filename);
 
     // 检查数据大小是否是4的倍数(因为我们要转换为uint32_t)
-    if (binaryData.size() % sizeof(uint32_t) != 0)
+    if (file.Size() % sizeof(uint32_t) != 0)
     {
         throw std::runtime_error("Shader binary file size is not a multiple of 4 bytes");
     }
 
-    // 将uint8_t数据转换为uint32_t
-    std::vector<uint32_t> result;
-    result.resize(binaryData.size() / sizeof(uint32_t));
-    std::memcpy(result.data(), binaryData.data(), binaryData.size());
-
-    return result;
+    auto words = reinterpret_cast<const uint32_t *>(file.Data());
+    return std::vector<uint32_t>(words, words + file.Size() / sizeof(uint32_t));
 }
 
 std::vector<uint8_t> FileLoader::ReadFileBinary(const std::filesystem::path &path)
@@ -46,15 +49,78 @@ std::vector<uint8_t> FileLoader::ReadFileBinary(const std::filesystem::path &pat
 
 std::string FileLoader::ReadFileString(const std::filesystem::path &path)
 {
-    // 调用ReadFileBinary获取二进制数据
-    std::vector<uint8_t> binaryData = ReadFileBinary(path);
-
-    // 将二进制数据转换为字符串
-    return std::string(reinterpret_cast<const char *>(binaryData.data()), binaryData.size());
+    // 映射文件后直接构造字符串, 不经过中间的 vector
+    auto file = MapFile(path);
+    return std::string(reinterpret_cast<const char *>(file.Data()), file.Size());
 }
 
 std::string FileLoader::ReadTextFile(const std::string &filename)
 {
     // 调用FileLoader::ReadFileString
     return FileLoader::ReadFileString(filename);
+}
+
+MappedFile FileLoader::MapFile(const std::filesystem::path &path)
+{
+    return MappedFile::Open(path);
+}
+
+void FileLoader::ReadFilesAsync(const std::vector<std::filesystem::path> &paths, std::vector<MappedFile> &files,
+                                JobCounter &counter)
+{
+    files.clear();
+    files.resize(paths.size());
+
+    auto &jobSystem = JobSystem::GetInstance();
+    auto count = static_cast<uint32_t>(paths.size());
+    uint32_t batchSize = jobSystem.GetGrainSize(count);
+
+    // 每个任务打开连续的一批文件, 小文件不必各占一个任务
+    for (uint32_t begin = 0; begin < count; begin += batchSize)
+    {
+        uint32_t end = std::min(count, begin + batchSize);
+        std::vector<std::filesystem::path> batch(paths.begin() + begin, paths.begin() + end);
+
+        jobSystem.Run([&files, batch = std::move(batch), begin]()
+        {
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                files[begin + i] = MappedFile::Open(batch[i]);
+            }
+        }, &counter);
+    }
+}
+
+void FileLoader::WriteFileBinary(const std::filesystem::path &path, const void *data, size_t size)
+{
+    if (path.has_parent_path())
+    {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    // 临时文件名带上线程 id, 多个线程写同一个目标时互不干扰
+    auto tempPath = path;
+    tempPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to create file: " + tempPath.string());
+        }
+
+        if (!file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size)))
+        {
+            throw std::runtime_error("Failed to write file: " + tempPath.string());
+        }
+    }
+
+    // rename 覆盖已存在的目标
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        throw std::runtime_error("Failed to replace file: " + path.string());
+    }
 }
\ No newline at end of file
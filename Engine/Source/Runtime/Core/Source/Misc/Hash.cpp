@@ -0,0 +1,130 @@
+#include "Misc/Hash.hpp"
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
+#endif
+
+namespace
+{
+    constexpr uint64_t kSecret0 = 0xa0761d6478bd642full;
+    constexpr uint64_t kSecret1 = 0xe7037ed1a0b428dbull;
+    constexpr uint64_t kSecret2 = 0x8ebc6af09c88c6e3ull;
+    constexpr uint64_t kSecret3 = 0x589965cc75374cc3ull;
+
+    // 64x64 -> 128 位乘法, 高低两半异或
+    inline uint64_t Mix(uint64_t a, uint64_t b)
+    {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t r = static_cast<__uint128_t>(a) * b;
+        return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        uint64_t high;
+        uint64_t low = _umul128(a, b, &high);
+        return low ^ high;
+#else
+        uint64_t ha = a >> 32, la = static_cast<uint32_t>(a);
+        uint64_t hb = b >> 32, lb = static_cast<uint32_t>(b);
+        uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        uint64_t t = rl + (rm0 << 32);
+        uint64_t c = t < rl;
+        uint64_t low = t + (rm1 << 32);
+        c += low < t;
+        uint64_t high = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+        return low ^ high;
+#endif
+    }
+
+    inline uint64_t Read64(const uint8_t *p)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t Read32(const uint8_t *p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // 1 到 3 字节的尾部
+    inline uint64_t Read3(const uint8_t *p, size_t k)
+    {
+        return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[k >> 1]) << 8) | p[k - 1];
+    }
+}
+
+uint64_t Hash::Hash64(const void *data, size_t size, uint64_t seed)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    seed ^= Mix(seed ^ kSecret0, kSecret1);
+
+    uint64_t a;
+    uint64_t b;
+    if (size <= 16)
+    {
+        if (size >= 4)
+        {
+            a = (Read32(p) << 32) | Read32(p + ((size >> 3) << 2));
+            b = (Read32(p + size - 4) << 32) | Read32(p + size - 4 - ((size >> 3) << 2));
+        }
+        else if (size > 0)
+        {
+            a = Read3(p, size);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        size_t i = size;
+        if (i > 48)
+        {
+            // 三条独立的链, 让长输入可以并行执行乘法
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do
+            {
+                seed = Mix(Read64(p) ^ kSecret1, Read64(p + 8) ^ seed);
+                see1 = Mix(Read64(p + 16) ^ kSecret2, Read64(p + 24) ^ see1);
+                see2 = Mix(Read64(p + 32) ^ kSecret3, Read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = Mix(Read64(p) ^ kSecret1, Read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = Read64(p + i - 16);
+        b = Read64(p + i - 8);
+    }
+
+    return Mix(kSecret1 ^ static_cast<uint64_t>(size), Mix(a ^ kSecret1, b ^ seed));
+}
+
+uint64_t Hash::Combine(uint64_t hash, uint64_t value)
+{
+    return Mix(hash ^ kSecret0, value ^ kSecret2);
+}
+
+std::string Hash::ToHex(uint64_t hash)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string result(16, '0');
+    for (int i = 15; i >= 0; --i)
+    {
+        result[i] = digits[hash & 0xf];
+        hash >>= 4;
+    }
+    return result;
+}
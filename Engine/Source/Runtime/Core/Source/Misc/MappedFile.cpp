@@ -0,0 +1,214 @@
+#include "Misc/MappedFile.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    void ReadInto(const std::filesystem::path &path, std::vector<uint8_t> &buffer)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open file: " + path.string());
+        }
+
+        std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+
+        buffer.resize(static_cast<size_t>(size));
+        if (!file.read(reinterpret_cast<char *>(buffer.data()), size))
+        {
+            throw std::runtime_error("Failed to read file: " + path.string());
+        }
+    }
+} // namespace
+
+MappedFile::~MappedFile()
+{
+    Release();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+
+        // Moving a vector keeps its storage, data stays valid for buffered files
+        buffer = std::move(other.buffer);
+        parent = std::move(other.parent);
+        data = other.data;
+        size = other.size;
+        mapped = other.mapped;
+#if defined(_WIN32)
+        mapping = other.mapping;
+        other.mapping = nullptr;
+#endif
+
+        other.data = nullptr;
+        other.size = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+MappedFile MappedFile::Open(const std::filesystem::path &path)
+{
+    MappedFile file;
+
+    std::error_code error;
+    auto file_size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+
+    if (file_size < MapThreshold)
+    {
+        ReadInto(path, file.buffer);
+        file.data = file.buffer.data();
+        file.size = file.buffer.size();
+        return file;
+    }
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+
+    // The view keeps the mapping and the mapping keeps the file open, both handles can be closed
+    HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (!mapping)
+    {
+        throw std::runtime_error("Failed to map file: " + path.string());
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        throw std::runtime_error("Failed to map file: " + path.string());
+    }
+
+    file.mapping = mapping;
+    file.data = static_cast<const uint8_t *>(view);
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+
+    void *view = ::mmap(nullptr, static_cast<size_t>(file_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (view == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map file: " + path.string());
+    }
+
+    // Assets are decoded front to back
+    ::madvise(view, static_cast<size_t>(file_size), MADV_SEQUENTIAL);
+
+    file.data = static_cast<const uint8_t *>(view);
+#endif
+
+    file.size = static_cast<size_t>(file_size);
+    file.mapped = true;
+    return file;
+}
+
+MappedFile MappedFile::FromBuffer(std::vector<uint8_t> buffer)
+{
+    MappedFile file;
+    file.buffer = std::move(buffer);
+    file.data = file.buffer.data();
+    file.size = file.buffer.size();
+    return file;
+}
+
+MappedFile MappedFile::Slice(std::shared_ptr<const MappedFile> parent, size_t offset, size_t size)
+{
+    if (!parent || offset > parent->Size() || size > parent->Size() - offset)
+    {
+        throw std::runtime_error("Slice out of the bounds of its file");
+    }
+
+    MappedFile file;
+    file.data = parent->Data() + offset;
+    file.size = size;
+    file.parent = std::move(parent);
+    return file;
+}
+
+const uint8_t *MappedFile::Data() const
+{
+    return data;
+}
+
+size_t MappedFile::Size() const
+{
+    return size;
+}
+
+bool MappedFile::Empty() const
+{
+    return size == 0;
+}
+
+bool MappedFile::IsMapped() const
+{
+    return mapped;
+}
+
+const uint8_t *MappedFile::begin() const
+{
+    return data;
+}
+
+const uint8_t *MappedFile::end() const
+{
+    return data + size;
+}
+
+void MappedFile::Release()
+{
+    if (mapped)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        ::munmap(const_cast<uint8_t *>(data), size);
+#endif
+    }
+
+    buffer.clear();
+    parent.reset();
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
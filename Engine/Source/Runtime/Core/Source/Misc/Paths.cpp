@@ -37,34 +37,57 @@ std::string Paths::GetCurrentExecutablePath()
     return std::string(path);
 }
 
-std::string Paths::GetAssetPath()
+namespace
 {
-    fs::path exePath = fs::canonical(GetCurrentExecutablePath());
-    fs::path binDir = exePath.parent_path();
-
-    fs::path projectRoot = binDir;
-    for (int i = 0; i < 8; ++i)
+    fs::path FindProjectRoot()
     {
-        if (fs::exists(projectRoot / "CMakeLists.txt"))
+        fs::path exePath = fs::canonical(Paths::GetCurrentExecutablePath());
+        fs::path binDir = exePath.parent_path();
+
+        fs::path projectRoot = binDir;
+        for (int i = 0; i < 8; ++i)
+        {
+            if (fs::exists(projectRoot / "CMakeLists.txt"))
+            {
+                break;
+            }
+            projectRoot = projectRoot.parent_path();
+        }
+
+        if (!fs::exists(projectRoot / "CMakeLists.txt"))
         {
-            break;
+            throw std::runtime_error("Could not find project root directory.");
         }
-        projectRoot = projectRoot.parent_path();
+
+        return projectRoot;
     }
 
-    if (!fs::exists(projectRoot / "CMakeLists.txt"))
+    /**
+     * The directories never move while the engine runs, they are searched for once.
+     * A throwing initializer leaves the static uninitialized, the next call searches again.
+     */
+    const fs::path &GetProjectRoot()
     {
-        throw std::runtime_error("Could not find project root directory.");
+        static const fs::path projectRoot = FindProjectRoot();
+        return projectRoot;
     }
+} // namespace
 
-    fs::path assetPath = projectRoot / "Assets";
-
-    if (!fs::exists(assetPath))
+std::string Paths::GetAssetPath()
+{
+    static const std::string assetPath = []()
     {
-        throw std::runtime_error("Asset directory not found: " + assetPath.string());
-    }
+        fs::path path = GetProjectRoot() / "Assets";
+
+        if (!fs::exists(path))
+        {
+            throw std::runtime_error("Asset directory not found: " + path.string());
+        }
+
+        return path.string();
+    }();
 
-    return assetPath.string();
+    return assetPath;
 }
 
 std::string Paths::GetAssetFullPath(const std::string &relativePath)
@@ -74,32 +97,19 @@ std::string Paths::GetAssetFullPath(const std::string &relativePath)
 
 std::string Paths::GetShaderPath()
 {
-    fs::path exePath = fs::canonical(GetCurrentExecutablePath());
-    fs::path binDir = exePath.parent_path();
-
-    fs::path projectRoot = binDir;
-    for (int i = 0; i < 8; ++i)
+    static const std::string shaderPath = []()
     {
-        if (fs::exists(projectRoot / "CMakeLists.txt"))
+        fs::path path = GetProjectRoot() / "Engine/Shaders";
+
+        if (!fs::exists(path))
         {
-            break;
+            throw std::runtime_error("Shaders/spv directory not found: " + path.string());
         }
-        projectRoot = projectRoot.parent_path();
-    }
 
-    if (!fs::exists(projectRoot / "CMakeLists.txt"))
-    {
-        throw std::runtime_error("Could not find project root directory.");
-    }
-
-    fs::path assetPath = projectRoot / "Engine/Shaders";
-
-    if (!fs::exists(assetPath))
-    {
-        throw std::runtime_error("Shaders/spv directory not found: " + assetPath.string());
-    }
+        return path.string();
+    }();
 
-    return assetPath.string();
+    return shaderPath;
 }
 
 std::string Paths::GetShaderFullPath(const std::string& relativePath)
@@ -0,0 +1,172 @@
+#include "Misc/VirtualFileSystem.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+#include "Logging/Logger.hpp"
+
+void VirtualFileSystem::MountDirectory(const std::string &mountPoint, const std::filesystem::path &directory)
+{
+    auto mount = std::make_shared<Mount>();
+    mount->point = AssetArchive::NormalizePath(mountPoint);
+    mount->directory = directory;
+
+    AddMount(std::move(mount));
+    LOGI("Mounted {} at /{}", directory.string(), AssetArchive::NormalizePath(mountPoint));
+}
+
+void VirtualFileSystem::MountArchive(const std::string &mountPoint, const std::filesystem::path &archivePath)
+{
+    auto mount = std::make_shared<Mount>();
+    mount->point = AssetArchive::NormalizePath(mountPoint);
+    mount->archive = AssetArchive::Open(archivePath);
+
+    size_t entryCount = mount->archive->GetEntries().size();
+    AddMount(std::move(mount));
+    LOGI("Mounted {} with {} files at /{}", archivePath.string(), entryCount, AssetArchive::NormalizePath(mountPoint));
+}
+
+void VirtualFileSystem::Unmount(const std::string &mountPoint)
+{
+    auto point = AssetArchive::NormalizePath(mountPoint);
+
+    std::unique_lock<std::shared_mutex> lock{mutex};
+    mounts.erase(std::remove_if(mounts.begin(), mounts.end(),
+                                [&point](const std::shared_ptr<const Mount> &mount) { return mount->point == point; }),
+                 mounts.end());
+    resolved.clear();
+    generation++;
+}
+
+void VirtualFileSystem::ClearCache()
+{
+    std::unique_lock<std::shared_mutex> lock{mutex};
+    resolved.clear();
+}
+
+bool VirtualFileSystem::Exists(const std::string &path)
+{
+    Location location;
+    return Resolve(path, location);
+}
+
+MappedFile VirtualFileSystem::Read(const std::string &path)
+{
+    Location location;
+    if (!Resolve(path, location))
+    {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+
+    // The location holds the mount, the archive stays open while its entry is read
+    if (location.entry)
+    {
+        return location.mount->archive->Read(*location.entry);
+    }
+    return MappedFile::Open(location.diskPath);
+}
+
+std::filesystem::path VirtualFileSystem::GetDiskPath(const std::string &path)
+{
+    Location location;
+    if (!Resolve(path, location))
+    {
+        return {};
+    }
+    return location.diskPath;
+}
+
+void VirtualFileSystem::AddMount(std::shared_ptr<const Mount> mount)
+{
+    std::unique_lock<std::shared_mutex> lock{mutex};
+    mounts.push_back(std::move(mount));
+
+    // A new mount can shadow paths resolved before
+    resolved.clear();
+    generation++;
+}
+
+bool VirtualFileSystem::Resolve(const std::string &path, Location &location)
+{
+    std::vector<std::shared_ptr<const Mount>> candidates;
+    uint64_t candidatesGeneration;
+    {
+        std::shared_lock<std::shared_mutex> lock{mutex};
+
+        auto it = resolved.find(path);
+        if (it != resolved.end())
+        {
+            location = it->second;
+            return true;
+        }
+
+        candidates = mounts;
+        candidatesGeneration = generation;
+    }
+
+    // Looked up without the lock, the file system calls of directory mounts may be slow
+    std::error_code error;
+    bool found = false;
+
+    if (!std::filesystem::path{path}.is_absolute())
+    {
+        auto normalized = AssetArchive::NormalizePath(path);
+
+        for (auto it = candidates.rbegin(); it != candidates.rend() && !found; ++it)
+        {
+            auto &mount = *it;
+
+            std::string relative;
+            if (mount->point.empty())
+            {
+                relative = normalized;
+            }
+            else if (normalized.size() > mount->point.size() && normalized.compare(0, mount->point.size(), mount->point) == 0 &&
+                     normalized[mount->point.size()] == '/')
+            {
+                relative = normalized.substr(mount->point.size() + 1);
+            }
+            else
+            {
+                continue;
+            }
+
+            if (mount->archive)
+            {
+                if (auto entry = mount->archive->Find(relative))
+                {
+                    location = {mount, entry, {}};
+                    found = true;
+                }
+            }
+            else
+            {
+                auto diskPath = mount->directory / relative;
+                if (std::filesystem::is_regular_file(diskPath, error))
+                {
+                    location = {mount, nullptr, std::move(diskPath)};
+                    found = true;
+                }
+            }
+        }
+    }
+
+    if (!found)
+    {
+        // Absolute paths, and relative ones no mount contains, are plain files
+        if (!std::filesystem::is_regular_file(path, error))
+        {
+            return false;
+        }
+        location = {nullptr, nullptr, path};
+    }
+
+    // Not cached if the mounts changed meanwhile, the result may already be shadowed
+    std::unique_lock<std::shared_mutex> lock{mutex};
+    if (generation == candidatesGeneration)
+    {
+        resolved.emplace(path, location);
+    }
+    return true;
+}
@@ -0,0 +1,377 @@
+#include "Profiler/Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include "Logging/Logger.hpp"
+
+namespace
+{
+    /// Events kept per track, a power of two
+    constexpr size_t track_capacity = 1 << 15;
+
+    /// Frames kept for GetFrames() and the trace
+    constexpr size_t frame_capacity = 512;
+
+    thread_local ProfileTrack *thread_track = nullptr;
+
+    void append_escaped(std::string &out, const char *text)
+    {
+        for (; *text; text++)
+        {
+            char c = *text;
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+
+    void append_format(std::string &out, const char *format, double a, double b = 0.0)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), format, a, b);
+        out += buffer;
+    }
+} // namespace
+
+const std::string &ProfileTrack::GetName() const
+{
+    return name;
+}
+
+uint32_t ProfileTrack::GetId() const
+{
+    return id;
+}
+
+void ProfileTrack::Lock()
+{
+    while (locked.exchange(true, std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+}
+
+void ProfileTrack::Unlock()
+{
+    locked.store(false, std::memory_order_release);
+}
+
+void ProfileTrack::Push(const ProfileEvent &event)
+{
+    Lock();
+    events[write_count & (events.size() - 1)] = event;
+    write_count++;
+    Unlock();
+}
+
+Profiler::Profiler() : start_time{Now()}, frames(frame_capacity)
+{
+}
+
+uint64_t Profiler::Now()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::SetEnabled(bool enabled_)
+{
+    enabled.store(enabled_, std::memory_order_relaxed);
+}
+
+bool Profiler::IsEnabled() const
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::BeginFrame()
+{
+    uint64_t now = Now();
+
+    {
+        std::lock_guard<std::mutex> lock{frames_mutex};
+        if (frame_start != 0)
+        {
+            frames[frame_count % frames.size()] = {frame_start, now};
+            frame_count++;
+        }
+        frame_start = now;
+    }
+
+    std::vector<ProfileTrack::Counter> totals;
+
+    std::lock_guard<std::mutex> lock{tracks_mutex};
+    for (auto &track : tracks)
+    {
+        totals.clear();
+
+        track->Lock();
+        for (auto &counter : track->counters)
+        {
+            totals.push_back(counter);
+            counter.value = 0.0;
+        }
+        track->Unlock();
+
+        for (auto &total : totals)
+        {
+            track->Push({total.name, now, now, total.value, 0, ProfileEventType::Plot});
+        }
+    }
+}
+
+void Profiler::SetThreadName(const std::string &name)
+{
+    auto &track = GetThreadTrack();
+
+    std::lock_guard<std::mutex> lock{tracks_mutex};
+    track.name = name;
+}
+
+ProfileTrack &Profiler::GetThreadTrack()
+{
+    if (!thread_track)
+    {
+        std::lock_guard<std::mutex> lock{tracks_mutex};
+        thread_track = &AddTrack("Thread " + std::to_string(tracks.size()));
+    }
+
+    return *thread_track;
+}
+
+ProfileTrack &Profiler::CreateTrack(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock{tracks_mutex};
+    return AddTrack(name);
+}
+
+uint16_t Profiler::BeginZone()
+{
+    return GetThreadTrack().depth++;
+}
+
+void Profiler::EndZone(const char *name, uint64_t start, uint16_t depth)
+{
+    auto &track = GetThreadTrack();
+    track.depth = depth;
+    track.Push({name, start, Now(), 0.0, depth, ProfileEventType::Zone});
+}
+
+void Profiler::RecordZone(ProfileTrack &track, const char *name, uint64_t start, uint64_t end, uint16_t depth)
+{
+    if (IsEnabled())
+    {
+        track.Push({name, start, end, 0.0, depth, ProfileEventType::Zone});
+    }
+}
+
+void Profiler::Plot(const char *name, double value)
+{
+    if (IsEnabled())
+    {
+        uint64_t now = Now();
+        GetThreadTrack().Push({name, now, now, value, 0, ProfileEventType::Plot});
+    }
+}
+
+void Profiler::Count(const char *name, double amount)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    auto &track = GetThreadTrack();
+
+    track.Lock();
+    auto counter = std::find_if(track.counters.begin(), track.counters.end(),
+                                [name](const ProfileTrack::Counter &counter) { return counter.name == name; });
+    if (counter != track.counters.end())
+    {
+        counter->value += amount;
+    }
+    else
+    {
+        track.counters.push_back({name, amount});
+    }
+    track.Unlock();
+}
+
+const char *Profiler::Intern(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock{names_mutex};
+    return names.insert(name).first->c_str();
+}
+
+Profiler::Capture Profiler::CaptureEvents(uint64_t since)
+{
+    Capture capture;
+    capture.frames = GetFrames();
+
+    std::lock_guard<std::mutex> lock{tracks_mutex};
+    capture.tracks.reserve(tracks.size());
+
+    for (auto &track : tracks)
+    {
+        Capture::Track captured;
+        captured.name = track->name;
+        captured.id = track->id;
+
+        track->Lock();
+        uint64_t count = std::min<uint64_t>(track->write_count, track->events.size());
+        for (uint64_t i = track->write_count - count; i < track->write_count; i++)
+        {
+            auto &event = track->events[i & (track->events.size() - 1)];
+            if (event.end >= since)
+            {
+                captured.events.push_back(event);
+            }
+        }
+        track->Unlock();
+
+        capture.tracks.push_back(std::move(captured));
+    }
+
+    return capture;
+}
+
+std::vector<Profiler::Frame> Profiler::GetFrames()
+{
+    std::lock_guard<std::mutex> lock{frames_mutex};
+
+    uint64_t count = std::min<uint64_t>(frame_count, frames.size());
+
+    std::vector<Frame> result;
+    result.reserve(count);
+    for (uint64_t i = frame_count - count; i < frame_count; i++)
+    {
+        result.push_back(frames[i % frames.size()]);
+    }
+
+    return result;
+}
+
+std::string Profiler::ExportChromeTrace()
+{
+    auto capture = CaptureEvents();
+
+    // Microseconds since the profiler started, the unit of the trace format
+    auto to_us = [this](uint64_t time) { return time >= start_time ? static_cast<double>(time - start_time) / 1000.0 : 0.0; };
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    auto begin_event = [&](const char *name, const char *phase, uint32_t tid) {
+        json += first ? "\n" : ",\n";
+        first = false;
+        json += "{\"name\":\"";
+        append_escaped(json, name);
+        json += "\",\"ph\":\"";
+        json += phase;
+        json += "\",\"pid\":1,\"tid\":";
+        json += std::to_string(tid);
+    };
+
+    for (auto &track : capture.tracks)
+    {
+        begin_event("thread_name", "M", track.id);
+        json += ",\"args\":{\"name\":\"";
+        append_escaped(json, track.name.c_str());
+        json += "\"}}";
+
+        for (auto &event : track.events)
+        {
+            if (event.type == ProfileEventType::Zone)
+            {
+                begin_event(event.name, "X", track.id);
+                append_format(json, ",\"ts\":%.3f,\"dur\":%.3f}", to_us(event.start),
+                              static_cast<double>(event.end - event.start) / 1000.0);
+            }
+            else
+            {
+                begin_event(event.name, "C", track.id);
+                append_format(json, ",\"ts\":%.3f,\"args\":{\"value\":%.6g}}", to_us(event.start), event.value);
+            }
+        }
+    }
+
+    // Frames get a track of their own after the others
+    auto frame_track = static_cast<uint32_t>(capture.tracks.size());
+    begin_event("thread_name", "M", frame_track);
+    json += ",\"args\":{\"name\":\"Frames\"}}";
+
+    for (auto &frame : capture.frames)
+    {
+        begin_event("Frame", "X", frame_track);
+        append_format(json, ",\"ts\":%.3f,\"dur\":%.3f}", to_us(frame.start),
+                      static_cast<double>(frame.end - frame.start) / 1000.0);
+    }
+
+    json += "\n]}\n";
+    return json;
+}
+
+bool Profiler::WriteChromeTrace(const std::filesystem::path &path)
+{
+    auto json = ExportChromeTrace();
+
+    std::error_code error;
+    if (path.has_parent_path())
+    {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file.write(json.data(), static_cast<std::streamsize>(json.size())))
+    {
+        LOGE("Failed to write the profiler trace {}", path.string());
+        return false;
+    }
+
+    LOGI("Profiler trace written to {}", path.string());
+    return true;
+}
+
+ProfileTrack &Profiler::AddTrack(const std::string &name)
+{
+    auto track = std::make_unique<ProfileTrack>();
+    track->name = name;
+    track->id = static_cast<uint32_t>(tracks.size());
+    track->events.resize(track_capacity);
+
+    tracks.push_back(std::move(track));
+    return *tracks.back();
+}
+
+ProfileZone::ProfileZone(const char *name) : name{name}, active{Profiler::GetInstance().IsEnabled()}
+{
+    if (active)
+    {
+        depth = Profiler::GetInstance().BeginZone();
+        start = Profiler::Now();
+    }
+}
+
+ProfileZone::~ProfileZone()
+{
+    if (active)
+    {
+        Profiler::GetInstance().EndZone(name, start, depth);
+    }
+}
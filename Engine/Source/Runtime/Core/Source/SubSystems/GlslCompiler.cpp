@@ -1,67 +1,400 @@
-//#include "SubSystems/GLSLCompiler.hpp"
-//
-//void GlslCompiler::Initialize()
-//{
-//    glslang::InitializeProcess();
-//}
-//
-//std::vector<unsigned int> GlslCompiler::CompileGLSLToSpv(const std::string &glslCode, EShLanguage shaderType, std::string &errorLog)
-//{
-//    // 1. 创建着色器对象
-//    glslang::TShader shader(shaderType);
-//
-//    // 2. 设置着色器源码
-//    const char *shaderStrings[1];
-//    shaderStrings[0] = glslCode.c_str();
-//    shader.setStrings(shaderStrings, 1);
-//
-//    // 3. 设置编译环境
-//    // 指定输入语言为 GLSL，目标客户端为 Vulkan 1.3，目标 SPIR-V 版本为 1.3
-//    // 你可以根据你的需求调整这些版本号
-//    int clientInputSemanticsVersion = 130; // Vulkan 1.1
-//    glslang::EShTargetClientVersion vulkanClientVersion = glslang::EShTargetVulkan_1_3;
-//    glslang::EShTargetLanguageVersion targetVersion = glslang::EShTargetSpv_1_3;
-//
-//    shader.setEnvInput(glslang::EShSourceGlsl, shaderType, glslang::EShClientVulkan, clientInputSemanticsVersion);
-//    shader.setEnvClient(glslang::EShClientVulkan, vulkanClientVersion);
-//    shader.setEnvTarget(glslang::EShTargetSpv, targetVersion);
-//
-//    // 4. 设置编译选项/消息
-//    // EShMsgSpvRules: 启用 SPIR-V 的特定规则
-//    // EShMsgVulkanRules: 启用 Vulkan 的特定规则
-//    EShMessages messages = (EShMessages)(EShMsgSpvRules | EShMsgVulkanRules);
-//
-//    // 5. 解析 GLSL 代码
-//    const TBuiltInResource *resources = GetDefaultResources();
-//    if (!shader.parse(resources, 110, false, messages))
-//    {
-//        errorLog = "GLSL Parsing Failed:\n";
-//        errorLog += shader.getInfoLog();
-//        errorLog += "\n";
-//        errorLog += shader.getInfoDebugLog();
-//        return {}; // 返回空 vector 表示失败
-//    }
-//
-//    // 6. 将着色器链接到 Program
-//    glslang::TProgram program;
-//    program.addShader(&shader);
-//
-//    if (!program.link(messages))
-//    {
-//        errorLog = "GLSL Linking Failed:\n";
-//        errorLog += program.getInfoLog();
-//        errorLog += "\n";
-//        errorLog += program.getInfoDebugLog();
-//        return {}; // 返回空 vector 表示失败
-//    }
-//
-//    // 7. 从 Program 中间表示生成 SPIR-V
-//    std::vector<unsigned int> spv;
-//    glslang::SpvOptions spvOptions;
-//    spvOptions.validate = true; // 开启验证，确保生成的 SPIR-V 有效
-//    glslang::GlslangToSpv(*program.getIntermediate(shaderType), spv, &spvOptions);
-//
-//    // 8. 成功，返回 SPIR-V
-//    errorLog = "Compilation successful.";
-//    return spv;
-//}
\ No newline at end of file
+#include "SubSystems/GlslCompiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glslang/Public/ResourceLimits.h>
+#include <glslang/Public/ShaderLang.h>
+#include <SPIRV/GlslangToSpv.h>
+
+#include "Logging/Logger.hpp"
+#include "Misc/FileLoader.hpp"
+#include "Misc/Hash.hpp"
+#include "SubSystems/JobSystem.hpp"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    /// Bump when the compile options change, old cache entries are then never hit again
+    constexpr uint32_t cache_format_version = 1;
+
+    constexpr uint32_t spirv_magic = 0x07230203;
+
+    EShLanguage ToEShLanguage(GlslStage stage)
+    {
+        return static_cast<EShLanguage>(stage);
+    }
+
+    bool IsRayTracingStage(GlslStage stage)
+    {
+        return stage >= GlslStage::RayGen && stage <= GlslStage::Callable;
+    }
+
+    std::string ReadFileOrEmpty(const fs::path &path)
+    {
+        try
+        {
+            return FileLoader::ReadFileString(path);
+        }
+        catch (const std::exception &)
+        {
+            return {};
+        }
+    }
+
+    /**
+     * Finds the file of an #include, local includes look next to the including file first
+     */
+    fs::path ResolveInclude(const std::string &header_name, const fs::path &includer_path, bool local,
+                            const std::vector<fs::path> &include_directories)
+    {
+        std::error_code error;
+
+        if (local)
+        {
+            auto path = includer_path.parent_path() / header_name;
+            if (fs::is_regular_file(path, error))
+            {
+                return path.lexically_normal();
+            }
+        }
+
+        for (auto &directory : include_directories)
+        {
+            auto path = directory / header_name;
+            if (fs::is_regular_file(path, error))
+            {
+                return path.lexically_normal();
+            }
+        }
+
+        return {};
+    }
+
+    /**
+     * Calls on_include for every #include line of the source, conditionals are not evaluated so
+     * an include in an inactive branch is still reported
+     */
+    template <typename Func>
+    void ForEachInclude(const std::string &source, Func &&on_include)
+    {
+        size_t line_start = 0;
+        while (line_start < source.size())
+        {
+            size_t line_end = source.find('\n', line_start);
+            if (line_end == std::string::npos)
+            {
+                line_end = source.size();
+            }
+
+            size_t i = source.find_first_not_of(" \t", line_start);
+            if (i < line_end && source[i] == '#')
+            {
+                i = source.find_first_not_of(" \t", i + 1);
+                if (i < line_end && source.compare(i, 7, "include") == 0)
+                {
+                    i = source.find_first_not_of(" \t", i + 7);
+                    if (i < line_end && (source[i] == '"' || source[i] == '<'))
+                    {
+                        char close = source[i] == '"' ? '"' : '>';
+                        size_t name_end = source.find(close, i + 1);
+                        if (name_end < line_end)
+                        {
+                            on_include(source.substr(i + 1, name_end - i - 1), close == '"');
+                        }
+                    }
+                }
+            }
+
+            line_start = line_end + 1;
+        }
+    }
+
+    void HashIncludes(const std::string &source, const fs::path &source_path, const std::vector<fs::path> &include_directories,
+                      std::vector<fs::path> &visited, uint64_t &key)
+    {
+        ForEachInclude(source, [&](const std::string &header_name, bool local)
+        {
+            auto path = ResolveInclude(header_name, source_path, local, include_directories);
+            if (path.empty())
+            {
+                // The compile reports the missing file, the name still changes the key
+                key = Hash::Combine(key, Hash::Hash64(header_name.data(), header_name.size()));
+                return;
+            }
+
+            if (std::find(visited.begin(), visited.end(), path) != visited.end())
+            {
+                return;
+            }
+            visited.push_back(path);
+
+            auto content = ReadFileOrEmpty(path);
+            auto path_string = path.generic_string();
+            key = Hash::Combine(key, Hash::Hash64(path_string.data(), path_string.size()));
+            key = Hash::Combine(key, Hash::Hash64(content.data(), content.size()));
+
+            HashIncludes(content, path, include_directories, visited, key);
+        });
+    }
+
+    /**
+     * Reads includes from disk for glslang, the same resolution as the cache key uses
+     */
+    class FileIncluder : public glslang::TShader::Includer
+    {
+    public:
+        explicit FileIncluder(const std::vector<fs::path> &include_directories) : include_directories{include_directories}
+        {
+        }
+
+        IncludeResult *includeLocal(const char *header_name, const char *includer_name, size_t) override
+        {
+            return include(header_name, includer_name, true);
+        }
+
+        IncludeResult *includeSystem(const char *header_name, const char *includer_name, size_t) override
+        {
+            return include(header_name, includer_name, false);
+        }
+
+        void releaseInclude(IncludeResult *result) override
+        {
+            if (result)
+            {
+                delete static_cast<std::string *>(result->userData);
+                delete result;
+            }
+        }
+
+    private:
+        IncludeResult *include(const char *header_name, const char *includer_name, bool local)
+        {
+            auto path = ResolveInclude(header_name, includer_name, local, include_directories);
+            if (path.empty())
+            {
+                return nullptr;
+            }
+
+            auto *content = new std::string{ReadFileOrEmpty(path)};
+            return new IncludeResult{path.generic_string(), content->data(), content->size(), content};
+        }
+
+        const std::vector<fs::path> &include_directories;
+    };
+} // namespace
+
+GlslCompiler::GlslCompiler()
+{
+    glslang::InitializeProcess();
+}
+
+GlslCompiler::~GlslCompiler()
+{
+    glslang::FinalizeProcess();
+}
+
+void GlslCompiler::SetCacheDirectory(const std::filesystem::path &directory)
+{
+    std::lock_guard<std::mutex> guard{config_mutex};
+    cache_directory = directory;
+}
+
+std::filesystem::path GlslCompiler::GetCacheDirectory() const
+{
+    std::lock_guard<std::mutex> guard{config_mutex};
+    return cache_directory;
+}
+
+void GlslCompiler::AddIncludeDirectory(const std::filesystem::path &directory)
+{
+    std::lock_guard<std::mutex> guard{config_mutex};
+    if (std::find(include_directories.begin(), include_directories.end(), directory) == include_directories.end())
+    {
+        include_directories.push_back(directory);
+    }
+}
+
+std::vector<std::filesystem::path> GlslCompiler::GetIncludeDirectories() const
+{
+    std::lock_guard<std::mutex> guard{config_mutex};
+    return include_directories;
+}
+
+uint64_t GlslCompiler::ComputeKey(const GlslCompileJob &job) const
+{
+    auto version = glslang::GetVersion();
+    uint64_t key = Hash::Hash64(&cache_format_version, sizeof(cache_format_version));
+    key = Hash::Combine(key, static_cast<uint64_t>(version.major) << 32 | static_cast<uint64_t>(version.minor) << 16 | version.patch);
+    key = Hash::Combine(key, static_cast<uint64_t>(job.stage));
+    key = Hash::Combine(key, Hash::Hash64(job.entry_point.data(), job.entry_point.size()));
+    key = Hash::Combine(key, Hash::Hash64(job.preamble.data(), job.preamble.size()));
+    key = Hash::Combine(key, Hash::Hash64(job.source.data(), job.source.size()));
+
+    std::vector<fs::path> visited;
+    HashIncludes(job.source, job.source_path, GetIncludeDirectories(), visited, key);
+
+    return key;
+}
+
+bool GlslCompiler::Compile(GlslCompileJob &job)
+{
+    job.spirv.clear();
+    job.info_log.clear();
+
+    uint64_t key = ComputeKey(job);
+
+    {
+        std::lock_guard<std::mutex> guard{memory_cache_mutex};
+        auto it = memory_cache.find(key);
+        if (it != memory_cache.end())
+        {
+            job.spirv = it->second;
+            job.success = true;
+            memory_hits++;
+            return true;
+        }
+    }
+
+    auto directory = GetCacheDirectory();
+    fs::path cache_path = directory.empty() ? fs::path{} : directory / (Hash::ToHex(key) + ".spv");
+
+    std::error_code error;
+    if (!cache_path.empty() && fs::is_regular_file(cache_path, error))
+    {
+        try
+        {
+            job.spirv = FileLoader::ReadShaderBinaryU32(cache_path.string());
+        }
+        catch (const std::exception &e)
+        {
+            LOGW("Ignoring shader cache file {}: {}", cache_path.string(), e.what());
+            job.spirv.clear();
+        }
+
+        if (!job.spirv.empty() && job.spirv[0] == spirv_magic)
+        {
+            disk_hits++;
+        }
+        else
+        {
+            job.spirv.clear();
+        }
+    }
+
+    if (job.spirv.empty())
+    {
+        if (!CompileUncached(job, GetIncludeDirectories()))
+        {
+            failed++;
+            job.success = false;
+            return false;
+        }
+
+        compiled++;
+
+        if (!cache_path.empty())
+        {
+            try
+            {
+                FileLoader::WriteFileBinary(cache_path, job.spirv.data(), job.spirv.size() * sizeof(uint32_t));
+            }
+            catch (const std::exception &e)
+            {
+                LOGW("Failed to store shader cache file {}: {}", cache_path.string(), e.what());
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard{memory_cache_mutex};
+        memory_cache.emplace(key, job.spirv);
+    }
+
+    job.success = true;
+    return true;
+}
+
+bool GlslCompiler::CompileAll(std::vector<GlslCompileJob> &jobs)
+{
+    std::atomic<bool> all_succeeded{true};
+
+    JobSystem::GetInstance().ParallelFor(static_cast<uint32_t>(jobs.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (!Compile(jobs[i]))
+            {
+                all_succeeded = false;
+            }
+        }
+    });
+
+    return all_succeeded;
+}
+
+GlslCompiler::Stats GlslCompiler::GetStats() const
+{
+    return {compiled.load(), memory_hits.load(), disk_hits.load(), failed.load()};
+}
+
+bool GlslCompiler::CompileUncached(GlslCompileJob &job, const std::vector<std::filesystem::path> &include_directories) const
+{
+    EShLanguage language = ToEShLanguage(job.stage);
+
+    glslang::TShader shader(language);
+
+    const char *source = job.source.c_str();
+    int source_length = static_cast<int>(job.source.size());
+    std::string source_name = job.source_path.generic_string();
+    const char *source_name_ptr = source_name.c_str();
+    shader.setStringsWithLengthsAndNames(&source, &source_length, &source_name_ptr, 1);
+    shader.setPreamble(job.preamble.c_str());
+    shader.setEntryPoint(job.entry_point.c_str());
+    shader.setSourceEntryPoint(job.entry_point.c_str());
+
+    // Ray tracing needs SPIR-V 1.4 and Vulkan 1.2, mesh and task shaders SPIR-V 1.4, like compileshaders.py
+    auto client_version = glslang::EShTargetVulkan_1_1;
+    auto target_version = glslang::EShTargetSpv_1_3;
+    if (IsRayTracingStage(job.stage))
+    {
+        client_version = glslang::EShTargetVulkan_1_2;
+        target_version = glslang::EShTargetSpv_1_4;
+    }
+    else if (job.stage == GlslStage::Task || job.stage == GlslStage::Mesh)
+    {
+        target_version = glslang::EShTargetSpv_1_4;
+    }
+
+    shader.setEnvInput(glslang::EShSourceGlsl, language, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, client_version);
+    shader.setEnvTarget(glslang::EShTargetSpv, target_version);
+
+    auto messages = static_cast<EShMessages>(EShMsgDefault | EShMsgSpvRules | EShMsgVulkanRules);
+
+    FileIncluder includer{include_directories};
+
+    if (!shader.parse(GetDefaultResources(), 100, false, messages, includer))
+    {
+        job.info_log = std::string{shader.getInfoLog()} + "\n" + shader.getInfoDebugLog();
+        return false;
+    }
+
+    glslang::TProgram program;
+    program.addShader(&shader);
+
+    if (!program.link(messages))
+    {
+        job.info_log = std::string{program.getInfoLog()} + "\n" + program.getInfoDebugLog();
+        return false;
+    }
+
+    spv::SpvBuildLogger logger;
+    glslang::SpvOptions options;
+    glslang::GlslangToSpv(*program.getIntermediate(language), job.spirv, &logger, &options);
+
+    job.info_log = std::string{shader.getInfoLog()} + logger.getAllMessages();
+
+    return !job.spirv.empty();
+}
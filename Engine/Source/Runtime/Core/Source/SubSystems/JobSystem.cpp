@@ -0,0 +1,478 @@
+#include "SubSystems/JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "Logging/Logger.hpp"
+#include "Profiler/Profiler.hpp"
+
+namespace
+{
+    constexpr uint32_t no_worker = ~0u;
+
+    /// Index of the worker running on this thread, no_worker on every other thread
+    thread_local uint32_t current_worker = no_worker;
+
+    /// Waiting threads look for new jobs at least this often, a queued job does not wake them
+    constexpr auto wait_poll_interval = std::chrono::microseconds(200);
+} // namespace
+
+bool JobCounter::IsDone() const
+{
+    return pending.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::JobSystem() : main_thread_id{std::this_thread::get_id()}
+{
+    uint32_t worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    for (uint32_t i = 0; i < worker_count; i++)
+    {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    // Started once every deque exists, workers steal from each other right away
+    for (uint32_t i = 0; i < worker_count; i++)
+    {
+        workers[i]->thread = std::thread{&JobSystem::WorkerLoop, this, i};
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    Shutdown();
+}
+
+void JobSystem::Run(JobFunc func, JobCounter *counter)
+{
+    if (counter)
+    {
+        counter->pending++;
+    }
+
+    Push({std::move(func), counter});
+}
+
+void JobSystem::RunAfter(JobCounter &dependency, JobFunc func, JobCounter *counter)
+{
+    if (counter)
+    {
+        counter->pending++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{dependency.mutex};
+        if (!dependency.IsDone())
+        {
+            dependency.continuations.push_back({std::move(func), counter});
+            return;
+        }
+    }
+
+    Push({std::move(func), counter});
+}
+
+void JobSystem::RunOnMainThread(JobFunc func, JobCounter *counter)
+{
+    if (counter)
+    {
+        counter->pending++;
+    }
+
+    Job job{std::move(func), counter};
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock{main_thread_mutex};
+        if (!stopping)
+        {
+            main_thread_jobs.push_back(std::move(job));
+            queued_main_thread_jobs++;
+            queued = true;
+        }
+    }
+
+    if (!queued)
+    {
+        Cancel(job);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{sleep_mutex};
+    done_condition.notify_all();
+}
+
+void JobSystem::ProcessMainThreadJobs()
+{
+    Job job;
+    while (TryPopMainThread(job))
+    {
+        Execute(job);
+    }
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+    bool main_thread = IsMainThread();
+
+    while (!counter.IsDone())
+    {
+        Job job;
+        if ((main_thread && TryPopMainThread(job)) || TryPop(job))
+        {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{sleep_mutex};
+        done_condition.wait_for(lock, wait_poll_interval, [&]()
+        {
+            return counter.IsDone() || queued_jobs > 0 || (main_thread && queued_main_thread_jobs > 0);
+        });
+    }
+
+    // The last job may still hold the lock of the counter, it is released before the counter can be destroyed
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock{counter.mutex};
+        exception = std::exchange(counter.exception, nullptr);
+    }
+
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)> &func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grain_size = std::max(1u, grain_size);
+    uint32_t range_count = (count - 1) / grain_size + 1;
+
+    if (range_count == 1 || workers.empty())
+    {
+        func(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (uint32_t range = 1; range < range_count; range++)
+    {
+        uint32_t begin = range * grain_size;
+        uint32_t end = std::min(count, begin + grain_size);
+        Run([&func, begin, end]() { func(begin, end); }, &counter);
+    }
+
+    std::exception_ptr exception;
+    try
+    {
+        func(0, grain_size);
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+
+    // Waits even when the first range threw, the other ranges reference func
+    try
+    {
+        Wait(counter);
+    }
+    catch (...)
+    {
+        if (!exception)
+        {
+            exception = std::current_exception();
+        }
+    }
+
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+uint32_t JobSystem::GetGrainSize(uint32_t count, uint32_t ranges_per_thread) const
+{
+    uint32_t range_count = (GetWorkerCount() + 1) * std::max(1u, ranges_per_thread);
+    return std::max(1u, (count + range_count - 1) / range_count);
+}
+
+uint32_t JobSystem::GetWorkerCount() const
+{
+    return static_cast<uint32_t>(workers.size());
+}
+
+bool JobSystem::IsMainThread() const
+{
+    return std::this_thread::get_id() == main_thread_id;
+}
+
+void JobSystem::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock{sleep_mutex};
+        stopping = true;
+    }
+    work_condition.notify_all();
+
+    for (auto &worker : workers)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+
+    // Nothing is queued from here on, the jobs left behind finish their counters so no Wait hangs
+    std::vector<Job> dropped;
+
+    for (auto &worker : workers)
+    {
+        std::lock_guard<std::mutex> lock{worker->mutex};
+        std::move(worker->jobs.begin(), worker->jobs.end(), std::back_inserter(dropped));
+        worker->jobs.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{shared_mutex};
+        std::move(shared_jobs.begin(), shared_jobs.end(), std::back_inserter(dropped));
+        shared_jobs.clear();
+    }
+    queued_jobs = 0;
+
+    {
+        std::lock_guard<std::mutex> lock{main_thread_mutex};
+        std::move(main_thread_jobs.begin(), main_thread_jobs.end(), std::back_inserter(dropped));
+        main_thread_jobs.clear();
+    }
+    queued_main_thread_jobs = 0;
+
+    workers.clear();
+
+    if (!dropped.empty())
+    {
+        LOGW("JobSystem shut down with {} jobs queued, they are not run", dropped.size());
+    }
+
+    for (auto &job : dropped)
+    {
+        Cancel(job);
+    }
+}
+
+void JobSystem::Push(Job job)
+{
+    // Checked under the lock of the queue, Shutdown() empties the queues after setting stopping
+    bool queued = false;
+
+    if (current_worker != no_worker)
+    {
+        auto &worker = *workers[current_worker];
+        std::lock_guard<std::mutex> lock{worker.mutex};
+        if (!stopping)
+        {
+            worker.jobs.push_back(std::move(job));
+            queued_jobs++;
+            queued = true;
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock{shared_mutex};
+        if (!stopping)
+        {
+            shared_jobs.push_back(std::move(job));
+            queued_jobs++;
+            queued = true;
+        }
+    }
+
+    if (!queued)
+    {
+        Cancel(job);
+        return;
+    }
+
+    // Taken so a worker between its last TryPop and its wait does not miss the notification
+    std::lock_guard<std::mutex> lock{sleep_mutex};
+    work_condition.notify_one();
+}
+
+bool JobSystem::TryPop(Job &job)
+{
+    if (queued_jobs == 0)
+    {
+        return false;
+    }
+
+    uint32_t worker_count = static_cast<uint32_t>(workers.size());
+
+    if (current_worker != no_worker)
+    {
+        auto &worker = *workers[current_worker];
+        std::lock_guard<std::mutex> lock{worker.mutex};
+        if (!worker.jobs.empty())
+        {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            queued_jobs--;
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{shared_mutex};
+        if (!shared_jobs.empty())
+        {
+            job = std::move(shared_jobs.front());
+            shared_jobs.pop_front();
+            queued_jobs--;
+            return true;
+        }
+    }
+
+    // Victims are visited starting after the current worker, so thieves spread over the deques
+    uint32_t first = current_worker != no_worker ? current_worker + 1 : 0;
+    for (uint32_t i = 0; i < worker_count; i++)
+    {
+        uint32_t victim_index = (first + i) % worker_count;
+        if (victim_index == current_worker)
+        {
+            continue;
+        }
+
+        auto &victim = *workers[victim_index];
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued_jobs--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool JobSystem::TryPopMainThread(Job &job)
+{
+    std::lock_guard<std::mutex> lock{main_thread_mutex};
+    if (main_thread_jobs.empty())
+    {
+        return false;
+    }
+
+    job = std::move(main_thread_jobs.front());
+    main_thread_jobs.pop_front();
+    queued_main_thread_jobs--;
+    return true;
+}
+
+void JobSystem::Execute(Job &job)
+{
+    PROFILE_SCOPE("Job");
+    PROFILE_COUNT("Jobs", 1);
+
+    std::exception_ptr exception;
+    try
+    {
+        job.func();
+    }
+    catch (const std::exception &e)
+    {
+        if (!job.counter)
+        {
+            LOGE("Job failed: {}", e.what());
+        }
+        exception = std::current_exception();
+    }
+    catch (...)
+    {
+        if (!job.counter)
+        {
+            LOGE("Job failed with an unknown exception");
+        }
+        exception = std::current_exception();
+    }
+
+    // Releases what the job captured before its counter reports it done
+    job.func = nullptr;
+
+    if (job.counter)
+    {
+        Finish(*job.counter, exception);
+    }
+}
+
+void JobSystem::Cancel(Job &job)
+{
+    job.func = nullptr;
+
+    if (job.counter)
+    {
+        Finish(*job.counter, std::make_exception_ptr(std::runtime_error("The JobSystem was shut down before the job ran")));
+    }
+}
+
+void JobSystem::Finish(JobCounter &counter, std::exception_ptr exception)
+{
+    std::vector<Job> ready;
+    bool done = false;
+
+    {
+        std::lock_guard<std::mutex> lock{counter.mutex};
+
+        if (exception && !counter.exception)
+        {
+            counter.exception = exception;
+        }
+
+        if (--counter.pending == 0)
+        {
+            ready.swap(counter.continuations);
+            done = true;
+        }
+    }
+
+    // The counter may be destroyed from here on
+    for (auto &job : ready)
+    {
+        Push(std::move(job));
+    }
+
+    if (done)
+    {
+        std::lock_guard<std::mutex> lock{sleep_mutex};
+        done_condition.notify_all();
+    }
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+    current_worker = index;
+    Profiler::GetInstance().SetThreadName("Worker " + std::to_string(index));
+
+    while (!stopping)
+    {
+        Job job;
+        if (TryPop(job))
+        {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{sleep_mutex};
+        work_condition.wait(lock, [this]() { return stopping || queued_jobs > 0; });
+    }
+
+    current_worker = no_worker;
+}
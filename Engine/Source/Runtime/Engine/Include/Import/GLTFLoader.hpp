@@ -29,10 +29,16 @@
 
 #include <volk.h>
 
+#include "Framework/Misc/MeshArena.hpp"
+#include "SceneGraph/Components/Image/MipGenerator.h"
+#include "SceneGraph/Components/VertexLayout.h"
+
 #define KHR_LIGHTS_PUNCTUAL_EXTENSION "KHR_lights_punctual"
 
 namespace vkb
 {
+    class TextureStreamer;
+    class UploadManager;
     class VulkanDevice;
 
     namespace sg
@@ -85,6 +91,48 @@ namespace vkb
                                                           bool storage_buffer = false,
                                                           VkBufferUsageFlags additional_buffer_usage_flags = 0);
 
+        /**
+         * @brief Selects the vertex formats of the loaded submeshes. The default full layout keeps a buffer
+         *        per glTF attribute (read_scene_from_file) or matches the Vertex struct (read_model_from_file),
+         *        a compact layout interleaves quantized attributes into "vertex_buffer" and adds the matching
+         *        defines to the submesh shader variant. The storage buffer path always uses AlignedVertex.
+         */
+        void set_vertex_layout(const sg::VertexLayout& layout);
+
+        const sg::VertexLayout& get_vertex_layout() const;
+
+        /**
+         * @brief Filter used for the mip chains generated while loading a scene. Images without mips
+         *        are filtered in their color space, normal maps are renormalized, and large levels are
+         *        split across the image loading thread pool.
+         */
+        void set_mip_generation_options(const sg::MipGenerationOptions& options);
+
+        /**
+         * @brief Streams the mip chains of scene images through the given streamer. Only the tail levels
+         *        are uploaded by load_scene. The images have to be unregistered from the streamer before
+         *        the scene is destroyed.
+         */
+        void set_texture_streamer(TextureStreamer* streamer);
+
+        /**
+         * @brief Uploads images and mesh buffers on the transfer queue through the given manager. The mesh
+         *        buffers become device local, and loading waits once for all uploads at its end instead of
+         *        after every batch. The manager's acquire() has to be recorded by the renderer every frame.
+         */
+        void set_upload_manager(UploadManager* manager);
+
+        /**
+         * @brief Also copies the triangle lists of read_scene_from_file into one MeshArena of DrawListSubpass::Vertex,
+         *        sized for the file. SubMesh::arena_mesh indexes the arena, take_mesh_arena() hands it over.
+         */
+        void set_build_mesh_arena(bool build);
+
+        /**
+         * @return The arena of the last scene, null when none was built
+         */
+        std::unique_ptr<MeshArena> take_mesh_arena();
+
     protected:
         virtual std::unique_ptr<sg::Node> parse_node(const tinygltf::Node& gltf_node, size_t index) const;
 
@@ -132,6 +180,31 @@ namespace vkb
 
         std::string model_path;
 
+        sg::VertexLayout vertex_layout;
+
+        sg::MipGenerationOptions mip_generation_options;
+
+        /// How the materials use each glTF image, gathered by load_scene before the images are parsed
+        struct ImageUsage
+        {
+            bool srgb{false};
+
+            bool normal_map{false};
+        };
+
+        std::vector<ImageUsage> image_usages;
+
+        /// Set while the images of the current scene are parsed on the JobSystem workers
+        bool loading_scene_images{false};
+
+        TextureStreamer* texture_streamer{nullptr};
+
+        UploadManager* upload_manager{nullptr};
+
+        bool build_mesh_arena{false};
+
+        std::unique_ptr<MeshArena> mesh_arena;
+
         /// The extensions that the GLTFLoader can load mapped to whether they should be enabled or not
         static std::unordered_map<std::string, bool> supported_extensions;
 
@@ -20,13 +20,16 @@
 #include <memory>
 #include <string>
 #include <typeinfo>
+#include <utility>
 #include <vector>
 
 #include <volk.h>
 
+#include "Framework/Core/BindlessDescriptorTable.hpp"
 #include "Framework/Core/Image.hpp"
 #include "Framework/Core/ImageView.hpp"
 #include "SceneGraph/Component.h"
+#include "SceneGraph/Components/Image/MipGenerator.h"
 
 
 namespace vkb
@@ -68,7 +71,9 @@ class Image : public Component
 	{
 		Unknown,
 		Color,
-		Other
+		Other,
+		/// Tangent space normals, xy are kept by the texture cooker and z is rebuilt when sampling
+		NormalMap
 	};
 
 	Image(const std::string &name, std::vector<uint8_t> &&data = {}, std::vector<Mipmap> &&mipmaps = {{}});
@@ -93,7 +98,11 @@ class Image : public Component
 
 	const std::vector<std::vector<VkDeviceSize>> &get_offsets() const;
 
-	void generate_mipmaps();
+	/**
+	 * @brief Generates the full mip chain from the base level, see MipGenerator
+	 * @param options Filter, normal map handling and the optional thread pool to spread large levels on
+	 */
+	void generate_mipmaps(const MipGenerationOptions &options = {});
 
 	void create_vk_image(VulkanDevice &device, VkImageViewType image_view_type = VK_IMAGE_VIEW_TYPE_2D, VkImageCreateFlags flags = 0);
 
@@ -103,6 +112,27 @@ class Image : public Component
 
 	void coerce_format_to_srgb();
 
+	/**
+	 * @brief Replaces the Vulkan image and its view, used when the resident mip range of a streamed image changes
+	 * @return The previous image and view, they must outlive the command buffers still referencing them
+	 */
+	std::pair<std::unique_ptr<vkb::Image>, std::unique_ptr<vkb::ImageView>> replace_vk_image(std::unique_ptr<vkb::Image> &&image,
+	                                                                                         std::unique_ptr<vkb::ImageView> &&image_view);
+
+	/**
+	 * @brief File the image data was read from, lets the texture streamer reload single levels
+	 */
+	const std::string &get_source_path() const;
+
+	void set_source_path(const std::string &path);
+
+	/**
+	 * @brief Slot of the image view in the bindless descriptor table, invalid when bindless resources are not used
+	 */
+	BindlessHandle get_bindless_handle() const;
+
+	void set_bindless_handle(BindlessHandle handle);
+
   protected:
 	std::vector<uint8_t> &get_mut_data();
 
@@ -139,6 +169,10 @@ class Image : public Component
 	std::unique_ptr<vkb::Image> vk_image;
 
 	std::unique_ptr<vkb::ImageView> vk_image_view;
+
+	std::string source_path;
+
+	BindlessHandle bindless_handle;
 };
 
 }        // namespace sg
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <volk.h>
+
+namespace vkb
+{
+    namespace sg
+    {
+        /**
+         * @brief CPU encoders for the BC block formats the texture cooker produces
+         *        BC4 and BC5 store one and two channels with 8 interpolated values per channel.
+         *        BC7 is encoded in mode 6 only (one RGBA subset, 7-bit endpoints with p-bits, 4-bit indices),
+         *        which keeps the encoder small and fast while staying well above BC1/BC3 quality.
+         */
+        class BlockCompression
+        {
+        public:
+            /// Size in bytes of one 4x4 block
+            static constexpr uint32_t bc4_block_size = 8;
+            static constexpr uint32_t bc5_block_size = 16;
+            static constexpr uint32_t bc7_block_size = 16;
+
+            /**
+             * @return Whether compress can produce the format
+             */
+            static bool is_supported(VkFormat format);
+
+            /**
+             * @return Size in bytes of an image of the given size in a 4x4 block format
+             */
+            static size_t get_compressed_size(VkFormat format, const VkExtent3D &extent);
+
+            /**
+             * @brief Compresses one 8-bit RGBA level, partial blocks on the right and bottom edges are
+             *        padded by clamping to the last row and column
+             * @param rgba Tightly packed RGBA8 texels
+             * @param extent Size of the level
+             * @param format BC4, BC5 or BC7 format, sRGB variants only change how the data is sampled
+             * @param output Receives get_compressed_size(format, extent) bytes
+             */
+            static void compress(const uint8_t *rgba, const VkExtent3D &extent, VkFormat format, uint8_t *output);
+
+            /**
+             * @brief Encodes 16 single channel values in row major order
+             */
+            static void encode_bc4_block(const uint8_t values[16], uint8_t output[bc4_block_size]);
+
+            /**
+             * @brief Encodes 16 RGBA texels in row major order, only red and green are stored
+             */
+            static void encode_bc5_block(const uint8_t texels[64], uint8_t output[bc5_block_size]);
+
+            /**
+             * @brief Encodes 16 RGBA texels in row major order using BC7 mode 6
+             */
+            static void encode_bc7_block(const uint8_t texels[64], uint8_t output[bc7_block_size]);
+        };
+    } // namespace sg
+} // namespace vkb
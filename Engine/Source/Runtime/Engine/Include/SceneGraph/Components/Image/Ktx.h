@@ -29,6 +29,11 @@ class Ktx : public Image
   public:
 	Ktx(const std::string &name, const std::vector<uint8_t> &data, ContentType content_type);
 
+	/**
+	 * @brief Decodes the encoded bytes in place, e.g. straight out of a MappedFile
+	 */
+	Ktx(const std::string &name, const uint8_t *data, size_t size, ContentType content_type);
+
 	virtual ~Ktx() = default;
 };
 
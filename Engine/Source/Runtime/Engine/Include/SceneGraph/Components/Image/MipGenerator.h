@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <volk.h>
+
+namespace vkb
+{
+    namespace sg
+    {
+        struct Mipmap;
+
+        /**
+         * @brief Downsampling kernel used between two mip levels
+         */
+        enum class MipFilter
+        {
+            /// 2x2 average, the cheapest option
+            Box,
+            /// 8 tap Kaiser windowed sinc, sharper minification with less aliasing
+            Kaiser
+        };
+
+        struct MipGenerationOptions
+        {
+            MipFilter filter{MipFilter::Box};
+
+            /// Renormalizes the xyz channels of every texel, which are expected to hold a [0, 1] encoded normal
+            bool normal_map{false};
+
+            /// Filters large levels in tiles on the JobSystem workers, the calling thread always takes part
+            bool parallel{false};
+
+            /// Destination rows processed by one task
+            uint32_t tile_rows{32};
+        };
+
+        /**
+         * @brief CPU mip chain generator
+         *        Filtering happens in linear space: sRGB formats are decoded before and encoded after the
+         *        kernel is applied, alpha is always treated as linear. 8-bit, 16-bit (unorm and half float)
+         *        and 32-bit float formats with 1, 2 or 4 channels are supported.
+         */
+        class MipGenerator
+        {
+        public:
+            /**
+             * @return Whether the format can be filtered by the generator
+             */
+            static bool is_supported(VkFormat format);
+
+            /**
+             * @brief Appends every mip level below the base level to data
+             * @param data Image data, holding only the base level on input
+             * @param format Format of the image data
+             * @param extent Size of the base level
+             * @param mipmaps Receives the description of all levels, including the base level
+             * @param options Filtering and threading options
+             */
+            static void generate(std::vector<uint8_t> &data, VkFormat format, const VkExtent3D &extent,
+                                 std::vector<Mipmap> &mipmaps, const MipGenerationOptions &options = {});
+        };
+    } // namespace sg
+} // namespace vkb
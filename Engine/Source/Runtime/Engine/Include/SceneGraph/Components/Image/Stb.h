@@ -28,6 +28,11 @@ class Stb : public Image
   public:
 	Stb(const std::string &name, const std::vector<uint8_t> &data, ContentType content_type);
 
+	/**
+	 * @brief Decodes the encoded bytes in place, e.g. straight out of a MappedFile
+	 */
+	Stb(const std::string &name, const uint8_t *data, size_t size, ContentType content_type);
+
 	virtual ~Stb() = default;
 };
 
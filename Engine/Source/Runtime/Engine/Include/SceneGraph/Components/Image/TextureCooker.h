@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <volk.h>
+
+#include "SceneGraph/Components/Image.h"
+
+namespace vkb
+{
+    namespace sg
+    {
+        /**
+         * @brief Offline texture compression with a content addressed cache
+         *        PNG/JPG sources are decoded once, given a full mip chain and block compressed, the result is
+         *        written as KTX2 under the cache directory, named after the hash of the source bytes and the
+         *        cook settings. Image::load picks the cooked file up on later runs and skips decoding entirely.
+         *
+         *        Format selection:
+         *          Color        BC7 sRGB       (ASTC 4x4 sRGB)
+         *          NormalMap    BC5, xy only, z has to be rebuilt in the shader (ASTC 4x4, xy in rg)
+         *          greyscale    BC4, the view replicates red so it samples like the source (ASTC 4x4)
+         *          anything     BC7           (ASTC 4x4)
+         */
+        class TextureCooker
+        {
+        public:
+            enum class Target
+            {
+                /// BC4/BC5/BC7, desktop GPUs
+                BC,
+                /// ASTC 4x4, mobile GPUs
+                ASTC
+            };
+
+            struct Settings
+            {
+                bool enabled{true};
+
+                Target target{Target::BC};
+
+                /// Defaults to <project root>/Cache/Textures when empty
+                std::string cache_directory;
+
+                MipFilter mip_filter{MipFilter::Kaiser};
+            };
+
+            static void set_settings(const Settings &settings);
+
+            static Settings get_settings();
+
+            /**
+             * @brief Returns the cooked version of an encoded PNG/JPG image, cooking and caching it first if needed
+             * @return nullptr when cooking is disabled or failed, the caller falls back to the source image
+             */
+            static std::unique_ptr<Image> load(const std::string &name, const uint8_t *source, size_t size,
+                                               Image::ContentType content_type);
+
+            /**
+             * @return Path of the cooked file for the given source bytes under the current settings
+             */
+            static std::string get_cooked_path(const uint8_t *source, size_t size, Image::ContentType content_type);
+
+            /**
+             * @brief Picks the compressed format for a decoded RGBA8 base level
+             */
+            static VkFormat select_format(const std::vector<uint8_t> &rgba, Image::ContentType content_type, Target target);
+
+            /**
+             * @brief Compresses a decoded image with its mip chain into a KTX2 file
+             * @param image 8-bit RGBA image, its mip chain is generated if missing
+             * @param content_type Content of the image, normal maps are renormalized while filtering
+             * @param format Compressed format from select_format
+             * @param settings Mip filter used for the generated levels
+             * @return The KTX2 file contents
+             */
+            static std::vector<uint8_t> cook(Image &image, Image::ContentType content_type, VkFormat format,
+                                             const Settings &settings);
+
+            /**
+             * @brief Serializes a single layer 2D texture to KTX2 without supercompression
+             * @param levels Data of every mip level, largest first
+             */
+            static std::vector<uint8_t> write_ktx2(VkFormat format, const VkExtent3D &extent,
+                                                   const std::vector<std::vector<uint8_t>> &levels);
+        };
+    } // namespace sg
+} // namespace vkb
@@ -33,6 +33,26 @@ namespace vkb
 {
 namespace sg
 {
+/**
+ * @brief Indices of the textures of a PBR material in the bindless descriptor table, sized to be pushed as constants
+ *        Textures the material doesn't have or that are not registered are BindlessHandle::invalid_index.
+ */
+struct PBRMaterialIndices
+{
+	uint32_t base_color;
+
+	uint32_t metallic_roughness;
+
+	uint32_t normal;
+
+	uint32_t occlusion;
+
+	uint32_t emissive;
+
+	/// Sampler of the base color texture, applies to all the textures of the material
+	uint32_t sampler;
+};
+
 class PBRMaterial : public Material
 {
   public:
@@ -47,6 +67,11 @@ class PBRMaterial : public Material
 	float metallic_factor{0.0f};
 
 	float roughness_factor{0.0f};
+
+	/**
+	 * @brief Looks the indices up on every call, streamed textures move to a new slot when their image is replaced
+	 */
+	PBRMaterialIndices get_bindless_indices() const;
 };
 
 }        // namespace sg
@@ -22,6 +22,7 @@
 #include <typeinfo>
 #include <vector>
 
+#include "Framework/Core/BindlessDescriptorTable.hpp"
 #include "Framework/Core/Sampler.hpp"
 #include "SceneGraph/Component.h"
 
@@ -42,6 +43,9 @@ namespace vkb
             virtual std::type_index get_type() override;
 
             vkb::Sampler vk_sampler;
+
+            /// Slot of the sampler in the bindless descriptor table, invalid when bindless resources are not used
+            BindlessHandle bindless_handle;
         };
     } // namespace sg
 } // namespace vkb
@@ -29,6 +29,7 @@
 #include "Framework/Core/ShaderModule.hpp"
 
 #include "SceneGraph/Component.h"
+#include "SceneGraph/Components/VertexLayout.h"
 
 namespace vkb
 {
@@ -66,6 +67,15 @@ class SubMesh : public Component
 
 	std::unique_ptr<vkb::Buffer> index_buffer;
 
+	/// Only meaningful when the positions were quantized, see VertexLayout
+	PositionDequantization position_dequantization{};
+
+	/// Average texture coordinate units per object space unit, drives the texture streaming mip estimate
+	float texcoord_density = 1.0f;
+
+	/// Mesh of the primitive in the loader's MeshArena, ~0u when no arena was built or the primitive is not a triangle list
+	std::uint32_t arena_mesh = ~0u;
+
 	void set_attribute(const std::string &name, const VertexAttribute &attribute);
 
 	bool get_attribute(const std::string &name, VertexAttribute &attribute) const;
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Framework/Common/glmCommon.hpp"
+
+namespace vkb
+{
+    class ShaderVariant;
+
+    namespace sg
+    {
+        /**
+         * @brief Selects how each vertex attribute is stored in the GPU vertex buffer
+         *        The default layout keeps the full precision float attributes of the Vertex struct.
+         *        Every enabled option shrinks one group of attributes and adds a define to the
+         *        submesh shader variant, so the vertex shader can pick the matching decode
+         *        (see Shaders/Default/Common/VertexDecode.glsl).
+         */
+        struct VertexLayout
+        {
+            /// Positions as RGBA16_UNORM relative to the submesh AABB (QUANTIZED_POSITION)
+            bool quantize_positions = false;
+
+            /// Normals and tangents as octahedral RG16_SNORM (OCT_NORMAL, OCT_TANGENT)
+            bool octahedral_normals = false;
+
+            /// Texture coordinates as RG16_SFLOAT (HALF_TEXCOORD)
+            bool half_texcoords = false;
+
+            /// Joints as RGBA8_UINT when they fit, weights and colors as RGBA8_UNORM (UNORM8_SKIN)
+            bool compact_skin = false;
+
+            /**
+             * @return The full precision layout, which matches the Vertex struct
+             */
+            static VertexLayout full();
+
+            /**
+             * @return A layout with every compression option enabled
+             */
+            static VertexLayout compact();
+
+            /**
+             * @return True if any attribute is stored in a compressed format
+             */
+            bool is_compact() const;
+
+            /**
+             * @brief Adds the defines selecting the shader decode of this layout
+             * @param variant The shader variant of the submesh using this layout
+             */
+            void apply_defines(ShaderVariant& variant) const;
+        };
+
+        /**
+         * @brief Maps a quantized position back into model space: pos = offset + scale * q,
+         *        where q is the normalized [0, 1] value read from the RGBA16_UNORM attribute
+         */
+        struct PositionDequantization
+        {
+            glm::vec3 offset{0.0f};
+
+            glm::vec3 scale{1.0f};
+
+            /**
+             * @brief Creates the dequantization parameters which cover the given bounds
+             */
+            static PositionDequantization from_bounds(const glm::vec3& min, const glm::vec3& max);
+
+            /**
+             * @return The transform which can be folded into the model matrix of the submesh
+             */
+            glm::mat4 to_matrix() const;
+        };
+
+        /**
+         * @brief Octahedral mapping of a unit vector onto the [-1, 1] square
+         */
+        glm::vec2 octahedral_encode(const glm::vec3& n);
+
+        glm::vec3 octahedral_decode(const glm::vec2& e);
+
+        /**
+         * @return The octahedral encoded normal packed as RG16_SNORM
+         */
+        uint32_t pack_octahedral_normal(const glm::vec3& normal);
+
+        /**
+         * @brief Packs a glTF tangent as RG16_SNORM. The handedness in w is folded into the sign of the
+         *        second component, which is remapped to [0, 1] beforehand (one bit of precision is lost).
+         */
+        uint32_t pack_octahedral_tangent(const glm::vec4& tangent);
+
+        /**
+         * @return The position quantized to RGBA16_UNORM relative to the dequantization range, w is 1
+         */
+        uint64_t quantize_position(const glm::vec3& position, const PositionDequantization& dequantization);
+
+        /**
+         * @return The texture coordinate packed as RG16_SFLOAT
+         */
+        uint32_t pack_half_texcoord(const glm::vec2& uv);
+
+        /**
+         * @brief Packs skinning weights as RGBA8_UNORM, the rounding error is given to the largest
+         *        weight so the packed weights still sum up to one
+         */
+        uint32_t pack_unorm8_weights(const glm::vec4& weights);
+    } // namespace sg
+} // namespace vkb
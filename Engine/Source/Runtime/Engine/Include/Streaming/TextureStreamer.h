@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <volk.h>
+
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Core/Image.hpp"
+#include "Framework/Core/ImageView.hpp"
+
+namespace vkb
+{
+    class CommandBuffer;
+    class VulkanDevice;
+
+    namespace sg
+    {
+        class Camera;
+        class Image;
+        class Scene;
+    } // namespace sg
+
+    /**
+     * @brief Provides the texel data of single mip levels of a streamed image
+     */
+    class MipSource
+    {
+    public:
+        virtual ~MipSource() = default;
+
+        /**
+         * @brief Reads one level, called from worker threads
+         */
+        virtual std::vector<uint8_t> read_level(uint32_t level) const = 0;
+    };
+
+    /**
+     * @brief Reads levels straight from an uncompressed (no supercompression) KTX2 file
+     */
+    class Ktx2MipSource : public MipSource
+    {
+    public:
+        /**
+         * @return nullptr when the file is not a single layer, single face KTX2 file with the expected level count
+         */
+        static std::unique_ptr<Ktx2MipSource> open(const std::string &path, uint32_t level_count);
+
+        std::vector<uint8_t> read_level(uint32_t level) const override;
+
+    private:
+        struct Level
+        {
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        std::string path;
+
+        std::vector<Level> levels;
+    };
+
+    /**
+     * @brief Keeps the decoded data of every level in system memory, for images without a file to stream from
+     */
+    class MemoryMipSource : public MipSource
+    {
+    public:
+        explicit MemoryMipSource(sg::Image &image);
+
+        std::vector<uint8_t> read_level(uint32_t level) const override;
+
+    private:
+        std::vector<uint8_t> data;
+
+        std::vector<std::pair<size_t, size_t>> levels;
+    };
+
+    /**
+     * @brief Keeps only the mips that are needed on screen resident on the GPU
+     *        Images start with their small tail levels resident. Every frame the required mip of each image is
+     *        estimated on the CPU from the visible instances (texel density of the submesh against the projected
+     *        pixel size), higher levels are read from their MipSource on the JobSystem workers and the image is
+     *        reallocated over the new mip range through VMA. Levels that are no longer needed stay resident until
+     *        the memory budget is exceeded, then the least recently used images are reduced first.
+     *
+     *        The streamed image is always allocated over [resident mip, last mip], the sampler therefore needs no
+     *        LOD clamp and descriptors simply pick up the new view of sg::Image.
+     */
+    class TextureStreamer
+    {
+    public:
+        struct Settings
+        {
+            /// Device memory streamed images may use, 0 picks half of the device local heap budget
+            VkDeviceSize budget{0};
+
+            /// Levels up to this size are loaded with the scene and never evicted
+            uint32_t resident_tail_size{128};
+
+            /// Upper bound of new texel data uploaded per update
+            VkDeviceSize max_upload_per_frame{32 * 1024 * 1024};
+
+            /// Frames an old allocation is kept alive after it was replaced
+            uint32_t frames_in_flight{3};
+
+            /// Added to the computed mip, positive values trade sharpness for memory
+            float mip_bias{0.0f};
+        };
+
+        struct Stats
+        {
+            size_t image_count{0};
+
+            VkDeviceSize resident_bytes{0};
+
+            VkDeviceSize budget{0};
+
+            uint32_t pending_reads{0};
+
+            uint32_t evictions{0};
+
+            uint32_t stream_ins{0};
+        };
+
+        explicit TextureStreamer(VulkanDevice &device);
+
+        TextureStreamer(VulkanDevice &device, const Settings &settings);
+
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer &) = delete;
+
+        TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+        /**
+         * @return Whether the image can be streamed: single layer 2D images with more than one level
+         */
+        static bool is_streamable(const sg::Image &image);
+
+        /**
+         * @brief Creates the Vulkan image of a loaded sg::Image with only its tail levels and records their upload
+         * @param image Image with its CPU data, the data is released once it has been staged
+         * @param command_buffer Recording command buffer the upload is recorded to
+         * @param staging_buffers Receives the staging buffer, which has to live until the command buffer completes
+         * @return false when the image is not streamable, it has to be uploaded as usual
+         */
+        bool register_image(sg::Image &image, CommandBuffer &command_buffer, std::vector<Buffer> &staging_buffers);
+
+        void unregister_image(sg::Image &image);
+
+        /**
+         * @brief Requests a mip level for the current frame, the finest request of a frame wins
+         */
+        void request(sg::Image &image, float mip);
+
+        /**
+         * @brief Computes the requests of every visible textured submesh of the scene
+         * @param viewport Size in pixels of the target the camera renders to
+         */
+        void request_visible(const sg::Scene &scene, sg::Camera &camera, const VkExtent2D &viewport);
+
+        /**
+         * @brief Streams levels in and out, records the copies into the command buffer
+         *        Call once per frame before recording work that samples the streamed images
+         */
+        void update(CommandBuffer &command_buffer);
+
+        const Settings &get_settings() const;
+
+        Stats get_stats() const;
+
+    private:
+        struct Entry
+        {
+            sg::Image *image{nullptr};
+
+            std::unique_ptr<MipSource> source;
+
+            /// First level of the full chain present in the Vulkan image
+            uint32_t resident_mip{0};
+
+            /// Finest level the image may be reduced to, the tail is never evicted
+            uint32_t tail_mip{0};
+
+            /// Level wanted by the last request
+            uint32_t wanted_mip{0};
+
+            uint64_t last_used_frame{0};
+
+            VkDeviceSize resident_bytes{0};
+
+            /// Size of the texel data of every level of the full chain
+            std::vector<VkDeviceSize> level_sizes;
+
+            /// First level being read
+            uint32_t loading_mip{0};
+
+            std::future<std::vector<std::vector<uint8_t>>> loading;
+        };
+
+        struct Retired
+        {
+            std::unique_ptr<vkb::Image> image;
+
+            std::unique_ptr<vkb::ImageView> view;
+
+            std::unique_ptr<Buffer> staging;
+
+            uint64_t frame;
+        };
+
+        /**
+         * @brief Moves the image to a new allocation covering [mip, last mip]
+         * @param levels Data of the levels [mip, resident_mip) when growing
+         * @return false when the allocation failed
+         */
+        bool reallocate(Entry &entry, uint32_t mip, const std::vector<std::vector<uint8_t>> &levels,
+                        CommandBuffer &command_buffer);
+
+        /**
+         * @brief Reduces least recently used images until bytes fit in the budget
+         * @param keep Entry that must not be evicted
+         */
+        bool make_room(VkDeviceSize bytes, const Entry *keep, CommandBuffer &command_buffer);
+
+        VkDeviceSize estimate_size(const Entry &entry, uint32_t mip) const;
+
+        VulkanDevice &device;
+
+        Settings settings;
+
+        std::unordered_map<sg::Image *, std::unique_ptr<Entry>> entries;
+
+        std::deque<Retired> retired;
+
+        uint64_t frame{0};
+
+        VkDeviceSize resident_bytes{0};
+
+        uint32_t evictions{0};
+
+        uint32_t stream_ins{0};
+    };
+} // namespace vkb
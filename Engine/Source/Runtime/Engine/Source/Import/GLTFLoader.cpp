@@ -19,32 +19,38 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "Import/GLTFLoader.hpp"
 
-#include <future>
 #include <limits>
+#include <numeric>
 #include <queue>
 
 #include "Framework/Common/VkError.hpp"
 
 #include "Framework/Common/glmCommon.hpp"
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "Framework/Core/BindlessDescriptorTable.hpp"
 #include "Framework/Core/CommandBuffer.hpp"
 #include "SceneGraph/Scene.h"
 #include "SceneGraph/Components/Image.h"
 #include "SceneGraph/Components/Mesh.h"
 
-#include <ctpl_stl.h>
-
 #include "Framework/Core/CommandPool.hpp"
 #include "Framework/Core/Queue.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
 #include "Framework/Misc/FencePool.hpp"
-#include "Misc/Paths.hpp"
+#include "Framework/Rendering/Subpasses/DrawListSubpass.hpp"
+#include "Framework/Misc/UploadManager.hpp"
+#include "Misc/VirtualFileSystem.hpp"
+#include "Profiler/Profiler.hpp"
 #include "SceneGraph/Node.h"
 #include "SceneGraph/Components/Camera.h"
 #include "SceneGraph/Components/Pbr_Material.h"
+#include "SceneGraph/Components/SubMesh.h"
 #include "SceneGraph/Components/PerspectiveCamera.h"
 #include "SceneGraph/Scripts/Animation.h"
+#include "Streaming/TextureStreamer.h"
+#include "SubSystems/JobSystem.hpp"
 #include "Timer/timer.hpp"
 #include "Tools/Utils.hpp"
 
@@ -52,6 +58,9 @@ namespace vkb
 {
     namespace
     {
+        /// Per image and per mesh messages of the importer, large scenes have thousands of them
+        LogChannel import_log{"Import", 100};
+
         inline VkFilter find_min_filter(int min_filter)
         {
             switch (min_filter)
@@ -299,6 +308,30 @@ namespace vkb
             return result;
         }
 
+        /**
+         * @brief Creates a buffer image copy for every mip level of the image data
+         */
+        inline std::vector<VkBufferImageCopy> get_image_copy_regions(sg::Image& image)
+        {
+            auto& mipmaps = image.get_mipmaps();
+
+            std::vector<VkBufferImageCopy> buffer_copy_regions(mipmaps.size());
+
+            for (size_t i = 0; i < mipmaps.size(); ++i)
+            {
+                auto& mipmap = mipmaps[i];
+                auto& copy_region = buffer_copy_regions[i];
+
+                copy_region.bufferOffset = mipmap.offset;
+                copy_region.imageSubresource = image.get_vk_image_view().get_subresource_layers();
+                // Update miplevel
+                copy_region.imageSubresource.mipLevel = mipmap.level;
+                copy_region.imageExtent = mipmap.extent;
+            }
+
+            return buffer_copy_regions;
+        }
+
         inline void upload_image_to_gpu(vkb::CommandBuffer& command_buffer, vkb::Buffer& staging_buffer,
                                         sg::Image& image)
         {
@@ -317,22 +350,7 @@ namespace vkb
                 command_buffer.image_memory_barrier(image.get_vk_image_view(), memory_barrier);
             }
 
-            // Create a buffer image copy for every mip level
-            auto& mipmaps = image.get_mipmaps();
-
-            std::vector<VkBufferImageCopy> buffer_copy_regions(mipmaps.size());
-
-            for (size_t i = 0; i < mipmaps.size(); ++i)
-            {
-                auto& mipmap = mipmaps[i];
-                auto& copy_region = buffer_copy_regions[i];
-
-                copy_region.bufferOffset = mipmap.offset;
-                copy_region.imageSubresource = image.get_vk_image_view().get_subresource_layers();
-                // Update miplevel
-                copy_region.imageSubresource.mipLevel = mipmap.level;
-                copy_region.imageExtent = mipmap.extent;
-            }
+            auto buffer_copy_regions = get_image_copy_regions(image);
 
             command_buffer.copy_buffer_to_image(staging_buffer, image.get_vk_image(), buffer_copy_regions);
 
@@ -400,6 +418,427 @@ namespace vkb
             }
         }
 
+        /**
+         * @brief Non owning view of a glTF vertex attribute, honours the byte stride of the buffer view
+         */
+        struct AttributeView
+        {
+            const uint8_t* data = nullptr;
+            size_t stride = 0;
+            int component_type = 0;
+            bool normalized = false;
+            uint32_t components = 0;
+
+            explicit operator bool() const
+            {
+                return data != nullptr;
+            }
+
+            float read(size_t vertex, uint32_t component) const
+            {
+                const uint8_t* element = data + vertex * stride;
+                // Signed normalized values follow the glTF rule max(c / (2^(b-1) - 1), -1)
+                switch (component_type)
+                {
+                case TINYGLTF_COMPONENT_TYPE_BYTE:
+                    {
+                        float value = static_cast<float>(static_cast<int8_t>(element[component]));
+                        return normalized ? std::max(value / 127.0f, -1.0f) : value;
+                    }
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                    {
+                        float value = static_cast<float>(element[component]);
+                        return normalized ? value / 255.0f : value;
+                    }
+                case TINYGLTF_COMPONENT_TYPE_SHORT:
+                    {
+                        int16_t value;
+                        std::memcpy(&value, element + component * sizeof(int16_t), sizeof(int16_t));
+                        return normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+                    }
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                    {
+                        uint16_t value;
+                        std::memcpy(&value, element + component * sizeof(uint16_t), sizeof(uint16_t));
+                        return normalized ? value / 65535.0f : static_cast<float>(value);
+                    }
+                case TINYGLTF_COMPONENT_TYPE_FLOAT:
+                    {
+                        float value;
+                        std::memcpy(&value, element + component * sizeof(float), sizeof(float));
+                        return value;
+                    }
+                default:
+                    return 0.0f;
+                }
+            }
+
+            glm::vec4 read_vec4(size_t vertex, float w = 0.0f) const
+            {
+                glm::vec4 value{0.0f, 0.0f, 0.0f, w};
+                for (uint32_t c = 0; c < components && c < 4; c++)
+                {
+                    value[c] = read(vertex, c);
+                }
+                return value;
+            }
+        };
+
+        inline AttributeView find_attribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive,
+                                            const std::string& name)
+        {
+            auto it = primitive.attributes.find(name);
+            if (it == primitive.attributes.end())
+            {
+                return {};
+            }
+
+            assert(it->second < model.accessors.size());
+            auto& accessor = model.accessors[it->second];
+            auto& buffer_view = model.bufferViews[accessor.bufferView];
+
+            AttributeView attribute;
+            attribute.data = &model.buffers[buffer_view.buffer].data[accessor.byteOffset + buffer_view.byteOffset];
+            attribute.stride = accessor.ByteStride(buffer_view);
+            attribute.component_type = accessor.componentType;
+            attribute.normalized = accessor.normalized;
+            attribute.components = to_u32(tinygltf::GetNumComponentsInType(accessor.type));
+            return attribute;
+        }
+
+        inline std::vector<uint32_t> read_indices(const tinygltf::Model& model, const tinygltf::Primitive& primitive)
+        {
+            std::vector<uint32_t> indices;
+            if (primitive.indices < 0)
+            {
+                return indices;
+            }
+
+            auto& accessor = model.accessors[primitive.indices];
+            auto& buffer_view = model.bufferViews[accessor.bufferView];
+            const uint8_t* data = &model.buffers[buffer_view.buffer].data[accessor.byteOffset + buffer_view.byteOffset];
+            size_t stride = accessor.ByteStride(buffer_view);
+
+            indices.resize(accessor.count);
+            for (size_t i = 0; i < accessor.count; i++)
+            {
+                switch (accessor.componentType)
+                {
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                    indices[i] = data[i * stride];
+                    break;
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                    {
+                        uint16_t value;
+                        std::memcpy(&value, data + i * stride, sizeof(value));
+                        indices[i] = value;
+                        break;
+                    }
+                default:
+                    std::memcpy(&indices[i], data + i * stride, sizeof(uint32_t));
+                    break;
+                }
+            }
+            return indices;
+        }
+
+        /**
+         * @brief Average texture coordinate units per object space unit of a triangle list primitive,
+         *        the area weighted ratio of uv area to surface area. Used to pick streamed mip levels.
+         */
+        inline float compute_texcoord_density(const tinygltf::Model& model, const tinygltf::Primitive& primitive)
+        {
+            auto positions = find_attribute(model, primitive, "POSITION");
+            auto uvs = find_attribute(model, primitive, "TEXCOORD_0");
+            if (!positions.data || !uvs.data || primitive.mode != TINYGLTF_MODE_TRIANGLES)
+            {
+                return 1.0f;
+            }
+
+            auto indices = read_indices(model, primitive);
+            size_t count = indices.empty() ? model.accessors[primitive.attributes.at("POSITION")].count : indices.size();
+
+            double position_area = 0.0;
+            double uv_area = 0.0;
+            for (size_t i = 0; i + 2 < count; i += 3)
+            {
+                size_t v[3];
+                for (size_t k = 0; k < 3; k++)
+                {
+                    v[k] = indices.empty() ? i + k : indices[i + k];
+                }
+
+                glm::vec3 p0 = positions.read_vec4(v[0]);
+                glm::vec3 p1 = positions.read_vec4(v[1]);
+                glm::vec3 p2 = positions.read_vec4(v[2]);
+                position_area += glm::length(glm::cross(p1 - p0, p2 - p0));
+
+                glm::vec2 t0 = uvs.read_vec4(v[0]);
+                glm::vec2 t1 = uvs.read_vec4(v[1]);
+                glm::vec2 t2 = uvs.read_vec4(v[2]);
+                glm::vec2 e0 = t1 - t0;
+                glm::vec2 e1 = t2 - t0;
+                uv_area += std::abs(e0.x * e1.y - e0.y * e1.x);
+            }
+
+            if (position_area <= 0.0 || uv_area <= 0.0)
+            {
+                return 1.0f;
+            }
+
+            return static_cast<float>(std::sqrt(uv_area / position_area));
+        }
+
+        /**
+         * @brief Copies a triangle list primitive into the arena in the DrawListSubpass::Vertex layout
+         * @return Index of the arena mesh, ~0u when the primitive is not a triangle list
+         */
+        inline uint32_t add_to_mesh_arena(MeshArena& arena, const tinygltf::Model& model,
+                                          const tinygltf::Primitive& primitive)
+        {
+            auto positions = find_attribute(model, primitive, "POSITION");
+            if (!positions || primitive.mode != TINYGLTF_MODE_TRIANGLES)
+            {
+                return ~0u;
+            }
+
+            auto normals = find_attribute(model, primitive, "NORMAL");
+            auto uvs = find_attribute(model, primitive, "TEXCOORD_0");
+
+            size_t vertex_count = model.accessors[primitive.attributes.at("POSITION")].count;
+
+            std::vector<DrawListSubpass::Vertex> vertices(vertex_count);
+            std::vector<glm::vec3> points(vertex_count);
+            for (size_t v = 0; v < vertex_count; v++)
+            {
+                vertices[v].position = positions.read_vec4(v);
+                vertices[v].normal = normals ? glm::vec3(normals.read_vec4(v)) : glm::vec3{0.0f, 0.0f, 1.0f};
+                vertices[v].uv = uvs ? glm::vec2(uvs.read_vec4(v)) : glm::vec2{0.0f};
+                points[v] = vertices[v].position;
+            }
+
+            auto indices = read_indices(model, primitive);
+            if (indices.empty())
+            {
+                indices.resize(vertex_count);
+                std::iota(indices.begin(), indices.end(), 0u);
+            }
+
+            return arena.add_mesh(vertices.data(), to_u32(vertex_count), indices,
+                                  MeshArena::compute_bounding_sphere(points));
+        }
+
+        /**
+         * @brief Interleaves the attributes of a primitive into a single vertex stream using the
+         *        formats selected by the layout. Only attributes present in the source are written.
+         *        The submesh attributes, dequantization range and shader defines are filled in as well.
+         */
+        inline std::vector<uint8_t> pack_compact_vertices(const tinygltf::Model& model,
+                                                          const tinygltf::Primitive& primitive,
+                                                          const sg::VertexLayout& layout, sg::SubMesh& submesh)
+        {
+            auto positions = find_attribute(model, primitive, "POSITION");
+            auto normals = find_attribute(model, primitive, "NORMAL");
+            auto tangents = find_attribute(model, primitive, "TANGENT");
+            auto uvs = find_attribute(model, primitive, "TEXCOORD_0");
+            auto colors = find_attribute(model, primitive, "COLOR_0");
+            auto joints = find_attribute(model, primitive, "JOINTS_0");
+            auto weights = find_attribute(model, primitive, "WEIGHTS_0");
+
+            size_t vertex_count = submesh.vertices_count;
+            bool has_skin = joints && weights;
+
+            uint32_t max_joint = 0;
+            for (size_t v = 0; has_skin && v < vertex_count; v++)
+            {
+                glm::vec4 joint = joints.read_vec4(v);
+                max_joint = std::max(max_joint, static_cast<uint32_t>(glm::max(glm::max(joint.x, joint.y),
+                                                                               glm::max(joint.z, joint.w))));
+            }
+            bool byte_joints = layout.compact_skin && max_joint <= std::numeric_limits<uint8_t>::max();
+
+            // Lay out the interleaved stream, every format below is a multiple of 4 bytes
+            std::vector<std::pair<std::string, sg::VertexAttribute>> attributes;
+            uint32_t stride = 0;
+            auto add_attribute = [&](const std::string& name, VkFormat format, uint32_t size)
+            {
+                sg::VertexAttribute attribute;
+                attribute.format = format;
+                attribute.offset = stride;
+                attributes.emplace_back(name, attribute);
+                stride += size;
+                return attribute.offset;
+            };
+
+            uint32_t position_offset = layout.quantize_positions
+                                           ? add_attribute("position", VK_FORMAT_R16G16B16A16_UNORM, 8)
+                                           : add_attribute("position", VK_FORMAT_R32G32B32_SFLOAT, 12);
+            uint32_t normal_offset = 0;
+            if (normals)
+            {
+                normal_offset = layout.octahedral_normals
+                                    ? add_attribute("normal", VK_FORMAT_R16G16_SNORM, 4)
+                                    : add_attribute("normal", VK_FORMAT_R32G32B32_SFLOAT, 12);
+            }
+            uint32_t tangent_offset = 0;
+            if (tangents)
+            {
+                tangent_offset = layout.octahedral_normals
+                                     ? add_attribute("tangent", VK_FORMAT_R16G16_SNORM, 4)
+                                     : add_attribute("tangent", VK_FORMAT_R32G32B32A32_SFLOAT, 16);
+            }
+            uint32_t uv_offset = 0;
+            if (uvs)
+            {
+                uv_offset = layout.half_texcoords
+                                ? add_attribute("texcoord_0", VK_FORMAT_R16G16_SFLOAT, 4)
+                                : add_attribute("texcoord_0", VK_FORMAT_R32G32_SFLOAT, 8);
+            }
+            uint32_t color_offset = 0;
+            if (colors)
+            {
+                color_offset = layout.compact_skin
+                                   ? add_attribute("color_0", VK_FORMAT_R8G8B8A8_UNORM, 4)
+                                   : add_attribute("color_0", VK_FORMAT_R32G32B32A32_SFLOAT, 16);
+            }
+            uint32_t joint_offset = 0;
+            uint32_t weight_offset = 0;
+            if (has_skin)
+            {
+                joint_offset = byte_joints
+                                   ? add_attribute("joints_0", VK_FORMAT_R8G8B8A8_UINT, 4)
+                                   : layout.compact_skin
+                                   ? add_attribute("joints_0", VK_FORMAT_R16G16B16A16_UINT, 8)
+                                   : add_attribute("joints_0", VK_FORMAT_R32G32B32A32_SFLOAT, 16);
+                weight_offset = layout.compact_skin
+                                    ? add_attribute("weights_0", VK_FORMAT_R8G8B8A8_UNORM, 4)
+                                    : add_attribute("weights_0", VK_FORMAT_R32G32B32A32_SFLOAT, 16);
+            }
+
+            for (auto& [name, attribute] : attributes)
+            {
+                attribute.stride = stride;
+                submesh.set_attribute(name, attribute);
+            }
+
+            if (layout.quantize_positions)
+            {
+                glm::vec3 min{std::numeric_limits<float>::max()};
+                glm::vec3 max{std::numeric_limits<float>::lowest()};
+                for (size_t v = 0; v < vertex_count; v++)
+                {
+                    glm::vec3 position = positions.read_vec4(v);
+                    min = glm::min(min, position);
+                    max = glm::max(max, position);
+                }
+                submesh.position_dequantization = sg::PositionDequantization::from_bounds(min, max);
+            }
+
+            layout.apply_defines(submesh.get_mut_shader_variant());
+
+            std::vector<uint8_t> vertex_data(vertex_count * stride);
+
+            auto write = [&vertex_data, stride](size_t vertex, uint32_t offset, const auto& value)
+            {
+                std::memcpy(vertex_data.data() + vertex * stride + offset, &value, sizeof(value));
+            };
+
+            for (size_t v = 0; v < vertex_count; v++)
+            {
+                glm::vec3 position = positions.read_vec4(v);
+                if (layout.quantize_positions)
+                {
+                    write(v, position_offset, sg::quantize_position(position, submesh.position_dequantization));
+                }
+                else
+                {
+                    write(v, position_offset, position);
+                }
+
+                if (normals)
+                {
+                    glm::vec3 normal = normals.read_vec4(v);
+                    normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+                    if (layout.octahedral_normals)
+                    {
+                        write(v, normal_offset, sg::pack_octahedral_normal(normal));
+                    }
+                    else
+                    {
+                        write(v, normal_offset, normal);
+                    }
+                }
+
+                if (tangents)
+                {
+                    glm::vec4 tangent = tangents.read_vec4(v, 1.0f);
+                    if (layout.octahedral_normals)
+                    {
+                        write(v, tangent_offset, sg::pack_octahedral_tangent(tangent));
+                    }
+                    else
+                    {
+                        write(v, tangent_offset, tangent);
+                    }
+                }
+
+                if (uvs)
+                {
+                    glm::vec2 uv = uvs.read_vec4(v);
+                    if (layout.half_texcoords)
+                    {
+                        write(v, uv_offset, sg::pack_half_texcoord(uv));
+                    }
+                    else
+                    {
+                        write(v, uv_offset, uv);
+                    }
+                }
+
+                if (colors)
+                {
+                    glm::vec4 color = colors.read_vec4(v, 1.0f);
+                    if (layout.compact_skin)
+                    {
+                        write(v, color_offset, glm::packUnorm4x8(color));
+                    }
+                    else
+                    {
+                        write(v, color_offset, color);
+                    }
+                }
+
+                if (has_skin)
+                {
+                    glm::vec4 joint = joints.read_vec4(v);
+                    glm::vec4 weight = weights.read_vec4(v);
+                    if (byte_joints)
+                    {
+                        write(v, joint_offset, glm::u8vec4(joint));
+                    }
+                    else if (layout.compact_skin)
+                    {
+                        write(v, joint_offset, glm::u16vec4(joint));
+                    }
+                    else
+                    {
+                        write(v, joint_offset, joint);
+                    }
+
+                    if (layout.compact_skin)
+                    {
+                        write(v, weight_offset, sg::pack_unorm8_weights(weight));
+                    }
+                    else
+                    {
+                        write(v, weight_offset, weight);
+                    }
+                }
+            }
+
+            return vertex_data;
+        }
+
         static inline bool texture_needs_srgb_colorspace(const std::string& name)
         {
             // The gltf spec states that the base and emissive textures MUST be encoded with the sRGB
@@ -413,6 +852,94 @@ namespace vkb
             assert(name == "metallicRoughnessTexture" || name == "normalTexture" || name == "occlusionTexture");
             return false;
         }
+
+        /**
+         * @brief Reads the glTF file and its buffers through the VirtualFileSystem, so models can be packed in archives
+         */
+        tinygltf::FsCallbacks get_file_system_callbacks()
+        {
+            tinygltf::FsCallbacks callbacks{};
+
+            callbacks.FileExists = [](const std::string& path, void*)
+            {
+                return VirtualFileSystem::GetInstance().Exists(path);
+            };
+
+            callbacks.ExpandFilePath = [](const std::string& path, void*)
+            {
+                return path;
+            };
+
+            callbacks.ReadWholeFile = [](std::vector<unsigned char>* out, std::string* err, const std::string& path, void*)
+            {
+                try
+                {
+                    auto file = VirtualFileSystem::GetInstance().Read(path);
+                    out->assign(file.begin(), file.end());
+                    return true;
+                }
+                catch (const std::exception& e)
+                {
+                    if (err)
+                    {
+                        *err += e.what();
+                    }
+                    return false;
+                }
+            };
+
+            callbacks.WriteWholeFile = &tinygltf::WriteWholeFile;
+
+            return callbacks;
+        }
+
+        /// Every stage that reads mesh buffers, the uploads are finished before the first frame uses them
+        constexpr VkPipelineStageFlags mesh_buffer_stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                                            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+        constexpr VkAccessFlags mesh_buffer_access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                                     VK_ACCESS_SHADER_READ_BIT;
+
+        /**
+         * @brief Fills a device local buffer through the upload manager when there is one, otherwise records the
+         *        copy from a staging buffer which is kept in transient_buffers until the command buffer completed
+         */
+        void upload_to_buffer(VulkanDevice& device, UploadManager* upload_manager, const void* data, VkDeviceSize size,
+                              vkb::Buffer& buffer, CommandBuffer* command_buffer, std::vector<vkb::Buffer>& transient_buffers)
+        {
+            if (upload_manager)
+            {
+                upload_manager->upload_buffer(buffer, 0, data, size, mesh_buffer_stages, mesh_buffer_access);
+                return;
+            }
+
+            vkb::Buffer stage_buffer = vkb::Buffer::create_staging_buffer(device, size, data);
+
+            command_buffer->copy_buffer(stage_buffer, buffer, size);
+
+            transient_buffers.push_back(std::move(stage_buffer));
+        }
+
+        /**
+         * @brief Creates a mesh buffer of the scene. With an upload manager it is device local and written by the
+         *        transfer queue, otherwise it is host visible and written directly.
+         */
+        vkb::Buffer create_mesh_buffer(VulkanDevice& device, UploadManager* upload_manager,
+                                       const std::vector<uint8_t>& data, VkBufferUsageFlags usage,
+                                       VmaMemoryUsage host_memory_usage)
+        {
+            if (upload_manager)
+            {
+                vkb::Buffer buffer{device, data.size(), usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0};
+                upload_manager->upload_buffer(buffer, 0, data.data(), data.size(), mesh_buffer_stages, mesh_buffer_access);
+                return buffer;
+            }
+
+            vkb::Buffer buffer{device, data.size(), usage, host_memory_usage};
+            buffer.update(data);
+            return buffer;
+        }
     } // namespace
 
     std::unordered_map<std::string, bool> GLTFLoader::supported_extensions = {
@@ -427,14 +954,16 @@ namespace vkb
     std::unique_ptr<sg::Scene> GLTFLoader::read_scene_from_file(const std::string& file_name, int scene_index,
                                                                 VkBufferUsageFlags additional_buffer_usage_flags)
     {
-        //PROFILE_SCOPE("Load GLTF Scene");
+        PROFILE_SCOPE("Load GLTF Scene");
 
         std::string err;
         std::string warn;
 
         tinygltf::TinyGLTF gltf_loader;
+        gltf_loader.SetFsCallbacks(get_file_system_callbacks());
 
-        std::string gltf_file = Paths::GetAssetFullPath(file_name);
+        // Relative to the Assets directory, which the VirtualFileSystem mounts at its root
+        const std::string& gltf_file = file_name;
 
         bool importResult = gltf_loader.LoadASCIIFromFile(&model, &err, &warn, gltf_file.c_str());
 
@@ -472,14 +1001,16 @@ namespace vkb
                                                                   bool storage_buffer,
                                                                   VkBufferUsageFlags additional_buffer_usage_flags)
     {
-        //PROFILE_SCOPE("Load GLTF Model");
+        PROFILE_SCOPE("Load GLTF Model");
 
         std::string err;
         std::string warn;
 
         tinygltf::TinyGLTF gltf_loader;
+        gltf_loader.SetFsCallbacks(get_file_system_callbacks());
 
-        std::string gltf_file = Paths::GetAssetFullPath(file_name);
+        // Relative to the Assets directory, which the VirtualFileSystem mounts at its root
+        const std::string& gltf_file = file_name;
 
         bool importResult = gltf_loader.LoadASCIIFromFile(&model, &err, &warn, gltf_file.c_str());
 
@@ -516,7 +1047,7 @@ namespace vkb
 
     sg::Scene GLTFLoader::load_scene(int scene_index, VkBufferUsageFlags additional_buffer_usage_flags)
     {
-        //PROFILE_SCOPE("Process Scene");
+        PROFILE_SCOPE("Process Scene");
 
         auto scene = sg::Scene();
 
@@ -573,41 +1104,113 @@ namespace vkb
         timer.start();
 
         // Load images
-        auto thread_count = std::thread::hardware_concurrency();
-        thread_count = thread_count == 0 ? 1 : thread_count;
-        ctpl::thread_pool thread_pool(thread_count);
+        auto& job_system = JobSystem::GetInstance();
 
         auto image_count = to_u32(model.images.size());
 
-        std::vector<std::future<std::unique_ptr<sg::Image>>> image_component_futures;
-        for (size_t image_index = 0; image_index < image_count; image_index++)
+        // The color space and normal map usage decide how the mip chain is filtered, so gather them up front
+        image_usages.assign(image_count, ImageUsage{});
+        for (auto& gltf_material : model.materials)
         {
-            auto fut = thread_pool.push(
-                [this, image_index](size_t)
+            auto gather_usage = [this](const tinygltf::ParameterMap& values)
+            {
+                for (auto& gltf_value : values)
                 {
-                    auto image = parse_image(model.images[image_index]);
+                    if (gltf_value.first.find("Texture") == std::string::npos)
+                    {
+                        continue;
+                    }
 
-                    LOGI("Loaded gltf image #{} ({})", image_index, model.images[image_index].uri.c_str());
+                    auto texture_index = gltf_value.second.TextureIndex();
+                    if (texture_index < 0 || texture_index >= static_cast<int>(model.textures.size()))
+                    {
+                        continue;
+                    }
 
-                    return image;
-                });
+                    auto source = model.textures[texture_index].source;
+                    if (source < 0 || source >= static_cast<int>(image_usages.size()))
+                    {
+                        continue;
+                    }
 
-            image_component_futures.push_back(std::move(fut));
+                    image_usages[source].srgb |= texture_needs_srgb_colorspace(gltf_value.first);
+                    image_usages[source].normal_map |= gltf_value.first == "normalTexture";
+                }
+            };
+
+            gather_usage(gltf_material.values);
+            gather_usage(gltf_material.additionalValues);
         }
 
-        std::vector<std::unique_ptr<sg::Image>> image_components;
+        loading_scene_images = true;
+
+        // Image i is parsed into image_components[i] once image_counters[i] is done
+        std::vector<std::unique_ptr<sg::Image>> image_components(image_count);
+        std::vector<JobCounter> image_counters(image_count);
+        for (size_t image_index = 0; image_index < image_count; image_index++)
+        {
+            job_system.Run(
+                [this, image_index, &image_components]()
+                {
+                    image_components[image_index] = parse_image(model.images[image_index]);
+
+                    LOG_CHANNEL(import_log, DEBUG, "Loaded gltf image #{} ({})", image_index, model.images[image_index].uri);
+                },
+                &image_counters[image_index]);
+        }
+
+        // When the upload below throws, the image jobs still write into image_components
+        struct ImageJobsGuard
+        {
+            std::vector<JobCounter>& counters;
+
+            ~ImageJobsGuard()
+            {
+                for (auto& counter : counters)
+                {
+                    try
+                    {
+                        JobSystem::GetInstance().Wait(counter);
+                    }
+                    catch (...)
+                    {
+                    }
+                }
+            }
+        } image_jobs_guard{image_counters};
 
         // Upload images to GPU. We do this in batches of 64MB of data to avoid needing
         // double the amount of memory (all the images and all the corresponding buffers).
         // This helps keep memory footprint lower which is helpful on smaller devices.
-        size_t image_index = 0;
-        while (image_index < image_count)
+        // With an upload manager the batches only bound its staging ring, nothing waits until the meshes are uploaded.
+        auto& queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+        std::vector<vkb::Buffer> transient_buffers;
+        std::shared_ptr<CommandBuffer> command_buffer;
+
+        auto submit_and_wait = [&]()
         {
-            std::vector<vkb::Buffer> transient_buffers;
+            command_buffer->end();
 
-            auto command_buffer = device.request_command_buffer();
+            queue.submit(*command_buffer, device.request_fence());
 
-            command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+            device.get_fence_pool().wait();
+            device.get_fence_pool().reset();
+            device.get_command_pool().reset_pool();
+
+            // Remove the staging buffers of the work we just waited for
+            transient_buffers.clear();
+            command_buffer.reset();
+        };
+
+        size_t image_index = 0;
+        while (image_index < image_count)
+        {
+            if (!command_buffer)
+            {
+                command_buffer = device.request_command_buffer();
+                command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+            }
 
             size_t batch_size = 0;
 
@@ -615,10 +1218,29 @@ namespace vkb
             while (image_index < image_count && batch_size < 64 * 1024 * 1024)
             {
                 // Wait for this image to complete loading, then stage for upload
-                image_components.push_back(image_component_futures[image_index].get());
+                job_system.Wait(image_counters[image_index]);
 
                 auto& image = image_components[image_index];
 
+                if (texture_streamer && texture_streamer->register_image(*image, *command_buffer, transient_buffers))
+                {
+                    batch_size += transient_buffers.back().get_size();
+                    image_index++;
+                    continue;
+                }
+
+                if (upload_manager)
+                {
+                    batch_size += image->get_data().size();
+
+                    upload_manager->upload_image(image->get_vk_image(), image->get_data().data(), image->get_data().size(),
+                                                 get_image_copy_regions(*image), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                    image->clear_data();
+
+                    image_index++;
+                    continue;
+                }
+
                 Buffer stage_buffer = vkb::Buffer::create_staging_buffer(device, image->get_data());
 
                 batch_size += image->get_data().size();
@@ -630,26 +1252,30 @@ namespace vkb
                 image_index++;
             }
 
-            command_buffer->end();
-
-            auto& queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
-
-            queue.submit(*command_buffer, device.request_fence());
+            if (upload_manager)
+            {
+                // Submitted per batch so the staging ring is reused instead of growing overflow buffers. The streamed
+                // tails are small, they stay in the command buffer which is submitted once after the last batch.
+                upload_manager->flush();
+                continue;
+            }
 
-            device.get_fence_pool().wait();
-            device.get_fence_pool().reset();
-            device.get_command_pool().reset_pool();
-            device.wait_idle();
+            submit_and_wait();
+        }
 
-            // Remove the staging buffers for the batch we just processed
-            transient_buffers.clear();
+        if (command_buffer)
+        {
+            submit_and_wait();
         }
 
+        loading_scene_images = false;
+
         scene.set_components(std::move(image_components));
 
         auto elapsed_time = timer.stop();
 
-        LOGI("Time spent loading images: {} seconds across {} threads.", vkb::to_string(elapsed_time), thread_count);
+        LOGI("Time spent loading images: {} seconds across {} threads.", vkb::to_string(elapsed_time),
+             job_system.GetWorkerCount() + 1);
 
         // Load textures
         auto images = scene.get_components<sg::Image>();
@@ -700,6 +1326,20 @@ namespace vkb
             scene.add_component(std::move(default_sampler_nearest));
         }
 
+        // Give every image and sampler a slot in the bindless table, materials hand their indices to shaders
+        if (auto* bindless_table = device.get_resource_cache().get_bindless_table())
+        {
+            for (auto* image : scene.get_components<sg::Image>())
+            {
+                image->set_bindless_handle(bindless_table->register_texture(image->get_vk_image_view()));
+            }
+
+            for (auto* sampler : scene.get_components<sg::Sampler>())
+            {
+                sampler->bindless_handle = bindless_table->register_sampler(sampler->vk_sampler);
+            }
+        }
+
         // Load materials
         bool has_textures = scene.has_component<sg::Texture>();
         std::vector<vkb::sg::Texture*> textures;
@@ -756,9 +1396,39 @@ namespace vkb
         // Load meshes
         auto materials = scene.get_components<sg::PBRMaterial>();
 
+        mesh_arena.reset();
+        if (build_mesh_arena)
+        {
+            // Sized for every triangle list of the file, the arena cannot grow
+            size_t arena_vertices = 0;
+            size_t arena_indices = 0;
+            size_t arena_meshes = 0;
+            for (auto& gltf_mesh : model.meshes)
+            {
+                for (auto& gltf_primitive : gltf_mesh.primitives)
+                {
+                    auto position = gltf_primitive.attributes.find("POSITION");
+                    if (position == gltf_primitive.attributes.end() || gltf_primitive.mode != TINYGLTF_MODE_TRIANGLES)
+                    {
+                        continue;
+                    }
+
+                    size_t vertex_count = model.accessors[position->second].count;
+                    arena_vertices += vertex_count;
+                    arena_indices += gltf_primitive.indices >= 0 ? model.accessors[gltf_primitive.indices].count : vertex_count;
+                    arena_meshes++;
+                }
+            }
+
+            mesh_arena = std::make_unique<MeshArena>(device, to_u32(sizeof(DrawListSubpass::Vertex)),
+                                                     to_u32(std::max<size_t>(arena_vertices, 1)),
+                                                     to_u32(std::max<size_t>(arena_indices, 1)),
+                                                     to_u32(std::max<size_t>(arena_meshes, 1)));
+        }
+
         for (auto& gltf_mesh : model.meshes)
         {
-            //PROFILE_SCOPE("Processing Mesh");
+            PROFILE_SCOPE("Processing Mesh");
 
             auto mesh = parse_mesh(gltf_mesh);
 
@@ -769,36 +1439,50 @@ namespace vkb
                 auto submesh_name = fmt::format("'{}' mesh, primitive #{}", gltf_mesh.name, i_primitive);
                 auto submesh = std::make_unique<sg::SubMesh>(std::move(submesh_name));
 
-                for (auto& attribute : gltf_primitive.attributes)
+                if (vertex_layout.is_compact())
                 {
-                    std::string attrib_name = attribute.first;
-                    std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
+                    submesh->vertices_count = to_u32(model.accessors[gltf_primitive.attributes.at("POSITION")].count);
 
-                    auto vertex_data = get_attribute_data(&model, attribute.second);
+                    std::vector<uint8_t> vertex_data = pack_compact_vertices(model, gltf_primitive, vertex_layout, *submesh);
 
-                    if (attrib_name == "position")
+                    vkb::Buffer buffer = create_mesh_buffer(device, upload_manager, vertex_data,
+                                                            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | additional_buffer_usage_flags,
+                                                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+                    buffer.SetDebugName(fmt::format("'{}' mesh, primitive #{}: compact vertex buffer",
+                                                    gltf_mesh.name, i_primitive));
+
+                    submesh->vertex_buffers.insert(std::make_pair("vertex_buffer", std::move(buffer)));
+                }
+                else
+                {
+                    for (auto& attribute : gltf_primitive.attributes)
                     {
-                        assert(attribute.second < model.accessors.size());
-                        submesh->vertices_count = to_u32(model.accessors[attribute.second].count);
-                    }
+                        std::string attrib_name = attribute.first;
+                        std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
 
-                    vkb::Buffer buffer{
-                        device,
-                        vertex_data.size(),
-                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | additional_buffer_usage_flags,
-                        VMA_MEMORY_USAGE_CPU_TO_GPU
-                    };
-                    buffer.update(vertex_data);
-                    buffer.SetDebugName(fmt::format("'{}' mesh, primitive #{}: '{}' vertex buffer",
-                                                    gltf_mesh.name, i_primitive, attrib_name));
+                        auto vertex_data = get_attribute_data(&model, attribute.second);
+
+                        if (attrib_name == "position")
+                        {
+                            assert(attribute.second < model.accessors.size());
+                            submesh->vertices_count = to_u32(model.accessors[attribute.second].count);
+                        }
+
+                        vkb::Buffer buffer = create_mesh_buffer(device, upload_manager, vertex_data,
+                                                                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                                                                additional_buffer_usage_flags,
+                                                                VMA_MEMORY_USAGE_CPU_TO_GPU);
+                        buffer.SetDebugName(fmt::format("'{}' mesh, primitive #{}: '{}' vertex buffer",
+                                                        gltf_mesh.name, i_primitive, attrib_name));
 
-                    submesh->vertex_buffers.insert(std::make_pair(attrib_name, std::move(buffer)));
+                        submesh->vertex_buffers.insert(std::make_pair(attrib_name, std::move(buffer)));
 
-                    sg::VertexAttribute attrib;
-                    attrib.format = get_attribute_format(&model, attribute.second);
-                    attrib.stride = to_u32(get_attribute_stride(&model, attribute.second));
+                        sg::VertexAttribute attrib;
+                        attrib.format = get_attribute_format(&model, attribute.second);
+                        attrib.stride = to_u32(get_attribute_stride(&model, attribute.second));
 
-                    submesh->set_attribute(attrib_name, attrib);
+                        submesh->set_attribute(attrib_name, attrib);
+                    }
                 }
 
                 if (gltf_primitive.indices >= 0)
@@ -827,15 +1511,12 @@ namespace vkb
                         break;
                     }
 
-                    submesh->index_buffer = std::make_unique<vkb::Buffer>(device,
-                                                                          index_data.size(),
-                                                                          VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
-                                                                          additional_buffer_usage_flags,
-                                                                          VMA_MEMORY_USAGE_GPU_TO_CPU);
+                    submesh->index_buffer = std::make_unique<vkb::Buffer>(
+                        create_mesh_buffer(device, upload_manager, index_data,
+                                           VK_BUFFER_USAGE_INDEX_BUFFER_BIT | additional_buffer_usage_flags,
+                                           VMA_MEMORY_USAGE_GPU_TO_CPU));
                     submesh->index_buffer->SetDebugName(fmt::format("'{}' mesh, primitive #{}: index buffer",
                                                                     gltf_mesh.name, i_primitive));
-
-                    submesh->index_buffer->update(index_data);
                 }
                 else
                 {
@@ -853,6 +1534,27 @@ namespace vkb
                     submesh->set_material(*materials[gltf_primitive.material]);
                 }
 
+                // glTF requires min/max on positions, the bounds come for free
+                auto position = gltf_primitive.attributes.find("POSITION");
+                if (position != gltf_primitive.attributes.end())
+                {
+                    auto& accessor = model.accessors[position->second];
+                    if (accessor.minValues.size() == 3 && accessor.maxValues.size() == 3)
+                    {
+                        mesh->update_bounds({
+                            glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]),
+                            glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2])
+                        });
+                    }
+                }
+
+                submesh->texcoord_density = compute_texcoord_density(model, gltf_primitive);
+
+                if (mesh_arena)
+                {
+                    submesh->arena_mesh = add_to_mesh_arena(*mesh_arena, model, gltf_primitive);
+                }
+
                 mesh->add_submesh(*submesh);
 
                 scene.add_component(std::move(submesh));
@@ -861,9 +1563,11 @@ namespace vkb
             scene.add_component(std::move(mesh));
         }
 
-        device.get_fence_pool().wait();
-        device.get_fence_pool().reset();
-        device.get_command_pool().reset_pool();
+        // The only wait for the uploads of the scene
+        if (upload_manager)
+        {
+            upload_manager->finish();
+        }
 
         scene.add_component(std::move(default_material));
 
@@ -1131,7 +1835,7 @@ namespace vkb
     std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index, bool storage_buffer,
                                                         VkBufferUsageFlags additional_buffer_usage_flags)
     {
-        //PROFILE_SCOPE("Process Model");
+        PROFILE_SCOPE("Process Model");
 
         auto submesh = std::make_unique<sg::SubMesh>();
 
@@ -1139,9 +1843,13 @@ namespace vkb
 
         auto& queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
 
-        auto command_buffer = device.request_command_buffer();
-
-        command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        // The copies are recorded here only without an upload manager
+        std::shared_ptr<CommandBuffer> command_buffer;
+        if (!upload_manager)
+        {
+            command_buffer = device.request_command_buffer();
+            command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        }
 
         assert(index < model.meshes.size());
         auto& gltf_mesh = model.meshes[index];
@@ -1161,9 +1869,10 @@ namespace vkb
         uint32_t color_component_count{4};
 
         // Position attribute is required
-        auto& accessor = model.accessors[gltf_primitive.attributes.find("POSITION")->second];
+        // Copies on purpose, the accessor is reassigned for every attribute below
+        auto accessor = model.accessors[gltf_primitive.attributes.find("POSITION")->second];
         size_t vertex_count = accessor.count;
-        auto& buffer_view = model.bufferViews[accessor.bufferView];
+        auto buffer_view = model.bufferViews[accessor.bufferView];
         pos = reinterpret_cast<const float*>(&(model.buffers[buffer_view.buffer].data[accessor.byteOffset + buffer_view.
             byteOffset]));
 
@@ -1226,8 +1935,6 @@ namespace vkb
                 aligned_vertex_data.push_back(vert);
             }
 
-            vkb::Buffer stage_buffer = vkb::Buffer::create_staging_buffer(device, aligned_vertex_data);
-
             vkb::Buffer buffer{
                 device,
                 aligned_vertex_data.size() * sizeof(AlignedVertex),
@@ -1235,12 +1942,32 @@ namespace vkb
                 VMA_MEMORY_USAGE_GPU_ONLY
             };
 
-            command_buffer->copy_buffer(stage_buffer, buffer, aligned_vertex_data.size() * sizeof(AlignedVertex));
+            upload_to_buffer(device, upload_manager, aligned_vertex_data.data(),
+                             aligned_vertex_data.size() * sizeof(AlignedVertex), buffer, command_buffer.get(),
+                             transient_buffers);
 
             auto pair = std::make_pair("vertex_buffer", std::move(buffer));
             submesh->vertex_buffers.insert(std::move(pair));
+        }
+        else if (vertex_layout.is_compact())
+        {
+            std::vector<uint8_t> vertex_data = pack_compact_vertices(model, gltf_primitive, vertex_layout, *submesh);
 
-            transient_buffers.push_back(std::move(stage_buffer));
+            vkb::Buffer buffer{
+                device,
+                vertex_data.size(),
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | additional_buffer_usage_flags,
+                VMA_MEMORY_USAGE_GPU_ONLY
+            };
+
+            upload_to_buffer(device, upload_manager, vertex_data.data(), vertex_data.size(), buffer,
+                             command_buffer.get(), transient_buffers);
+
+            LOGD("Packed {} vertices into {} bytes ({} bytes with the full layout)", vertex_count,
+                 vertex_data.size(), vertex_count * sizeof(Vertex));
+
+            auto pair = std::make_pair("vertex_buffer", std::move(buffer));
+            submesh->vertex_buffers.insert(std::move(pair));
         }
         else
         {
@@ -1271,8 +1998,6 @@ namespace vkb
                 vertex_data.push_back(vert);
             }
 
-            vkb::Buffer stage_buffer = vkb::Buffer::create_staging_buffer(device, vertex_data);
-
             vkb::Buffer buffer{
                 device,
                 vertex_data.size() * sizeof(Vertex),
@@ -1280,12 +2005,11 @@ namespace vkb
                 VMA_MEMORY_USAGE_GPU_ONLY
             };
 
-            command_buffer->copy_buffer(stage_buffer, buffer, vertex_data.size() * sizeof(Vertex));
+            upload_to_buffer(device, upload_manager, vertex_data.data(), vertex_data.size() * sizeof(Vertex), buffer,
+                             command_buffer.get(), transient_buffers);
 
             auto pair = std::make_pair("vertex_buffer", std::move(buffer));
             submesh->vertex_buffers.insert(std::move(pair));
-
-            transient_buffers.push_back(std::move(stage_buffer));
         }
 
         if (gltf_primitive.indices >= 0)
@@ -1330,34 +2054,34 @@ namespace vkb
                 // vertex_indices and index_buffer are used for meshlets now
                 submesh->vertex_indices = static_cast<uint32_t>(meshlets.size());
 
-                vkb::Buffer stage_buffer = vkb::Buffer::create_staging_buffer(device, meshlets);
-
                 submesh->index_buffer = std::make_unique<vkb::Buffer>(device,
                                                                       meshlets.size() * sizeof(Meshlet),
                                                                       VK_BUFFER_USAGE_TRANSFER_DST_BIT |
                                                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                                                                       VMA_MEMORY_USAGE_GPU_ONLY);
 
-                command_buffer->copy_buffer(stage_buffer, *submesh->index_buffer, meshlets.size() * sizeof(Meshlet));
-
-                transient_buffers.push_back(std::move(stage_buffer));
+                upload_to_buffer(device, upload_manager, meshlets.data(), meshlets.size() * sizeof(Meshlet),
+                                 *submesh->index_buffer, command_buffer.get(), transient_buffers);
             }
             else
             {
-                vkb::Buffer stage_buffer = vkb::Buffer::create_staging_buffer(device, index_data);
-
                 submesh->index_buffer = std::make_unique<vkb::Buffer>(device,
                                                                       index_data.size(),
                                                                       VK_BUFFER_USAGE_TRANSFER_DST_BIT |
                                                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                                                                       VMA_MEMORY_USAGE_GPU_ONLY);
 
-                command_buffer->copy_buffer(stage_buffer, *submesh->index_buffer, index_data.size());
-
-                transient_buffers.push_back(std::move(stage_buffer));
+                upload_to_buffer(device, upload_manager, index_data.data(), index_data.size(), *submesh->index_buffer,
+                                 command_buffer.get(), transient_buffers);
             }
         }
 
+        if (upload_manager)
+        {
+            upload_manager->finish();
+            return std::move(submesh);
+        }
+
         command_buffer->end();
 
         queue.submit(*command_buffer, device.request_fence());
@@ -1369,6 +2093,41 @@ namespace vkb
         return std::move(submesh);
     }
 
+    void GLTFLoader::set_vertex_layout(const sg::VertexLayout& layout)
+    {
+        vertex_layout = layout;
+    }
+
+    const sg::VertexLayout& GLTFLoader::get_vertex_layout() const
+    {
+        return vertex_layout;
+    }
+
+    void GLTFLoader::set_mip_generation_options(const sg::MipGenerationOptions& options)
+    {
+        mip_generation_options = options;
+    }
+
+    void GLTFLoader::set_texture_streamer(TextureStreamer* streamer)
+    {
+        texture_streamer = streamer;
+    }
+
+    void GLTFLoader::set_upload_manager(UploadManager* manager)
+    {
+        upload_manager = manager;
+    }
+
+    void GLTFLoader::set_build_mesh_arena(bool build)
+    {
+        build_mesh_arena = build;
+    }
+
+    std::unique_ptr<MeshArena> GLTFLoader::take_mesh_arena()
+    {
+        return std::move(mesh_arena);
+    }
+
     std::unique_ptr<sg::Node> GLTFLoader::parse_node(const tinygltf::Node& gltf_node, size_t index) const
     {
         auto node = std::make_unique<sg::Node>(index, gltf_node.name);
@@ -1516,6 +2275,10 @@ namespace vkb
             gltf_image.name = gltf_image.uri;
         }
 
+        // Images parsed as part of a scene know their material usage
+        auto image_index = static_cast<size_t>(&gltf_image - model.images.data());
+        const ImageUsage* usage = image_index < image_usages.size() ? &image_usages[image_index] : nullptr;
+
         if (!gltf_image.image.empty())
         {
             // Image embedded in gltf file
@@ -1535,8 +2298,36 @@ namespace vkb
         {
             // Load image from uri
             auto image_uri = model_path + "/" + gltf_image.uri;
-            image = sg::Image::load(gltf_image.name, image_uri, vkb::sg::Image::Unknown);
+
+            // The content type steers the texture cooker towards BC7 sRGB for colors and BC5 for normals
+            auto content_type = vkb::sg::Image::Unknown;
+            if (usage)
+            {
+                content_type = usage->normal_map ? vkb::sg::Image::NormalMap
+                                   : usage->srgb ? vkb::sg::Image::Color
+                                                 : vkb::sg::Image::Other;
+            }
+
+            image = sg::Image::load(gltf_image.name, image_uri, content_type);
         }
+        // Apply the material usage before the Vulkan image is created
+        if (image && usage)
+        {
+            if (usage->srgb)
+            {
+                image->coerce_format_to_srgb();
+            }
+
+            if (image->get_mipmaps().size() == 1 && sg::MipGenerator::is_supported(image->get_format()))
+            {
+                sg::MipGenerationOptions options = mip_generation_options;
+                options.normal_map = usage->normal_map;
+                options.parallel = loading_scene_images;
+
+                image->generate_mipmaps(options);
+            }
+        }
+
         // TODO astc
         // Check whether the format is supported by the GPU
         /*if (sg::is_astc(image->get_format()))
@@ -1549,6 +2340,12 @@ namespace vkb
             }
         }*/
 
+        // Streamed scene images get their Vulkan image from the streamer when they are uploaded
+        if (texture_streamer && loading_scene_images && TextureStreamer::is_streamable(*image))
+        {
+            return image;
+        }
+
         image->create_vk_image(device);
 
         return image;
@@ -18,13 +18,12 @@
 #include "SceneGraph/Components/Image.h"
 #include <mutex>
 
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
-#include "stb_image_resize.h"
 #include "stb_image.h"
-#include "Misc/FileLoader.hpp"
+#include "Misc/VirtualFileSystem.hpp"
 
 #include "SceneGraph/Components/Image/Ktx.h"
 #include "SceneGraph/Components/Image/Stb.h"
+#include "SceneGraph/Components/Image/TextureCooker.h"
 #include "Logging/Logger.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
 
@@ -225,31 +224,43 @@ namespace vkb
             return *vk_image_view;
         }
 
-        Mipmap &Image::get_mipmap(const size_t index)
+        std::pair<std::unique_ptr<vkb::Image>, std::unique_ptr<vkb::ImageView>> Image::replace_vk_image(
+            std::unique_ptr<vkb::Image> &&image, std::unique_ptr<vkb::ImageView> &&image_view)
         {
-            assert(index < mipmaps.size());
-            return mipmaps[index];
+            std::pair<std::unique_ptr<vkb::Image>, std::unique_ptr<vkb::ImageView>> previous{std::move(vk_image),
+                                                                                            std::move(vk_image_view)};
+            vk_image = std::move(image);
+            vk_image_view = std::move(image_view);
+            return previous;
         }
 
-        // Note that this function returns the required size for ALL mip levels, *including* the base level.
-        uint32_t get_required_mipmaps_size(const VkExtent3D &extent)
+        const std::string &Image::get_source_path() const
         {
-            constexpr uint32_t channels = 4;
-            auto width = std::max<uint32_t>(1, extent.width);
-            auto height = std::max<uint32_t>(1, extent.height);
-            auto size = width * height * channels;
-            auto result = size;
-            while (size != channels)
-            {
-                width = std::max<uint32_t>(1u, width >> 1);
-                height = std::max<uint32_t>(1u, height >> 1);
-                size = width * height * channels;
-                result += size;
-            }
-            return result;
+            return source_path;
+        }
+
+        void Image::set_source_path(const std::string &path)
+        {
+            source_path = path;
+        }
+
+        BindlessHandle Image::get_bindless_handle() const
+        {
+            return bindless_handle;
         }
 
-        void Image::generate_mipmaps()
+        void Image::set_bindless_handle(BindlessHandle handle)
+        {
+            bindless_handle = handle;
+        }
+
+        Mipmap &Image::get_mipmap(const size_t index)
+        {
+            assert(index < mipmaps.size());
+            return mipmaps[index];
+        }
+
+        void Image::generate_mipmaps(const MipGenerationOptions &options)
         {
             assert(mipmaps.size() == 1 && "Mipmaps already generated");
 
@@ -258,47 +269,10 @@ namespace vkb
                 return; // Do not generate again
             }
 
-            auto extent = get_extent();
-            auto next_width = std::max<uint32_t>(1u, extent.width / 2);
-            auto next_height = std::max<uint32_t>(1u, extent.height / 2);
-            auto channels = 4;
-            auto next_size = next_width * next_height * channels;
-
-            // Allocate for all the mips at once.  The function returns the total size needed for the
-            // existing base mip as well as all the mips that will be generated.
-            data.reserve(get_required_mipmaps_size(extent));
+            // Copied, the generator rewrites the mipmap list
+            const VkExtent3D extent = get_extent();
 
-            while (true)
-            {
-                // Make space for next mipmap
-                auto old_size = to_u32(data.size());
-                data.resize(old_size + next_size);
-
-                auto &prev_mipmap = mipmaps.back();
-                // Update mipmaps
-                Mipmap next_mipmap{};
-                next_mipmap.level = prev_mipmap.level + 1;
-                next_mipmap.offset = old_size;
-                next_mipmap.extent = {next_width, next_height, 1u};
-
-                // Fill next mipmap memory
-                stbir_resize_uint8(data.data() + prev_mipmap.offset, prev_mipmap.extent.width,
-                                   prev_mipmap.extent.height, 0,
-                                   data.data() + next_mipmap.offset, next_mipmap.extent.width,
-                                   next_mipmap.extent.height, 0, channels);
-
-                mipmaps.emplace_back(std::move(next_mipmap));
-
-                // Next mipmap values
-                next_width = std::max<uint32_t>(1u, next_width / 2);
-                next_height = std::max<uint32_t>(1u, next_height / 2);
-                next_size = next_width * next_height * channels;
-
-                if (next_width == 1 && next_height == 1)
-                {
-                    break;
-                }
-            }
+            MipGenerator::generate(data, format, extent, mipmaps, options);
         }
 
         std::vector<Mipmap> &Image::get_mut_mipmaps()
@@ -360,8 +334,8 @@ namespace vkb
         {
             std::unique_ptr<Image> image{nullptr};
 
-            // auto data = fs::read_asset(uri);
-            auto data = FileLoader::ReadFileBinary(uri);
+            // The decoders read the mapped file or archive entry directly, the encoded bytes are never copied
+            auto file = VirtualFileSystem::GetInstance().Read(uri);
 
             auto fun = [](const std::string &uri) -> std::string
             {
@@ -381,15 +355,21 @@ namespace vkb
 
             if (extension == "png" || extension == "jpg")
             {
-                image = std::make_unique<Stb>(name, data, content_type);
+                // Prefer the block compressed KTX2 produced by the texture cooker
+                image = TextureCooker::load(name, file.Data(), file.Size(), content_type);
+                if (!image)
+                {
+                    image = std::make_unique<Stb>(name, file.Data(), file.Size(), content_type);
+                }
             }
             else if (extension == "ktx")
             {
-                image = std::make_unique<Ktx>(name, data, content_type);
+                image = std::make_unique<Ktx>(name, file.Data(), file.Size(), content_type);
             }
             else if (extension == "ktx2")
             {
-                image = std::make_unique<Ktx>(name, data, content_type);
+                image = std::make_unique<Ktx>(name, file.Data(), file.Size(), content_type);
+                image->set_source_path(uri);
             }
 
             return image;
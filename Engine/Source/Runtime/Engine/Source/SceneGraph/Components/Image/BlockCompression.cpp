@@ -0,0 +1,442 @@
+#include "SceneGraph/Components/Image/BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace vkb
+{
+    namespace sg
+    {
+        namespace
+        {
+            /// BC7 4-bit index interpolation weights, out of 64
+            constexpr int bc7_weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+            class BitWriter
+            {
+            public:
+                explicit BitWriter(uint8_t *output) :
+                    output{output}
+                {
+                    std::memset(output, 0, 16);
+                }
+
+                void write(uint32_t value, uint32_t bits)
+                {
+                    for (uint32_t i = 0; i < bits; i++, position++)
+                    {
+                        output[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1u) << (position & 7));
+                    }
+                }
+
+            private:
+                uint8_t *output;
+
+                uint32_t position{0};
+            };
+
+            uint32_t block_size(VkFormat format)
+            {
+                switch (format)
+                {
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                    return BlockCompression::bc4_block_size;
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                    return BlockCompression::bc5_block_size;
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK:
+                    return BlockCompression::bc7_block_size;
+                default:
+                    return 0;
+                }
+            }
+
+            /// Single channel BC4 encode, reading every stride-th byte of the 16 texels
+            void encode_bc4_channel(const uint8_t *values, uint32_t stride, uint8_t *output)
+            {
+                int min_value = 255;
+                int max_value = 0;
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    min_value = std::min<int>(min_value, values[i * stride]);
+                    max_value = std::max<int>(max_value, values[i * stride]);
+                }
+
+                output[0] = static_cast<uint8_t>(max_value);
+                output[1] = static_cast<uint8_t>(min_value);
+
+                uint64_t indices = 0;
+                if (max_value > min_value)
+                {
+                    // red_0 > red_1 selects the 8 value palette: red_0, red_1, then 6 steps from red_0 to red_1
+                    int palette[8];
+                    palette[0] = max_value;
+                    palette[1] = min_value;
+                    for (int i = 1; i < 7; i++)
+                    {
+                        palette[i + 1] = ((7 - i) * max_value + i * min_value) / 7;
+                    }
+
+                    for (uint32_t i = 0; i < 16; i++)
+                    {
+                        int value = values[i * stride];
+                        uint64_t best = 0;
+                        int best_error = 256;
+                        for (int j = 0; j < 8; j++)
+                        {
+                            int error = std::abs(palette[j] - value);
+                            if (error < best_error)
+                            {
+                                best_error = error;
+                                best = static_cast<uint64_t>(j);
+                            }
+                        }
+                        indices |= best << (3 * i);
+                    }
+                }
+
+                for (int i = 0; i < 6; i++)
+                {
+                    output[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+                }
+            }
+
+            struct Bc7Endpoints
+            {
+                int color[2][4];
+                int p_bit[2];
+            };
+
+            /// Rounds one endpoint to 7 bits per channel plus a shared p-bit, keeping the better p-bit
+            void quantize_bc7_endpoint(const float color[4], int quantized[4], int &p_bit)
+            {
+                float best_error = 1e30f;
+                for (int p = 0; p < 2; p++)
+                {
+                    int candidate[4];
+                    float error = 0.0f;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        int q = static_cast<int>(std::lround((color[c] - static_cast<float>(p)) * 0.5f));
+                        candidate[c] = std::clamp(q, 0, 127);
+                        float difference = static_cast<float>(candidate[c] * 2 + p) - color[c];
+                        error += difference * difference;
+                    }
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        p_bit = p;
+                        std::copy(candidate, candidate + 4, quantized);
+                    }
+                }
+            }
+
+            Bc7Endpoints quantize_bc7_endpoints(const float e0[4], const float e1[4])
+            {
+                Bc7Endpoints endpoints;
+                quantize_bc7_endpoint(e0, endpoints.color[0], endpoints.p_bit[0]);
+                quantize_bc7_endpoint(e1, endpoints.color[1], endpoints.p_bit[1]);
+                return endpoints;
+            }
+
+            /// Picks the closest palette entry for every texel, returns the summed squared error
+            int select_bc7_indices(const uint8_t *texels, const Bc7Endpoints &endpoints, uint8_t indices[16])
+            {
+                int palette[16][4];
+                for (int c = 0; c < 4; c++)
+                {
+                    int a = endpoints.color[0][c] * 2 + endpoints.p_bit[0];
+                    int b = endpoints.color[1][c] * 2 + endpoints.p_bit[1];
+                    for (int i = 0; i < 16; i++)
+                    {
+                        palette[i][c] = ((64 - bc7_weights[i]) * a + bc7_weights[i] * b + 32) >> 6;
+                    }
+                }
+
+                int total_error = 0;
+                for (int t = 0; t < 16; t++)
+                {
+                    const uint8_t *texel = texels + t * 4;
+                    int best_error = 0x7fffffff;
+                    for (int i = 0; i < 16; i++)
+                    {
+                        int error = 0;
+                        for (int c = 0; c < 4; c++)
+                        {
+                            int difference = palette[i][c] - texel[c];
+                            error += difference * difference;
+                        }
+                        if (error < best_error)
+                        {
+                            best_error = error;
+                            indices[t] = static_cast<uint8_t>(i);
+                        }
+                    }
+                    total_error += best_error;
+                }
+
+                return total_error;
+            }
+
+            /// Least squares endpoints for fixed indices, false when the indices do not span a line
+            bool refine_bc7_endpoints(const uint8_t *texels, const uint8_t indices[16], float e0[4], float e1[4])
+            {
+                float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+                float ax[4] = {};
+                float bx[4] = {};
+                for (int t = 0; t < 16; t++)
+                {
+                    float b = bc7_weights[indices[t]] / 64.0f;
+                    float a = 1.0f - b;
+                    aa += a * a;
+                    ab += a * b;
+                    bb += b * b;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        ax[c] += a * texels[t * 4 + c];
+                        bx[c] += b * texels[t * 4 + c];
+                    }
+                }
+
+                float determinant = aa * bb - ab * ab;
+                if (std::abs(determinant) < 1e-6f)
+                {
+                    return false;
+                }
+
+                float inverse = 1.0f / determinant;
+                for (int c = 0; c < 4; c++)
+                {
+                    e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.0f, 255.0f);
+                    e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.0f, 255.0f);
+                }
+
+                return true;
+            }
+
+            void write_bc7_mode6(Bc7Endpoints endpoints, uint8_t indices[16], uint8_t *output)
+            {
+                // The anchor texel stores only 3 index bits, its top bit must be zero
+                if (indices[0] & 8)
+                {
+                    std::swap(endpoints.color[0], endpoints.color[1]);
+                    std::swap(endpoints.p_bit[0], endpoints.p_bit[1]);
+                    for (int t = 0; t < 16; t++)
+                    {
+                        indices[t] = static_cast<uint8_t>(15 - indices[t]);
+                    }
+                }
+
+                BitWriter writer{output};
+                writer.write(1u << 6, 7);
+                for (int c = 0; c < 4; c++)
+                {
+                    writer.write(static_cast<uint32_t>(endpoints.color[0][c]), 7);
+                    writer.write(static_cast<uint32_t>(endpoints.color[1][c]), 7);
+                }
+                writer.write(static_cast<uint32_t>(endpoints.p_bit[0]), 1);
+                writer.write(static_cast<uint32_t>(endpoints.p_bit[1]), 1);
+                writer.write(indices[0], 3);
+                for (int t = 1; t < 16; t++)
+                {
+                    writer.write(indices[t], 4);
+                }
+            }
+        } // namespace
+
+        bool BlockCompression::is_supported(VkFormat format)
+        {
+            return block_size(format) != 0;
+        }
+
+        size_t BlockCompression::get_compressed_size(VkFormat format, const VkExtent3D &extent)
+        {
+            size_t blocks_x = (extent.width + 3) / 4;
+            size_t blocks_y = (extent.height + 3) / 4;
+            return blocks_x * blocks_y * std::max(1u, extent.depth) * block_size(format);
+        }
+
+        void BlockCompression::compress(const uint8_t *rgba, const VkExtent3D &extent, VkFormat format, uint8_t *output)
+        {
+            uint32_t size = block_size(format);
+            if (size == 0)
+            {
+                throw std::runtime_error{"Block compression does not support format " + std::to_string(format)};
+            }
+
+            uint8_t texels[64];
+            for (uint32_t block_y = 0; block_y < extent.height; block_y += 4)
+            {
+                for (uint32_t block_x = 0; block_x < extent.width; block_x += 4)
+                {
+                    for (uint32_t y = 0; y < 4; y++)
+                    {
+                        uint32_t source_y = std::min(block_y + y, extent.height - 1);
+                        for (uint32_t x = 0; x < 4; x++)
+                        {
+                            uint32_t source_x = std::min(block_x + x, extent.width - 1);
+                            std::memcpy(texels + (y * 4 + x) * 4,
+                                        rgba + (static_cast<size_t>(source_y) * extent.width + source_x) * 4, 4);
+                        }
+                    }
+
+                    switch (format)
+                    {
+                    case VK_FORMAT_BC4_UNORM_BLOCK:
+                        encode_bc4_channel(texels, 4, output);
+                        break;
+                    case VK_FORMAT_BC5_UNORM_BLOCK:
+                        encode_bc5_block(texels, output);
+                        break;
+                    default:
+                        encode_bc7_block(texels, output);
+                        break;
+                    }
+                    output += size;
+                }
+            }
+        }
+
+        void BlockCompression::encode_bc4_block(const uint8_t values[16], uint8_t output[bc4_block_size])
+        {
+            encode_bc4_channel(values, 1, output);
+        }
+
+        void BlockCompression::encode_bc5_block(const uint8_t texels[64], uint8_t output[bc5_block_size])
+        {
+            encode_bc4_channel(texels, 4, output);
+            encode_bc4_channel(texels + 1, 4, output + bc4_block_size);
+        }
+
+        void BlockCompression::encode_bc7_block(const uint8_t texels[64], uint8_t output[bc7_block_size])
+        {
+            float mean[4] = {};
+            float min_color[4] = {255.0f, 255.0f, 255.0f, 255.0f};
+            float max_color[4] = {};
+            for (int t = 0; t < 16; t++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    float value = texels[t * 4 + c];
+                    mean[c] += value;
+                    min_color[c] = std::min(min_color[c], value);
+                    max_color[c] = std::max(max_color[c], value);
+                }
+            }
+            for (auto &value : mean)
+            {
+                value /= 16.0f;
+            }
+
+            // Principal axis of the texels by power iteration on the covariance, seeded with the bounding box diagonal
+            float covariance[4][4] = {};
+            for (int t = 0; t < 16; t++)
+            {
+                float d[4];
+                for (int c = 0; c < 4; c++)
+                {
+                    d[c] = texels[t * 4 + c] - mean[c];
+                }
+                for (int i = 0; i < 4; i++)
+                {
+                    for (int j = 0; j < 4; j++)
+                    {
+                        covariance[i][j] += d[i] * d[j];
+                    }
+                }
+            }
+
+            float axis[4];
+            for (int c = 0; c < 4; c++)
+            {
+                axis[c] = max_color[c] - min_color[c];
+            }
+            for (int iteration = 0; iteration < 8; iteration++)
+            {
+                float next[4] = {};
+                float length = 0.0f;
+                for (int i = 0; i < 4; i++)
+                {
+                    for (int j = 0; j < 4; j++)
+                    {
+                        next[i] += covariance[i][j] * axis[j];
+                    }
+                    length = std::max(length, std::abs(next[i]));
+                }
+                if (length < 1e-6f)
+                {
+                    break;
+                }
+                for (int i = 0; i < 4; i++)
+                {
+                    axis[i] = next[i] / length;
+                }
+            }
+
+            float axis_length = 0.0f;
+            for (auto value : axis)
+            {
+                axis_length += value * value;
+            }
+
+            float e0[4];
+            float e1[4];
+            if (axis_length < 1e-6f)
+            {
+                // Solid block
+                std::copy(mean, mean + 4, e0);
+                std::copy(mean, mean + 4, e1);
+            }
+            else
+            {
+                float min_t = 1e30f;
+                float max_t = -1e30f;
+                for (int t = 0; t < 16; t++)
+                {
+                    float projection = 0.0f;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        projection += (texels[t * 4 + c] - mean[c]) * axis[c];
+                    }
+                    min_t = std::min(min_t, projection);
+                    max_t = std::max(max_t, projection);
+                }
+                for (int c = 0; c < 4; c++)
+                {
+                    e0[c] = std::clamp(mean[c] + axis[c] * min_t / axis_length, 0.0f, 255.0f);
+                    e1[c] = std::clamp(mean[c] + axis[c] * max_t / axis_length, 0.0f, 255.0f);
+                }
+            }
+
+            Bc7Endpoints best_endpoints = quantize_bc7_endpoints(e0, e1);
+            uint8_t best_indices[16];
+            int best_error = select_bc7_indices(texels, best_endpoints, best_indices);
+
+            // Two rounds of least squares refinement on the selected indices
+            for (int iteration = 0; iteration < 2 && best_error > 0; iteration++)
+            {
+                if (!refine_bc7_endpoints(texels, best_indices, e0, e1))
+                {
+                    break;
+                }
+
+                Bc7Endpoints endpoints = quantize_bc7_endpoints(e0, e1);
+                uint8_t indices[16];
+                int error = select_bc7_indices(texels, endpoints, indices);
+                if (error >= best_error)
+                {
+                    break;
+                }
+
+                best_error = error;
+                best_endpoints = endpoints;
+                std::copy(indices, indices + 16, best_indices);
+            }
+
+            write_bc7_mode6(best_endpoints, best_indices, output);
+        }
+    } // namespace sg
+} // namespace vkb
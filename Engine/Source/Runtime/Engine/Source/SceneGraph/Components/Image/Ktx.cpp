@@ -70,10 +70,15 @@ namespace vkb
         }
 
         Ktx::Ktx(const std::string& name, const std::vector<uint8_t>& data, ContentType content_type) :
+            Ktx{name, data.data(), data.size(), content_type}
+        {
+        }
+
+        Ktx::Ktx(const std::string& name, const uint8_t* data, size_t size, ContentType content_type) :
             Image{name}
         {
-            auto data_buffer = reinterpret_cast<const ktx_uint8_t*>(data.data());
-            auto data_size = static_cast<ktx_size_t>(data.size());
+            auto data_buffer = reinterpret_cast<const ktx_uint8_t*>(data);
+            auto data_size = static_cast<ktx_size_t>(size);
 
             ktxTexture* texture;
             auto load_ktx_result = ktxTexture_CreateFromMemory(data_buffer,
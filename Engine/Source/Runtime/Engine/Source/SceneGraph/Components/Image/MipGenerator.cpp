@@ -0,0 +1,630 @@
+#include "SceneGraph/Components/Image/MipGenerator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <glm/gtc/packing.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE 1
+#endif
+
+#include "SceneGraph/Components/Image.h"
+#include "SubSystems/JobSystem.hpp"
+
+namespace vkb
+{
+    namespace sg
+    {
+        namespace
+        {
+            enum class ComponentType
+            {
+                UInt8,
+                UInt16,
+                Float16,
+                Float32
+            };
+
+            struct PixelLayout
+            {
+                uint32_t channels = 0;
+
+                ComponentType type = ComponentType::UInt8;
+
+                /// Whether the color channels (never alpha) are sRGB encoded
+                bool srgb = false;
+
+                uint32_t pixel_size() const
+                {
+                    switch (type)
+                    {
+                    case ComponentType::UInt8:
+                        return channels;
+                    case ComponentType::UInt16:
+                    case ComponentType::Float16:
+                        return channels * 2;
+                    case ComponentType::Float32:
+                    default:
+                        return channels * 4;
+                    }
+                }
+            };
+
+            bool get_pixel_layout(VkFormat format, PixelLayout &layout)
+            {
+                switch (format)
+                {
+                case VK_FORMAT_R8_UNORM:
+                    layout = {1, ComponentType::UInt8, false};
+                    return true;
+                case VK_FORMAT_R8_SRGB:
+                    layout = {1, ComponentType::UInt8, true};
+                    return true;
+                case VK_FORMAT_R8G8_UNORM:
+                    layout = {2, ComponentType::UInt8, false};
+                    return true;
+                case VK_FORMAT_R8G8_SRGB:
+                    layout = {2, ComponentType::UInt8, true};
+                    return true;
+                case VK_FORMAT_R8G8B8A8_UNORM:
+                case VK_FORMAT_B8G8R8A8_UNORM:
+                    layout = {4, ComponentType::UInt8, false};
+                    return true;
+                case VK_FORMAT_R8G8B8A8_SRGB:
+                case VK_FORMAT_B8G8R8A8_SRGB:
+                    layout = {4, ComponentType::UInt8, true};
+                    return true;
+                case VK_FORMAT_R16_UNORM:
+                    layout = {1, ComponentType::UInt16, false};
+                    return true;
+                case VK_FORMAT_R16G16_UNORM:
+                    layout = {2, ComponentType::UInt16, false};
+                    return true;
+                case VK_FORMAT_R16G16B16A16_UNORM:
+                    layout = {4, ComponentType::UInt16, false};
+                    return true;
+                case VK_FORMAT_R16_SFLOAT:
+                    layout = {1, ComponentType::Float16, false};
+                    return true;
+                case VK_FORMAT_R16G16_SFLOAT:
+                    layout = {2, ComponentType::Float16, false};
+                    return true;
+                case VK_FORMAT_R16G16B16A16_SFLOAT:
+                    layout = {4, ComponentType::Float16, false};
+                    return true;
+                case VK_FORMAT_R32_SFLOAT:
+                    layout = {1, ComponentType::Float32, false};
+                    return true;
+                case VK_FORMAT_R32G32_SFLOAT:
+                    layout = {2, ComponentType::Float32, false};
+                    return true;
+                case VK_FORMAT_R32G32B32A32_SFLOAT:
+                    layout = {4, ComponentType::Float32, false};
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            inline float srgb_to_linear(float c)
+            {
+                return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+
+            /**
+             * @brief Exact 8-bit sRGB conversion tables
+             *        Encoding looks up the code at the start of a bucket indexed by the top bits of the float,
+             *        buckets are narrower than the distance between two codes so one compare finishes the job.
+             */
+            struct SrgbTables
+            {
+                static constexpr uint32_t mantissa_bits = 11;
+
+                /// Values below 2^-13 always encode to 0
+                static constexpr uint32_t min_exponent = 127 - 13;
+
+                static constexpr uint32_t bucket_count = 13u << mantissa_bits;
+
+                float to_linear[256];
+
+                /// Linear midpoints between two consecutive codes
+                float thresholds[256];
+
+                uint8_t buckets[bucket_count];
+
+                SrgbTables()
+                {
+                    for (uint32_t i = 0; i < 256; i++)
+                    {
+                        to_linear[i] = srgb_to_linear(i / 255.0f);
+                    }
+                    for (uint32_t i = 0; i < 255; i++)
+                    {
+                        thresholds[i] = 0.5f * (to_linear[i] + to_linear[i + 1]);
+                    }
+                    thresholds[255] = 2.0f;
+
+                    for (uint32_t bucket = 0; bucket < bucket_count; bucket++)
+                    {
+                        uint32_t bits = (min_exponent << 23) + (bucket << (23 - mantissa_bits));
+                        float value;
+                        std::memcpy(&value, &bits, sizeof(value));
+                        buckets[bucket] = static_cast<uint8_t>(
+                            std::upper_bound(thresholds, thresholds + 255, value) - thresholds);
+                    }
+                }
+
+                uint8_t encode(float linear) const
+                {
+                    if (!(linear >= 1.0f / 8192.0f))
+                    {
+                        return 0;
+                    }
+                    if (linear >= 1.0f)
+                    {
+                        return 255;
+                    }
+
+                    uint32_t bits;
+                    std::memcpy(&bits, &linear, sizeof(bits));
+
+                    uint8_t code = buckets[(bits - (min_exponent << 23)) >> (23 - mantissa_bits)];
+                    return linear >= thresholds[code] ? code + 1 : code;
+                }
+            };
+
+            const SrgbTables &get_srgb_tables()
+            {
+                static const SrgbTables tables;
+                return tables;
+            }
+
+            /**
+             * @brief Separable kernel, tap t of destination texel x reads source texel 2 * x + first_offset + t
+             */
+            struct Kernel
+            {
+                int first_offset = 0;
+
+                std::vector<float> weights;
+            };
+
+            double bessel_i0(double x)
+            {
+                double sum = 1.0;
+                double term = 1.0;
+                for (int k = 1; k < 32; k++)
+                {
+                    double f = x / (2.0 * k);
+                    term *= f * f;
+                    sum += term;
+                }
+                return sum;
+            }
+
+            Kernel make_kernel(MipFilter filter)
+            {
+                Kernel kernel;
+
+                if (filter == MipFilter::Box)
+                {
+                    kernel.first_offset = 0;
+                    kernel.weights = {0.5f, 0.5f};
+                    return kernel;
+                }
+
+                // Kaiser windowed sinc with a radius of two destination texels
+                constexpr double pi = 3.14159265358979323846;
+                constexpr double radius = 2.0;
+                constexpr double alpha = 4.0;
+
+                kernel.first_offset = -3;
+
+                double sum = 0.0;
+                std::vector<double> weights;
+                for (int offset = -3; offset <= 4; offset++)
+                {
+                    // Distance to the destination texel center, in destination texels
+                    double t = (offset - 0.5) / 2.0;
+                    double sinc = std::sin(pi * t) / (pi * t);
+                    double r = t / radius;
+                    double window = bessel_i0(alpha * std::sqrt(std::max(0.0, 1.0 - r * r))) / bessel_i0(alpha);
+
+                    weights.push_back(sinc * window);
+                    sum += weights.back();
+                }
+
+                for (auto weight : weights)
+                {
+                    kernel.weights.push_back(static_cast<float>(weight / sum));
+                }
+
+                return kernel;
+            }
+
+            void decode_row(const uint8_t *src, uint32_t width, const PixelLayout &layout, float *dst)
+            {
+                const uint32_t channels = layout.channels;
+                const size_t count = static_cast<size_t>(width) * channels;
+
+                switch (layout.type)
+                {
+                case ComponentType::UInt8:
+                    if (layout.srgb)
+                    {
+                        const auto &tables = get_srgb_tables();
+                        for (size_t i = 0; i < count; i += channels)
+                        {
+                            for (uint32_t c = 0; c < channels; c++)
+                            {
+                                dst[i + c] = c < 3 ? tables.to_linear[src[i + c]] : src[i + c] * (1.0f / 255.0f);
+                            }
+                        }
+                    }
+                    else
+                    {
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            dst[i] = src[i] * (1.0f / 255.0f);
+                        }
+                    }
+                    break;
+                case ComponentType::UInt16:
+                    {
+                        auto src16 = reinterpret_cast<const uint16_t *>(src);
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            dst[i] = src16[i] * (1.0f / 65535.0f);
+                        }
+                        break;
+                    }
+                case ComponentType::Float16:
+                    {
+                        auto src16 = reinterpret_cast<const uint16_t *>(src);
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            dst[i] = glm::unpackHalf1x16(src16[i]);
+                        }
+                        break;
+                    }
+                case ComponentType::Float32:
+                    std::copy_n(reinterpret_cast<const float *>(src), count, dst);
+                    break;
+                }
+            }
+
+            void encode_row(const float *src, uint32_t width, const PixelLayout &layout, uint8_t *dst)
+            {
+                const uint32_t channels = layout.channels;
+                const size_t count = static_cast<size_t>(width) * channels;
+
+                switch (layout.type)
+                {
+                case ComponentType::UInt8:
+                    if (layout.srgb)
+                    {
+                        const auto &tables = get_srgb_tables();
+                        for (size_t i = 0; i < count; i += channels)
+                        {
+                            for (uint32_t c = 0; c < channels; c++)
+                            {
+                                float v = std::clamp(src[i + c], 0.0f, 1.0f);
+                                dst[i + c] = c < 3 ? tables.encode(v) : static_cast<uint8_t>(v * 255.0f + 0.5f);
+                            }
+                        }
+                    }
+                    else
+                    {
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            dst[i] = static_cast<uint8_t>(std::clamp(src[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+                        }
+                    }
+                    break;
+                case ComponentType::UInt16:
+                    {
+                        auto dst16 = reinterpret_cast<uint16_t *>(dst);
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            dst16[i] = static_cast<uint16_t>(std::clamp(src[i], 0.0f, 1.0f) * 65535.0f + 0.5f);
+                        }
+                        break;
+                    }
+                case ComponentType::Float16:
+                    {
+                        auto dst16 = reinterpret_cast<uint16_t *>(dst);
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            dst16[i] = glm::packHalf1x16(src[i]);
+                        }
+                        break;
+                    }
+                case ComponentType::Float32:
+                    std::copy_n(src, count, reinterpret_cast<float *>(dst));
+                    break;
+                }
+            }
+
+            /**
+             * @brief Renormalizes the xyz channels, unsigned normalized formats store n * 0.5 + 0.5
+             */
+            void renormalize_row(float *row, uint32_t width, const PixelLayout &layout)
+            {
+                if (layout.channels < 3)
+                {
+                    return;
+                }
+
+                const bool biased = layout.type == ComponentType::UInt8 || layout.type == ComponentType::UInt16;
+
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    float *texel = row + static_cast<size_t>(x) * layout.channels;
+
+                    float n[3];
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        n[c] = biased ? texel[c] * 2.0f - 1.0f : texel[c];
+                    }
+
+                    float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                    if (length <= 0.0f)
+                    {
+                        n[0] = 0.0f;
+                        n[1] = 0.0f;
+                        n[2] = 1.0f;
+                        length = 1.0f;
+                    }
+
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        texel[c] = biased ? n[c] / length * 0.5f + 0.5f : n[c] / length;
+                    }
+                }
+            }
+
+            void filter_horizontal(const float *src, uint32_t src_width, float *dst, uint32_t dst_width,
+                                   uint32_t channels, const Kernel &kernel)
+            {
+                const int taps = static_cast<int>(kernel.weights.size());
+                const int last = static_cast<int>(src_width) - 1;
+
+                for (uint32_t x = 0; x < dst_width; x++)
+                {
+                    const int base = static_cast<int>(2 * x) + kernel.first_offset;
+
+#ifdef MIP_GENERATOR_SSE
+                    if (channels == 4)
+                    {
+                        __m128 acc = _mm_setzero_ps();
+                        for (int t = 0; t < taps; t++)
+                        {
+                            const int sx = std::clamp(base + t, 0, last);
+                            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(kernel.weights[t]), _mm_loadu_ps(src + sx * 4)));
+                        }
+                        _mm_storeu_ps(dst + static_cast<size_t>(x) * 4, acc);
+                        continue;
+                    }
+#endif
+
+                    for (uint32_t c = 0; c < channels; c++)
+                    {
+                        float acc = 0.0f;
+                        for (int t = 0; t < taps; t++)
+                        {
+                            const int sx = std::clamp(base + t, 0, last);
+                            acc += kernel.weights[t] * src[static_cast<size_t>(sx) * channels + c];
+                        }
+                        dst[static_cast<size_t>(x) * channels + c] = acc;
+                    }
+                }
+            }
+
+            void filter_vertical(const float *const *rows, const Kernel &kernel, size_t count, float *dst)
+            {
+                const size_t taps = kernel.weights.size();
+
+                size_t i = 0;
+#ifdef MIP_GENERATOR_SSE
+                for (; i + 4 <= count; i += 4)
+                {
+                    __m128 acc = _mm_setzero_ps();
+                    for (size_t t = 0; t < taps; t++)
+                    {
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(kernel.weights[t]), _mm_loadu_ps(rows[t] + i)));
+                    }
+                    _mm_storeu_ps(dst + i, acc);
+                }
+#endif
+                for (; i < count; i++)
+                {
+                    float acc = 0.0f;
+                    for (size_t t = 0; t < taps; t++)
+                    {
+                        acc += kernel.weights[t] * rows[t][i];
+                    }
+                    dst[i] = acc;
+                }
+            }
+
+            struct LevelJob
+            {
+                const uint8_t *src = nullptr;
+                uint32_t src_width = 0;
+                uint32_t src_height = 0;
+
+                uint8_t *dst = nullptr;
+                uint32_t dst_width = 0;
+                uint32_t dst_height = 0;
+
+                PixelLayout layout;
+                const Kernel *kernel = nullptr;
+                bool normal_map = false;
+
+                uint32_t tile_rows = 1;
+                uint32_t tile_count = 0;
+            };
+
+            /// Buffers reused across the tiles of a range
+            struct Scratch
+            {
+                std::vector<float> decoded;
+                std::vector<float> rows;
+                std::vector<float> output;
+                std::vector<const float *> row_pointers;
+            };
+
+            void process_tile(const LevelJob &job, uint32_t tile, Scratch &scratch)
+            {
+                const uint32_t channels = job.layout.channels;
+                const uint32_t pixel_size = job.layout.pixel_size();
+                const Kernel &kernel = *job.kernel;
+                const int taps = static_cast<int>(kernel.weights.size());
+                const int last_row = static_cast<int>(job.src_height) - 1;
+
+                const uint32_t y_begin = tile * job.tile_rows;
+                const uint32_t y_end = std::min(y_begin + job.tile_rows, job.dst_height);
+
+                // Source rows touched by this tile
+                const int first_row = std::clamp(static_cast<int>(2 * y_begin) + kernel.first_offset, 0, last_row);
+                const int end_row = std::clamp(static_cast<int>(2 * (y_end - 1)) + kernel.first_offset + taps - 1, 0,
+                                               last_row);
+
+                const size_t src_row_size = static_cast<size_t>(job.src_width) * channels;
+                const size_t dst_row_size = static_cast<size_t>(job.dst_width) * channels;
+
+                scratch.decoded.resize(src_row_size);
+                scratch.rows.resize((end_row - first_row + 1) * dst_row_size);
+                scratch.output.resize(dst_row_size);
+                scratch.row_pointers.resize(taps);
+
+                for (int row = first_row; row <= end_row; row++)
+                {
+                    decode_row(job.src + static_cast<size_t>(row) * job.src_width * pixel_size, job.src_width,
+                               job.layout, scratch.decoded.data());
+                    filter_horizontal(scratch.decoded.data(), job.src_width,
+                                      scratch.rows.data() + (row - first_row) * dst_row_size, job.dst_width, channels,
+                                      kernel);
+                }
+
+                for (uint32_t y = y_begin; y < y_end; y++)
+                {
+                    const int base = static_cast<int>(2 * y) + kernel.first_offset;
+                    for (int t = 0; t < taps; t++)
+                    {
+                        const int row = std::clamp(base + t, 0, last_row);
+                        scratch.row_pointers[t] = scratch.rows.data() + (row - first_row) * dst_row_size;
+                    }
+
+                    filter_vertical(scratch.row_pointers.data(), kernel, dst_row_size, scratch.output.data());
+
+                    if (job.normal_map)
+                    {
+                        renormalize_row(scratch.output.data(), job.dst_width, job.layout);
+                    }
+
+                    encode_row(scratch.output.data(), job.dst_width, job.layout,
+                               job.dst + static_cast<size_t>(y) * job.dst_width * pixel_size);
+                }
+            }
+
+            /// Levels smaller than this are cheaper to filter than to dispatch
+            constexpr uint64_t min_parallel_texels = 256 * 256;
+        } // namespace
+
+        bool MipGenerator::is_supported(VkFormat format)
+        {
+            PixelLayout layout;
+            return get_pixel_layout(format, layout);
+        }
+
+        void MipGenerator::generate(std::vector<uint8_t> &data, VkFormat format, const VkExtent3D &extent,
+                                    std::vector<Mipmap> &mipmaps, const MipGenerationOptions &options)
+        {
+            PixelLayout layout;
+            if (!get_pixel_layout(format, layout))
+            {
+                throw std::runtime_error{"Mip generation does not support format " + std::to_string(format)};
+            }
+
+            assert(extent.depth <= 1 && "Mip generation only supports 2D images");
+
+            const uint32_t pixel_size = layout.pixel_size();
+
+            // Describe the whole chain first so the data only grows once
+            mipmaps.clear();
+            mipmaps.push_back(Mipmap{0, 0, {std::max(1u, extent.width), std::max(1u, extent.height), 1u}});
+
+            size_t size = static_cast<size_t>(mipmaps[0].extent.width) * mipmaps[0].extent.height * pixel_size;
+            if (data.size() < size)
+            {
+                throw std::runtime_error{"Mip generation source data is smaller than its base level"};
+            }
+
+            while (mipmaps.back().extent.width > 1 || mipmaps.back().extent.height > 1)
+            {
+                const auto &prev = mipmaps.back().extent;
+
+                Mipmap mipmap{};
+                mipmap.level = mipmaps.back().level + 1;
+                mipmap.offset = static_cast<uint32_t>(size);
+                mipmap.extent = {std::max(1u, prev.width / 2), std::max(1u, prev.height / 2), 1u};
+
+                size += static_cast<size_t>(mipmap.extent.width) * mipmap.extent.height * pixel_size;
+                mipmaps.push_back(mipmap);
+            }
+
+            data.resize(size);
+
+            const Kernel kernel = make_kernel(options.filter);
+
+            for (size_t level = 1; level < mipmaps.size(); level++)
+            {
+                const auto &src = mipmaps[level - 1];
+                const auto &dst = mipmaps[level];
+
+                LevelJob job;
+                job.src = data.data() + src.offset;
+                job.src_width = src.extent.width;
+                job.src_height = src.extent.height;
+                job.dst = data.data() + dst.offset;
+                job.dst_width = dst.extent.width;
+                job.dst_height = dst.extent.height;
+                job.layout = layout;
+                job.kernel = &kernel;
+                job.normal_map = options.normal_map;
+                job.tile_rows = std::max(1u, options.tile_rows);
+                job.tile_count = (job.dst_height + job.tile_rows - 1) / job.tile_rows;
+
+                auto process_tiles = [&job](uint32_t first_tile, uint32_t end_tile)
+                {
+                    Scratch scratch;
+                    for (uint32_t tile = first_tile; tile < end_tile; tile++)
+                    {
+                        process_tile(job, tile, scratch);
+                    }
+                };
+
+                const bool parallel = options.parallel && job.tile_count > 1 &&
+                    static_cast<uint64_t>(job.dst_width) * job.dst_height >= min_parallel_texels;
+
+                if (parallel)
+                {
+                    // Waiting runs other jobs, so generating mips from inside a job cannot dead lock the workers
+                    auto &job_system = JobSystem::GetInstance();
+                    job_system.ParallelFor(job.tile_count, job_system.GetGrainSize(job.tile_count), process_tiles);
+                }
+                else
+                {
+                    process_tiles(0, job.tile_count);
+                }
+            }
+        }
+    } // namespace sg
+} // namespace vkb
@@ -0,0 +1,327 @@
+#include "SceneGraph/Components/Image/TextureCooker.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+
+#include <astcenc.h>
+#include <dfdutils/dfd.h>
+
+#include "Logging/Logger.hpp"
+#include "Misc/FileLoader.hpp"
+#include "Misc/Hash.hpp"
+#include "Misc/Paths.hpp"
+#include "SceneGraph/Components/Image/BlockCompression.h"
+#include "SceneGraph/Components/Image/Ktx.h"
+#include "SceneGraph/Components/Image/Stb.h"
+
+namespace vkb
+{
+    namespace sg
+    {
+        namespace
+        {
+            /// Bump when the encoders or the file layout change, invalidates every cooked file
+            constexpr uint64_t cooker_version = 1;
+
+            constexpr uint8_t ktx2_identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+            /// Identifier, header and index, the level index follows
+            constexpr size_t ktx2_header_size = 80;
+
+            /// lcm(16 byte blocks, 4) as required between mip levels
+            constexpr size_t ktx2_level_alignment = 16;
+
+            std::mutex settings_mutex;
+
+            TextureCooker::Settings current_settings;
+
+            void write_u32(std::vector<uint8_t> &file, size_t offset, uint32_t value)
+            {
+                std::memcpy(file.data() + offset, &value, sizeof(value));
+            }
+
+            void write_u64(std::vector<uint8_t> &file, size_t offset, uint64_t value)
+            {
+                std::memcpy(file.data() + offset, &value, sizeof(value));
+            }
+
+            std::filesystem::path get_cache_directory(const TextureCooker::Settings &settings)
+            {
+                if (!settings.cache_directory.empty())
+                {
+                    return settings.cache_directory;
+                }
+
+                return std::filesystem::path{Paths::GetAssetPath()}.parent_path() / "Cache" / "Textures";
+            }
+
+            std::vector<uint8_t> compress_astc(const uint8_t *rgba, const VkExtent3D &extent, astcenc_context *context,
+                                               Image::ContentType content_type)
+            {
+                size_t blocks = static_cast<size_t>((extent.width + 3) / 4) * ((extent.height + 3) / 4);
+                std::vector<uint8_t> output(blocks * 16);
+
+                astcenc_image image{};
+                image.dim_x = extent.width;
+                image.dim_y = extent.height;
+                image.dim_z = 1;
+                image.data_type = ASTCENC_TYPE_U8;
+                void *slices[] = {const_cast<uint8_t *>(rgba)};
+                image.data = slices;
+
+                // Normal maps keep the same xy layout as BC5 so shaders decode both the same way
+                astcenc_swizzle swizzle{ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B, ASTCENC_SWZ_A};
+                if (content_type == Image::NormalMap)
+                {
+                    swizzle = {ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_0, ASTCENC_SWZ_1};
+                }
+
+                auto result = astcenc_compress_image(context, &image, &swizzle, output.data(), output.size(), 0);
+                astcenc_compress_reset(context);
+                if (result != ASTCENC_SUCCESS)
+                {
+                    throw std::runtime_error{std::string{"ASTC compression failed: "} + astcenc_get_error_string(result)};
+                }
+
+                return output;
+            }
+        } // namespace
+
+        void TextureCooker::set_settings(const Settings &settings)
+        {
+            std::lock_guard<std::mutex> lock{settings_mutex};
+            current_settings = settings;
+        }
+
+        TextureCooker::Settings TextureCooker::get_settings()
+        {
+            std::lock_guard<std::mutex> lock{settings_mutex};
+            return current_settings;
+        }
+
+        std::unique_ptr<Image> TextureCooker::load(const std::string &name, const uint8_t *source, size_t size,
+                                                   Image::ContentType content_type)
+        {
+            auto settings = get_settings();
+            if (!settings.enabled)
+            {
+                return nullptr;
+            }
+
+            std::filesystem::path cooked_path;
+            try
+            {
+                cooked_path = get_cooked_path(source, size, content_type);
+
+                if (std::filesystem::exists(cooked_path))
+                {
+                    auto cooked = FileLoader::MapFile(cooked_path);
+                    auto image = std::make_unique<Ktx>(name, cooked.Data(), cooked.Size(), content_type);
+                    image->set_source_path(cooked_path.string());
+                    return image;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                LOGW("Ignoring cooked texture for {}: {}", name, e.what());
+            }
+
+            try
+            {
+                Stb decoded{name, source, size, content_type};
+                auto format = select_format(decoded.get_data(), content_type, settings.target);
+                auto ktx2 = cook(decoded, content_type, format, settings);
+
+                auto image = std::make_unique<Ktx>(name, ktx2, content_type);
+
+                if (!cooked_path.empty())
+                {
+                    try
+                    {
+                        FileLoader::WriteFileBinary(cooked_path, ktx2.data(), ktx2.size());
+                        image->set_source_path(cooked_path.string());
+                    }
+                    catch (const std::exception &e)
+                    {
+                        LOGW("Could not cache cooked texture {}: {}", name, e.what());
+                    }
+                }
+
+                return image;
+            }
+            catch (const std::exception &e)
+            {
+                LOGW("Failed to cook texture {}: {}", name, e.what());
+                return nullptr;
+            }
+        }
+
+        std::string TextureCooker::get_cooked_path(const uint8_t *source, size_t size, Image::ContentType content_type)
+        {
+            auto settings = get_settings();
+
+            uint64_t hash = Hash::Hash64(source, size);
+            hash = Hash::Combine(hash, cooker_version);
+            hash = Hash::Combine(hash, static_cast<uint64_t>(content_type));
+            hash = Hash::Combine(hash, static_cast<uint64_t>(settings.target));
+            hash = Hash::Combine(hash, static_cast<uint64_t>(settings.mip_filter));
+
+            return (get_cache_directory(settings) / (Hash::ToHex(hash) + ".ktx2")).string();
+        }
+
+        VkFormat TextureCooker::select_format(const std::vector<uint8_t> &rgba, Image::ContentType content_type,
+                                              Target target)
+        {
+            if (target == Target::ASTC)
+            {
+                return content_type == Image::Color ? VK_FORMAT_ASTC_4x4_SRGB_BLOCK : VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+            }
+
+            if (content_type == Image::Color)
+            {
+                return VK_FORMAT_BC7_SRGB_BLOCK;
+            }
+
+            if (content_type == Image::NormalMap)
+            {
+                return VK_FORMAT_BC5_UNORM_BLOCK;
+            }
+
+            // Opaque greyscale data (masks, roughness, occlusion) only needs one channel
+            for (size_t i = 0; i + 3 < rgba.size(); i += 4)
+            {
+                if (rgba[i] != rgba[i + 1] || rgba[i] != rgba[i + 2] || rgba[i + 3] != 255)
+                {
+                    return VK_FORMAT_BC7_UNORM_BLOCK;
+                }
+            }
+
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        }
+
+        std::vector<uint8_t> TextureCooker::cook(Image &image, Image::ContentType content_type, VkFormat format,
+                                                 const Settings &settings)
+        {
+            if (image.get_format() != VK_FORMAT_R8G8B8A8_UNORM && image.get_format() != VK_FORMAT_R8G8B8A8_SRGB)
+            {
+                throw std::runtime_error{"Texture cooking expects 8-bit RGBA data: " + image.get_name()};
+            }
+
+            if (image.get_mipmaps().size() == 1)
+            {
+                MipGenerationOptions options;
+                options.filter = settings.mip_filter;
+                options.normal_map = content_type == Image::NormalMap;
+                image.generate_mipmaps(options);
+            }
+
+            const auto &data = image.get_data();
+            const auto &mipmaps = image.get_mipmaps();
+
+            std::vector<std::vector<uint8_t>> levels;
+            levels.reserve(mipmaps.size());
+
+            if (is_astc(format))
+            {
+                astcenc_config config;
+                auto profile = format == VK_FORMAT_ASTC_4x4_SRGB_BLOCK ? ASTCENC_PRF_LDR_SRGB : ASTCENC_PRF_LDR;
+                auto result = astcenc_config_init(profile, 4, 4, 1, ASTCENC_PRE_MEDIUM, 0, &config);
+
+                astcenc_context *context = nullptr;
+                if (result == ASTCENC_SUCCESS)
+                {
+                    result = astcenc_context_alloc(&config, 1, &context);
+                }
+                if (result != ASTCENC_SUCCESS)
+                {
+                    throw std::runtime_error{std::string{"ASTC encoder setup failed: "} + astcenc_get_error_string(result)};
+                }
+
+                try
+                {
+                    for (auto &mipmap : mipmaps)
+                    {
+                        levels.push_back(compress_astc(data.data() + mipmap.offset, mipmap.extent, context, content_type));
+                    }
+                }
+                catch (...)
+                {
+                    astcenc_context_free(context);
+                    throw;
+                }
+                astcenc_context_free(context);
+            }
+            else
+            {
+                for (auto &mipmap : mipmaps)
+                {
+                    std::vector<uint8_t> level(BlockCompression::get_compressed_size(format, mipmap.extent));
+                    BlockCompression::compress(data.data() + mipmap.offset, mipmap.extent, format, level.data());
+                    levels.push_back(std::move(level));
+                }
+            }
+
+            return write_ktx2(format, image.get_extent(), levels);
+        }
+
+        std::vector<uint8_t> TextureCooker::write_ktx2(VkFormat format, const VkExtent3D &extent,
+                                                       const std::vector<std::vector<uint8_t>> &levels)
+        {
+            uint32_t *dfd = vk2dfd(format);
+            if (!dfd)
+            {
+                throw std::runtime_error{"No data format descriptor for format " + std::to_string(format)};
+            }
+            // The first word of the descriptor is its total size in bytes
+            uint32_t dfd_size = dfd[0];
+
+            auto level_count = static_cast<uint32_t>(levels.size());
+            size_t dfd_offset = ktx2_header_size + 24 * static_cast<size_t>(level_count);
+
+            // Level data is stored smallest first, the level index is largest first
+            std::vector<size_t> level_offsets(level_count);
+            size_t end = dfd_offset + dfd_size;
+            for (uint32_t level = level_count; level-- > 0;)
+            {
+                end = (end + ktx2_level_alignment - 1) / ktx2_level_alignment * ktx2_level_alignment;
+                level_offsets[level] = end;
+                end += levels[level].size();
+            }
+
+            std::vector<uint8_t> file(end, 0);
+            std::memcpy(file.data(), ktx2_identifier, sizeof(ktx2_identifier));
+
+            write_u32(file, 12, format);
+            write_u32(file, 16, 1);    // typeSize, 1 for block compressed formats
+            write_u32(file, 20, extent.width);
+            write_u32(file, 24, extent.height);
+            write_u32(file, 28, 0);    // pixelDepth, 0 for 2D
+            write_u32(file, 32, 0);    // layerCount, 0 for non array
+            write_u32(file, 36, 1);    // faceCount
+            write_u32(file, 40, level_count);
+            write_u32(file, 44, 0);    // no supercompression
+
+            write_u32(file, 48, static_cast<uint32_t>(dfd_offset));
+            write_u32(file, 52, dfd_size);
+            // Key/value data and supercompression global data are left empty
+
+            for (uint32_t level = 0; level < level_count; level++)
+            {
+                size_t entry = ktx2_header_size + 24 * static_cast<size_t>(level);
+                write_u64(file, entry, level_offsets[level]);
+                write_u64(file, entry + 8, levels[level].size());
+                write_u64(file, entry + 16, levels[level].size());
+
+                std::memcpy(file.data() + level_offsets[level], levels[level].data(), levels[level].size());
+            }
+
+            std::memcpy(file.data() + dfd_offset, dfd, dfd_size);
+            std::free(dfd);
+
+            return file;
+        }
+    } // namespace sg
+} // namespace vkb
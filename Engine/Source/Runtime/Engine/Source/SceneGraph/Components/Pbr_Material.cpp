@@ -18,6 +18,10 @@
 
 #include "SceneGraph/Components/Pbr_Material.h"
 
+#include "SceneGraph/Components/Image.h"
+#include "SceneGraph/Components/Sampler.h"
+#include "SceneGraph/Components/Texture.h"
+
 namespace vkb
 {
 namespace sg
@@ -30,5 +34,33 @@ std::type_index PBRMaterial::get_type()
 {
 	return typeid(PBRMaterial);
 }
+
+PBRMaterialIndices PBRMaterial::get_bindless_indices() const
+{
+	auto texture_index = [this](const std::string &name) {
+		auto it = textures.find(name);
+		if (it == textures.end() || !it->second->get_image())
+		{
+			return BindlessHandle::invalid_index;
+		}
+		return it->second->get_image()->get_bindless_handle().index;
+	};
+
+	PBRMaterialIndices indices{};
+	indices.base_color         = texture_index("base_color_texture");
+	indices.metallic_roughness = texture_index("metallic_roughness_texture");
+	indices.normal             = texture_index("normal_texture");
+	indices.occlusion          = texture_index("occlusion_texture");
+	indices.emissive           = texture_index("emissive_texture");
+	indices.sampler            = BindlessHandle::invalid_index;
+
+	auto it = textures.find("base_color_texture");
+	if (it != textures.end())
+	{
+		indices.sampler = it->second->get_sampler()->bindless_handle.index;
+	}
+
+	return indices;
+}
 }        // namespace sg
 }        // namespace vkb
@@ -0,0 +1,168 @@
+#include "SceneGraph/Components/VertexLayout.h"
+
+#include <algorithm>
+
+#include <glm/gtc/packing.hpp>
+
+#include "Framework/Core/ShaderModule.hpp"
+
+namespace vkb
+{
+    namespace sg
+    {
+        namespace
+        {
+            inline glm::vec2 sign_not_zero(const glm::vec2& v)
+            {
+                return {v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f};
+            }
+        } // namespace
+
+        VertexLayout VertexLayout::full()
+        {
+            return VertexLayout{};
+        }
+
+        VertexLayout VertexLayout::compact()
+        {
+            VertexLayout layout;
+            layout.quantize_positions = true;
+            layout.octahedral_normals = true;
+            layout.half_texcoords = true;
+            layout.compact_skin = true;
+            return layout;
+        }
+
+        bool VertexLayout::is_compact() const
+        {
+            return quantize_positions || octahedral_normals || half_texcoords || compact_skin;
+        }
+
+        void VertexLayout::apply_defines(ShaderVariant& variant) const
+        {
+            if (quantize_positions)
+            {
+                variant.add_define("QUANTIZED_POSITION");
+            }
+            if (octahedral_normals)
+            {
+                variant.add_define("OCT_NORMAL");
+                variant.add_define("OCT_TANGENT");
+            }
+            if (half_texcoords)
+            {
+                variant.add_define("HALF_TEXCOORD");
+            }
+            if (compact_skin)
+            {
+                variant.add_define("UNORM8_SKIN");
+            }
+        }
+
+        PositionDequantization PositionDequantization::from_bounds(const glm::vec3& min, const glm::vec3& max)
+        {
+            PositionDequantization dequantization;
+            dequantization.offset = min;
+            dequantization.scale = max - min;
+
+            // Flat meshes still need a valid range on the degenerate axis
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (dequantization.scale[axis] <= 0.0f)
+                {
+                    dequantization.scale[axis] = 1.0f;
+                }
+            }
+
+            return dequantization;
+        }
+
+        glm::mat4 PositionDequantization::to_matrix() const
+        {
+            return glm::translate(offset) * glm::scale(scale);
+        }
+
+        glm::vec2 octahedral_encode(const glm::vec3& n)
+        {
+            float l1_norm = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+            if (l1_norm <= 0.0f)
+            {
+                return glm::vec2(0.0f);
+            }
+
+            glm::vec2 p = glm::vec2(n.x, n.y) / l1_norm;
+            if (n.z < 0.0f)
+            {
+                p = (glm::vec2(1.0f) - glm::abs(glm::vec2(p.y, p.x))) * sign_not_zero(p);
+            }
+
+            return p;
+        }
+
+        glm::vec3 octahedral_decode(const glm::vec2& e)
+        {
+            glm::vec3 n{e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y)};
+            if (n.z < 0.0f)
+            {
+                glm::vec2 xy = (glm::vec2(1.0f) - glm::abs(glm::vec2(n.y, n.x))) * sign_not_zero(glm::vec2(n.x, n.y));
+                n.x = xy.x;
+                n.y = xy.y;
+            }
+
+            return glm::normalize(n);
+        }
+
+        uint32_t pack_octahedral_normal(const glm::vec3& normal)
+        {
+            return glm::packSnorm2x16(octahedral_encode(normal));
+        }
+
+        uint32_t pack_octahedral_tangent(const glm::vec4& tangent)
+        {
+            glm::vec2 e = octahedral_encode(glm::vec3(tangent));
+
+            // Keep the remapped component away from zero, otherwise the sign could not be recovered
+            float y = std::max(e.y * 0.5f + 0.5f, 1.0f / 32767.0f);
+            e.y = tangent.w < 0.0f ? -y : y;
+
+            return glm::packSnorm2x16(e);
+        }
+
+        uint64_t quantize_position(const glm::vec3& position, const PositionDequantization& dequantization)
+        {
+            glm::vec3 q = (position - dequantization.offset) / dequantization.scale;
+
+            return glm::packUnorm4x16(glm::vec4(glm::clamp(q, 0.0f, 1.0f), 1.0f));
+        }
+
+        uint32_t pack_half_texcoord(const glm::vec2& uv)
+        {
+            return glm::packHalf2x16(uv);
+        }
+
+        uint32_t pack_unorm8_weights(const glm::vec4& weights)
+        {
+            float sum = weights.x + weights.y + weights.z + weights.w;
+            glm::vec4 normalized = sum > 0.0f ? weights / sum : glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+
+            int quantized[4];
+            int total = 0;
+            int largest = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                quantized[i] = static_cast<int>(std::round(normalized[i] * 255.0f));
+                total += quantized[i];
+                if (normalized[i] > normalized[largest])
+                {
+                    largest = i;
+                }
+            }
+            quantized[largest] = std::clamp(quantized[largest] + 255 - total, 0, 255);
+
+            return static_cast<uint32_t>(quantized[0]) |
+                static_cast<uint32_t>(quantized[1]) << 8 |
+                static_cast<uint32_t>(quantized[2]) << 16 |
+                static_cast<uint32_t>(quantized[3]) << 24;
+        }
+    } // namespace sg
+} // namespace vkb
@@ -0,0 +1,722 @@
+#include "Streaming/TextureStreamer.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+#include "Framework/Common/glmCommon.hpp"
+#include "Framework/Core/BindlessDescriptorTable.hpp"
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Logging/Logger.hpp"
+#include "SceneGraph/Components/Camera.h"
+#include "SceneGraph/Components/Image.h"
+#include "SceneGraph/Components/Material.h"
+#include "SceneGraph/Components/Mesh.h"
+#include "SceneGraph/Components/SubMesh.h"
+#include "SceneGraph/Components/Texture.h"
+#include "SceneGraph/Components/Transform.h"
+#include "SceneGraph/Node.h"
+#include "SceneGraph/Scene.h"
+#include "SubSystems/JobSystem.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        constexpr uint8_t ktx2_identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+        constexpr size_t ktx2_header_size = 80;
+
+        uint32_t read_u32(const uint8_t *data)
+        {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint64_t read_u64(const uint8_t *data)
+        {
+            uint64_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        /**
+         * @brief Byte range of every level in the image data
+         *        Loaders store levels in either order (KTX2 is smallest first), so a level ends where the
+         *        next higher offset starts
+         */
+        std::vector<std::pair<size_t, size_t>> get_level_ranges(const sg::Image &image)
+        {
+            const auto &mipmaps = image.get_mipmaps();
+            size_t data_size = image.get_data().size();
+
+            std::vector<size_t> offsets;
+            for (auto &mipmap : mipmaps)
+            {
+                offsets.push_back(mipmap.offset);
+            }
+            std::sort(offsets.begin(), offsets.end());
+
+            std::vector<std::pair<size_t, size_t>> ranges;
+            for (auto &mipmap : mipmaps)
+            {
+                auto next = std::upper_bound(offsets.begin(), offsets.end(), static_cast<size_t>(mipmap.offset));
+                size_t end = next == offsets.end() ? data_size : *next;
+                ranges.emplace_back(mipmap.offset, end - mipmap.offset);
+            }
+            return ranges;
+        }
+
+        /// Left, right, bottom and top planes of a view projection matrix, normals point inside
+        std::array<glm::vec4, 4> get_side_planes(const glm::mat4 &view_projection)
+        {
+            glm::mat4 rows = glm::transpose(view_projection);
+
+            std::array<glm::vec4, 4> planes = {rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1]};
+            for (auto &plane : planes)
+            {
+                plane /= glm::length(glm::vec3(plane));
+            }
+            return planes;
+        }
+
+        bool is_sphere_visible(const std::array<glm::vec4, 4> &planes, const glm::vec3 &center, float radius)
+        {
+            for (auto &plane : planes)
+            {
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void transition(CommandBuffer &command_buffer, const ImageView &view, VkImageLayout old_layout,
+                        VkImageLayout new_layout, VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+                        VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+        {
+            ImageMemoryBarrier memory_barrier{};
+            memory_barrier.old_layout = old_layout;
+            memory_barrier.new_layout = new_layout;
+            memory_barrier.src_stage_mask = src_stage;
+            memory_barrier.src_access_mask = src_access;
+            memory_barrier.dst_stage_mask = dst_stage;
+            memory_barrier.dst_access_mask = dst_access;
+
+            command_buffer.image_memory_barrier(view, memory_barrier);
+        }
+
+        /**
+         * @brief Creates an image covering the levels [mip, last level] of the full chain
+         */
+        std::pair<std::unique_ptr<vkb::Image>, std::unique_ptr<ImageView>> create_resident_image(
+            VulkanDevice &device, const sg::Image &image, uint32_t mip)
+        {
+            const auto &mipmaps = image.get_mipmaps();
+
+            auto vk_image = ImageBuilder{mipmaps[mip].extent}
+                            .with_format(image.get_format())
+                            .with_usage(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                                        VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+                            .with_mip_levels(to_u32(mipmaps.size()) - mip)
+                            .with_tiling(VK_IMAGE_TILING_OPTIMAL)
+                            .with_vma_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+                            .with_vma_flags(VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT)
+                            .with_debug_name(image.get_name())
+                            .build_unique(device);
+
+            auto view = std::make_unique<ImageView>(*vk_image, VK_IMAGE_VIEW_TYPE_2D);
+            view->SetDebugName("View on " + image.get_name());
+
+            return {std::move(vk_image), std::move(view)};
+        }
+    } // namespace
+
+    std::unique_ptr<Ktx2MipSource> Ktx2MipSource::open(const std::string &path, uint32_t level_count)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return nullptr;
+        }
+
+        uint8_t header[ktx2_header_size];
+        if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) ||
+            std::memcmp(header, ktx2_identifier, sizeof(ktx2_identifier)) != 0)
+        {
+            return nullptr;
+        }
+
+        uint32_t layer_count = read_u32(header + 32);
+        uint32_t face_count = read_u32(header + 36);
+        uint32_t file_level_count = std::max(1u, read_u32(header + 40));
+        uint32_t supercompression = read_u32(header + 44);
+        if (layer_count > 1 || face_count != 1 || file_level_count != level_count || supercompression != 0)
+        {
+            return nullptr;
+        }
+
+        std::vector<uint8_t> level_index(static_cast<size_t>(level_count) * 24);
+        if (!file.read(reinterpret_cast<char *>(level_index.data()), level_index.size()))
+        {
+            return nullptr;
+        }
+
+        auto source = std::make_unique<Ktx2MipSource>();
+        source->path = path;
+        for (uint32_t level = 0; level < level_count; level++)
+        {
+            const uint8_t *entry = level_index.data() + level * 24;
+            source->levels.push_back({read_u64(entry), read_u64(entry + 8)});
+        }
+
+        return source;
+    }
+
+    std::vector<uint8_t> Ktx2MipSource::read_level(uint32_t level) const
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<uint8_t> data(levels.at(level).size);
+
+        if (!file.seekg(static_cast<std::streamoff>(levels[level].offset)) ||
+            !file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size())))
+        {
+            throw std::runtime_error{"Failed to read level " + std::to_string(level) + " of " + path};
+        }
+
+        return data;
+    }
+
+    MemoryMipSource::MemoryMipSource(sg::Image &image) :
+        data{image.get_data()},
+        levels{get_level_ranges(image)}
+    {
+    }
+
+    std::vector<uint8_t> MemoryMipSource::read_level(uint32_t level) const
+    {
+        auto &range = levels.at(level);
+        return {data.begin() + range.first, data.begin() + range.first + range.second};
+    }
+
+    TextureStreamer::TextureStreamer(VulkanDevice &device) :
+        TextureStreamer{device, Settings{}}
+    {
+    }
+
+    TextureStreamer::TextureStreamer(VulkanDevice &device, const Settings &settings) :
+        device{device},
+        settings{settings}
+    {
+        if (this->settings.budget == 0)
+        {
+            // Half of what the device local heaps can give us, the rest is left to buffers and render targets
+            const VkPhysicalDeviceMemoryProperties *memory_properties = nullptr;
+            vmaGetMemoryProperties(get_memory_allocator(), &memory_properties);
+
+            std::vector<VmaBudget> budgets(memory_properties->memoryHeapCount);
+            vmaGetHeapBudgets(get_memory_allocator(), budgets.data());
+
+            for (uint32_t heap = 0; heap < memory_properties->memoryHeapCount; heap++)
+            {
+                if (memory_properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                {
+                    this->settings.budget = std::max(this->settings.budget, budgets[heap].budget / 2);
+                }
+            }
+        }
+
+        LOGI("Texture streaming budget: {} MB", this->settings.budget / (1024 * 1024));
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        // Pending reads reference the sources owned by the entries
+        for (auto &entry : entries)
+        {
+            if (entry.second->loading.valid())
+            {
+                entry.second->loading.wait();
+            }
+        }
+    }
+
+    bool TextureStreamer::is_streamable(const sg::Image &image)
+    {
+        const auto &extent = image.get_extent();
+        return image.get_layers() == 1 && image.get_mipmaps().size() > 1 && extent.depth <= 1 &&
+            !image.get_data().empty();
+    }
+
+    bool TextureStreamer::register_image(sg::Image &image, CommandBuffer &command_buffer,
+                                         std::vector<Buffer> &staging_buffers)
+    {
+        if (!is_streamable(image))
+        {
+            return false;
+        }
+
+        const auto &mipmaps = image.get_mipmaps();
+        auto level_count = to_u32(mipmaps.size());
+
+        auto entry = std::make_unique<Entry>();
+        entry->image = &image;
+        entry->last_used_frame = frame;
+
+        auto ranges = get_level_ranges(image);
+        for (auto &range : ranges)
+        {
+            entry->level_sizes.push_back(range.second);
+        }
+
+        // The tail starts at the first level small enough to stay resident
+        entry->tail_mip = level_count - 1;
+        for (uint32_t level = 0; level < level_count; level++)
+        {
+            if (std::max(mipmaps[level].extent.width, mipmaps[level].extent.height) <= settings.resident_tail_size)
+            {
+                entry->tail_mip = level;
+                break;
+            }
+        }
+        entry->resident_mip = entry->tail_mip;
+        entry->wanted_mip = entry->tail_mip;
+
+        if (!image.get_source_path().empty())
+        {
+            entry->source = Ktx2MipSource::open(image.get_source_path(), level_count);
+        }
+        if (!entry->source)
+        {
+            entry->source = std::make_unique<MemoryMipSource>(image);
+        }
+
+        std::vector<uint8_t> tail_data;
+        std::vector<VkBufferImageCopy> regions;
+        for (uint32_t level = entry->tail_mip; level < level_count; level++)
+        {
+            VkBufferImageCopy region{};
+            region.bufferOffset = tail_data.size();
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - entry->tail_mip, 0, 1};
+            region.imageExtent = mipmaps[level].extent;
+            regions.push_back(region);
+
+            auto &range = ranges[level];
+            tail_data.insert(tail_data.end(), image.get_data().begin() + range.first,
+                             image.get_data().begin() + range.first + range.second);
+        }
+
+        auto resident = create_resident_image(device, image, entry->tail_mip);
+
+        staging_buffers.push_back(Buffer::create_staging_buffer(device, tail_data));
+
+        transition(command_buffer, *resident.second, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_PIPELINE_STAGE_HOST_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        command_buffer.copy_buffer_to_image(staging_buffers.back(), *resident.first, regions);
+
+        transition(command_buffer, *resident.second, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                   VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+        entry->resident_bytes = resident.first->get_image_required_size();
+        resident_bytes += entry->resident_bytes;
+
+        image.replace_vk_image(std::move(resident.first), std::move(resident.second));
+        image.clear_data();
+
+        entries[&image] = std::move(entry);
+
+        return true;
+    }
+
+    void TextureStreamer::unregister_image(sg::Image &image)
+    {
+        auto it = entries.find(&image);
+        if (it == entries.end())
+        {
+            return;
+        }
+
+        if (it->second->loading.valid())
+        {
+            it->second->loading.wait();
+        }
+
+        resident_bytes -= it->second->resident_bytes;
+        entries.erase(it);
+    }
+
+    void TextureStreamer::request(sg::Image &image, float mip)
+    {
+        auto it = entries.find(&image);
+        if (it == entries.end())
+        {
+            return;
+        }
+
+        auto &entry = *it->second;
+
+        float biased = std::floor(mip + settings.mip_bias);
+        uint32_t level = biased <= 0.0f ? 0 : std::min(static_cast<uint32_t>(biased), entry.tail_mip);
+
+        if (entry.last_used_frame != frame)
+        {
+            entry.wanted_mip = level;
+            entry.last_used_frame = frame;
+        }
+        else
+        {
+            entry.wanted_mip = std::min(entry.wanted_mip, level);
+        }
+    }
+
+    void TextureStreamer::request_visible(const sg::Scene &scene, sg::Camera &camera, const VkExtent2D &viewport)
+    {
+        glm::mat4 view = camera.get_view();
+        glm::mat4 projection = camera.get_projection();
+
+        auto planes = get_side_planes(projection * view);
+        glm::vec3 camera_position = glm::vec3(glm::inverse(view)[3]);
+
+        // Pixels covered by one world unit, at unit distance for perspective projections
+        bool orthographic = projection[3][3] == 1.0f;
+        float pixels_per_unit = 0.5f * static_cast<float>(viewport.height) * std::abs(projection[1][1]);
+
+        for (auto *mesh : scene.get_components<sg::Mesh>())
+        {
+            // Meshes without bounds are treated as points at their origin and never culled
+            const auto &bounds = mesh->get_bounds();
+            bool has_bounds = glm::all(glm::lessThanEqual(bounds.get_min(), bounds.get_max()));
+            glm::vec3 local_center = has_bounds ? bounds.get_center() : glm::vec3{0.0f};
+            float local_radius = has_bounds ? 0.5f * glm::length(bounds.get_scale()) : 0.0f;
+
+            for (auto *node : mesh->get_nodes())
+            {
+                glm::mat4 world = node->get_transform().get_world_matrix();
+                float scale = std::max({glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])),
+                                        glm::length(glm::vec3(world[2]))});
+                if (scale <= 0.0f)
+                {
+                    continue;
+                }
+
+                glm::vec3 center = glm::vec3(world * glm::vec4(local_center, 1.0f));
+                float radius = local_radius * scale;
+                if (has_bounds && !is_sphere_visible(planes, center, radius))
+                {
+                    continue;
+                }
+
+                float projected_pixels_per_unit = pixels_per_unit;
+                if (!orthographic)
+                {
+                    // The closest point of the bounds decides, the mip is only ever underestimated
+                    float distance = std::max(glm::length(center - camera_position) - radius, 1e-3f);
+                    projected_pixels_per_unit /= distance;
+                }
+
+                for (auto *submesh : mesh->get_submeshes())
+                {
+                    auto *material = submesh->get_material();
+                    if (!material)
+                    {
+                        continue;
+                    }
+
+                    float texcoords_per_unit = submesh->texcoord_density / scale;
+
+                    for (auto &texture : material->textures)
+                    {
+                        auto *image = texture.second ? texture.second->get_image() : nullptr;
+                        if (!image)
+                        {
+                            continue;
+                        }
+
+                        const auto &extent = image->get_extent();
+                        float texels_per_unit = texcoords_per_unit * static_cast<float>(std::max(extent.width, extent.height));
+
+                        request(*image, std::log2(std::max(texels_per_unit / projected_pixels_per_unit, 1e-6f)));
+                    }
+                }
+            }
+        }
+    }
+
+    void TextureStreamer::update(CommandBuffer &command_buffer)
+    {
+        // Allocations replaced at least frames_in_flight updates ago are no longer referenced by the GPU
+        while (!retired.empty() && retired.front().frame + settings.frames_in_flight <= frame)
+        {
+            retired.pop_front();
+        }
+
+        // The budget may have been lowered, or images registered past it
+        make_room(0, nullptr, command_buffer);
+
+        // Recently requested images first, then the ones missing the most levels
+        std::vector<Entry *> order;
+        order.reserve(entries.size());
+        for (auto &entry : entries)
+        {
+            order.push_back(entry.second.get());
+        }
+        std::sort(order.begin(), order.end(), [](const Entry *a, const Entry *b)
+        {
+            if (a->last_used_frame != b->last_used_frame)
+            {
+                return a->last_used_frame > b->last_used_frame;
+            }
+            return a->resident_mip - std::min(a->wanted_mip, a->resident_mip) >
+                b->resident_mip - std::min(b->wanted_mip, b->resident_mip);
+        });
+
+        VkDeviceSize uploaded = 0;
+        for (auto *entry : order)
+        {
+            if (entry->loading.valid())
+            {
+                if (entry->loading.wait_for(std::chrono::seconds(0)) == std::future_status::timeout)
+                {
+                    continue;
+                }
+
+                VkDeviceSize upload_size = 0;
+                for (uint32_t level = entry->loading_mip; level < entry->resident_mip; level++)
+                {
+                    upload_size += entry->level_sizes[level];
+                }
+
+                // Leave the data for a later frame once this frame's upload allowance is spent
+                if (uploaded > 0 && uploaded + upload_size > settings.max_upload_per_frame)
+                {
+                    continue;
+                }
+
+                std::vector<std::vector<uint8_t>> levels;
+                try
+                {
+                    levels = entry->loading.get();
+                }
+                catch (const std::exception &e)
+                {
+                    LOGW("Texture streaming read failed for {}: {}", entry->image->get_name(), e.what());
+                    continue;
+                }
+
+                VkDeviceSize size = estimate_size(*entry, entry->loading_mip);
+                VkDeviceSize growth = size > entry->resident_bytes ? size - entry->resident_bytes : 0;
+                if (!make_room(growth, entry, command_buffer))
+                {
+                    continue;
+                }
+
+                if (reallocate(*entry, entry->loading_mip, levels, command_buffer))
+                {
+                    uploaded += upload_size;
+                    stream_ins++;
+                }
+                continue;
+            }
+
+            // Only images requested this frame start reads, the others wait for their next request
+            if (entry->last_used_frame == frame && entry->wanted_mip < entry->resident_mip)
+            {
+                MipSource *source = entry->source.get();
+                uint32_t first = entry->wanted_mip;
+                uint32_t last = entry->resident_mip;
+
+                auto read = [source, first, last]()
+                {
+                    std::vector<std::vector<uint8_t>> levels;
+                    for (uint32_t level = first; level < last; level++)
+                    {
+                        levels.push_back(source->read_level(level));
+                    }
+                    return levels;
+                };
+
+                entry->loading_mip = first;
+                auto task = std::make_shared<std::packaged_task<std::vector<std::vector<uint8_t>>()>>(read);
+                entry->loading = task->get_future();
+                JobSystem::GetInstance().Run([task]() { (*task)(); });
+            }
+        }
+
+        frame++;
+    }
+
+    const TextureStreamer::Settings &TextureStreamer::get_settings() const
+    {
+        return settings;
+    }
+
+    TextureStreamer::Stats TextureStreamer::get_stats() const
+    {
+        Stats stats;
+        stats.image_count = entries.size();
+        stats.resident_bytes = resident_bytes;
+        stats.budget = settings.budget;
+        stats.evictions = evictions;
+        stats.stream_ins = stream_ins;
+        for (auto &entry : entries)
+        {
+            stats.pending_reads += entry.second->loading.valid() ? 1 : 0;
+        }
+        return stats;
+    }
+
+    bool TextureStreamer::reallocate(Entry &entry, uint32_t mip, const std::vector<std::vector<uint8_t>> &levels,
+                                     CommandBuffer &command_buffer)
+    {
+        auto &image = *entry.image;
+        const auto &mipmaps = image.get_mipmaps();
+        auto level_count = to_u32(mipmaps.size());
+
+        std::pair<std::unique_ptr<vkb::Image>, std::unique_ptr<ImageView>> resident;
+        try
+        {
+            resident = create_resident_image(device, image, mip);
+        }
+        catch (const std::exception &e)
+        {
+            LOGW("Texture streaming could not allocate {} from mip {}: {}", image.get_name(), mip, e.what());
+            return false;
+        }
+
+        transition(command_buffer, *resident.second, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        // Levels both allocations hold are copied on the GPU
+        uint32_t first_kept = std::max(mip, entry.resident_mip);
+        if (first_kept < level_count)
+        {
+            transition(command_buffer, image.get_vk_image_view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+            std::vector<VkImageCopy> regions;
+            for (uint32_t level = first_kept; level < level_count; level++)
+            {
+                VkImageCopy region{};
+                region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - entry.resident_mip, 0, 1};
+                region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - mip, 0, 1};
+                region.extent = mipmaps[level].extent;
+                regions.push_back(region);
+            }
+
+            command_buffer.copy_image(image.get_vk_image(), *resident.first, regions);
+        }
+
+        // Streamed in levels come from the staging buffer
+        std::unique_ptr<Buffer> staging;
+        if (mip < entry.resident_mip)
+        {
+            std::vector<uint8_t> data;
+            std::vector<VkBufferImageCopy> regions;
+            for (uint32_t level = mip; level < entry.resident_mip; level++)
+            {
+                auto &level_data = levels.at(level - mip);
+
+                VkBufferImageCopy region{};
+                region.bufferOffset = data.size();
+                region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - mip, 0, 1};
+                region.imageExtent = mipmaps[level].extent;
+                regions.push_back(region);
+
+                data.insert(data.end(), level_data.begin(), level_data.end());
+            }
+
+            staging = std::make_unique<Buffer>(Buffer::create_staging_buffer(device, data));
+            command_buffer.copy_buffer_to_image(*staging, *resident.first, regions);
+        }
+
+        transition(command_buffer, *resident.second, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                   VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+        VkDeviceSize size = resident.first->get_image_required_size();
+        resident_bytes = resident_bytes - entry.resident_bytes + size;
+        entry.resident_bytes = size;
+        entry.resident_mip = mip;
+
+        auto previous = image.replace_vk_image(std::move(resident.first), std::move(resident.second));
+        retired.push_back({std::move(previous.first), std::move(previous.second), std::move(staging), frame});
+
+        // Frames in flight may still sample the old slot, point a new one to the new view
+        if (auto *bindless_table = device.get_resource_cache().get_bindless_table(); bindless_table && image.get_bindless_handle().is_valid())
+        {
+            auto previous_handle = image.get_bindless_handle();
+            image.set_bindless_handle(bindless_table->register_texture(image.get_vk_image_view()));
+            bindless_table->release_texture(previous_handle);
+        }
+
+        return true;
+    }
+
+    bool TextureStreamer::make_room(VkDeviceSize bytes, const Entry *keep, CommandBuffer &command_buffer)
+    {
+        if (resident_bytes + bytes <= settings.budget)
+        {
+            return true;
+        }
+
+        // Least recently used first, images used this frame and images being read are left alone
+        std::vector<Entry *> candidates;
+        for (auto &entry : entries)
+        {
+            auto *candidate = entry.second.get();
+            if (candidate != keep && candidate->resident_mip < candidate->tail_mip &&
+                candidate->last_used_frame < frame && !candidate->loading.valid())
+            {
+                candidates.push_back(candidate);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Entry *a, const Entry *b)
+        {
+            return a->last_used_frame < b->last_used_frame;
+        });
+
+        for (auto *candidate : candidates)
+        {
+            // Keep what the last request still wanted when that is enough, drop to the tail otherwise
+            uint32_t mip = std::max(candidate->wanted_mip, candidate->resident_mip + 1);
+            VkDeviceSize reduced = estimate_size(*candidate, mip);
+            if (resident_bytes - candidate->resident_bytes + reduced + bytes > settings.budget)
+            {
+                mip = candidate->tail_mip;
+            }
+
+            if (reallocate(*candidate, std::min(mip, candidate->tail_mip), {}, command_buffer))
+            {
+                evictions++;
+            }
+
+            if (resident_bytes + bytes <= settings.budget)
+            {
+                return true;
+            }
+        }
+
+        return resident_bytes + bytes <= settings.budget;
+    }
+
+    VkDeviceSize TextureStreamer::estimate_size(const Entry &entry, uint32_t mip) const
+    {
+        VkDeviceSize size = 0;
+        for (size_t level = mip; level < entry.level_sizes.size(); level++)
+        {
+            size += entry.level_sizes[level];
+        }
+        return size;
+    }
+} // namespace vkb
@@ -25,659 +25,308 @@
 #include "Framework/Core/PipelineState.hpp"
 #include "Framework/Core/ShaderModule.hpp"
 #include "VkHelpers.hpp"
+#include "Framework/Common/ResourceKey.hpp"
+#include "Framework/Misc/ConcurrentResourceMap.hpp"
 #include "Framework/Misc/ResourceRecord.hpp"
 #include "Framework/Rendering/RenderTarget.hpp"
 #include "Logging/Logger.hpp"
 
-namespace std
+namespace vkb
 {
-    template <>
-    struct hash<vkb::ShaderSource>
-    {
-        std::size_t operator()(const vkb::ShaderSource &shader_source) const
-        {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, shader_source.get_id());
-
-            return result;
-        }
-    };
-
-    template <>
-    struct hash<vkb::ShaderVariant>
+    namespace
     {
-        std::size_t operator()(const vkb::ShaderVariant &shader_variant) const
-        {
-            std::size_t result = 0;
+        // key_param packs the creation parameters of a resource into its ResourceKey. Every vector and map is
+        // prefixed with its length, so different parameter lists can never pack into the same bytes.
 
-            vkb::hash_combine(result, shader_variant.get_id());
-
-            return result;
-        }
-    };
-
-    template <>
-    struct hash<vkb::ShaderModule>
-    {
-        std::size_t operator()(const vkb::ShaderModule &shader_module) const
-        {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, shader_module.get_id());
-
-            return result;
-        }
-    };
-
-    template <>
-    struct hash<vkb::DescriptorSetLayout>
-    {
-        std::size_t operator()(const vkb::DescriptorSetLayout &descriptor_set_layout) const
+        template <typename T>
+        void key_param(ResourceKey &key, const T &value)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, descriptor_set_layout.get_handle());
-
-            return result;
+            key.write(value);
         }
-    };
 
-    template <>
-    struct hash<vkb::DescriptorPool>
-    {
-        std::size_t operator()(const vkb::DescriptorPool &descriptor_pool) const
+        void key_param(ResourceKey & /*key*/, const VkPipelineCache & /*value*/)
         {
-            std::size_t result = 0;
-
-            hash_combine(result, descriptor_pool.get_descriptor_set_layout());
-
-            return result;
         }
-    };
 
-    template <>
-    struct hash<vkb::PipelineLayout>
-    {
-        std::size_t operator()(const vkb::PipelineLayout &pipeline_layout) const
+        void key_param(ResourceKey &key, const std::string &value)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, pipeline_layout.get_handle());
-
-            return result;
+            key.write(value);
         }
-    };
 
-    template <>
-    struct hash<vkb::RenderPass>
-    {
-        std::size_t operator()(const vkb::RenderPass &render_pass) const
+        void key_param(ResourceKey &key, const std::vector<uint8_t> &value)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, render_pass.GetHandle());
-
-            return result;
+            key.write(value);
         }
-    };
 
-    template <>
-    struct hash<vkb::Attachment>
-    {
-        std::size_t operator()(const vkb::Attachment &attachment) const
+        void key_param(ResourceKey &key, const std::vector<uint32_t> &value)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkFormat>>(attachment.format));
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkSampleCountFlagBits>>(attachment.samples));
-            vkb::hash_combine(result, attachment.usage);
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkImageLayout>>(attachment.initial_layout));
-
-            return result;
+            key.write(static_cast<uint64_t>(value.size()));
+            key.write_bytes(value.data(), value.size() * sizeof(uint32_t));
         }
-    };
 
-    template <>
-    struct hash<vkb::LoadStoreInfo>
-    {
-        std::size_t operator()(const vkb::LoadStoreInfo &load_store_info) const
+        void key_param(ResourceKey &key, const ShaderSource &shader_source)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkAttachmentLoadOp>>(load_store_info.load_op));
-            vkb::hash_combine(
-                result, static_cast<std::underlying_type_t<VkAttachmentStoreOp>>(load_store_info.store_op));
-
-            return result;
+            key.write(shader_source.get_filename());
+            key.write(static_cast<uint64_t>(shader_source.get_id()));
         }
-    };
 
-    template <>
-    struct hash<vkb::SubpassInfo>
-    {
-        std::size_t operator()(const vkb::SubpassInfo &subpass_info) const
+        void key_param(ResourceKey &key, const ShaderVariant &shader_variant)
         {
-            std::size_t result = 0;
+            key.write(shader_variant.get_preamble());
 
-            for (uint32_t output_attachment : subpass_info.output_attachments)
+            key.write(static_cast<uint64_t>(shader_variant.get_processes().size()));
+            for (auto &process : shader_variant.get_processes())
             {
-                vkb::hash_combine(result, output_attachment);
+                key.write(process);
             }
 
-            for (uint32_t input_attachment : subpass_info.input_attachments)
-            {
-                vkb::hash_combine(result, input_attachment);
-            }
+            // Unordered, sort so equal variants pack the same way
+            std::vector<std::pair<std::string, size_t>> runtime_array_sizes{
+                shader_variant.get_runtime_array_sizes().begin(), shader_variant.get_runtime_array_sizes().end()};
+            std::sort(runtime_array_sizes.begin(), runtime_array_sizes.end());
 
-            for (uint32_t resolve_attachment : subpass_info.color_resolve_attachments)
+            key.write(static_cast<uint64_t>(runtime_array_sizes.size()));
+            for (auto &runtime_array_size : runtime_array_sizes)
             {
-                vkb::hash_combine(result, resolve_attachment);
+                key.write(runtime_array_size.first);
+                key.write(static_cast<uint64_t>(runtime_array_size.second));
             }
-
-            vkb::hash_combine(result, subpass_info.disable_depth_stencil_attachment);
-            vkb::hash_combine(result, subpass_info.depth_stencil_resolve_attachment);
-            vkb::hash_combine(result, subpass_info.depth_stencil_resolve_mode);
-
-            return result;
         }
-    };
 
-    template <>
-    struct hash<vkb::SpecializationConstantState>
-    {
-        std::size_t operator()(const vkb::SpecializationConstantState &specialization_constant_state) const
+        void key_param(ResourceKey &key, const std::vector<ShaderModule *> &shader_modules)
         {
-            std::size_t result = 0;
-
-            for (auto constants : specialization_constant_state.get_specialization_constant_state())
+            // Shader modules are unique in the cache, their address identifies them
+            key.write(static_cast<uint64_t>(shader_modules.size()));
+            for (auto shader_module : shader_modules)
             {
-                vkb::hash_combine(result, constants.first);
-                for (const auto data : constants.second)
-                {
-                    vkb::hash_combine(result, data);
-                }
+                key.write(shader_module);
             }
-
-            return result;
         }
-    };
 
-    template <>
-    struct hash<vkb::ShaderResource>
-    {
-        std::size_t operator()(const vkb::ShaderResource &shader_resource) const
+        void key_param(ResourceKey &key, const std::vector<ShaderResource> &shader_resources)
         {
-            std::size_t result = 0;
-
-            if (shader_resource.type == vkb::ShaderResourceType::Input ||
-                shader_resource.type == vkb::ShaderResourceType::Output ||
-                shader_resource.type == vkb::ShaderResourceType::PushConstant ||
-                shader_resource.type == vkb::ShaderResourceType::SpecializationConstant)
+            key.write(static_cast<uint64_t>(shader_resources.size()));
+            for (auto &resource : shader_resources)
             {
-                return result;
-            }
-
-            vkb::hash_combine(result, shader_resource.set);
-            vkb::hash_combine(result, shader_resource.binding);
-            vkb::hash_combine(
-                result, static_cast<std::underlying_type_t<vkb::ShaderResourceType>>(shader_resource.type));
-            hash_combine(result, shader_resource.mode);
+                key.write(resource.type);
 
-            return result;
-        }
-    };
-
-    template <>
-    struct hash<VkDescriptorBufferInfo>
-    {
-        std::size_t operator()(const VkDescriptorBufferInfo &descriptor_buffer_info) const
-        {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, descriptor_buffer_info.buffer);
-            vkb::hash_combine(result, descriptor_buffer_info.range);
-            vkb::hash_combine(result, descriptor_buffer_info.offset);
-
-            return result;
-        }
-    };
-
-    template <>
-    struct hash<VkDescriptorImageInfo>
-    {
-        std::size_t operator()(const VkDescriptorImageInfo &descriptor_image_info) const
-        {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, descriptor_image_info.imageView);
-            vkb::hash_combine(
-                result, static_cast<std::underlying_type_t<VkImageLayout>>(descriptor_image_info.imageLayout));
-            vkb::hash_combine(result, descriptor_image_info.sampler);
-
-            return result;
-        }
-    };
-
-    template <>
-    struct hash<VkWriteDescriptorSet>
-    {
-        std::size_t operator()(const VkWriteDescriptorSet &write_descriptor_set) const
-        {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, write_descriptor_set.dstSet);
-            vkb::hash_combine(result, write_descriptor_set.dstBinding);
-            vkb::hash_combine(result, write_descriptor_set.dstArrayElement);
-            vkb::hash_combine(result, write_descriptor_set.descriptorCount);
-            vkb::hash_combine(result, write_descriptor_set.descriptorType);
-
-            switch (write_descriptor_set.descriptorType)
-            {
-            case VK_DESCRIPTOR_TYPE_SAMPLER:
-            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-                for (uint32_t i = 0; i < write_descriptor_set.descriptorCount; i++)
+                // Only descriptor resources affect a set layout
+                if (resource.type == ShaderResourceType::Input ||
+                    resource.type == ShaderResourceType::Output ||
+                    resource.type == ShaderResourceType::PushConstant ||
+                    resource.type == ShaderResourceType::SpecializationConstant)
                 {
-                    vkb::hash_combine(result, write_descriptor_set.pImageInfo[i]);
+                    continue;
                 }
-                break;
 
-            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-                for (uint32_t i = 0; i < write_descriptor_set.descriptorCount; i++)
-                {
-                    vkb::hash_combine(result, write_descriptor_set.pTexelBufferView[i]);
-                }
-                break;
-
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-                for (uint32_t i = 0; i < write_descriptor_set.descriptorCount; i++)
-                {
-                    vkb::hash_combine(result, write_descriptor_set.pBufferInfo[i]);
-                }
-                break;
-
-            default:
-                // Not implemented
-                break;
+                key.write(resource.set);
+                key.write(resource.binding);
+                key.write(resource.mode);
+                key.write(resource.stages);
+                key.write(resource.array_size);
             }
-
-            return result;
         }
-    };
 
-    template <>
-    struct hash<VkVertexInputAttributeDescription>
-    {
-        std::size_t operator()(const VkVertexInputAttributeDescription &vertex_attrib) const
+        void key_param(ResourceKey &key, const DescriptorSetLayout &descriptor_set_layout)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, vertex_attrib.binding);
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkFormat>>(vertex_attrib.format));
-            vkb::hash_combine(result, vertex_attrib.location);
-            vkb::hash_combine(result, vertex_attrib.offset);
-
-            return result;
+            key.write(descriptor_set_layout.get_handle());
         }
-    };
 
-    template <>
-    struct hash<VkVertexInputBindingDescription>
-    {
-        std::size_t operator()(const VkVertexInputBindingDescription &vertex_binding) const
+        void key_param(ResourceKey &key, const DescriptorPool &descriptor_pool)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, vertex_binding.binding);
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkVertexInputRate>>(vertex_binding.inputRate));
-            vkb::hash_combine(result, vertex_binding.stride);
-
-            return result;
+            key.write(&descriptor_pool);
         }
-    };
 
-    template <>
-    struct hash<vkb::StencilOpState>
-    {
-        std::size_t operator()(const vkb::StencilOpState &stencil) const
+        void key_param(ResourceKey &key, const RenderPass &render_pass)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkCompareOp>>(stencil.compare_op));
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkStencilOp>>(stencil.depth_fail_op));
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkStencilOp>>(stencil.fail_op));
-            vkb::hash_combine(result, static_cast<std::underlying_type_t<VkStencilOp>>(stencil.pass_op));
-
-            return result;
+            key.write(render_pass.GetHandle());
         }
-    };
 
-    template <>
-    struct hash<VkExtent2D>
-    {
-        size_t operator()(const VkExtent2D &extent) const
+        void key_param(ResourceKey &key, const std::vector<Attachment> &attachments)
         {
-            size_t result = 0;
-
-            vkb::hash_combine(result, extent.width);
-            vkb::hash_combine(result, extent.height);
-
-            return result;
+            key.write(static_cast<uint64_t>(attachments.size()));
+            for (auto &attachment : attachments)
+            {
+                key.write(attachment.format);
+                key.write(attachment.samples);
+                key.write(attachment.usage);
+                key.write(attachment.initial_layout);
+            }
         }
-    };
 
-    template <>
-    struct hash<VkOffset2D>
-    {
-        size_t operator()(const VkOffset2D &offset) const
+        void key_param(ResourceKey &key, const std::vector<LoadStoreInfo> &load_store_infos)
         {
-            size_t result = 0;
-
-            vkb::hash_combine(result, offset.x);
-            vkb::hash_combine(result, offset.y);
-
-            return result;
+            key.write(static_cast<uint64_t>(load_store_infos.size()));
+            for (auto &load_store_info : load_store_infos)
+            {
+                key.write(load_store_info.load_op);
+                key.write(load_store_info.store_op);
+            }
         }
-    };
 
-    template <>
-    struct hash<VkRect2D>
-    {
-        size_t operator()(const VkRect2D &rect) const
+        void key_param(ResourceKey &key, const std::vector<SubpassInfo> &subpasses)
         {
-            size_t result = 0;
-
-            vkb::hash_combine(result, rect.extent);
-            vkb::hash_combine(result, rect.offset);
-
-            return result;
+            key.write(static_cast<uint64_t>(subpasses.size()));
+            for (auto &subpass : subpasses)
+            {
+                key_param(key, subpass.input_attachments);
+                key_param(key, subpass.output_attachments);
+                key_param(key, subpass.color_resolve_attachments);
+                key.write(subpass.disable_depth_stencil_attachment);
+                key.write(subpass.depth_stencil_resolve_attachment);
+                key.write(subpass.depth_stencil_resolve_mode);
+            }
         }
-    };
 
-    template <>
-    struct hash<VkViewport>
-    {
-        size_t operator()(const VkViewport &viewport) const
+        void key_param(ResourceKey &key, const BindingMap<VkDescriptorBufferInfo> &buffer_infos)
         {
-            size_t result = 0;
-
-            vkb::hash_combine(result, viewport.width);
-            vkb::hash_combine(result, viewport.height);
-            vkb::hash_combine(result, viewport.maxDepth);
-            vkb::hash_combine(result, viewport.minDepth);
-            vkb::hash_combine(result, viewport.x);
-            vkb::hash_combine(result, viewport.y);
+            key.write(static_cast<uint64_t>(buffer_infos.size()));
+            for (auto &binding_set : buffer_infos)
+            {
+                key.write(binding_set.first);
+                key.write(static_cast<uint64_t>(binding_set.second.size()));
 
-            return result;
+                for (auto &binding_element : binding_set.second)
+                {
+                    key.write(binding_element.first);
+                    key.write(binding_element.second.buffer);
+                    key.write(binding_element.second.offset);
+                    key.write(binding_element.second.range);
+                }
+            }
         }
-    };
 
-    template <>
-    struct hash<vkb::ColorBlendAttachmentState>
-    {
-        std::size_t operator()(const vkb::ColorBlendAttachmentState &color_blend_attachment) const
+        void key_param(ResourceKey &key, const BindingMap<VkDescriptorImageInfo> &image_infos)
         {
-            std::size_t result = 0;
-
-            vkb::hash_combine(
-                result, static_cast<std::underlying_type_t<VkBlendOp>>(color_blend_attachment.alpha_blend_op));
-            vkb::hash_combine(result, color_blend_attachment.blend_enable);
-            vkb::hash_combine(
-                result, static_cast<std::underlying_type_t<VkBlendOp>>(color_blend_attachment.color_blend_op));
-            vkb::hash_combine(result, color_blend_attachment.color_write_mask);
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkBlendFactor>>(color_blend_attachment.dst_alpha_blend_factor));
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkBlendFactor>>(color_blend_attachment.dst_color_blend_factor));
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkBlendFactor>>(color_blend_attachment.src_alpha_blend_factor));
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkBlendFactor>>(color_blend_attachment.src_color_blend_factor));
-
-            return result;
+            key.write(static_cast<uint64_t>(image_infos.size()));
+            for (auto &binding_set : image_infos)
+            {
+                key.write(binding_set.first);
+                key.write(static_cast<uint64_t>(binding_set.second.size()));
+
+                for (auto &binding_element : binding_set.second)
+                {
+                    key.write(binding_element.first);
+                    key.write(binding_element.second.sampler);
+                    key.write(binding_element.second.imageView);
+                    key.write(binding_element.second.imageLayout);
+                }
+            }
         }
-    };
 
-    template <>
-    struct hash<vkb::RenderTarget>
-    {
-        std::size_t operator()(const vkb::RenderTarget &render_target) const
+        void key_param(ResourceKey &key, const RenderTarget &render_target)
         {
-            std::size_t result = 0;
-
+            key.write(static_cast<uint64_t>(render_target.get_views().size()));
             for (auto &view : render_target.get_views())
             {
-                vkb::hash_combine(result, view.GetHandle());
-                vkb::hash_combine(result, view.get_image().GetHandle());
+                key.write(view.GetHandle());
+                key.write(view.get_image().GetHandle());
             }
-
-            return result;
         }
-    };
 
-    template <>
-    struct hash<vkb::PipelineState>
-    {
-        std::size_t operator()(const vkb::PipelineState &pipeline_state) const
+        void key_param(ResourceKey &key, const StencilOpState &stencil)
         {
-            std::size_t result = 0;
+            key.write(stencil.fail_op);
+            key.write(stencil.pass_op);
+            key.write(stencil.depth_fail_op);
+            key.write(stencil.compare_op);
+        }
 
-            vkb::hash_combine(result, pipeline_state.get_pipeline_layout().get_handle());
+        void key_param(ResourceKey &key, const PipelineState &pipeline_state)
+        {
+            key.write(pipeline_state.get_pipeline_layout().get_handle());
 
             // For graphics only
-            if (auto render_pass = pipeline_state.get_render_pass())
-            {
-                vkb::hash_combine(result, render_pass->GetHandle());
-            }
-
-            hash_combine(result, pipeline_state.get_specialization_constant_state());
-
-            vkb::hash_combine(result, pipeline_state.get_subpass_index());
+            auto render_pass = pipeline_state.get_render_pass();
+            key.write(render_pass ? render_pass->GetHandle() : VK_NULL_HANDLE);
+            key.write(pipeline_state.get_subpass_index());
 
-            for (auto shader_module : pipeline_state.get_pipeline_layout().get_shader_modules())
+            auto &specialization_constants = pipeline_state.get_specialization_constant_state().get_specialization_constant_state();
+            key.write(static_cast<uint64_t>(specialization_constants.size()));
+            for (auto &constant : specialization_constants)
             {
-                vkb::hash_combine(result, shader_module->get_id());
+                key.write(constant.first);
+                key.write(constant.second);
             }
 
             // VkPipelineVertexInputStateCreateInfo
-            for (auto &attribute : pipeline_state.get_vertex_input_state().attributes)
+            auto &vertex_input = pipeline_state.get_vertex_input_state();
+            key.write(static_cast<uint64_t>(vertex_input.bindings.size()));
+            for (auto &binding : vertex_input.bindings)
             {
-                vkb::hash_combine(result, attribute);
+                key.write(binding.binding);
+                key.write(binding.stride);
+                key.write(binding.inputRate);
             }
-
-            for (auto &binding : pipeline_state.get_vertex_input_state().bindings)
+            key.write(static_cast<uint64_t>(vertex_input.attributes.size()));
+            for (auto &attribute : vertex_input.attributes)
             {
-                vkb::hash_combine(result, binding);
+                key.write(attribute.location);
+                key.write(attribute.binding);
+                key.write(attribute.format);
+                key.write(attribute.offset);
             }
 
             // VkPipelineInputAssemblyStateCreateInfo
-            vkb::hash_combine(result, pipeline_state.get_input_assembly_state().primitive_restart_enable);
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkPrimitiveTopology>>(pipeline_state.get_input_assembly_state().topology));
+            key.write(pipeline_state.get_input_assembly_state().topology);
+            key.write(pipeline_state.get_input_assembly_state().primitive_restart_enable);
 
             // VkPipelineViewportStateCreateInfo
-            vkb::hash_combine(result, pipeline_state.get_viewport_state().viewport_count);
-            vkb::hash_combine(result, pipeline_state.get_viewport_state().scissor_count);
+            key.write(pipeline_state.get_viewport_state().viewport_count);
+            key.write(pipeline_state.get_viewport_state().scissor_count);
 
             // VkPipelineRasterizationStateCreateInfo
-            vkb::hash_combine(result, pipeline_state.get_rasterization_state().cull_mode);
-            vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_bias_enable);
-            vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_clamp_enable);
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkFrontFace>>(pipeline_state.get_rasterization_state().front_face));
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkPolygonMode>>(pipeline_state.get_rasterization_state().polygon_mode));
-            vkb::hash_combine(result, pipeline_state.get_rasterization_state().rasterizer_discard_enable);
+            auto &rasterization = pipeline_state.get_rasterization_state();
+            key.write(rasterization.depth_clamp_enable);
+            key.write(rasterization.rasterizer_discard_enable);
+            key.write(rasterization.polygon_mode);
+            key.write(rasterization.cull_mode);
+            key.write(rasterization.front_face);
+            key.write(rasterization.depth_bias_enable);
 
             // VkPipelineMultisampleStateCreateInfo
-            vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_coverage_enable);
-            vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_one_enable);
-            vkb::hash_combine(result, pipeline_state.get_multisample_state().min_sample_shading);
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkSampleCountFlagBits>>(pipeline_state.get_multisample_state().rasterization_samples));
-            vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_shading_enable);
-            vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_mask);
+            auto &multisample = pipeline_state.get_multisample_state();
+            key.write(multisample.rasterization_samples);
+            key.write(multisample.sample_shading_enable);
+            key.write(multisample.min_sample_shading);
+            key.write(multisample.sample_mask);
+            key.write(multisample.alpha_to_coverage_enable);
+            key.write(multisample.alpha_to_one_enable);
 
             // VkPipelineDepthStencilStateCreateInfo
-            hash_combine(result, pipeline_state.get_depth_stencil_state().back);
-            vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_bounds_test_enable);
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkCompareOp>>(pipeline_state.get_depth_stencil_state().depth_compare_op));
-            vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_test_enable);
-            vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_write_enable);
-            hash_combine(result, pipeline_state.get_depth_stencil_state().front);
-            vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().stencil_test_enable);
+            auto &depth_stencil = pipeline_state.get_depth_stencil_state();
+            key.write(depth_stencil.depth_test_enable);
+            key.write(depth_stencil.depth_write_enable);
+            key.write(depth_stencil.depth_compare_op);
+            key.write(depth_stencil.depth_bounds_test_enable);
+            key.write(depth_stencil.stencil_test_enable);
+            key_param(key, depth_stencil.front);
+            key_param(key, depth_stencil.back);
 
             // VkPipelineColorBlendStateCreateInfo
-            vkb::hash_combine(
-                result,
-                static_cast<std::underlying_type_t<VkLogicOp>>(pipeline_state.get_color_blend_state().logic_op));
-            vkb::hash_combine(result, pipeline_state.get_color_blend_state().logic_op_enable);
-
-            for (auto &attachment : pipeline_state.get_color_blend_state().attachments)
-            {
-                hash_combine(result, attachment);
-            }
-
-            return result;
-        }
-    };
-} // namespace std
-
-namespace vkb
-{
-    namespace
-    {
-        template <typename T>
-        void hash_param(size_t &seed, const T &value)
-        {
-            hash_combine(seed, value);
-        }
-
-        template <>
-        void hash_param(size_t & /*seed*/, const VkPipelineCache & /*value*/)
-        {
-        }
-
-        template <>
-        void hash_param<std::vector<uint8_t>>(
-            size_t &seed,
-            const std::vector<uint8_t> &value)
-        {
-            hash_combine(seed, std::string{value.begin(), value.end()});
-        }
-
-        template <>
-        void hash_param<std::vector<Attachment>>(
-            size_t &seed,
-            const std::vector<Attachment> &value)
-        {
-            for (auto &attachment : value)
-            {
-                hash_combine(seed, attachment);
-            }
-        }
-
-        template <>
-        void hash_param<std::vector<LoadStoreInfo>>(
-            size_t &seed,
-            const std::vector<LoadStoreInfo> &value)
-        {
-            for (auto &load_store_info : value)
-            {
-                hash_combine(seed, load_store_info);
-            }
-        }
-
-        template <>
-        void hash_param<std::vector<SubpassInfo>>(
-            size_t &seed,
-            const std::vector<SubpassInfo> &value)
-        {
-            for (auto &subpass_info : value)
-            {
-                hash_combine(seed, subpass_info);
-            }
-        }
-
-        template <>
-        void hash_param<std::vector<ShaderModule *>>(
-            size_t &seed,
-            const std::vector<ShaderModule *> &value)
-        {
-            for (auto &shader_module : value)
-            {
-                hash_combine(seed, shader_module->get_id());
-            }
-        }
-
-        template <>
-        void hash_param<std::vector<ShaderResource>>(
-            size_t &seed,
-            const std::vector<ShaderResource> &value)
-        {
-            for (auto &resource : value)
+            auto &color_blend = pipeline_state.get_color_blend_state();
+            key.write(color_blend.logic_op_enable);
+            key.write(color_blend.logic_op);
+            key.write(static_cast<uint64_t>(color_blend.attachments.size()));
+            for (auto &attachment : color_blend.attachments)
             {
-                hash_combine(seed, resource);
-            }
-        }
-
-        template <>
-        void hash_param<std::map<uint32_t, std::map<uint32_t, VkDescriptorBufferInfo>>>(
-            size_t &seed,
-            const std::map<uint32_t, std::map<uint32_t, VkDescriptorBufferInfo>> &value)
-        {
-            for (auto &binding_set : value)
-            {
-                hash_combine(seed, binding_set.first);
-
-                for (auto &binding_element : binding_set.second)
-                {
-                    hash_combine(seed, binding_element.first);
-                    hash_combine(seed, binding_element.second);
-                }
-            }
-        }
-
-        template <>
-        void hash_param<std::map<uint32_t, std::map<uint32_t, VkDescriptorImageInfo>>>(
-            size_t &seed,
-            const std::map<uint32_t, std::map<uint32_t, VkDescriptorImageInfo>> &value)
-        {
-            for (auto &binding_set : value)
-            {
-                hash_combine(seed, binding_set.first);
-
-                for (auto &binding_element : binding_set.second)
-                {
-                    hash_combine(seed, binding_element.first);
-                    hash_combine(seed, binding_element.second);
-                }
+                key.write(attachment.blend_enable);
+                key.write(attachment.src_color_blend_factor);
+                key.write(attachment.dst_color_blend_factor);
+                key.write(attachment.color_blend_op);
+                key.write(attachment.src_alpha_blend_factor);
+                key.write(attachment.dst_alpha_blend_factor);
+                key.write(attachment.alpha_blend_op);
+                key.write(attachment.color_write_mask);
             }
         }
 
         template <typename T, typename... Args>
-        void hash_param(size_t &seed, const T &first_arg, const Args &...args)
+        void key_param(ResourceKey &key, const T &first_arg, const Args &...args)
         {
-            hash_param(seed, first_arg);
+            key_param(key, first_arg);
 
-            hash_param(seed, args...);
+            key_param(key, args...);
         }
 
         template <class T, class... A>
@@ -750,59 +399,58 @@ namespace vkb
         };
     } // namespace
 
+    /**
+     * @brief Looks a resource up by the key of its creation parameters, the resource is built without holding any lock
+     *        Concurrent requests of the same resource wait for the first one to build it
+     * @param defer_record A new resource is recorded by the first request without the flag, the replay builds
+     *        resources that way so only the ones requested again are recorded
+     */
     template <class T, class... A>
-    T &request_resource(VulkanDevice &device, ResourceRecord *recorder, std::unordered_map<std::size_t, T> &resources,
-                        A &...args)
+    T &request_resource(VulkanDevice &device, ResourceRecord *recorder, bool defer_record,
+                        ConcurrentResourceMap<T> &resources, A &...args)
     {
-        RecordHelper<T, A...> record_helper;
-
-        std::size_t hash{0U};
-        hash_param(hash, args...);
+        ResourceKey key;
+        key_param(key, args...);
 
-        auto res_it = resources.find(hash);
-
-        if (res_it != resources.end())
-        {
-            return res_it->second;
-        }
-
-        // If we do not have it already, create and cache it
         const char *res_type = typeid(T).name();
-        size_t res_id = resources.size();
 
-        LOG_DEBUG("Building #{} cache object ({})", res_id, res_type);
+        auto create = [&]()
+        {
+            LOG_DEBUG("Building cache object ({})", res_type);
 
-        // Only error handle in release
+            // Only error handle in release
 #ifndef DEBUG
-        try
-        {
+            try
+            {
 #endif
-            T resource(device, args...);
-
-            auto res_ins_it = resources.emplace(hash, std::move(resource));
-
-            if (!res_ins_it.second)
+                return std::make_unique<T>(device, args...);
+#ifndef DEBUG
+            }
+            catch (const std::exception &e)
             {
-                throw std::runtime_error{
-                    std::string{"Insertion error for #"} + std::to_string(res_id) + "cache object (" + res_type + ")"};
+                LOG_ERROR("Creation error for cache object ({})", res_type);
+                throw;
             }
+#endif
+        };
 
-            res_it = res_ins_it.first;
-
+        auto record = [&](T &resource)
+        {
             if (recorder)
             {
+                RecordHelper<T, A...> record_helper;
                 size_t index = record_helper.record(*recorder, args...);
-                record_helper.index(*recorder, index, res_it->second);
+                record_helper.index(*recorder, index, resource);
             }
-#ifndef DEBUG
-        }
-        catch (const std::exception &e)
-        {
-            LOG_ERROR("Creation error for #{} cache object ({})", res_id, res_type);
-            throw;
-        }
-#endif
+        };
+
+        return resources.get_or_create(key, create, record, defer_record);
+    }
 
-        return res_it->second;
+    template <class T, class... A>
+    T &request_resource(VulkanDevice &device, ResourceRecord *recorder, ConcurrentResourceMap<T> &resources,
+                        A &...args)
+    {
+        return request_resource(device, recorder, false, resources, args...);
     }
 } // namespace vkb
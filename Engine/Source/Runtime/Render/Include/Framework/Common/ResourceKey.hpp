@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Misc/Hash.hpp"
+
+namespace vkb
+{
+    /**
+     * @brief Exact identity of a cached resource
+     *        The parameters a resource is created from are packed field by field into a byte blob, variable
+     *        length parts are prefixed with their length. Two keys are equal only if their blobs are, the 64-bit
+     *        hash of the blob merely picks the bucket, so colliding hashes can never return the wrong resource.
+     *
+     *        Short keys live in an inline buffer and building one does not allocate.
+     */
+    class ResourceKey
+    {
+    public:
+        /**
+         * @brief Appends a scalar, enum or Vulkan handle
+         *        Structs are written field by field so their padding never ends up in the key
+         */
+        template <class T>
+        void write(const T &value)
+        {
+            static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                          "Write structs field by field");
+            write_bytes(&value, sizeof(T));
+        }
+
+        void write(const std::string &value)
+        {
+            write(static_cast<uint64_t>(value.size()));
+            write_bytes(value.data(), value.size());
+        }
+
+        void write(const std::vector<uint8_t> &value)
+        {
+            write(static_cast<uint64_t>(value.size()));
+            write_bytes(value.data(), value.size());
+        }
+
+        void write_bytes(const void *bytes, size_t byte_count)
+        {
+            if (byte_count == 0)
+            {
+                return;
+            }
+
+            if (heap_data.empty() && size + byte_count <= inline_capacity)
+            {
+                std::memcpy(inline_data + size, bytes, byte_count);
+            }
+            else
+            {
+                if (heap_data.empty())
+                {
+                    heap_data.assign(inline_data, inline_data + size);
+                }
+                auto source = static_cast<const uint8_t *>(bytes);
+                heap_data.insert(heap_data.end(), source, source + byte_count);
+            }
+
+            size += byte_count;
+            hash_valid = false;
+        }
+
+        /**
+         * @brief Empties the key but keeps its heap capacity, so a reused key stops allocating
+         */
+        void clear()
+        {
+            heap_data.clear();
+            size = 0;
+            hash_valid = false;
+        }
+
+        const uint8_t *data() const
+        {
+            return heap_data.empty() ? inline_data : heap_data.data();
+        }
+
+        size_t get_size() const
+        {
+            return size;
+        }
+
+        uint64_t get_hash() const
+        {
+            if (!hash_valid)
+            {
+                hash = Hash::Hash64(data(), size);
+                hash_valid = true;
+            }
+            return hash;
+        }
+
+        bool operator==(const ResourceKey &other) const
+        {
+            return size == other.size && get_hash() == other.get_hash() && std::memcmp(data(), other.data(), size) == 0;
+        }
+
+        bool operator!=(const ResourceKey &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        /// Fits the keys of everything but large pipeline and descriptor states
+        static constexpr size_t inline_capacity = 192;
+
+        uint8_t inline_data[inline_capacity];
+
+        std::vector<uint8_t> heap_data;
+
+        size_t size{0};
+
+        mutable uint64_t hash{0};
+
+        mutable bool hash_valid{false};
+    };
+
+    struct ResourceKeyHash
+    {
+        std::size_t operator()(const ResourceKey &key) const
+        {
+            return static_cast<std::size_t>(key.get_hash());
+        }
+    };
+} // namespace vkb
@@ -162,17 +162,6 @@ namespace vkb
         write(os, args...);
     }
 
-    /**
-     * @brief Helper function to combine a given hash
-     *        with a generated hash for the input param.
-     */
-    template <class T>
-    void hash_combine(size_t& seed, const T& v)
-    {
-        std::hash<T> hasher;
-        glm::detail::hash_combine(seed, hasher(v));
-    }
-
     /**
      * @brief Helper function to convert a data type
      *        to string using output stream operator.
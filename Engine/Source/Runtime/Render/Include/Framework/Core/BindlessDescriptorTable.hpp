@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Framework/Common/VkCommon.hpp"
+
+namespace vkb
+{
+    class Buffer;
+    class DescriptorPool;
+    class DescriptorSetLayout;
+    class ImageView;
+    class PhysicalDevice;
+    class Sampler;
+    class VulkanDevice;
+
+    /**
+     * @brief Index of a resource in one of the arrays of the bindless table, passed to shaders e.g. in push constants
+     */
+    struct BindlessHandle
+    {
+        static constexpr uint32_t invalid_index = ~0u;
+
+        uint32_t index{invalid_index};
+
+        bool is_valid() const
+        {
+            return index != invalid_index;
+        }
+    };
+
+    /**
+     * @brief One descriptor set of large update-after-bind arrays holding every texture, sampler and storage buffer
+     *        Shaders declare the set as
+     *
+     *            layout(set = N, binding = 0) uniform texture2D textures[];
+     *            layout(set = N, binding = 1) uniform sampler samplers[];
+     *            layout(set = N, binding = 2) buffer StorageBuffers { uint data[]; } storage_buffers[];
+     *
+     *        and index the arrays with nonuniformEXT() where the index may diverge. Pipeline layouts reflected from such
+     *        shaders use the layout of the table for set N once the table is registered with the resource cache, and
+     *        command buffers bind the set whenever a pipeline layout using it is flushed.
+     *
+     *        Released slots are reused only after frames_in_flight calls to next_frame(), so a slot is never rewritten
+     *        while a frame in flight may still read it.
+     */
+    class BindlessDescriptorTable
+    {
+    public:
+        struct Config
+        {
+            /// Above the sets 0-2 the default shaders declare, within the minimum maxBoundDescriptorSets of 4
+            uint32_t set_index{3};
+
+            uint32_t max_textures{16384};
+
+            uint32_t max_samplers{256};
+
+            uint32_t max_storage_buffers{4096};
+
+            uint32_t frames_in_flight{3};
+        };
+
+        /**
+         * @brief Requests the descriptor indexing features the table needs, before the device is created
+         *        VK_EXT_descriptor_indexing has to be added to the device extensions as well.
+         * @return True if the device supports them
+         */
+        static bool request_features(PhysicalDevice &gpu);
+
+        BindlessDescriptorTable(VulkanDevice &device, const Config &config);
+
+        BindlessDescriptorTable(VulkanDevice &device);
+
+        ~BindlessDescriptorTable();
+
+        BindlessDescriptorTable(const BindlessDescriptorTable &) = delete;
+
+        BindlessDescriptorTable(BindlessDescriptorTable &&) = delete;
+
+        BindlessDescriptorTable &operator=(const BindlessDescriptorTable &) = delete;
+
+        BindlessDescriptorTable &operator=(BindlessDescriptorTable &&) = delete;
+
+        /**
+         * @brief Writes a sampled image into a free slot of the texture array
+         * @param layout Layout the image is in when shaders sample it
+         */
+        BindlessHandle register_texture(const ImageView &image_view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        BindlessHandle register_sampler(const Sampler &sampler);
+
+        BindlessHandle register_storage_buffer(const Buffer &buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+        /**
+         * @brief Points an existing slot to another image, e.g. when a streamed texture gets its full mip chain
+         *        The slot must not be in use by frames in flight.
+         */
+        void update_texture(BindlessHandle handle, const ImageView &image_view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        void release_texture(BindlessHandle handle);
+
+        void release_sampler(BindlessHandle handle);
+
+        void release_storage_buffer(BindlessHandle handle);
+
+        /**
+         * @brief Advances the frame counter, slots released frames_in_flight frames ago become free
+         */
+        void next_frame();
+
+        uint32_t get_set_index() const;
+
+        const DescriptorSetLayout &get_layout() const;
+
+        VkDescriptorSet get_descriptor_set() const;
+
+    private:
+        enum Binding : uint32_t
+        {
+            Textures,
+            Samplers,
+            StorageBuffers,
+            BindingCount
+        };
+
+        /// Free-list of the slots of one array, released slots wait out the frames in flight before reuse
+        struct SlotAllocator
+        {
+            uint32_t capacity{0};
+
+            /// Slots below it were handed out at least once
+            uint32_t high_water_mark{0};
+
+            std::vector<uint32_t> free_slots;
+
+            /// Released slots and the frame they were released in
+            std::vector<std::pair<uint32_t, uint64_t>> retired_slots;
+        };
+
+        BindlessHandle allocate_slot(Binding binding);
+
+        void release_slot(Binding binding, BindlessHandle handle);
+
+        void write(Binding binding, uint32_t index, const VkDescriptorImageInfo *image_info, const VkDescriptorBufferInfo *buffer_info);
+
+        VulkanDevice &device;
+
+        Config config;
+
+        std::unique_ptr<DescriptorSetLayout> layout;
+
+        std::unique_ptr<DescriptorPool> pool;
+
+        VkDescriptorSet descriptor_set{VK_NULL_HANDLE};
+
+        /// Slots are registered from loading threads too, guards the slot allocators and the writes of the set
+        std::mutex mutex;
+
+        SlotAllocator slots[BindingCount];
+
+        uint64_t frame_index{0};
+    };
+} // namespace vkb
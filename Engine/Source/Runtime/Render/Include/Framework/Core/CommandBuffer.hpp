@@ -2,6 +2,7 @@
 
 #include "PipelineState.hpp"
 #include "VulkanResource.hpp"
+#include "DescriptorSetLayout.hpp"
 #include "Framework/Misc/ResourceBindingState.hpp"
 
 namespace vkb
@@ -114,6 +115,7 @@ namespace vkb
         void bind_vertex_buffers(uint32_t first_binding,
                                  std::vector<std::reference_wrapper<const vkb::Buffer>> const& buffers,
                                  std::vector<DeviceSizeType> const& offsets);
+        void bind_vertex_buffers(uint32_t first_binding, vkb::Buffer const& buffer, DeviceSizeType offset);
         void blit_image(vkb::Image const& src_img, vkb::Image const& dst_img,
                         std::vector<ImageBlitType> const& regions);
         void buffer_memory_barrier(vkb::Buffer const& buffer, DeviceSizeType offset, DeviceSizeType size,
@@ -135,19 +137,31 @@ namespace vkb
                           uint32_t first_instance);
         void draw_indexed_indirect(vkb::Buffer const& buffer, DeviceSizeType offset, uint32_t draw_count,
                                    uint32_t stride);
+        /**
+         * @brief Draws with the number of draws read from count_buffer, needs VK_KHR_draw_indirect_count
+         */
+        void draw_indexed_indirect_count(vkb::Buffer const& buffer, DeviceSizeType offset,
+                                         vkb::Buffer const& count_buffer, DeviceSizeType count_offset,
+                                         uint32_t max_draw_count, uint32_t stride);
         void end();
         void end_query(QueryPoolType const& query_pool, uint32_t query);
+        void fill_buffer(vkb::Buffer const& buffer, DeviceSizeType offset, DeviceSizeType size, uint32_t data);
         void end_render_pass();
         void execute_commands(vkb::CommandBuffer& secondary_command_buffer);
         void execute_commands(std::vector<std::shared_ptr<vkb::CommandBuffer>>& secondary_command_buffers);
         CommandBufferLevelType get_level() const;
+
+        /**
+         * @return The pool the command buffer was allocated from, its thread index selects the per-thread frame resources
+         */
+        vkb::CommandPool& get_command_pool() const;
         RenderPassType& get_render_pass(RenderTargetType const& render_target,
                                         std::vector<LoadStoreInfoType> const& load_store_infos,
                                         std::vector<std::unique_ptr<vkb::Subpass>> const& subpasses);
         void image_memory_barrier(ImageViewType const& image_view, ImageMemoryBarrierType const& memory_barrier) const;
         void image_memory_barrier(RenderTargetType& render_target, uint32_t view_index,
                                   ImageMemoryBarrierType const& memory_barrier) const;
-        void next_subpass();
+        void next_subpass(SubpassContentsType contents = VK_SUBPASS_CONTENTS_INLINE);
 
         /**
          * @brief Records byte data into the command buffer to be pushed as push constants to each draw call
@@ -224,9 +238,16 @@ namespace vkb
                                         vkb::BufferMemoryBarrier const& memory_barrier);
         void copy_buffer_impl(vkb::Buffer const& src_buffer, vkb::Buffer const& dst_buffer, VkDeviceSize size);
         void execute_commands_impl(std::vector<std::shared_ptr<vkb::CommandBuffer>>& secondary_command_buffers);
+        void bind_pipeline_impl(VkPipelineBindPoint pipeline_bind_point, VkPipeline pipeline,
+                                vkb::PipelineLayout const& pipeline_layout);
         void flush_impl(vkb::VulkanDevice& device, VkPipelineBindPoint pipeline_bind_point);
         void flush_descriptor_state_impl(VkPipelineBindPoint pipeline_bind_point);
+        void bind_descriptor_set(VkPipelineBindPoint pipeline_bind_point, vkb::PipelineLayout const& pipeline_layout,
+                                 uint32_t set, VkDescriptorSet descriptor_set,
+                                 std::vector<uint32_t> const& dynamic_offsets);
+        void reset_descriptor_set_states();
         void flush_pipeline_state_impl(vkb::VulkanDevice& device, VkPipelineBindPoint pipeline_bind_point);
+        vkb::PipelineLayout const& get_bound_pipeline_layout() const;
         vkb::RenderPass& get_render_pass_impl(vkb::VulkanDevice& device,
                                               vkb::RenderTarget const& render_target,
                                               std::vector<vkb::LoadStoreInfo> const& load_store_infos,
@@ -242,7 +263,20 @@ namespace vkb
 
         vkb::RenderPass const* current_render_pass = nullptr;
 
-        std::unordered_map<uint32_t, vkb::DescriptorSetLayout const*> descriptor_set_layout_binding_state;
+        /**
+         * @brief What the command buffer last gathered and bound for a descriptor set
+         *        The vectors keep their capacity across draws, flushing descriptors does not allocate once warm.
+         */
+        struct DescriptorSetState : vkb::GatheredDescriptors
+        {
+            VkDescriptorSet bound_handle = VK_NULL_HANDLE;
+
+            VkPipelineLayout bound_pipeline_layout = VK_NULL_HANDLE;
+
+            std::vector<uint32_t> bound_dynamic_offsets;
+        };
+
+        std::array<DescriptorSetState, vkb::ResourceBindingState::max_sets> descriptor_set_states;
 
         VkExtent2D last_framebuffer_extent = {};
 
@@ -254,6 +288,11 @@ namespace vkb
 
         vkb::PipelineState pipeline_state = {};
 
+        VkPipeline bound_pipeline = VK_NULL_HANDLE;
+
+        // Layout of the bound pipeline, differs from the one of pipeline_state while a fallback pipeline is bound
+        vkb::PipelineLayout const* bound_pipeline_layout = nullptr;
+
         vkb::ResourceBindingState resource_binding_state = {};
 
         std::vector<uint8_t> stored_push_constants = {};
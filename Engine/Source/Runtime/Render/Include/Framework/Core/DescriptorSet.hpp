@@ -25,6 +25,7 @@ namespace vkb
 {
 	class DescriptorSetLayout;
 	class DescriptorPool;
+	union DescriptorInfo;
 	class VulkanDevice;
 	/**
 	 * @brief A descriptor set handle allocated from a \ref DescriptorPool.
@@ -76,6 +77,13 @@ namespace vkb
 		 */
 		void update(const std::vector<uint32_t> &bindings_to_update = {});
 
+		/**
+		 * @brief Writes every binding at once with the update template of the layout
+		 *        Afterwards update() treats all bindings as written
+		 * @param descriptor_infos The flat DescriptorInfo array of the set, every descriptor has to be bound
+		 */
+		void update_with_template(const DescriptorInfo *descriptor_infos);
+
 		/**
 		 * @brief Applies pending write operations without updating the state
 		 */
@@ -83,6 +91,8 @@ namespace vkb
 
 		const DescriptorSetLayout &get_layout() const;
 
+		DescriptorPool &get_descriptor_pool() const;
+
 		VkDescriptorSet get_handle() const;
 
 		BindingMap<VkDescriptorBufferInfo> &get_buffer_infos();
@@ -114,6 +124,6 @@ namespace vkb
 
 		// The bindings of the write descriptors that have had vkUpdateDescriptorSets since the last call to update().
 		// Each binding number is mapped to a hash of the binding description that it will be updated to.
-		std::unordered_map<uint32_t, size_t> updated_bindings;
+		std::unordered_map<uint32_t, uint64_t> updated_bindings;
 	};
 } // namespace vkb
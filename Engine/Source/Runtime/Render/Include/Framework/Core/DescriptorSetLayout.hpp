@@ -56,6 +56,33 @@ namespace vkb
 {
     class ShaderModule;
 
+    /**
+     * @brief One descriptor of a set in the flat array a descriptor update template reads
+     *        Unbound descriptors are all zero
+     */
+    union DescriptorInfo
+    {
+        VkDescriptorBufferInfo buffer;
+
+        VkDescriptorImageInfo image;
+    };
+
+    /**
+     * @brief Where the descriptors of a binding live in the flat DescriptorInfo array of its set
+     */
+    struct DescriptorRange
+    {
+        /// Index of the first descriptor of the binding
+        uint32_t offset{0};
+
+        uint32_t count{0};
+
+        VkDescriptorType type{VK_DESCRIPTOR_TYPE_MAX_ENUM};
+
+        /// Index of the first dynamic offset of the binding, for dynamic buffer types
+        uint32_t dynamic_offset{0};
+    };
+
     /**
      * @brief Caches DescriptorSet objects for the shader's set index.
      *        Creates a DescriptorPool to allocate the DescriptorSet objects
@@ -101,7 +128,27 @@ namespace vkb
 
         const std::vector<ShaderModule *> &get_shader_modules() const;
 
+        /**
+         * @return The descriptors of binding_index in the flat DescriptorInfo array, nullptr if the binding does not exist
+         */
+        const DescriptorRange *get_descriptor_range(uint32_t binding_index) const;
+
+        /**
+         * @return Size of the flat DescriptorInfo array of a set with this layout
+         */
+        uint32_t get_descriptor_count() const;
+
+        uint32_t get_dynamic_offset_count() const;
+
+        /**
+         * @return Template writing every descriptor of a set from its flat DescriptorInfo array,
+         *         VK_NULL_HANDLE if the device does not support descriptor update templates
+         */
+        VkDescriptorUpdateTemplate get_update_template() const;
+
     private:
+        void create_update_template();
+
         VulkanDevice &device;
 
         VkDescriptorSetLayout handle{VK_NULL_HANDLE};
@@ -119,5 +166,14 @@ namespace vkb
         std::unordered_map<std::string, uint32_t> resources_lookup;
 
         std::vector<ShaderModule *> shader_modules;
+
+        /// Indexed by binding number, bindings the layout lacks have a count of 0
+        std::vector<DescriptorRange> descriptor_ranges;
+
+        uint32_t descriptor_count{0};
+
+        uint32_t dynamic_offset_count{0};
+
+        VkDescriptorUpdateTemplate update_template{VK_NULL_HANDLE};
     };
 } // namespace vkb
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Framework/Common/VkCommon.hpp"
+
+namespace vkb
+{
+    class PhysicalDevice;
+    class VulkanDevice;
+
+    /**
+     * @brief Owns a VkPipelineCache that is persisted between runs
+     *        The driver blob is wrapped in a small header with the vendor, device, driver version and pipeline cache
+     *        UUID it was created with plus a hash of the blob. Data that does not match the current device or is
+     *        truncated is dropped and the cache starts empty, drivers are not trusted to reject foreign blobs.
+     */
+    class PipelineCache
+    {
+    public:
+        /**
+         * @param data Contents written by serialize() in a previous run, may be empty
+         */
+        explicit PipelineCache(VulkanDevice &device, const std::vector<uint8_t> &data = {});
+
+        PipelineCache(const PipelineCache &) = delete;
+
+        PipelineCache(PipelineCache &&other);
+
+        ~PipelineCache();
+
+        PipelineCache &operator=(const PipelineCache &) = delete;
+
+        PipelineCache &operator=(PipelineCache &&) = delete;
+
+        VkPipelineCache get_handle() const;
+
+        /**
+         * @return Whether data was loaded into the cache when it was created
+         */
+        bool is_warm() const;
+
+        /**
+         * @return The driver blob with its header, ready to be written to disk
+         */
+        std::vector<uint8_t> serialize() const;
+
+        /**
+         * @return Whether data was written by serialize() on the same device and driver
+         */
+        static bool is_compatible(const PhysicalDevice &gpu, const std::vector<uint8_t> &data);
+
+    private:
+        VulkanDevice &device;
+
+        VkPipelineCache handle{VK_NULL_HANDLE};
+
+        bool warm{false};
+    };
+} // namespace vkb
@@ -51,6 +51,8 @@ namespace vkb
 
 		VkResult submit(const std::vector<VkSubmitInfo> &submit_infos, VkFence fence) const;
 
+		VkResult submit(const VkSubmitInfo &submit_info, VkFence fence) const;
+
 		VkResult submit(const vkb::CommandBuffer &command_buffer, VkFence fence) const;
 
 		VkResult present(const VkPresentInfoKHR &present_infos) const;
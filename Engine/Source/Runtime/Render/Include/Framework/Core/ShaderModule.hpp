@@ -23,6 +23,7 @@
 #undef None
 #endif
 
+struct GlslCompileJob;
 
 namespace vkb
 {
@@ -51,7 +52,9 @@ namespace vkb
     {
         Static,
         Dynamic,
-        UpdateAfterBind
+        UpdateAfterBind,
+        /// Partially bound update-after-bind arrays, see BindlessDescriptorTable
+        Bindless
     };
 
     /// A bitmask of qualifiers applied to a resource
@@ -150,7 +153,7 @@ namespace vkb
         void clear();
 
     private:
-        size_t id;
+        size_t id{0};
 
         std::string preamble;
 
@@ -168,6 +171,11 @@ namespace vkb
 
         ShaderSource(const std::string& filename);
 
+        /**
+         * @brief Takes the contents of filename, when the caller has read the file already
+         */
+        ShaderSource(const std::string& filename, std::string source);
+
         size_t get_id() const;
 
         const std::string& get_filename() const;
@@ -204,7 +212,7 @@ namespace vkb
 
         ShaderModule(const ShaderModule&) = delete;
 
-        ShaderModule(ShaderModule&& other);
+        ShaderModule(ShaderModule&& other) noexcept;
 
         ShaderModule& operator=(const ShaderModule&) = delete;
 
@@ -237,7 +245,23 @@ namespace vkb
          */
         void set_resource_mode(const std::string& resource_name, const ShaderResourceMode& resource_mode);
 
+        /**
+         * @brief Fills the GlslCompiler job the module would compile, so variants can be compiled ahead of time
+         * @param glsl_source The GLSL next to a .spv when the caller has read it already, null reads the file
+         * @return false when the module loads a precompiled .spv as it is and nothing is compiled
+         */
+        static bool prepare_compile_job(VkShaderStageFlagBits stage, const ShaderSource& shader_source,
+                                        const std::string& entry_point, const ShaderVariant& shader_variant,
+                                        GlslCompileJob& job, const std::string* glsl_source = nullptr);
+
     private:
+        /**
+         * @brief Loads a precompiled .spv, or compiles the GLSL with the variant preamble through GlslCompiler
+         *        A .spv is compiled from the GLSL file of the same name without the extension when the variant has defines.
+         */
+        static std::vector<uint32_t> load_spirv(VkShaderStageFlagBits stage, const ShaderSource& shader_source,
+                                                const std::string& entry_point, const ShaderVariant& shader_variant);
+
         VulkanDevice& device;
 
         /// Shader unique id
@@ -20,26 +20,38 @@ namespace vkb
         BufferAllocation &operator=(const BufferAllocation &) = default;
         BufferAllocation &operator=(BufferAllocation &&) = default;
 
-        BufferAllocation(Buffer &buffer, DeviceSizeType size, DeviceSizeType offset);
+        /**
+         * @param data Mapping of the allocation if the allocator keeps its memory mapped and flushes it itself
+         */
+        BufferAllocation(Buffer &buffer, DeviceSizeType size, DeviceSizeType offset, uint8_t *data = nullptr);
 
         bool empty() const;
         Buffer &get_buffer();
         VkDeviceSize get_offset() const;
         VkDeviceSize get_size() const;
+
+        /**
+         * @return Pointer to write the allocation through directly, nullptr if it is not mapped
+         */
+        uint8_t *get_data() const;
+
         void update(const std::vector<uint8_t> &data, uint32_t offset = 0);
         template <typename T>
         void update(const T &value, uint32_t offset = 0);
 
     private:
+        void copy(const void *data, size_t data_size, uint32_t offset);
+
         Buffer *buffer = nullptr;
         VkDeviceSize offset = 0;
         VkDeviceSize size = 0;
+        uint8_t *data = nullptr;
     };
 
     template <typename T>
     inline void BufferAllocation::update(const T &value, uint32_t offset)
     {
-        update(to_bytes(value), offset);
+        copy(&value, sizeof(T), offset);
     }
 
     class BufferBlock
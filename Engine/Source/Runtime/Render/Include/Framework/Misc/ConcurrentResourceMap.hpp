@@ -0,0 +1,290 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "Framework/Common/ResourceKey.hpp"
+
+namespace vkb
+{
+    /**
+     * @brief Map of cached resources by ResourceKey that may be requested from many threads
+     *        Keys are spread over shards with a reader/writer lock each. Lookups of existing resources only take a
+     *        shared lock, inserting a key holds the exclusive lock for the insertion alone. Resources are built
+     *        outside of any lock: the first request of a key leaves an in-flight token that later requests of the
+     *        same key wait on, requests of other keys are never blocked by a build.
+     *
+     *        Resources are heap allocated, references stay valid until the resource is erased or the map cleared.
+     *        Erasing, clearing and iterating must not run concurrently with builds.
+     */
+    template <class T>
+    class ConcurrentResourceMap
+    {
+    public:
+        ConcurrentResourceMap() = default;
+
+        ConcurrentResourceMap(const ConcurrentResourceMap &) = delete;
+
+        ConcurrentResourceMap &operator=(const ConcurrentResourceMap &) = delete;
+
+        /**
+         * @return The resource of key, nullptr when it does not exist or is still being built
+         */
+        T *find(const ResourceKey &key) const
+        {
+            auto &shard = get_shard(key);
+            std::shared_lock<std::shared_mutex> lock{shard.mutex};
+
+            auto it = shard.entries.find(key);
+            return it != shard.entries.end() ? it->second.resource.get() : nullptr;
+        }
+
+        /**
+         * @brief Returns the resource of key, building it with create() when it does not exist yet
+         *        A failed build is not cached, its exception is thrown to every request waiting on it.
+         * @param create Returns a std::unique_ptr<T>, called at most once per key at a time
+         * @param on_created Called with the new resource before any other request can see it
+         * @param defer_on_created Builds the resource without calling on_created, the first later request without
+         *        the flag calls it instead and requests of the resource wait until it returned
+         */
+        template <class Create, class OnCreated>
+        T &get_or_create(const ResourceKey &key, Create &&create, OnCreated &&on_created, bool defer_on_created = false)
+        {
+            auto &shard = get_shard(key);
+
+            {
+                std::shared_lock<std::shared_mutex> lock{shard.mutex};
+
+                auto it = shard.entries.find(key);
+                if (it != shard.entries.end() && it->second.resource)
+                {
+                    if (!defer_on_created)
+                    {
+                        call_deferred(it->second, on_created);
+                    }
+                    return *it->second.resource;
+                }
+            }
+
+            std::promise<T *> promise;
+            std::shared_future<T *> in_flight;
+            Entry *waited_entry = nullptr;
+
+            {
+                std::unique_lock<std::shared_mutex> lock{shard.mutex};
+
+                auto result = shard.entries.try_emplace(key);
+                auto &entry = result.first->second;
+
+                if (entry.resource)
+                {
+                    if (!defer_on_created)
+                    {
+                        call_deferred(entry, on_created);
+                    }
+                    return *entry.resource;
+                }
+
+                if (!result.second)
+                {
+                    in_flight = entry.in_flight;
+                    waited_entry = &entry;
+                }
+                else
+                {
+                    entry.in_flight = promise.get_future().share();
+                }
+            }
+
+            if (in_flight.valid())
+            {
+                T &resource = *in_flight.get();
+                if (!defer_on_created)
+                {
+                    // The entry of a built resource stays where it is until it is erased
+                    std::shared_lock<std::shared_mutex> lock{shard.mutex};
+                    call_deferred(*waited_entry, on_created);
+                }
+                return resource;
+            }
+
+            try
+            {
+                std::unique_ptr<T> resource = create();
+                T *built = resource.get();
+
+                if (!defer_on_created)
+                {
+                    on_created(*built);
+                }
+
+                {
+                    std::unique_lock<std::shared_mutex> lock{shard.mutex};
+
+                    auto &entry = shard.entries.at(key);
+                    entry.resource = std::move(resource);
+                    entry.in_flight = {};
+                    entry.deferred.store(defer_on_created, std::memory_order_release);
+                }
+
+                promise.set_value(built);
+                return *built;
+            }
+            catch (...)
+            {
+                {
+                    std::unique_lock<std::shared_mutex> lock{shard.mutex};
+
+                    auto it = shard.entries.find(key);
+                    if (it != shard.entries.end() && !it->second.resource)
+                    {
+                        shard.entries.erase(it);
+                    }
+                }
+
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        /**
+         * @brief Moves a built resource to another key, nothing happens if new_key is taken
+         *        The resource then stays under key, references to it remain valid either way.
+         */
+        void rekey(const ResourceKey &key, ResourceKey new_key)
+        {
+            if (key == new_key)
+            {
+                return;
+            }
+
+            auto &shard = get_shard(key);
+            auto &new_shard = get_shard(new_key);
+
+            // Both shards are locked so the new key cannot be taken between the check and the move
+            std::unique_lock<std::shared_mutex> lock{shard.mutex, std::defer_lock};
+            std::unique_lock<std::shared_mutex> new_lock{new_shard.mutex, std::defer_lock};
+            if (&shard == &new_shard)
+            {
+                lock.lock();
+            }
+            else
+            {
+                std::lock(lock, new_lock);
+            }
+
+            auto it = shard.entries.find(key);
+            if (it == shard.entries.end() || !it->second.resource || new_shard.entries.count(new_key) != 0)
+            {
+                return;
+            }
+
+            // The insertion may rehash the shard of key, the old entry is reached through its node instead of it
+            auto &old_entry = it->second;
+            auto &entry = new_shard.entries[std::move(new_key)];
+            entry.resource = std::move(old_entry.resource);
+            entry.deferred.store(old_entry.deferred.load(std::memory_order_acquire), std::memory_order_release);
+
+            shard.entries.erase(key);
+        }
+
+        /**
+         * @brief Calls func(key, resource) for every built resource
+         */
+        template <class Func>
+        void for_each(Func &&func)
+        {
+            for (auto &shard : shards)
+            {
+                std::shared_lock<std::shared_mutex> lock{shard.mutex};
+
+                for (auto &key_entry : shard.entries)
+                {
+                    if (key_entry.second.resource)
+                    {
+                        func(key_entry.first, *key_entry.second.resource);
+                    }
+                }
+            }
+        }
+
+        std::size_t size() const
+        {
+            std::size_t count = 0;
+            for (auto &shard : shards)
+            {
+                std::shared_lock<std::shared_mutex> lock{shard.mutex};
+                count += shard.entries.size();
+            }
+            return count;
+        }
+
+        void clear()
+        {
+            for (auto &shard : shards)
+            {
+                std::unique_lock<std::shared_mutex> lock{shard.mutex};
+                shard.entries.clear();
+            }
+        }
+
+    private:
+        static constexpr std::size_t shard_count = 32;
+
+        struct Entry
+        {
+            std::unique_ptr<T> resource;
+
+            /// Valid while the resource is being built
+            std::shared_future<T *> in_flight;
+
+            /// Set when the resource was built with defer_on_created and on_created has not been called yet
+            std::atomic<bool> deferred{false};
+
+            std::once_flag deferred_once;
+        };
+
+        /**
+         * @brief Calls the deferred on_created of a built resource once, a shared lock of its shard is held
+         */
+        template <class OnCreated>
+        static void call_deferred(Entry &entry, OnCreated &on_created)
+        {
+            if (entry.deferred.load(std::memory_order_acquire))
+            {
+                std::call_once(entry.deferred_once, [&]()
+                {
+                    on_created(*entry.resource);
+                    entry.deferred.store(false, std::memory_order_release);
+                });
+            }
+        }
+
+        /// Padded to a cache line so the locks of neighbouring shards do not share one
+        struct alignas(64) Shard
+        {
+            mutable std::shared_mutex mutex;
+
+            std::unordered_map<ResourceKey, Entry, ResourceKeyHash> entries;
+        };
+
+        Shard &get_shard(const ResourceKey &key)
+        {
+            // The low bits pick the bucket inside the shard, the high bits pick the shard
+            return shards[(key.get_hash() >> 32) % shard_count];
+        }
+
+        const Shard &get_shard(const ResourceKey &key) const
+        {
+            return shards[(key.get_hash() >> 32) % shard_count];
+        }
+
+        std::array<Shard, shard_count> shards;
+    };
+} // namespace vkb
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <volk.h>
+
+class ProfileTrack;
+
+namespace vkb
+{
+    class CommandBuffer;
+    class QueryPool;
+    class VulkanDevice;
+
+    /**
+     * @brief Measures GPU zones with timestamp queries and reports them to the Profiler on a "GPU" track
+     *        Every render frame has its own query pool. Its results are read when the frame begins again, after its
+     *        fence was waited, so reading them never stalls. With VK_EXT_calibrated_timestamps the GPU clock is mapped
+     *        onto Profiler::Now(), otherwise the first zone of a frame is placed at the CPU time the frame began.
+     */
+    class GpuProfiler
+    {
+    public:
+        GpuProfiler(VulkanDevice &device, uint32_t frame_count, uint32_t max_zones_per_frame = 256);
+
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler &) = delete;
+
+        GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+        /**
+         * @return false when the graphics queue has no timestamps, every call does nothing then
+         */
+        bool is_supported() const;
+
+        /**
+         * @brief Reports the zones frame_index recorded when it was last used and resets its queries
+         *        Recorded outside of a render pass, before the zones of the frame.
+         */
+        void begin_frame(CommandBuffer &command_buffer, uint32_t frame_index);
+
+        /**
+         * @param name String literal or a name interned with Profiler::Intern
+         */
+        void begin_zone(CommandBuffer &command_buffer, const char *name);
+
+        void end_zone(CommandBuffer &command_buffer);
+
+    private:
+        struct Zone
+        {
+            const char *name;
+
+            /// The zone begins at query and ends at query + 1
+            uint32_t query;
+
+            uint16_t depth;
+        };
+
+        struct FrameQueries
+        {
+            std::unique_ptr<QueryPool> query_pool;
+
+            std::vector<Zone> zones;
+
+            /// Profiler::Now() when the frame began
+            uint64_t cpu_time{0};
+        };
+
+        void read_back(FrameQueries &frame);
+
+        void calibrate();
+
+        VulkanDevice &device;
+
+        uint32_t max_zones;
+
+        /// Nanoseconds per timestamp tick
+        double timestamp_period{0.0};
+
+        uint64_t timestamp_mask{0};
+
+        bool calibrated_timestamps{false};
+
+        /// Profiler::Now() minus the device time in nanoseconds, measured by calibrate()
+        int64_t clock_offset{0};
+
+        uint64_t last_calibration{0};
+
+        std::vector<FrameQueries> frames;
+
+        FrameQueries *current_frame{nullptr};
+
+        /// Indices of the zones of current_frame begun and not ended yet
+        std::vector<uint32_t> open_zones;
+
+        /// Timestamp and availability of every query, reused by read_back()
+        std::vector<uint64_t> results;
+
+        ProfileTrack *track{nullptr};
+    };
+
+    /**
+     * @brief GPU zone of the enclosing scope, does nothing without a profiler
+     */
+    class ScopedGpuZone
+    {
+    public:
+        ScopedGpuZone(GpuProfiler *profiler, CommandBuffer &command_buffer, const char *name);
+
+        ~ScopedGpuZone();
+
+        ScopedGpuZone(const ScopedGpuZone &) = delete;
+
+        ScopedGpuZone &operator=(const ScopedGpuZone &) = delete;
+
+    private:
+        GpuProfiler *profiler;
+
+        CommandBuffer &command_buffer;
+    };
+} // namespace vkb
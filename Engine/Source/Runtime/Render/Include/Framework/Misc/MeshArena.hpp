@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Rendering/DrawCulling.hpp"
+
+namespace vkb
+{
+    class VulkanDevice;
+
+    /**
+     * @brief Vertices and indices of many meshes in one vertex buffer and one index buffer
+     *        Meshes are addressed by index, so a whole scene is drawn with a single set of vertex and index buffer
+     *        binds and the draws can be generated on the GPU from the mesh table.
+     */
+    class MeshArena
+    {
+    public:
+        /**
+         * @param vertex_stride Size of one vertex, the same for every mesh
+         * @param max_vertices Capacity of the vertex buffer in vertices
+         * @param max_indices Capacity of the index buffer in 32-bit indices
+         */
+        MeshArena(VulkanDevice &device, uint32_t vertex_stride, uint32_t max_vertices, uint32_t max_indices, uint32_t max_meshes = 4096);
+
+        MeshArena(const MeshArena &) = delete;
+
+        MeshArena(MeshArena &&) = delete;
+
+        MeshArena &operator=(const MeshArena &) = delete;
+
+        MeshArena &operator=(MeshArena &&) = delete;
+
+        /**
+         * @brief Copies a mesh into the arena, throws when the arena is full
+         * @param vertex_data vertex_count vertices of vertex_stride bytes
+         * @param indices Indices relative to the first vertex of the mesh
+         * @param bounding_sphere Bounds in mesh space, center in xyz and radius in w
+         * @return Index of the mesh for GpuInstance::mesh
+         */
+        uint32_t add_mesh(const void *vertex_data, uint32_t vertex_count, const std::vector<uint32_t> &indices, const glm::vec4 &bounding_sphere);
+
+        /**
+         * @return A sphere centered on the bounding box of the positions that encloses all of them
+         */
+        static glm::vec4 compute_bounding_sphere(const std::vector<glm::vec3> &positions);
+
+        uint32_t get_vertex_stride() const;
+
+        const Buffer &get_vertex_buffer() const;
+
+        const Buffer &get_index_buffer() const;
+
+        /**
+         * @return Storage buffer with a GpuMesh per mesh
+         */
+        const Buffer &get_mesh_buffer() const;
+
+        const std::vector<GpuMesh> &get_meshes() const;
+
+    private:
+        uint32_t vertex_stride;
+
+        uint32_t max_vertices;
+
+        uint32_t max_indices;
+
+        uint32_t max_meshes;
+
+        uint32_t vertex_count{0};
+
+        uint32_t index_count{0};
+
+        std::unique_ptr<Buffer> vertex_buffer;
+
+        std::unique_ptr<Buffer> index_buffer;
+
+        std::unique_ptr<Buffer> mesh_buffer;
+
+        std::vector<GpuMesh> meshes;
+    };
+} // namespace vkb
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Framework/Common/ResourceKey.hpp"
+#include "Framework/Core/PipelineState.hpp"
+#include "SubSystems/JobSystem.hpp"
+
+namespace vkb
+{
+    class GraphicsPipeline;
+    class PipelineLayout;
+    class ResourceCache;
+
+    /**
+     * @brief Compiles graphics pipelines on the JobSystem workers instead of in the middle of command recording
+     *        The first request of a pipeline state queues its compilation and hands out a future. Until the
+     *        future is ready the recording thread can bind the pipeline of a registered fallback layout, without
+     *        one the draw compiles the pipeline itself. Compiled pipelines end up in the ResourceCache and are recorded like any other.
+     */
+    class PipelineCompiler
+    {
+    public:
+        struct FrameStats
+        {
+            /// Compilations queued or running at the end of the frame
+            uint32_t pending{0};
+
+            /// Compilations queued during the frame
+            uint32_t queued{0};
+
+            /// Compilations finished during the frame
+            uint32_t completed{0};
+
+            /// Draws that used a fallback pipeline
+            uint32_t fallback_draws{0};
+
+            /// Draws that compiled their pipeline on the recording thread because no fallback was ready
+            uint32_t waited_draws{0};
+        };
+
+        /**
+         * @param max_concurrency Compilations running at the same time, the other workers stay free for frame work
+         */
+        PipelineCompiler(ResourceCache &resource_cache, uint32_t max_concurrency);
+
+        ~PipelineCompiler();
+
+        PipelineCompiler(const PipelineCompiler &) = delete;
+
+        PipelineCompiler &operator=(const PipelineCompiler &) = delete;
+
+        /**
+         * @brief Queues the compilation of a pipeline state unless it is compiled or queued already
+         * @param pipeline_state State with its pipeline layout and render pass set
+         * @return Ready once the pipeline exists, holds the exception of a failed compilation
+         */
+        std::shared_future<GraphicsPipeline *> request_graphics_pipeline(const PipelineState &pipeline_state);
+
+        /**
+         * @brief Non blocking variant for command recording
+         * @return The pipeline when it is compiled, nullptr while it is pending
+         */
+        GraphicsPipeline *get_graphics_pipeline(const PipelineState &pipeline_state);
+
+        /**
+         * @brief Draws with pipeline_layout use fallback_layout while their pipeline compiles
+         *        The fallback layout must be compatible with the descriptor sets and vertex input of the draw,
+         *        e.g. the generic variant of the same material shaders.
+         */
+        void set_fallback(const PipelineLayout &pipeline_layout, PipelineLayout &fallback_layout);
+
+        /**
+         * @return The fallback layout registered for pipeline_layout, nullptr if there is none
+         */
+        PipelineLayout *get_fallback(const PipelineLayout &pipeline_layout) const;
+
+        void record_fallback_draw();
+
+        void record_waited_draw();
+
+        /**
+         * @brief Closes the statistics of the current frame, call once per frame
+         * @return The statistics of the frame that ended
+         */
+        FrameStats next_frame();
+
+        const FrameStats &get_last_frame_stats() const;
+
+        /**
+         * @brief Blocks until every queued compilation has finished
+         */
+        void wait_idle();
+
+        /**
+         * @brief Waits for queued compilations and forgets every pipeline, call before the cache drops its pipelines
+         */
+        void clear();
+
+    private:
+        struct Job
+        {
+            PipelineState pipeline_state;
+
+            std::promise<GraphicsPipeline *> promise;
+        };
+
+        /**
+         * @brief Compiles queued pipelines until the queue is empty, runs as a job
+         */
+        void drain();
+
+        ResourceCache &resource_cache;
+
+        mutable std::shared_mutex pipelines_mutex;
+
+        std::unordered_map<ResourceKey, std::shared_future<GraphicsPipeline *>, ResourceKeyHash> pipelines;
+
+        std::unordered_map<VkPipelineLayout, PipelineLayout *> fallbacks;
+
+        std::mutex jobs_mutex;
+
+        std::deque<Job> jobs;
+
+        uint32_t max_concurrency;
+
+        /// Drain jobs started and not finished yet, at most max_concurrency
+        uint32_t draining{0};
+
+        /// Counts the drain jobs, waiting for it waits for the queue to empty
+        JobCounter drain_counter;
+
+        bool stopping{false};
+
+        std::atomic<uint32_t> compiling{0};
+
+        std::atomic<uint32_t> queued{0};
+
+        std::atomic<uint32_t> completed{0};
+
+        std::atomic<uint32_t> fallback_draws{0};
+
+        std::atomic<uint32_t> waited_draws{0};
+
+        FrameStats last_frame_stats;
+    };
+} // namespace vkb
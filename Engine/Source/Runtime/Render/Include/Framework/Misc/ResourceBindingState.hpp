@@ -1,13 +1,17 @@
 #pragma once
 
+#include <array>
+#include <vector>
+
 #include "Framework/Common/VkCommon.hpp"
+#include "Framework/Core/DescriptorSetLayout.hpp"
 
 namespace vkb
 {
     class Buffer;
     class ImageView;
     class Sampler;
-    
+
     /**
      * @brief 包含实际资源数据的结构体。
      *
@@ -15,8 +19,6 @@ namespace vkb
      */
     struct ResourceInfo
     {
-        bool dirty{false};
-
         const vkb::Buffer *buffer{nullptr};
 
         VkDeviceSize offset{0};
@@ -32,17 +34,38 @@ namespace vkb
      * @brief 资源集是一组包含由命令缓冲区绑定的资源的绑定。
      *
      * ResourceSet 与 DescriptorSet 具有一一对应的关系。
+     * Bindings and array elements are stored in fixed arrays, bound and dirty bindings are tracked in bitmasks so
+     * binding a resource never allocates.
      */
     class ResourceSet
     {
     public:
+        static constexpr uint32_t max_bindings = 32;
+
+        /// Larger arrays of resources are bound through bindless descriptor sets
+        static constexpr uint32_t max_array_elements = 8;
+
+        struct Binding
+        {
+            std::array<ResourceInfo, max_array_elements> elements;
+
+            /// Bit i is set if elements[i] holds a resource
+            uint32_t bound_elements{0};
+        };
+
         void reset();
 
         bool is_dirty() const;
 
         void clear_dirty();
 
-        void clear_dirty(uint32_t binding, uint32_t array_element);
+        /// Bit b is set if binding b holds at least one resource
+        uint32_t get_bound_bindings() const;
+
+        /// Bit b is set if binding b changed since the last clear_dirty()
+        uint32_t get_dirty_bindings() const;
+
+        const Binding &get_binding(uint32_t binding) const;
 
         // 规则 1 & 4: vkb::core::BufferC -> vkb::Buffer
         void bind_buffer(const vkb::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element);
@@ -54,13 +77,17 @@ namespace vkb
 
         void bind_input(const vkb::ImageView &image_view, uint32_t binding, uint32_t array_element);
 
-        // 规则 2: BindingMap 的模板参数已是 ResourceInfo，本身不含 Cpp/C API 类型，无需更改
-        const BindingMap<ResourceInfo> &get_resource_bindings() const;
-
     private:
-        bool dirty{false};
+        ResourceInfo &get_resource_info(uint32_t binding, uint32_t array_element);
+
+        /// Stores resource_info, a resource equal to the bound one leaves the set clean
+        void bind(const ResourceInfo &resource_info, uint32_t binding, uint32_t array_element);
+
+        uint32_t bound_bindings{0};
+
+        uint32_t dirty_bindings{0};
 
-        BindingMap<ResourceInfo> resource_bindings;
+        std::array<Binding, max_bindings> bindings;
     };
 
     /**
@@ -72,14 +99,20 @@ namespace vkb
     class ResourceBindingState
     {
     public:
+        /// The minimum maxBoundDescriptorSets every device supports
+        static constexpr uint32_t max_sets = 4;
+
         void reset();
 
-        bool is_dirty();
+        bool is_dirty() const;
 
         void clear_dirty();
 
         void clear_dirty(uint32_t set);
 
+        /// Bit s is set if resource set s changed since it was last cleared
+        uint32_t get_dirty_sets() const;
+
         // 规则 1 & 4: vkb::core::BufferC -> vkb::Buffer
         void bind_buffer(const vkb::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
 
@@ -90,11 +123,35 @@ namespace vkb
 
         void bind_input(const vkb::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
-        const std::unordered_map<uint32_t, ResourceSet> &get_resource_sets();
+        const ResourceSet &get_resource_set(uint32_t set) const;
 
     private:
-        bool dirty{false};
+        /// Marks the set as used
+        ResourceSet &use_resource_set(uint32_t set);
+
+        /// Bit s is set if resource set s was bound since the last reset()
+        uint32_t used_sets{0};
+
+        std::array<ResourceSet, max_sets> resource_sets;
+    };
+
+    /**
+     * @brief The flat DescriptorInfo array and the dynamic offsets of a set, gathered from the resources bound to it
+     *        This is the CPU half of flushing a descriptor set, the vectors keep their capacity and gathering does
+     *        not allocate once warm.
+     */
+    struct GatheredDescriptors
+    {
+        /// Layout descriptor_infos were gathered for, nullptr until the set is first gathered
+        const DescriptorSetLayout *layout{nullptr};
+
+        std::vector<DescriptorInfo> descriptor_infos;
+
+        std::vector<uint32_t> dynamic_offsets;
 
-        std::unordered_map<uint32_t, ResourceSet> resource_sets;
+        /**
+         * @brief Writes the dirty bindings of resource_set into descriptor_infos, all bound bindings when the layout changed
+         */
+        void gather(const ResourceSet &resource_set, const DescriptorSetLayout &descriptor_set_layout);
     };
-} // namespace vkb
\ No newline at end of file
+} // namespace vkb
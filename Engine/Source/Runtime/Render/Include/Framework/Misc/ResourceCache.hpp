@@ -1,9 +1,12 @@
 #pragma once
 
+#include <memory>
 #include <mutex>
 
+#include "ConcurrentResourceMap.hpp"
 #include "ResourceRecord.hpp"
 #include "ResourceReplay.hpp"
+#include "ShaderVariantUsage.hpp"
 #include "Framework/Core/PipelineLayout.hpp"
 #include "Framework/Core/DescriptorSetLayout.hpp"
 #include "Framework/Core/DescriptorPool.hpp"
@@ -15,31 +18,34 @@
 
 namespace vkb
 {
+	class BindlessDescriptorTable;
 	class ImageView;
+	class PipelineCompiler;
 	class VulkanDevice;
     /**
      * @brief Struct to hold the internal state of the Resource Cache
-     *
+     *        Every map can be looked up from any thread, a resource that is being built only blocks requests of
+     *        the same resource
      */
     struct ResourceCacheState
     {
-        std::unordered_map<std::size_t, ShaderModule> shader_modules;
+        ConcurrentResourceMap<ShaderModule> shader_modules;
 
-        std::unordered_map<std::size_t, PipelineLayout> pipeline_layouts;
+        ConcurrentResourceMap<PipelineLayout> pipeline_layouts;
 
-        std::unordered_map<std::size_t, DescriptorSetLayout> descriptor_set_layouts;
+        ConcurrentResourceMap<DescriptorSetLayout> descriptor_set_layouts;
 
-        std::unordered_map<std::size_t, DescriptorPool> descriptor_pools;
+        ConcurrentResourceMap<DescriptorPool> descriptor_pools;
 
-        std::unordered_map<std::size_t, RenderPass> render_passes;
+        ConcurrentResourceMap<RenderPass> render_passes;
 
-        std::unordered_map<std::size_t, GraphicsPipeline> graphics_pipelines;
+        ConcurrentResourceMap<GraphicsPipeline> graphics_pipelines;
 
-        std::unordered_map<std::size_t, ComputePipeline> compute_pipelines;
+        ConcurrentResourceMap<ComputePipeline> compute_pipelines;
 
-        std::unordered_map<std::size_t, DescriptorSet> descriptor_sets;
+        ConcurrentResourceMap<DescriptorSet> descriptor_sets;
 
-        std::unordered_map<std::size_t, Framebuffer> framebuffers;
+        ConcurrentResourceMap<Framebuffer> framebuffers;
     };
 
     class ResourceCache
@@ -47,6 +53,8 @@ namespace vkb
 	public:
 		ResourceCache(VulkanDevice &device);
 
+		~ResourceCache();
+
 		ResourceCache(const ResourceCache &) = delete;
 
 		ResourceCache(ResourceCache &&) = delete;
@@ -55,12 +63,49 @@ namespace vkb
 
 		ResourceCache &operator=(ResourceCache &&) = delete;
 
-		void warmup(const std::vector<uint8_t> &data);
-
+		/**
+		 * @brief Creates every resource recorded by serialize() in a previous run
+		 *        Shader modules and graphics pipelines are created on the JobSystem workers. A replayed resource is only
+		 *        recorded again when the application requests it, so the next serialize() drops what this run did not use.
+		 * @return false when the data is truncated, corrupt or from an incompatible version
+		 */
+		bool warmup(const std::vector<uint8_t> &data);
+
+		/**
+		 * @return The recorded resource stream behind a header that warmup() validates
+		 */
 		std::vector<uint8_t> serialize();
 
 		void set_pipeline_cache(VkPipelineCache pipeline_cache);
 
+		/**
+		 * @brief Compiles the graphics pipelines requested during command recording, up to thread_count at a time on the JobSystem workers
+		 *        Draws whose pipeline is still compiling use a fallback or compile it themselves, see PipelineCompiler.
+		 *        0 turns it off and pipelines are compiled on the recording thread again.
+		 */
+		void set_async_pipeline_compilation(uint32_t thread_count);
+
+		/**
+		 * @return The background pipeline compiler, nullptr when pipelines are compiled on the recording thread
+		 */
+		PipelineCompiler *get_pipeline_compiler();
+
+		/**
+		 * @brief Pipeline layouts requested afterwards use the layout of the table for its set index, and command
+		 *        buffers bind its descriptor set with them. Set it before any pipeline layout is requested.
+		 */
+		void set_bindless_table(BindlessDescriptorTable *table);
+
+		/**
+		 * @return The bindless descriptor table, nullptr when bindless resources are not used
+		 */
+		BindlessDescriptorTable *get_bindless_table() const;
+
+		/**
+		 * @return The shader variants requested so far, including the ones loaded from previous runs
+		 */
+		ShaderVariantUsage &get_variant_usage();
+
 		ShaderModule &request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant = {});
 
 		PipelineLayout &request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules);
@@ -98,30 +143,39 @@ namespace vkb
 		const ResourceCacheState &get_internal_state() const;
 
 	private:
-		VulkanDevice &device;
+		friend class ResourceReplay;
 
-		ResourceRecord recorder;
+		/**
+		 * @brief Requests of the replay, the resources are recorded by the first request of the application
+		 */
+		ShaderModule &replay_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant);
 
-		ResourceReplay replayer;
+		PipelineLayout &replay_pipeline_layout(const std::vector<ShaderModule *> &shader_modules);
 
-		VkPipelineCache pipeline_cache{VK_NULL_HANDLE};
+		RenderPass &replay_render_pass(const std::vector<Attachment> &attachments,
+									   const std::vector<LoadStoreInfo> &load_store_infos,
+									   const std::vector<SubpassInfo> &subpasses);
 
-		ResourceCacheState state;
+		GraphicsPipeline &replay_graphics_pipeline(PipelineState &pipeline_state);
 
-		std::mutex descriptor_set_mutex;
+		VulkanDevice &device;
+
+		ResourceRecord recorder;
 
-		std::mutex pipeline_layout_mutex;
+		ResourceReplay replayer;
 
-		std::mutex shader_module_mutex;
+		ShaderVariantUsage variant_usage;
 
-		std::mutex descriptor_set_layout_mutex;
+		VkPipelineCache pipeline_cache{VK_NULL_HANDLE};
 
-		std::mutex graphics_pipeline_mutex;
+		BindlessDescriptorTable *bindless_table{nullptr};
 
-		std::mutex render_pass_mutex;
+		ResourceCacheState state;
 
-		std::mutex compute_pipeline_mutex;
+		/// DescriptorPool::allocate is not thread safe, serializes the build of new descriptor sets
+		std::mutex descriptor_set_mutex;
 
-		std::mutex framebuffer_mutex;
+		/// Declared last so its workers stop before the resources they compile into are destroyed
+		std::unique_ptr<PipelineCompiler> pipeline_compiler;
 	};
 } // namespace vkb
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 //#include "Framework/Core/PipelineState.hpp"
@@ -42,6 +43,8 @@ namespace vkb
 
 	/**
 	 * @brief Writes Vulkan objects in a memory stream.
+	 *        Shader modules are recorded by file name, replaying them reads the current file.
+	 *        Every call is thread safe, resources of different types are created concurrently.
 	 */
 	class ResourceRecord
 	{
@@ -92,5 +95,7 @@ namespace vkb
 		std::unordered_map<const RenderPass *, size_t> render_pass_to_index;
 
 		std::unordered_map<const GraphicsPipeline *, size_t> graphics_pipeline_to_index;
+
+		std::mutex mutex;
 	};
 } // namespace vkb
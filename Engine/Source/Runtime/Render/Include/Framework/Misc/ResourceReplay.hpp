@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "Framework/Core/PipelineState.hpp"
 #include "Framework/Misc/ResourceRecord.hpp"
 
 namespace vkb
@@ -31,6 +32,13 @@ class ResourceReplay
   public:
 	ResourceReplay();
 
+	/**
+	 * @brief Creates every resource of the recorded stream
+	 *        Pipeline layouts and render passes are created in stream order. Shader modules are compiled on
+	 *        the JobSystem workers in batches, up to the next pipeline layout that uses them, and graphics
+	 *        pipelines only depend on those and are created on the workers once the stream is read.
+	 *        The resources are recorded in the cache's own record once the application requests them.
+	 */
 	void play(ResourceCache &resource_cache, ResourceRecord &recorder);
 
   protected:
@@ -43,6 +51,18 @@ class ResourceReplay
 	void create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream);
 
   private:
+	struct PendingShaderModule
+	{
+		VkShaderStageFlagBits stage;
+
+		ShaderSource source;
+
+		ShaderVariant variant;
+	};
+
+	/// Creates the pending shader modules in parallel and fills their slots in shader_modules
+	void create_pending_shader_modules(ResourceCache &resource_cache);
+
 	using ResourceFunc = std::function<void(ResourceCache &, std::istringstream &)>;
 
 	std::unordered_map<ResourceType, ResourceFunc> stream_resources;
@@ -54,5 +74,11 @@ class ResourceReplay
 	std::vector<const RenderPass *> render_passes;
 
 	std::vector<const GraphicsPipeline *> graphics_pipelines;
+
+	/// Shader modules read from the stream, the last ones of shader_modules until they are created
+	std::vector<PendingShaderModule> pending_shader_modules;
+
+	/// Graphics pipelines read from the stream, created once the whole stream is read
+	std::vector<PipelineState> pending_pipelines;
 };
 }        // namespace vkb
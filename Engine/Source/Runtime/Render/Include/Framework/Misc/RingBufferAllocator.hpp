@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "Framework/Misc/BufferPool.hpp"
+
+namespace vkb
+{
+    class VulkanDevice;
+
+    /**
+     * @brief Linear allocator for the per-frame buffer data of a render frame
+     *        Every usage class (uniform, storage, geometry) is one persistently mapped buffer split into a sub-ring
+     *        per recording thread, so a thread allocates by bumping its own offset without any locking.
+     *        Allocations are aligned to the strictest offset alignment of the device and hand out a pointer into
+     *        the mapping to write through directly.
+     *
+     *        A sub-ring that runs out of space spills into overflow buffers for the rest of the frame. reset()
+     *        frees those and grows the rings to the high-water mark, so the steady state never spills.
+     */
+    class RingBufferAllocator
+    {
+    public:
+        struct Stats
+        {
+            /// Bytes mapped by the rings of all usage classes
+            VkDeviceSize capacity{0};
+
+            /// Bytes allocated since the last reset
+            VkDeviceSize used{0};
+
+            /// Largest amount a single thread of a usage class allocated in one frame
+            VkDeviceSize high_water_mark{0};
+
+            /// Allocations that did not fit into their sub-ring since the last reset
+            uint32_t overflow_allocations{0};
+
+            /// Number of times a ring was recreated larger
+            uint32_t grow_count{0};
+        };
+
+        /**
+         * @param thread_count Number of sub-rings per usage class
+         * @param thread_capacity Initial size of a sub-ring in bytes
+         */
+        RingBufferAllocator(VulkanDevice &device, size_t thread_count, VkDeviceSize thread_capacity = 256 * 1024);
+
+        RingBufferAllocator(const RingBufferAllocator &) = delete;
+
+        RingBufferAllocator(RingBufferAllocator &&) = default;
+
+        RingBufferAllocator &operator=(const RingBufferAllocator &) = delete;
+
+        RingBufferAllocator &operator=(RingBufferAllocator &&) = delete;
+
+        /**
+         * @brief Allocates from the sub-ring of a thread, only that thread may allocate with thread_index
+         * @param usage Usage of the allocation, any combination supported by one usage class
+         * @return A mapped allocation valid until the next reset
+         */
+        BufferAllocation allocate(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index);
+
+        /**
+         * @brief Makes the writes of the frame visible to the device, called before the frame is submitted
+         */
+        void flush();
+
+        /**
+         * @brief Rewinds the sub-rings, the device must be done with the allocations of the frame
+         */
+        void reset();
+
+        VkDeviceSize get_alignment() const;
+
+        Stats get_stats() const;
+
+    private:
+        enum UsageClass
+        {
+            Uniform,
+            Storage,
+            Geometry,
+            UsageClassCount
+        };
+
+        /// Per-thread state, on its own cache line so recording threads don't share one
+        struct alignas(64) SubRing
+        {
+            VkDeviceSize begin{0};
+
+            VkDeviceSize offset{0};
+
+            /// Buffers allocated after the sub-ring filled up, freed on reset
+            std::vector<std::unique_ptr<Buffer>> overflow_buffers;
+
+            VkDeviceSize overflow_offset{0};
+
+            /// Bytes allocated this frame, including the overflow
+            VkDeviceSize demand{0};
+
+            uint32_t overflow_allocations{0};
+        };
+
+        struct Ring
+        {
+            VkBufferUsageFlags usage{0};
+
+            std::unique_ptr<Buffer> buffer;
+
+            uint8_t *data{nullptr};
+
+            VkDeviceSize thread_capacity{0};
+
+            VkDeviceSize high_water_mark{0};
+
+            std::vector<SubRing> sub_rings;
+        };
+
+        static UsageClass get_usage_class(VkBufferUsageFlags usage);
+
+        void create_ring(Ring &ring, VkDeviceSize thread_capacity);
+
+        BufferAllocation allocate_overflow(Ring &ring, SubRing &sub_ring, VkDeviceSize size);
+
+        VulkanDevice &device;
+
+        size_t thread_count;
+
+        VkDeviceSize alignment{16};
+
+        std::array<Ring, UsageClassCount> rings;
+
+        uint32_t grow_count{0};
+    };
+} // namespace vkb
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Framework/Core/ShaderModule.hpp"
+#include "SubSystems/Singleton.h"
+
+namespace vkb
+{
+    /**
+     * @brief Reflected resources of SPIR-V binaries, keyed by a 64-bit hash of the words
+     *        Results are kept in memory and next to the binaries in the GlslCompiler cache directory, so spirv-cross
+     *        runs once per unique binary across runs.
+     */
+    class ShaderReflectionCache : public Singleton<ShaderReflectionCache>
+    {
+        friend class Singleton<ShaderReflectionCache>;
+
+    public:
+        struct Stats
+        {
+            uint32_t reflected{0};
+
+            uint32_t memory_hits{0};
+
+            uint32_t disk_hits{0};
+        };
+
+        /**
+         * @brief Looks the binary up or reflects it with SPIRVReflection, thread safe
+         * @param spirv_hash Hash::Hash64 of the words of spirv
+         * @param variant Its runtime array sizes change the reflected sizes and are part of the key
+         * @return false when reflection fails
+         */
+        bool reflect(VkShaderStageFlagBits stage, const std::vector<uint32_t> &spirv, uint64_t spirv_hash,
+                     const ShaderVariant &variant, std::vector<ShaderResource> &resources);
+
+        Stats get_stats() const;
+
+    private:
+        ShaderReflectionCache() = default;
+
+        ~ShaderReflectionCache() = default;
+
+        std::mutex mutex;
+
+        std::unordered_map<uint64_t, std::vector<ShaderResource>> resources_by_key;
+
+        std::atomic<uint32_t> reflected{0};
+
+        std::atomic<uint32_t> memory_hits{0};
+
+        std::atomic<uint32_t> disk_hits{0};
+    };
+} // namespace vkb
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <volk.h>
+
+namespace vkb
+{
+    class ShaderSource;
+    class ShaderVariant;
+
+    /**
+     * @brief Set of the shader variants requested through the ResourceCache, kept across runs
+     *        Each entry is what ResourceRecord writes for a shader module. precompile() compiles all of them
+     *        through GlslCompiler without a device, so the modules of known content come from the SPIR-V cache.
+     */
+    class ShaderVariantUsage
+    {
+    public:
+        struct Variant
+        {
+            VkShaderStageFlagBits stage{};
+
+            std::string filename;
+
+            std::string entry_point;
+
+            std::string preamble;
+
+            std::vector<std::string> processes;
+        };
+
+        /**
+         * @brief Adds the variant if it is not in the set yet, thread safe
+         */
+        void record(VkShaderStageFlagBits stage, const ShaderSource &shader_source, const std::string &entry_point,
+                    const ShaderVariant &shader_variant);
+
+        /**
+         * @brief Adds the variants written by serialize(), the ones already recorded are kept
+         * @return false when the data is truncated, corrupt or from an incompatible version
+         */
+        bool load(const std::vector<uint8_t> &data);
+
+        std::vector<uint8_t> serialize();
+
+        std::vector<Variant> get_variants();
+
+        /**
+         * @brief Compiles every recorded variant on the JobSystem workers, the calling thread included
+         *        The files of the variants are read ahead in batches through FileLoader::ReadFilesAsync. Variants whose
+         *        source file is gone are skipped, they are dropped from the set.
+         * @return The number of variants that failed to compile
+         */
+        uint32_t precompile();
+
+    private:
+        std::mutex mutex;
+
+        std::unordered_map<uint64_t, Variant> variants;
+    };
+} // namespace vkb
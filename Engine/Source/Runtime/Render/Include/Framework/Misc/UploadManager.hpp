@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <volk.h>
+
+#include "Framework/Core/Buffer.hpp"
+
+namespace vkb
+{
+    class CommandBuffer;
+    class CommandPool;
+    class Image;
+    class Queue;
+    class VulkanDevice;
+
+    /**
+     * @brief Uploads buffer and image data without stalling the device
+     *        Data is copied into a persistently mapped staging ring and the copies are recorded for the transfer
+     *        queue, a dedicated transfer queue family is used when the device has one. Each submission is tracked
+     *        by its own fence, ring space and overflow staging buffers are released as soon as it has completed.
+     *
+     *        With a dedicated transfer family the resources are released by the transfer queue and acquired by
+     *        the graphics queue in acquire(), record that at the start of each frame. Without one the copies go
+     *        to the graphics family directly and no ownership transfer is needed.
+     *
+     *        upload_buffer and upload_image may be called from any thread. flush, acquire and finish submit to
+     *        or record for the graphics family, call them from the thread that owns the graphics queue.
+     */
+    class UploadManager
+    {
+    public:
+        /**
+         * @param ring_size Size of the staging ring, larger uploads get their own staging buffer
+         */
+        explicit UploadManager(VulkanDevice &device, VkDeviceSize ring_size = 64 * 1024 * 1024);
+
+        ~UploadManager();
+
+        UploadManager(const UploadManager &) = delete;
+
+        UploadManager &operator=(const UploadManager &) = delete;
+
+        /**
+         * @brief Copies data into a region of a device local buffer
+         *        The region must not be in use by the device until the returned future is ready
+         * @param dst_stage Stages of the graphics queue that use the buffer afterwards
+         * @param dst_access Accesses of those stages
+         * @return Ready once the data is visible to dst_stage on the graphics queue
+         */
+        std::future<void> upload_buffer(const Buffer &buffer, VkDeviceSize offset, const void *data,
+                                        VkDeviceSize size, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+
+        /**
+         * @brief Copies data into every subresource of an image named in regions, previous contents are discarded
+         * @param regions Copy regions, their buffer offsets are relative to data
+         * @param layout Layout the image is left in
+         * @return Ready once the image is in layout and visible to dst_stage on the graphics queue
+         */
+        std::future<void> upload_image(const Image &image, const void *data, VkDeviceSize size,
+                                       const std::vector<VkBufferImageCopy> &regions, VkImageLayout layout,
+                                       VkPipelineStageFlags dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                       VkAccessFlags dst_access = VK_ACCESS_SHADER_READ_BIT);
+
+        /**
+         * @brief Submits the uploads recorded since the last flush to the transfer queue
+         */
+        void flush();
+
+        /**
+         * @brief Retires completed submissions and records the ownership acquires of their resources, followed by
+         *        an event the graphics queue sets once it executed them. The futures resolve when a later acquire
+         *        or flush sees that event set, the command buffer has to be submitted to the graphics queue.
+         *        Must be recorded outside of a render pass.
+         */
+        void acquire(CommandBuffer &command_buffer);
+
+        /**
+         * @brief Flushes and blocks until every upload so far is usable on the graphics queue
+         *        Only waits for the upload work itself, intended for loading screens
+         */
+        void finish();
+
+        bool has_dedicated_transfer_queue() const;
+
+        /**
+         * @return Bytes of the staging ring in use by recorded or in flight uploads
+         */
+        VkDeviceSize get_ring_usage() const;
+
+    private:
+        /// Ownership acquire of one resource, recorded on the graphics queue
+        struct Acquire
+        {
+            VkBuffer buffer{VK_NULL_HANDLE};
+
+            VkDeviceSize offset{0};
+
+            VkDeviceSize size{0};
+
+            VkImage image{VK_NULL_HANDLE};
+
+            VkImageSubresourceRange range{};
+
+            VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+            VkPipelineStageFlags dst_stage{0};
+
+            VkAccessFlags dst_access{0};
+        };
+
+        /// One transfer submission, recycled once it has completed
+        struct Batch
+        {
+            std::unique_ptr<CommandPool> command_pool;
+
+            std::shared_ptr<CommandBuffer> command_buffer;
+
+            VkFence fence{VK_NULL_HANDLE};
+
+            /// Set by the graphics queue after the acquires of the batch
+            VkEvent event{VK_NULL_HANDLE};
+
+            /// Ring bytes consumed by the batch, including padding and wrap around
+            VkDeviceSize ring_bytes{0};
+
+            /// Ring offset after the last allocation of the batch
+            VkDeviceSize ring_end{0};
+
+            std::vector<Buffer> staging_buffers;
+
+            std::vector<Acquire> acquires;
+
+            std::vector<std::promise<void>> promises;
+        };
+
+        /**
+         * @brief Copies data to staging memory, the ring when it has room and a new buffer otherwise
+         * @return Buffer and offset the copies read from
+         */
+        std::pair<VkBuffer, VkDeviceSize> stage(Batch &batch, const void *data, VkDeviceSize size);
+
+        /**
+         * @return Whether size bytes fit in the ring, offset and consumed are set when they do
+         */
+        bool allocate_ring(VkDeviceSize size, VkDeviceSize &offset, VkDeviceSize &consumed);
+
+        Batch &get_recording_batch();
+
+        /**
+         * @brief Recycles completed batches in submission order
+         * @param wait Blocks on the oldest batch when nothing has completed yet
+         */
+        void retire(bool wait);
+
+        void submit();
+
+        void recycle(std::unique_ptr<Batch> batch);
+
+        /**
+         * @brief Records the acquires of the completed batches and the events that signal them
+         */
+        void record_acquires(CommandBuffer &command_buffer);
+
+        /**
+         * @brief Resolves the futures of the batches whose acquires the graphics queue has executed
+         */
+        void resolve_acquired();
+
+        VulkanDevice &device;
+
+        const Queue *transfer_queue{nullptr};
+
+        uint32_t transfer_family{0};
+
+        uint32_t graphics_family{0};
+
+        std::unique_ptr<Buffer> ring;
+
+        uint8_t *ring_data{nullptr};
+
+        VkDeviceSize ring_alignment{16};
+
+        VkDeviceSize ring_head{0};
+
+        VkDeviceSize ring_tail{0};
+
+        VkDeviceSize ring_used{0};
+
+        std::unique_ptr<Batch> recording;
+
+        std::deque<std::unique_ptr<Batch>> in_flight;
+
+        /// Completed batches with ownership acquires left to record
+        std::vector<std::unique_ptr<Batch>> completed;
+
+        /// Batches with recorded acquires, waiting for the graphics queue to set their event
+        std::vector<std::unique_ptr<Batch>> acquiring;
+
+        std::vector<std::unique_ptr<Batch>> free_batches;
+
+        /// Records the acquires of finish(), created on first use
+        std::unique_ptr<CommandPool> graphics_command_pool;
+
+        mutable std::mutex mutex;
+    };
+} // namespace vkb
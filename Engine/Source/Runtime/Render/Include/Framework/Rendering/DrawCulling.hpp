@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <volk.h>
+
+#include "Framework/Common/glmCommon.hpp"
+
+namespace vkb
+{
+    /// std430 layout of Mesh in Cull.comp, a range of the mesh arena and its bounds in mesh space
+    struct alignas(16) GpuMesh
+    {
+        uint32_t first_index{0};
+
+        uint32_t index_count{0};
+
+        int32_t vertex_offset{0};
+
+        uint32_t padding{0};
+
+        /// Center in xyz, radius in w
+        glm::vec4 bounding_sphere{0.0f};
+    };
+
+    /// std430 layout of Instance in Cull.comp and IndirectDraw.vert
+    struct alignas(16) GpuInstance
+    {
+        glm::mat4 model{1.0f};
+
+        uint32_t mesh{0};
+
+        uint32_t material{0};
+
+        uint32_t padding[2]{};
+    };
+
+    /// std140 layout of UboCull in Cull.comp
+    struct alignas(16) CullUniform
+    {
+        glm::mat4 view_projection{1.0f};
+
+        /// View projection the depth pyramid was rendered with
+        glm::mat4 previous_view_projection{1.0f};
+
+        /// Left, right, bottom, top and the two depth planes, normals point inside
+        glm::vec4 frustum_planes[6];
+
+        /// Size of level 0 of the depth pyramid
+        glm::vec2 pyramid_size{0.0f};
+
+        uint32_t pyramid_levels{0};
+
+        uint32_t instance_count{0};
+
+        /// Non-zero to test against the depth pyramid
+        uint32_t occlusion_enabled{0};
+
+        uint32_t padding[3]{};
+    };
+
+    /**
+     * @brief Planes of the frustum of a view projection matrix with a [0, 1] depth range, normalized
+     */
+    std::array<glm::vec4, 6> extract_frustum_planes(const glm::mat4 &view_projection);
+
+    /**
+     * @brief CPU copy of the depth pyramid DepthPyramid.comp builds, each texel holds the farthest depth below it
+     *        Depth is reversed like the scene graph cameras, 1 at the near plane and 0 at the far plane.
+     */
+    class CpuDepthPyramid
+    {
+    public:
+        /**
+         * @param depth Depth buffer, row by row
+         */
+        CpuDepthPyramid(const std::vector<float> &depth, uint32_t width, uint32_t height);
+
+        uint32_t get_level_count() const;
+
+        glm::uvec2 get_level_size(uint32_t level) const;
+
+        /// Coordinates are clamped to the level
+        float fetch(uint32_t level, int32_t x, int32_t y) const;
+
+    private:
+        std::vector<glm::uvec2> sizes;
+
+        std::vector<std::vector<float>> levels;
+    };
+
+    /**
+     * @brief Reference implementation of Cull.comp
+     *        Produces the same draw commands as the GPU, in instance order where the GPU appends them in any order,
+     *        so the culling logic can be checked and profiled without a device.
+     */
+    class CpuDrawCuller
+    {
+    public:
+        struct Stats
+        {
+            uint32_t tested{0};
+
+            uint32_t frustum_culled{0};
+
+            uint32_t occlusion_culled{0};
+
+            uint32_t drawn{0};
+        };
+
+        /**
+         * @param pyramid Depth of the previous frame, only read when occlusion is enabled in the uniform
+         * @param draws Receives one command per visible instance, with the instance index as first instance
+         * @return The number of draws written
+         */
+        uint32_t cull(const CullUniform &uniform, const std::vector<GpuMesh> &meshes, const std::vector<GpuInstance> &instances,
+                      const CpuDepthPyramid *pyramid, std::vector<VkDrawIndexedIndirectCommand> &draws);
+
+        const Stats &get_stats() const;
+
+        /**
+         * @brief Transforms a mesh space bounding sphere, the radius grows with the largest axis scale
+         */
+        static glm::vec4 transform_sphere(const glm::vec4 &sphere, const glm::mat4 &model);
+
+        static bool is_in_frustum(const CullUniform &uniform, const glm::vec4 &sphere);
+
+        /**
+         * @brief Tests the screen rectangle of the sphere in the previous frame against the depth pyramid
+         * @return false when every texel below it is nearer than the sphere
+         */
+        static bool is_unoccluded(const CullUniform &uniform, const glm::vec4 &sphere, const CpuDepthPyramid &pyramid);
+
+    private:
+        Stats stats;
+    };
+} // namespace vkb
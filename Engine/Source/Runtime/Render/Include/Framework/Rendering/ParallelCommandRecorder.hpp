@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace vkb
+{
+    class CommandBuffer;
+
+    /**
+     * @brief Records the draws of a render pass on the JobSystem workers
+     *        A draw list is split into contiguous chunks. Every chunk is recorded into a secondary command buffer
+     *        that inherits the render pass, subpass and framebuffer of the primary, and the secondaries are
+     *        executed from the primary in chunk order, so the draw order is preserved.
+     *
+     *        Chunk i is recorded by a single job and allocates from the frame resources of thread index i,
+     *        whichever worker runs it. The render frame must be prepared with at least as many threads as chunks
+     *        are wanted, a frame with fewer threads records fewer, larger chunks.
+     */
+    class ParallelCommandRecorder
+    {
+    public:
+        /**
+         * @brief Records the draws [first_draw, first_draw + draw_count) into command_buffer
+         *        Called concurrently, once per chunk
+         */
+        using RecordFunc = std::function<void(CommandBuffer &command_buffer, uint32_t first_draw, uint32_t draw_count)>;
+
+        /**
+         * @param thread_count Maximum number of chunks, recorded in parallel
+         * @param min_draws_per_chunk Smaller draw lists are split into fewer chunks, a secondary costs more than a few draws
+         */
+        explicit ParallelCommandRecorder(uint32_t thread_count, uint32_t min_draws_per_chunk = 256);
+
+        ParallelCommandRecorder(const ParallelCommandRecorder &) = delete;
+
+        ParallelCommandRecorder &operator=(const ParallelCommandRecorder &) = delete;
+
+        uint32_t get_thread_count() const;
+
+        /**
+         * @brief Records draw_count draws into secondaries and executes them from primary
+         * @param primary Command buffer inside a subpass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+         *        allocated from the thread 0 pool of a render frame
+         * @param draw_count Number of draws record_draws splits
+         * @param record_draws Records a chunk, exceptions are rethrown on the calling thread once every chunk finished
+         *        The calling thread records chunks too.
+         */
+        void record(CommandBuffer &primary, uint32_t draw_count, const RecordFunc &record_draws);
+
+    private:
+        uint32_t thread_count;
+
+        uint32_t min_draws_per_chunk;
+
+        std::vector<std::shared_ptr<CommandBuffer>> secondary_command_buffers;
+    };
+} // namespace vkb
@@ -209,6 +209,11 @@ namespace vkb
 
         std::vector<std::unique_ptr<vkb::RenderFrame>>& get_render_frames();
 
+        /**
+         * @return Number of times recreate() replaced the render targets, views of earlier generations are destroyed
+         */
+        uint32_t get_swapchain_generation() const;
+
         /**
          * @brief 处理表面变化，仅在 RenderContext 使用交换链时适用
          */
@@ -252,5 +257,10 @@ namespace vkb
         VkSurfaceTransformFlagBitsKHR pre_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR};
 
         size_t thread_count{1};
+
+        uint32_t swapchain_generation{0};
+
+        /// Reused by the single command buffer submit, its capacity stays after the first frame
+        std::vector<std::shared_ptr<vkb::CommandBuffer>> single_submit;
     };
 } // namespace vkb
@@ -6,29 +6,24 @@
 #include <unordered_map>
 #include <memory>
 
+#include "Framework/Common/ResourceKey.hpp"
 #include "Framework/Misc/BufferPool.hpp"
 #include "Framework/Misc/FencePool.hpp"
+#include "Framework/Misc/RingBufferAllocator.hpp"
 #include "Framework/Misc/SemaphorePool.hpp"
 
 
 namespace vkb
 {
     class DescriptorSetLayout;
-    class BufferBlock;
-    class BufferPool;
     class DescriptorPool;
     class DescriptorSet;
+    union DescriptorInfo;
     class RenderTarget;
     class VulkanDevice;
     class Queue;
     class CommandPool;
     
-    enum BufferAllocationStrategy
-    {
-        OneAllocationPerBuffer,
-        MultipleAllocationsPerBuffer
-    };
-
     enum DescriptorManagementStrategy
     {
         StoreInCache,
@@ -64,11 +59,18 @@ namespace vkb
         /**
          * @param usage Usage of the buffer
          * @param size Amount of memory required
-         * @param thread_index Index of the buffer pool to be used by the current thread
-         * @return The requested allocation, it may be empty
+         * @param thread_index Index of the sub-ring to be used by the current thread
+         * @return The requested allocation, mapped and valid until the frame is reset
          */
         vkb::BufferAllocation allocate_buffer(BufferUsageFlagsType usage, DeviceSizeType size, size_t thread_index = 0);
 
+        /**
+         * @brief Flushes the buffer allocations of the frame, called before its command buffers are submitted
+         */
+        void flush_buffers();
+
+        const vkb::RingBufferAllocator &get_buffer_allocator() const;
+
         void clear_descriptors();
 
         /**
@@ -89,19 +91,25 @@ namespace vkb
         RenderTargetType const &get_render_target() const;
         SemaphorePoolType &get_semaphore_pool();
         SemaphorePoolType const &get_semaphore_pool() const;
+
+        /**
+         * @return Number of threads the frame keeps command, descriptor and buffer pools for
+         */
+        size_t get_thread_count() const;
+
+        /**
+         * @brief Get a descriptor set holding descriptor_infos, it is allocated and written on the first request
+         * @param descriptor_set_layout The layout of the set
+         * @param descriptor_infos The flat descriptor array of the set, see DescriptorSetLayout::get_descriptor_range
+         * @param update_after_bind Leave writing the update-after-bind bindings to update_descriptor_sets()
+         * @param thread_index Selects the thread's descriptor pools and sets
+         */
         DescriptorSetType request_descriptor_set(DescriptorSetLayoutType const &descriptor_set_layout,
-                                                 BindingMap<DescriptorBufferInfoType> const &buffer_infos,
-                                                 BindingMap<DescriptorImageInfoType> const &image_infos,
+                                                 std::vector<DescriptorInfo> const &descriptor_infos,
                                                  bool update_after_bind,
                                                  size_t thread_index = 0);
         void reset();
 
-        /**
-         * @brief Sets a new buffer allocation strategy
-         * @param new_strategy The new buffer allocation strategy
-         */
-        void set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy);
-
         /**
          * @brief Sets a new descriptor set management strategy
          * @param new_strategy The new descriptor set management strategy
@@ -120,7 +128,6 @@ namespace vkb
         void update_render_target(std::unique_ptr<RenderTargetType> &&render_target);
 
     private:
-        vkb::BufferAllocation allocate_buffer_impl(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index);
         vkb::CommandPool &get_command_pool_impl(vkb::Queue const &queue, vkb::CommandBufferResetMode reset_mode, size_t thread_index);
 
         /**
@@ -140,15 +147,15 @@ namespace vkb
 
     private:
         VulkanDevice &device;
-        std::map<VkBufferUsageFlags, std::vector<std::pair<vkb::BufferPool, vkb::BufferBlock *>>> buffer_pools;
+        vkb::RingBufferAllocator buffer_allocator;
         std::map<uint32_t, std::vector<vkb::CommandPool>> command_pools;                    // Commands pools per queue family index
-        std::vector<std::unordered_map<std::size_t, vkb::DescriptorPool>> descriptor_pools; // Descriptor pools per thread
-        std::vector<std::unordered_map<std::size_t, vkb::DescriptorSet>> descriptor_sets;   // Descriptor sets per thread
+        std::vector<std::unordered_map<VkDescriptorSetLayout, vkb::DescriptorPool>> descriptor_pools;                  // Descriptor pools per thread and layout
+        std::vector<std::unordered_map<vkb::ResourceKey, vkb::DescriptorSet, vkb::ResourceKeyHash>> descriptor_sets;   // Descriptor sets per thread
+        std::vector<vkb::ResourceKey> descriptor_set_keys;                                                             // Reused lookup key per thread
         vkb::FencePool fence_pool;
         vkb::SemaphorePool semaphore_pool;
         std::unique_ptr<vkb::RenderTarget> swapchain_render_target;
         size_t thread_count;
-        BufferAllocationStrategy buffer_allocation_strategy = BufferAllocationStrategy::MultipleAllocationsPerBuffer;
         DescriptorManagementStrategy descriptor_management_strategy = DescriptorManagementStrategy::StoreInCache;
     };
 }
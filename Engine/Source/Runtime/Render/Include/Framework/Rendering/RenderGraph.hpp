@@ -0,0 +1,452 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Framework/Common/ResourceKey.hpp"
+#include "Framework/Common/VkCommon.hpp"
+
+namespace vkb
+{
+    class Buffer;
+    class CommandBuffer;
+    class Framebuffer;
+    class GpuProfiler;
+    class Image;
+    class ImageView;
+    class RenderPass;
+    class RenderTarget;
+    class VulkanDevice;
+
+    /**
+     * @brief How a pass uses an image or buffer, selects the pipeline stages, access mask and layout of the use
+     */
+    enum class RenderGraphAccess
+    {
+        ColorAttachment,
+        DepthStencilAttachment,
+        SampledImage,
+        StorageImageRead,
+        StorageImageWrite,
+        TransferSrc,
+        TransferDst,
+        UniformBuffer,
+        StorageBufferRead,
+        StorageBufferWrite,
+        VertexBuffer,
+        IndexBuffer,
+        IndirectBuffer
+    };
+
+    struct RenderGraphImage
+    {
+        uint32_t index{~0u};
+    };
+
+    struct RenderGraphBuffer
+    {
+        uint32_t index{~0u};
+    };
+
+    /**
+     * @brief A transient image, the usage flags of its accesses are added by the graph
+     */
+    struct RenderGraphImageDesc
+    {
+        VkExtent2D extent{};
+
+        VkFormat format{VK_FORMAT_UNDEFINED};
+
+        VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+
+        VkImageUsageFlags usage{0};
+    };
+
+    /**
+     * @brief A transient buffer, the usage flags of its accesses are added by the graph
+     */
+    struct RenderGraphBufferDesc
+    {
+        VkDeviceSize size{0};
+
+        VkBufferUsageFlags usage{0};
+    };
+
+    /**
+     * @brief A pass of the render graph, declares the resources it reads and writes and records its commands
+     *        A graphics pass with attachments is recorded inside a render pass the graph begins for it, the
+     *        viewport and scissor cover the attachments.
+     */
+    class RenderGraphPass
+    {
+    public:
+        enum class Type
+        {
+            Graphics,
+            Compute,
+            Transfer
+        };
+
+        using ExecuteFunc = std::function<void(CommandBuffer &command_buffer)>;
+
+        RenderGraphPass(std::string name, Type type);
+
+        /**
+         * @brief Appends a color attachment, a load_op of LOAD also reads the previous contents
+         */
+        RenderGraphPass &add_color_attachment(RenderGraphImage image, const LoadStoreInfo &load_store = {}, const VkClearValue &clear_value = {});
+
+        /**
+         * @brief Sets the depth attachment, a load_op of LOAD also reads the previous contents
+         */
+        RenderGraphPass &set_depth_attachment(RenderGraphImage image, const LoadStoreInfo &load_store = {}, const VkClearValue &clear_value = {});
+
+        /**
+         * @brief Declares a use of image outside of the attachments, e.g. a sampled texture or a copy destination
+         */
+        RenderGraphPass &use(RenderGraphImage image, RenderGraphAccess access);
+
+        RenderGraphPass &use(RenderGraphBuffer buffer, RenderGraphAccess access);
+
+        /**
+         * @brief A pass with side effects is never culled, even if nothing reads what it writes
+         */
+        RenderGraphPass &set_side_effect(bool side_effect);
+
+        RenderGraphPass &set_execute(ExecuteFunc execute);
+
+        const std::string &get_name() const;
+
+        Type get_type() const;
+
+    private:
+        friend class RenderGraph;
+
+        struct ImageUse
+        {
+            uint32_t image;
+            RenderGraphAccess access;
+        };
+
+        struct BufferUse
+        {
+            uint32_t buffer;
+            RenderGraphAccess access;
+        };
+
+        struct Attachment
+        {
+            uint32_t image;
+            LoadStoreInfo load_store;
+        };
+
+        std::string name;
+
+        /// The name interned for the profiler zones of the pass
+        const char *profile_name;
+
+        Type type;
+
+        std::vector<ImageUse> image_uses;
+
+        std::vector<BufferUse> buffer_uses;
+
+        /// Color attachments followed by the depth attachment
+        std::vector<Attachment> attachments;
+
+        std::vector<VkClearValue> clear_values;
+
+        bool has_depth_attachment{false};
+
+        bool side_effect{false};
+
+        ExecuteFunc execute;
+    };
+
+    /**
+     * @brief A frame graph of passes and the images and buffers they use
+     *        The passes are declared every frame in execution order. compile() culls passes whose results are
+     *        never used, derives the layout transitions and barriers between the passes and batches those of a
+     *        pass into a single vkCmdPipelineBarrier. Transient images whose lifetimes do not overlap are bound
+     *        to the same VMA allocation.
+     *
+     *        The result of compile() is kept as long as the declared topology stays the same, only the execute
+     *        callbacks and the imported resources change between frames then. Imported resources are waited on
+     *        and released with full barriers, the barriers between passes are exact.
+     */
+    class RenderGraph
+    {
+    public:
+        struct Stats
+        {
+            uint32_t passes{0};
+
+            uint32_t culled_passes{0};
+
+            uint32_t barrier_batches{0};
+
+            uint32_t image_barriers{0};
+
+            uint32_t buffer_barriers{0};
+
+            uint32_t transient_images{0};
+
+            /// Memory bound to the transient images
+            VkDeviceSize transient_memory{0};
+
+            /// Memory the transient images would need without aliasing
+            VkDeviceSize unaliased_memory{0};
+
+            /// Number of compilations, stays the same while the topology does
+            uint32_t compilations{0};
+        };
+
+        /**
+         * @param frames_in_flight Frames that may still use the resources of a replaced compilation
+         */
+        explicit RenderGraph(VulkanDevice &device, uint32_t frames_in_flight = 3);
+
+        ~RenderGraph();
+
+        RenderGraph(const RenderGraph &) = delete;
+
+        RenderGraph &operator=(const RenderGraph &) = delete;
+
+        /**
+         * @brief Forgets the declared passes and resources to declare those of the next frame
+         *        Called once per frame, it destroys the resources of compilations replaced frames_in_flight frames ago.
+         */
+        void reset();
+
+        RenderGraphImage create_image(const std::string &name, const RenderGraphImageDesc &desc);
+
+        /**
+         * @brief Uses an image owned outside of the graph, e.g. a swapchain image
+         * @param initial_layout Layout of the image before the first pass using it
+         * @param final_layout Layout the image is left in after the last pass
+         * @param initial_stages Stages the image was last used in, e.g. the stage a semaphore wait blocks
+         */
+        RenderGraphImage import_image(const std::string &name, const ImageView &view,
+                                      VkImageLayout initial_layout, VkImageLayout final_layout,
+                                      VkPipelineStageFlags initial_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+        RenderGraphBuffer create_buffer(const std::string &name, const RenderGraphBufferDesc &desc);
+
+        RenderGraphBuffer import_buffer(const std::string &name, const Buffer &buffer);
+
+        /**
+         * @brief Appends a pass, passes execute in the order they are added
+         * @return The pass, valid until reset()
+         */
+        RenderGraphPass &add_pass(const std::string &name, RenderGraphPass::Type type);
+
+        /**
+         * @brief Compiles the declared graph unless the last compilation had the same topology
+         *        A recompilation keeps the old transient resources until the frames in flight are done with them.
+         * @return True if the graph was compiled again
+         */
+        bool compile();
+
+        /**
+         * @brief Records the barriers and the passes that were not culled
+         */
+        void execute(CommandBuffer &command_buffer);
+
+        /**
+         * @brief Waits for the device and drops the compiled graph and its resources, call it when the imported
+         *        swapchain images are recreated, their views are not part of the topology
+         */
+        void clear();
+
+        /**
+         * @return The view of a compiled transient image or of an imported one
+         */
+        const ImageView &get_image_view(RenderGraphImage image) const;
+
+        const Buffer &get_buffer(RenderGraphBuffer buffer) const;
+
+        const Stats &get_stats() const;
+
+        /**
+         * @brief Measures every executed pass as a CPU zone and, with a profiler, as a GPU zone
+         */
+        void set_gpu_profiler(GpuProfiler *profiler);
+
+    private:
+        struct ImageResource
+        {
+            std::string name;
+
+            RenderGraphImageDesc desc;
+
+            const ImageView *imported_view{nullptr};
+
+            VkImageLayout initial_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+            VkImageLayout final_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+            VkPipelineStageFlags initial_stages{0};
+        };
+
+        struct BufferResource
+        {
+            std::string name;
+
+            RenderGraphBufferDesc desc;
+
+            const Buffer *imported_buffer{nullptr};
+        };
+
+        struct ImageBarrier
+        {
+            uint32_t image;
+
+            VkAccessFlags src_access;
+
+            VkAccessFlags dst_access;
+
+            VkImageLayout old_layout;
+
+            VkImageLayout new_layout;
+        };
+
+        struct BufferBarrier
+        {
+            uint32_t buffer;
+
+            VkAccessFlags src_access;
+
+            VkAccessFlags dst_access;
+        };
+
+        /// The barriers recorded before a pass, in one vkCmdPipelineBarrier
+        struct BarrierBatch
+        {
+            VkPipelineStageFlags src_stages{0};
+
+            VkPipelineStageFlags dst_stages{0};
+
+            std::vector<ImageBarrier> image_barriers;
+
+            std::vector<BufferBarrier> buffer_barriers;
+        };
+
+        struct CompiledPass
+        {
+            uint32_t pass;
+
+            BarrierBatch barriers;
+
+            /// Set for graphics passes with attachments
+            RenderPass *render_pass{nullptr};
+        };
+
+        struct TransientImage
+        {
+            VkImage handle{VK_NULL_HANDLE};
+
+            std::unique_ptr<Image> image;
+
+            std::unique_ptr<ImageView> view;
+        };
+
+        /// The framebuffer is owned by the graph, so it goes away with the views it was created for
+        struct PassRenderTarget
+        {
+            std::unique_ptr<RenderTarget> render_target;
+
+            std::unique_ptr<Framebuffer> framebuffer;
+        };
+
+        using RenderTargetMap = std::unordered_map<ResourceKey, PassRenderTarget, ResourceKeyHash>;
+
+        /// Resources of a replaced compilation, destroyed once no frame in flight uses them
+        struct RetiredResources
+        {
+            uint64_t frame;
+
+            std::vector<TransientImage> transient_images;
+
+            std::vector<std::unique_ptr<Buffer>> transient_buffers;
+
+            std::vector<VmaAllocation> memory_blocks;
+
+            RenderTargetMap render_targets;
+        };
+
+        void build_topology_key(ResourceKey &key) const;
+
+        /**
+         * @brief Drops the compiled graph, its resources are destroyed frames_in_flight frames later
+         */
+        void retire_resources();
+
+        /**
+         * @param all Also destroys the resources frames in flight may still use, the device has to be idle
+         */
+        void destroy_retired_resources(bool all);
+
+        std::vector<bool> cull_passes() const;
+
+        void create_transient_resources(const std::vector<uint32_t> &pass_order);
+
+        void record_barriers(CommandBuffer &command_buffer, const BarrierBatch &batch);
+
+        PassRenderTarget &request_render_target(const CompiledPass &compiled_pass);
+
+        const Image &get_image(uint32_t image) const;
+
+        VulkanDevice &device;
+
+        std::deque<RenderGraphPass> passes;
+
+        std::vector<ImageResource> images;
+
+        std::vector<BufferResource> buffers;
+
+        ResourceKey topology_key;
+
+        ResourceKey compiled_key;
+
+        bool compiled{false};
+
+        std::vector<CompiledPass> compiled_passes;
+
+        /// Releases the imported images after the last pass
+        BarrierBatch final_barriers;
+
+        std::vector<TransientImage> transient_images;
+
+        std::vector<std::unique_ptr<Buffer>> transient_buffers;
+
+        std::vector<VmaAllocation> memory_blocks;
+
+        /// The image that used the memory of each transient image last, its own index if it is not aliased
+        std::vector<uint32_t> aliased_predecessors;
+
+        /// Render targets of the graphics passes, keyed by the pass and the views of its attachments
+        RenderTargetMap render_targets;
+
+        std::deque<RetiredResources> retired_resources;
+
+        /// Advanced by reset()
+        uint64_t frame_index{0};
+
+        uint32_t frames_in_flight;
+
+        ResourceKey render_target_key;
+
+        std::vector<VkImageMemoryBarrier> image_barrier_scratch;
+
+        std::vector<VkBufferMemoryBarrier> buffer_barrier_scratch;
+
+        Stats stats;
+
+        GpuProfiler *gpu_profiler{nullptr};
+    };
+} // namespace vkb
@@ -24,6 +24,7 @@ namespace vkb
 {
     class RenderTarget;
     class CommandBuffer;
+    class ParallelCommandRecorder;
     class Subpass;
     /**
      * @brief A RenderPipeline is a sequence of Subpass objects.
@@ -84,6 +85,13 @@ namespace vkb
 
         std::vector<std::unique_ptr<vkb::Subpass>>& get_subpasses();
 
+        /**
+         * @brief Records the subpasses into secondary command buffers on the threads of command_recorder
+         *        Subpasses that report a draw count are split between the threads, the others are recorded
+         *        into a single secondary. The recorder must outlive the pipeline, nullptr records inline.
+         */
+        void set_command_recorder(ParallelCommandRecorder* command_recorder);
+
         /**
          * @brief Record draw commands for each Subpass
          */
@@ -97,6 +105,11 @@ namespace vkb
         std::unique_ptr<vkb::Subpass>& get_active_subpass();
 
     private:
+        /**
+         * @brief Records a subpass begun with secondary contents through the command recorder
+         */
+        void draw_parallel(vkb::CommandBuffer& command_buffer, RenderTarget& render_target, Subpass& subpass);
+
         std::vector<std::unique_ptr<vkb::Subpass>> subpasses;
 
         /// Default to two load store
@@ -106,5 +119,7 @@ namespace vkb
         std::vector<VkClearValue> clear_value = std::vector<VkClearValue>(2);
 
         size_t active_subpass_index{0};
+
+        ParallelCommandRecorder* command_recorder{nullptr};
     };
 } // namespace vkb
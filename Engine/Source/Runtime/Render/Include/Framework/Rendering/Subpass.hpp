@@ -65,6 +65,19 @@ namespace vkb
          */
         virtual void draw(vkb::CommandBuffer& command_buffer) = 0;
 
+        /**
+         * @brief Number of draws draw_range() can split between recording threads
+         * @return 0 if the subpass can only be recorded as a whole with draw()
+         */
+        virtual uint32_t get_draw_count() const;
+
+        /**
+         * @brief Records the draws [first_draw, first_draw + draw_count) of the subpass
+         *        Called concurrently from the recording threads, each with its own secondary command buffer
+         *        whose pool thread index selects the frame resources to allocate from.
+         */
+        virtual void draw_range(vkb::CommandBuffer& command_buffer, uint32_t first_draw, uint32_t draw_count);
+
         /**
          * @brief 纯虚函数，用于准备子通道所需的着色器和着色器变体。
          */
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Framework/Rendering/Subpass.hpp"
+
+namespace vkb
+{
+    class Buffer;
+    class PipelineLayout;
+
+    /**
+     * @brief Draws a flat list of meshes with the default Blinn-Phong shaders
+     *        Every draw item references a mesh and a material and pushes its model matrix, so the list can be
+     *        split at any index and its chunks recorded on different threads. With bindless textures the base color
+     *        of a material is sampled from the bindless descriptor table, its indices are pushed with the matrix.
+     */
+    class DrawListSubpass : public Subpass
+    {
+    public:
+        /// Vertex layout of the meshes, matches the inputs of BlinnPhong.vert
+        struct Vertex
+        {
+            glm::vec3 position;
+            glm::vec3 normal;
+            glm::vec2 uv;
+        };
+
+        /// std140 layout of UboScene
+        struct alignas(16) SceneUniform
+        {
+            glm::mat4 projection;
+            glm::mat4 view;
+            glm::vec4 camera_position;
+        };
+
+        /// std140 layout of UboLight
+        struct alignas(16) LightUniform
+        {
+            glm::vec4 position;
+            glm::vec3 color;
+            float ambient_strength;
+        };
+
+        /// std140 layout of UboMaterial
+        struct alignas(16) MaterialUniform
+        {
+            glm::vec4 ambient;
+            glm::vec4 diffuse;
+            glm::vec3 specular;
+            float shininess;
+        };
+
+        /// Push constants of BlinnPhong.vert, the indices are read by BlinnPhong.frag with bindless textures
+        struct alignas(16) DrawPushConstants
+        {
+            glm::mat4 model;
+            glm::vec4 position_offset;
+            glm::vec4 position_scale;
+            uint32_t base_color_texture;
+            uint32_t base_color_sampler;
+            uint32_t padding[2];
+        };
+
+        /// Slots of a material in the bindless descriptor table, BindlessHandle::invalid_index when it has none
+        struct MaterialTextures
+        {
+            uint32_t base_color{~0u};
+            uint32_t sampler{~0u};
+        };
+
+        struct Mesh
+        {
+            const vkb::Buffer *vertex_buffer{nullptr};
+            const vkb::Buffer *index_buffer{nullptr};
+            uint32_t index_count{0};
+            VkIndexType index_type{VK_INDEX_TYPE_UINT32};
+
+            /// Buffers of bindings 1 and up of vertex_input_state, for attributes stored in separate streams
+            std::vector<const vkb::Buffer *> extra_vertex_buffers{};
+
+            /// Formats of the mesh, no bindings selects the Vertex layout
+            VertexInputState vertex_input_state{};
+
+            /// Defines of VertexDecode.glsl matching the formats, see sg::VertexLayout
+            ShaderVariant shader_variant{};
+
+            /// Rebuilds quantized positions as offset + scale * q, see sg::PositionDequantization
+            glm::vec3 position_offset{0.0f};
+            glm::vec3 position_scale{1.0f};
+        };
+
+        struct DrawItem
+        {
+            uint32_t mesh{0};
+            uint32_t material{0};
+            glm::mat4 model{1.0f};
+        };
+
+        explicit DrawListSubpass(vkb::RenderContext &render_context);
+
+        /**
+         * @brief Samples the base color textures through the bindless table of the resource cache, call before prepare()
+         *        The meshes need texture coordinates at location 2.
+         */
+        void set_bindless_textures(bool enabled);
+
+        void prepare() override;
+
+        void draw(vkb::CommandBuffer &command_buffer) override;
+
+        uint32_t get_draw_count() const override;
+
+        void draw_range(vkb::CommandBuffer &command_buffer, uint32_t first_draw, uint32_t draw_count) override;
+
+        /**
+         * @return Index of the mesh for DrawItem::mesh, the buffers must outlive the subpass
+         *         Meshes with a shader variant of their own get a pipeline layout of their own.
+         */
+        uint32_t add_mesh(const Mesh &mesh);
+
+        /**
+         * @return Index of the material for DrawItem::material
+         */
+        uint32_t add_material(const MaterialUniform &material);
+
+        /**
+         * @brief Sets the bindless slots of a material, streamed textures move to new slots so they can change every frame
+         */
+        void set_material_textures(uint32_t material, const MaterialTextures &textures);
+
+        void set_scene(const SceneUniform &scene);
+
+        void set_light(const LightUniform &light);
+
+        /**
+         * @brief The draws recorded in list order, sort them by material and mesh to save rebinding
+         */
+        std::vector<DrawItem> &get_draw_items();
+
+    private:
+        /// Requests the pipeline layout of a mesh variant, shared by the meshes with the same defines
+        void prepare_mesh(uint32_t mesh);
+
+        vkb::PipelineLayout *pipeline_layout{nullptr};
+
+        /// Built once by prepare(), the layout of meshes without formats of their own
+        VertexInputState vertex_input_state;
+
+        std::vector<Mesh> meshes;
+
+        /// Pipeline layout of each mesh, set by prepare() or by add_mesh() after it
+        std::vector<vkb::PipelineLayout *> mesh_layouts;
+
+        bool prepared{false};
+
+        bool bindless_textures{false};
+
+        std::vector<MaterialUniform> materials;
+
+        std::vector<MaterialTextures> material_textures;
+
+        std::vector<DrawItem> draw_items;
+
+        SceneUniform scene{};
+
+        LightUniform light{};
+    };
+} // namespace vkb
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Core/Image.hpp"
+#include "Framework/Core/ImageView.hpp"
+#include "Framework/Core/Sampler.hpp"
+#include "Framework/Rendering/DrawCulling.hpp"
+#include "Framework/Rendering/Subpass.hpp"
+#include "Framework/Rendering/Subpasses/DrawListSubpass.hpp"
+
+namespace vkb
+{
+    class MeshArena;
+    class PhysicalDevice;
+    class PipelineLayout;
+
+    /**
+     * @brief Draws the instances of a mesh arena with draws generated on the GPU
+     *        cull() runs Cull.comp before the render pass, it tests every instance against the frustum and the depth
+     *        pyramid of the previous frame and appends a draw command per visible instance. draw() then submits all of
+     *        them with a single indirect draw, with the vertex count taken from the GPU when VK_KHR_draw_indirect_count
+     *        is enabled. Uses the vertex layout and uniforms of DrawListSubpass.
+     */
+    class IndirectDrawSubpass : public Subpass
+    {
+    public:
+        /**
+         * @brief Requests multiDrawIndirect and drawIndirectFirstInstance, call before the device is created
+         * @return true when the GPU supports both
+         */
+        static bool request_features(PhysicalDevice &gpu);
+
+        IndirectDrawSubpass(vkb::RenderContext &render_context, MeshArena &mesh_arena);
+
+        void prepare() override;
+
+        /**
+         * @brief Records the culling dispatch, outside of a render pass and before the pass that calls draw()
+         */
+        void cull(vkb::CommandBuffer &command_buffer);
+
+        void draw(vkb::CommandBuffer &command_buffer) override;
+
+        /**
+         * @brief Rebuilds the depth pyramid for the culling of the next frame, outside of a render pass
+         * @param depth Sampled depth attachment of the pass, in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+         */
+        void build_depth_pyramid(vkb::CommandBuffer &command_buffer, const ImageView &depth);
+
+        /**
+         * @return Index of the material for GpuInstance::material
+         */
+        uint32_t add_material(const DrawListSubpass::MaterialUniform &material);
+
+        void set_scene(const DrawListSubpass::SceneUniform &scene);
+
+        void set_light(const DrawListSubpass::LightUniform &light);
+
+        void set_occlusion_culling(bool enabled);
+
+        /**
+         * @brief Copies the draws of every frame back and checks them against CpuDrawCuller once the frame has completed
+         *        Mismatches are logged as errors. Adds a copy per frame, meant for debugging Cull.comp.
+         */
+        void set_cull_validation(bool enabled);
+
+        /**
+         * @brief The instances culled and drawn every frame, GpuInstance::mesh indexes the mesh arena
+         */
+        std::vector<GpuInstance> &get_instances();
+
+    private:
+        /// Grows the draw buffer to hold a draw per instance
+        void prepare_draw_buffer(uint32_t instance_count);
+
+        void create_depth_pyramid(const VkExtent3D &depth_extent);
+
+        /// Draws of a render frame copied back for the validation, checked when the frame is recorded again
+        struct CullReadback
+        {
+            std::unique_ptr<Buffer> buffer;
+
+            uint32_t capacity{0};
+
+            CullUniform uniform{};
+
+            std::vector<GpuInstance> instances;
+
+            bool pending{false};
+        };
+
+        /**
+         * @brief Compares the draws of a completed frame with the frustum culling of CpuDrawCuller
+         *        The depth pyramid is not read back, with occlusion enabled the GPU draws only have to be a subset.
+         */
+        void validate_cull(const CullReadback &readback) const;
+
+        MeshArena &mesh_arena;
+
+        vkb::PipelineLayout *pipeline_layout{nullptr};
+
+        vkb::PipelineLayout *cull_layout{nullptr};
+
+        vkb::PipelineLayout *pyramid_layout{nullptr};
+
+        std::vector<DrawListSubpass::MaterialUniform> materials;
+
+        std::vector<GpuInstance> instances;
+
+        DrawListSubpass::SceneUniform scene{};
+
+        DrawListSubpass::LightUniform light{};
+
+        bool occlusion_culling{true};
+
+        bool draw_indirect_count{false};
+
+        bool cull_validation{false};
+
+        /// One per render frame
+        std::vector<CullReadback> cull_readbacks;
+
+        /// Device local draw commands written by Cull.comp
+        std::unique_ptr<Buffer> draw_buffer;
+
+        uint32_t draw_capacity{0};
+
+        std::unique_ptr<Buffer> count_buffer;
+
+        /// Instances of the frame being recorded, read by the culling and the vertex shader
+        BufferAllocation instance_buffer;
+
+        std::unique_ptr<Sampler> pyramid_sampler;
+
+        /// Level 0 is half the depth attachment, a 1x1 placeholder until the first build
+        std::unique_ptr<Image> depth_pyramid;
+
+        std::unique_ptr<ImageView> pyramid_view;
+
+        std::vector<ImageView> pyramid_level_views;
+
+        /// False until the placeholder pyramid has been transitioned
+        bool pyramid_ready{false};
+
+        /// False until a pyramid has been built from a depth attachment
+        bool pyramid_valid{false};
+
+        glm::mat4 pyramid_view_projection{1.0f};
+    };
+} // namespace vkb
@@ -0,0 +1,262 @@
+#include "Framework/Core/BindlessDescriptorTable.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Core/DescriptorPool.hpp"
+#include "Framework/Core/DescriptorSetLayout.hpp"
+#include "Framework/Core/ImageView.hpp"
+#include "Framework/Core/Instance.hpp"
+#include "Framework/Core/PhysicalDevice.hpp"
+#include "Framework/Core/Sampler.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Logging/Logger.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        ShaderResource make_array_resource(ShaderResourceType type, uint32_t set, uint32_t binding, uint32_t array_size, const char *name)
+        {
+            ShaderResource resource{};
+            resource.stages = VK_SHADER_STAGE_ALL;
+            resource.type = type;
+            resource.mode = ShaderResourceMode::Bindless;
+            resource.set = set;
+            resource.binding = binding;
+            resource.array_size = array_size;
+            resource.name = name;
+            return resource;
+        }
+    } // namespace
+
+    bool BindlessDescriptorTable::request_features(PhysicalDevice &gpu)
+    {
+        // Extension features are queried through vkGetPhysicalDeviceFeatures2KHR
+        if (!gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+        {
+            LOGI("{} is not enabled, bindless resources are disabled", VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+            return false;
+        }
+
+        const auto type = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        using Features = VkPhysicalDeviceDescriptorIndexingFeaturesEXT;
+
+        auto supported = gpu.get_extension_features<Features>(type);
+        if (!supported.runtimeDescriptorArray || !supported.descriptorBindingPartiallyBound ||
+            !supported.descriptorBindingUpdateUnusedWhilePending ||
+            !supported.descriptorBindingSampledImageUpdateAfterBind ||
+            !supported.descriptorBindingStorageBufferUpdateAfterBind ||
+            !supported.shaderSampledImageArrayNonUniformIndexing)
+        {
+            LOGI("Descriptor indexing is not supported, bindless resources are disabled");
+            return false;
+        }
+
+        auto &requested = gpu.add_extension_features<Features>(type);
+        requested.runtimeDescriptorArray = VK_TRUE;
+        requested.descriptorBindingPartiallyBound = VK_TRUE;
+        requested.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        requested.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        requested.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        requested.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        requested.shaderStorageBufferArrayNonUniformIndexing = supported.shaderStorageBufferArrayNonUniformIndexing;
+
+        return true;
+    }
+
+    BindlessDescriptorTable::BindlessDescriptorTable(VulkanDevice &device) :
+        BindlessDescriptorTable{device, Config{}}
+    {
+    }
+
+    BindlessDescriptorTable::BindlessDescriptorTable(VulkanDevice &device, const Config &config_) :
+        device{device},
+        config{config_}
+    {
+        // Clamp the arrays to what the device allows for update-after-bind sets
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT};
+        VkPhysicalDeviceProperties2 properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+        properties.pNext = &indexing_properties;
+        vkGetPhysicalDeviceProperties2(device.get_gpu().get_handle(), &properties);
+
+        config.max_textures = std::min({config.max_textures,
+                                        indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+                                        indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages});
+        config.max_samplers = std::min({config.max_samplers,
+                                        indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+                                        indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers});
+        config.max_storage_buffers = std::min({config.max_storage_buffers,
+                                               indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                               indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+
+        std::vector<ShaderResource> resources{
+            make_array_resource(ShaderResourceType::Image, config.set_index, Textures, config.max_textures, "textures"),
+            make_array_resource(ShaderResourceType::Sampler, config.set_index, Samplers, config.max_samplers, "samplers"),
+            make_array_resource(ShaderResourceType::BufferStorage, config.set_index, StorageBuffers, config.max_storage_buffers, "storage_buffers")};
+
+        layout = std::make_unique<DescriptorSetLayout>(device, config.set_index, std::vector<ShaderModule *>{}, resources);
+        pool = std::make_unique<DescriptorPool>(device, *layout, 1);
+
+        descriptor_set = pool->allocate();
+        if (descriptor_set == VK_NULL_HANDLE)
+        {
+            throw std::runtime_error("Cannot allocate the bindless descriptor set");
+        }
+
+        slots[Textures].capacity = config.max_textures;
+        slots[Samplers].capacity = config.max_samplers;
+        slots[StorageBuffers].capacity = config.max_storage_buffers;
+
+        LOGI("Bindless descriptor table in set {}: {} textures, {} samplers, {} storage buffers",
+             config.set_index, config.max_textures, config.max_samplers, config.max_storage_buffers);
+    }
+
+    BindlessDescriptorTable::~BindlessDescriptorTable()
+    {
+        // The set is freed with its pool
+        pool.reset();
+        layout.reset();
+    }
+
+    BindlessHandle BindlessDescriptorTable::register_texture(const ImageView &image_view, VkImageLayout image_layout)
+    {
+        auto handle = allocate_slot(Textures);
+        update_texture(handle, image_view, image_layout);
+        return handle;
+    }
+
+    BindlessHandle BindlessDescriptorTable::register_sampler(const Sampler &sampler)
+    {
+        auto handle = allocate_slot(Samplers);
+
+        VkDescriptorImageInfo image_info{sampler.GetHandle(), VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+        write(Samplers, handle.index, &image_info, nullptr);
+
+        return handle;
+    }
+
+    BindlessHandle BindlessDescriptorTable::register_storage_buffer(const Buffer &buffer, VkDeviceSize offset, VkDeviceSize range)
+    {
+        auto handle = allocate_slot(StorageBuffers);
+
+        VkDescriptorBufferInfo buffer_info{buffer.GetHandle(), offset, range};
+        write(StorageBuffers, handle.index, nullptr, &buffer_info);
+
+        return handle;
+    }
+
+    void BindlessDescriptorTable::update_texture(BindlessHandle handle, const ImageView &image_view, VkImageLayout image_layout)
+    {
+        assert(handle.is_valid() && handle.index < config.max_textures);
+
+        VkDescriptorImageInfo image_info{VK_NULL_HANDLE, image_view.GetHandle(), image_layout};
+        write(Textures, handle.index, &image_info, nullptr);
+    }
+
+    void BindlessDescriptorTable::release_texture(BindlessHandle handle)
+    {
+        release_slot(Textures, handle);
+    }
+
+    void BindlessDescriptorTable::release_sampler(BindlessHandle handle)
+    {
+        release_slot(Samplers, handle);
+    }
+
+    void BindlessDescriptorTable::release_storage_buffer(BindlessHandle handle)
+    {
+        release_slot(StorageBuffers, handle);
+    }
+
+    void BindlessDescriptorTable::next_frame()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        frame_index++;
+
+        for (auto &slot_allocator : slots)
+        {
+            auto &retired = slot_allocator.retired_slots;
+
+            // Retired in release order, the oldest come first
+            auto it = retired.begin();
+            while (it != retired.end() && it->second + config.frames_in_flight <= frame_index)
+            {
+                slot_allocator.free_slots.push_back(it->first);
+                ++it;
+            }
+            retired.erase(retired.begin(), it);
+        }
+    }
+
+    uint32_t BindlessDescriptorTable::get_set_index() const
+    {
+        return config.set_index;
+    }
+
+    const DescriptorSetLayout &BindlessDescriptorTable::get_layout() const
+    {
+        return *layout;
+    }
+
+    VkDescriptorSet BindlessDescriptorTable::get_descriptor_set() const
+    {
+        return descriptor_set;
+    }
+
+    BindlessHandle BindlessDescriptorTable::allocate_slot(Binding binding)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto &slot_allocator = slots[binding];
+
+        if (!slot_allocator.free_slots.empty())
+        {
+            BindlessHandle handle{slot_allocator.free_slots.back()};
+            slot_allocator.free_slots.pop_back();
+            return handle;
+        }
+
+        if (slot_allocator.high_water_mark == slot_allocator.capacity)
+        {
+            throw std::runtime_error("Bindless descriptor table is full");
+        }
+
+        return BindlessHandle{slot_allocator.high_water_mark++};
+    }
+
+    void BindlessDescriptorTable::release_slot(Binding binding, BindlessHandle handle)
+    {
+        if (!handle.is_valid())
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        assert(handle.index < slots[binding].high_water_mark);
+        slots[binding].retired_slots.emplace_back(handle.index, frame_index);
+    }
+
+    void BindlessDescriptorTable::write(Binding binding, uint32_t index, const VkDescriptorImageInfo *image_info, const VkDescriptorBufferInfo *buffer_info)
+    {
+        static const VkDescriptorType descriptor_types[BindingCount] = {
+            VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_DESCRIPTOR_TYPE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+
+        VkWriteDescriptorSet write_descriptor_set{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write_descriptor_set.dstSet = descriptor_set;
+        write_descriptor_set.dstBinding = binding;
+        write_descriptor_set.dstArrayElement = index;
+        write_descriptor_set.descriptorCount = 1;
+        write_descriptor_set.descriptorType = descriptor_types[binding];
+        write_descriptor_set.pImageInfo = image_info;
+        write_descriptor_set.pBufferInfo = buffer_info;
+
+        // Update-after-bind with unused-while-pending, slots not read by pending frames may be written at any time.
+        // The set itself has to be externally synchronized, loading threads and the render thread write it
+        std::lock_guard<std::mutex> lock{mutex};
+        vkUpdateDescriptorSets(device.GetHandle(), 1, &write_descriptor_set, 0, nullptr);
+    }
+} // namespace vkb
@@ -1,4 +1,5 @@
 #include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/BindlessDescriptorTable.hpp"
 #include "Framework/Core/CommandPool.hpp"
 #include "Framework/Core/QueryPool.hpp"
 #include "Framework/Rendering/RenderTarget.hpp"
@@ -8,6 +9,8 @@
 #include "Framework/Rendering/RenderFrame.hpp"
 #include "Framework/Core/RenderPass.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Misc/PipelineCompiler.hpp"
+#include "Memory/FrameAllocator.hpp"
 
 
 namespace vkb
@@ -83,7 +86,9 @@ namespace vkb
     {
         pipeline_state.reset();
         resource_binding_state.reset();
-        descriptor_set_layout_binding_state.clear();
+        reset_descriptor_set_states();
+        bound_pipeline = VK_NULL_HANDLE;
+        bound_pipeline_layout = nullptr;
         stored_push_constants.clear();
 
         VkCommandBufferBeginInfo begin_info{};
@@ -110,6 +115,13 @@ namespace vkb
             inheritance_info.subpass = subpass_index;
 
             begin_info.pInheritanceInfo = &inheritance_info;
+
+            // Pipelines recorded into the secondary are created for the inherited subpass
+            pipeline_state.set_subpass_index(subpass_index);
+
+            auto blend_state = pipeline_state.get_color_blend_state();
+            blend_state.attachments.resize(current_render_pass->get_color_output_count(subpass_index));
+            pipeline_state.set_color_blend_state(blend_state);
         }
 
         VkResult result = vkBeginCommandBuffer(this->GetHandle(), &begin_info);
@@ -138,7 +150,9 @@ namespace vkb
         // Reset state
         pipeline_state.reset();
         resource_binding_state.reset();
-        descriptor_set_layout_binding_state.clear();
+        reset_descriptor_set_states();
+        bound_pipeline = VK_NULL_HANDLE;
+        bound_pipeline_layout = nullptr;
 
         auto& render_pass = get_render_pass(render_target, load_store_infos, subpasses);
         auto& framebuffer = this->GetDevice().get_resource_cache().request_framebuffer(render_target, render_pass);
@@ -197,6 +211,9 @@ namespace vkb
 
         vkCmdBeginRenderPass(this->GetHandle(), &begin_info, contents);
 
+        // A render pass starts at its first subpass
+        pipeline_state.set_subpass_index(0);
+
         // Update blend state attachments
         auto blend_state = pipeline_state.get_color_blend_state();
         blend_state.attachments.resize(current_render_pass->get_color_output_count(pipeline_state.get_subpass_index()));
@@ -276,7 +293,8 @@ namespace vkb
             return;
         }
 
-        std::vector<VkBuffer> buffer_handles;
+        ScopedArena arena;
+        std::pmr::vector<VkBuffer> buffer_handles{arena.GetResource()};
         buffer_handles.reserve(buffers.size());
         std::transform(buffers.begin(), buffers.end(), std::back_inserter(buffer_handles),
                        [](auto const& buffer_wrapper)
@@ -291,6 +309,12 @@ namespace vkb
                                offsets.data());
     }
 
+    void CommandBuffer::bind_vertex_buffers(uint32_t first_binding, vkb::Buffer const& buffer, VkDeviceSize offset)
+    {
+        VkBuffer buffer_handle = buffer.GetHandle();
+        vkCmdBindVertexBuffers(GetHandle(), first_binding, 1, &buffer_handle, &offset);
+    }
+
     void CommandBuffer::blit_image(vkb::Image const& src_img, vkb::Image const& dst_img,
                                    std::vector<VkImageBlit> const& regions)
     {
@@ -460,6 +484,15 @@ namespace vkb
         vkCmdDrawIndexedIndirect(this->GetHandle(), buffer.GetHandle(), offset, draw_count, stride);
     }
 
+    void CommandBuffer::draw_indexed_indirect_count(vkb::Buffer const& buffer, VkDeviceSize offset,
+                                                    vkb::Buffer const& count_buffer, VkDeviceSize count_offset,
+                                                    uint32_t max_draw_count, uint32_t stride)
+    {
+        flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+        vkCmdDrawIndexedIndirectCountKHR(this->GetHandle(), buffer.GetHandle(), offset, count_buffer.GetHandle(),
+                                         count_offset, max_draw_count, stride);
+    }
+
     void CommandBuffer::end()
     {
         if (vkEndCommandBuffer(this->GetHandle()) != VK_SUCCESS)
@@ -474,6 +507,11 @@ namespace vkb
         vkCmdEndQuery(this->GetHandle(), query_pool.get_handle(), query);
     }
 
+    void CommandBuffer::fill_buffer(vkb::Buffer const& buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t data)
+    {
+        vkCmdFillBuffer(this->GetHandle(), buffer.GetHandle(), offset, size, data);
+    }
+
     void CommandBuffer::end_render_pass()
     {
         vkCmdEndRenderPass(this->GetHandle());
@@ -485,6 +523,11 @@ namespace vkb
         return level;
     }
 
+    vkb::CommandPool& CommandBuffer::get_command_pool() const
+    {
+        return command_pool;
+    }
+
     void CommandBuffer::execute_commands(vkb::CommandBuffer& secondary_command_buffer)
     {
         // vkCmdExecuteCommands expects a pointer to an array of command buffers
@@ -506,7 +549,8 @@ namespace vkb
             return;
         }
 
-        std::vector<VkCommandBuffer> sec_cmd_buf_handles;
+        ScopedArena arena;
+        std::pmr::vector<VkCommandBuffer> sec_cmd_buf_handles{arena.GetResource()};
         sec_cmd_buf_handles.reserve(secondary_command_buffers.size());
 
         std::transform(secondary_command_buffers.begin(),
@@ -614,7 +658,7 @@ namespace vkb
             &image_memory_barrier);
     }
 
-    void CommandBuffer::next_subpass()
+    void CommandBuffer::next_subpass(VkSubpassContents contents)
     {
         // Increment subpass index
         pipeline_state.set_subpass_index(pipeline_state.get_subpass_index() + 1);
@@ -626,14 +670,14 @@ namespace vkb
 
         // Reset descriptor sets
         resource_binding_state.reset();
-        descriptor_set_layout_binding_state.clear();
+        reset_descriptor_set_states();
 
         // Clear stored push constants
         stored_push_constants.clear();
 
         vkCmdNextSubpass(
             this->GetHandle(), // VkCommandBuffer
-            VK_SUBPASS_CONTENTS_INLINE);
+            contents);
     }
 
     void CommandBuffer::push_constants(const std::vector<uint8_t>& values)
@@ -834,171 +878,115 @@ namespace vkb
     {
         assert(command_pool.get_render_frame() && "The command pool must be associated to a render frame");
 
-        const auto& pipeline_layout = pipeline_state.get_pipeline_layout();
+        const auto& pipeline_layout = get_bound_pipeline_layout();
 
-        std::unordered_set<uint32_t> update_descriptor_sets;
+        // The bindless set never changes, only bind it to pipeline layouts that use it
+        auto* bindless_table = GetDevice().get_resource_cache().get_bindless_table();
+        uint32_t bindless_set = bindless_table ? bindless_table->get_set_index() : vkb::ResourceBindingState::max_sets;
 
-        // Iterate over the shader sets to check if they have already been bound
-        // If they have, add the set so that the command buffer later updates it
-        for (auto& set_it : pipeline_layout.get_shader_sets())
+        if (bindless_set < vkb::ResourceBindingState::max_sets &&
+            (!pipeline_layout.has_descriptor_set_layout(bindless_set) ||
+             &pipeline_layout.get_descriptor_set_layout(bindless_set) != &bindless_table->get_layout()))
         {
-            uint32_t descriptor_set_id = set_it.first;
-
-            auto descriptor_set_layout_it = descriptor_set_layout_binding_state.find(descriptor_set_id);
+            bindless_set = vkb::ResourceBindingState::max_sets;
+        }
 
-            if (descriptor_set_layout_it != descriptor_set_layout_binding_state.end())
-            {
-                if (descriptor_set_layout_it->second->get_handle() != pipeline_layout.get_descriptor_set_layout(
-                    descriptor_set_id).get_handle())
-                {
-                    update_descriptor_sets.emplace(descriptor_set_id);
-                }
-            }
+        if (bindless_set < vkb::ResourceBindingState::max_sets)
+        {
+            static const std::vector<uint32_t> no_dynamic_offsets;
+            bind_descriptor_set(pipeline_bind_point, pipeline_layout, bindless_set, bindless_table->get_descriptor_set(),
+                                no_dynamic_offsets);
         }
 
-        // Validate that the bound descriptor set layouts exist in the pipeline layout
-        for (auto set_it = descriptor_set_layout_binding_state.begin(); set_it != descriptor_set_layout_binding_state.
-             end();)
+        uint32_t dirty_sets = resource_binding_state.get_dirty_sets();
+
+        for (uint32_t descriptor_set_id = 0; descriptor_set_id < vkb::ResourceBindingState::max_sets; descriptor_set_id++)
         {
-            if (!pipeline_layout.has_descriptor_set_layout(set_it->first))
+            if (descriptor_set_id == bindless_set)
             {
-                set_it = descriptor_set_layout_binding_state.erase(set_it);
+                continue;
             }
-            else
+
+            auto& set_state = descriptor_set_states[descriptor_set_id];
+            auto& resource_set = resource_binding_state.get_resource_set(descriptor_set_id);
+
+            // Skip resource set if nothing is bound to it or a descriptor set layout doesn't exist for it
+            if (resource_set.get_bound_bindings() == 0 || !pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
             {
-                ++set_it;
+                continue;
             }
-        }
 
-        // Check if a descriptor set needs to be created
-        if (resource_binding_state.is_dirty() || !update_descriptor_sets.empty())
-        {
-            resource_binding_state.clear_dirty();
+            auto& descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
 
-            // Iterate over all of the resource sets bound by the command buffer
-            for (auto& resource_set_it : resource_binding_state.get_resource_sets())
-            {
-                uint32_t descriptor_set_id = resource_set_it.first;
-                auto& resource_set = resource_set_it.second;
+            bool layout_changed = set_state.layout != &descriptor_set_layout;
+            bool resources_changed = dirty_sets & (1u << descriptor_set_id);
 
-                // Don't update resource set if it's not in the update list OR its state hasn't changed
-                if (!resource_set.is_dirty() && (update_descriptor_sets.find(descriptor_set_id) ==
-                    update_descriptor_sets.end()))
+            if (!layout_changed && !resources_changed)
+            {
+                // A pipeline with another layout may have disturbed the set, bind it again as it was
+                if (set_state.bound_pipeline_layout != pipeline_layout.get_handle())
                 {
-                    continue;
+                    bind_descriptor_set(pipeline_bind_point, pipeline_layout, descriptor_set_id, set_state.bound_handle,
+                                        set_state.bound_dynamic_offsets);
                 }
+                continue;
+            }
 
-                // Clear dirty flag for resource set
-                resource_binding_state.clear_dirty(descriptor_set_id);
+            set_state.gather(resource_set, descriptor_set_layout);
 
-                // Skip resource set if a descriptor set layout doesn't exist for it
-                if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
-                {
-                    continue;
-                }
+            // Clear dirty flag for resource set
+            resource_binding_state.clear_dirty(descriptor_set_id);
 
-                auto& descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
+            VkDescriptorSet descriptor_set_handle = command_pool.get_render_frame()->request_descriptor_set(
+                descriptor_set_layout, set_state.descriptor_infos, update_after_bind, command_pool.get_thread_index());
 
-                // Make descriptor set layout bound for current set
-                descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
+            bind_descriptor_set(pipeline_bind_point, pipeline_layout, descriptor_set_id, descriptor_set_handle,
+                                set_state.dynamic_offsets);
+        }
+    }
 
-                BindingMap<VkDescriptorBufferInfo> buffer_infos;
-                BindingMap<VkDescriptorImageInfo> image_infos;
+    void CommandBuffer::bind_descriptor_set(VkPipelineBindPoint pipeline_bind_point,
+                                            vkb::PipelineLayout const& pipeline_layout, uint32_t set,
+                                            VkDescriptorSet descriptor_set, const std::vector<uint32_t>& dynamic_offsets)
+    {
+        auto& set_state = descriptor_set_states[set];
 
-                std::vector<uint32_t> dynamic_offsets;
+        // Skip binding what is bound already
+        if (set_state.bound_handle == descriptor_set &&
+            set_state.bound_pipeline_layout == pipeline_layout.get_handle() &&
+            set_state.bound_dynamic_offsets == dynamic_offsets)
+        {
+            return;
+        }
 
-                // Iterate over all resource bindings
-                for (auto& binding_it : resource_set.get_resource_bindings())
-                {
-                    auto binding_index = binding_it.first;
-                    auto& binding_resources = binding_it.second;
-
-                    // Check if binding exists in the pipeline layout
-                    if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
-                    {
-                        // Iterate over all binding resources
-                        for (auto& element_it : binding_resources)
-                        {
-                            auto array_element = element_it.first;
-                            auto& resource_info = element_it.second;
-
-                            // Pointer references
-                            auto& buffer = resource_info.buffer;
-                            auto& sampler = resource_info.sampler;
-                            auto& image_view = resource_info.image_view;
-
-                            // Get buffer info
-                            if (buffer != nullptr && vkb::is_buffer_descriptor_type(binding_info->descriptorType))
-                            {
-                                VkDescriptorBufferInfo buffer_info{
-                                    resource_info.buffer->GetHandle(), resource_info.offset, resource_info.range
-                                };
-
-                                if (vkb::is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
-                                {
-                                    dynamic_offsets.push_back(to_u32(buffer_info.offset));
-                                    buffer_info.offset = 0;
-                                }
-
-                                buffer_infos[binding_index][array_element] = buffer_info;
-                            }
-
-                            // Get image info
-                            else if (image_view != nullptr || sampler != nullptr)
-                            {
-                                // Can be null for input attachments
-                                VkDescriptorImageInfo image_info{
-                                    sampler ? sampler->GetHandle() : nullptr, image_view->GetHandle()
-                                };
-
-                                if (image_view != nullptr)
-                                {
-                                    // Add image layout info based on descriptor type
-                                    switch (binding_info->descriptorType)
-                                    {
-                                    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-                                        image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                                        break;
-                                    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-                                        image_info.imageLayout = vkb::is_depth_format(image_view->get_format())
-                                                                     ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-                                                                     : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                                        break;
-                                    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-                                        image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-                                        break;
-                                    default:
-                                        continue;
-                                    }
-                                }
-
-                                image_infos[binding_index][array_element] = image_info;
-                            }
-                        }
-
-                        assert(
-                            (!update_after_bind || (buffer_infos.count(binding_index) > 0 || (image_infos.count(
-                                binding_index) > 0))) &&
-                            "binding index with no buffer or image infos can't be checked for adding to bindings_to_update");
-                    }
-                }
+        // Bind descriptor set
+        vkCmdBindDescriptorSets(
+            this->GetHandle(), // commandBuffer (VkCommandBuffer)
+            pipeline_bind_point, // pipelineBindPoint (VkPipelineBindPoint)
+            pipeline_layout.get_handle(), // layout (VkPipelineLayout)
+            set, // firstSet (uint32_t)
+            1, // descriptorSetCount (uint32_t)
+            &descriptor_set, // pDescriptorSets (const VkDescriptorSet*)
+            to_u32(dynamic_offsets.size()), // dynamicOffsetCount (uint32_t)
+            dynamic_offsets.data() // pDynamicOffsets (const uint32_t*)
+        );
 
-                VkDescriptorSet descriptor_set_handle = command_pool.get_render_frame()->request_descriptor_set(
-                    descriptor_set_layout, buffer_infos, image_infos, update_after_bind,
-                    command_pool.get_thread_index());
-
-                // Bind descriptor set
-                vkCmdBindDescriptorSets(
-                    this->GetHandle(), // commandBuffer (VkCommandBuffer)
-                    pipeline_bind_point, // pipelineBindPoint (VkPipelineBindPoint)
-                    pipeline_layout.get_handle(), // layout (VkPipelineLayout)
-                    descriptor_set_id, // firstSet (uint32_t)
-                    1, // descriptorSetCount (uint32_t)
-                    &descriptor_set_handle, // pDescriptorSets (const VkDescriptorSet*)
-                    static_cast<uint32_t>(dynamic_offsets.size()), // dynamicOffsetCount (uint32_t)
-                    dynamic_offsets.data() // pDynamicOffsets (const uint32_t*)
-                );
-            }
+        set_state.bound_handle = descriptor_set;
+        set_state.bound_pipeline_layout = pipeline_layout.get_handle();
+        if (&set_state.bound_dynamic_offsets != &dynamic_offsets)
+        {
+            set_state.bound_dynamic_offsets.assign(dynamic_offsets.begin(), dynamic_offsets.end());
+        }
+    }
+
+    void CommandBuffer::reset_descriptor_set_states()
+    {
+        for (auto& set_state : descriptor_set_states)
+        {
+            set_state.layout = nullptr;
+            set_state.bound_handle = VK_NULL_HANDLE;
+            set_state.bound_pipeline_layout = VK_NULL_HANDLE;
+            set_state.bound_dynamic_offsets.clear();
         }
     }
 
@@ -1010,28 +998,87 @@ namespace vkb
             return;
         }
 
-        pipeline_state.clear_dirty();
-
         // Create and bind pipeline
         if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
         {
             pipeline_state.set_render_pass(*current_render_pass);
-            auto& pipeline = device.get_resource_cache().request_graphics_pipeline(pipeline_state);
 
-            vkCmdBindPipeline(this->GetHandle(), pipeline_bind_point, pipeline.get_handle());
+            auto* compiler = device.get_resource_cache().get_pipeline_compiler();
+            if (!compiler)
+            {
+                pipeline_state.clear_dirty();
+
+                auto& pipeline = device.get_resource_cache().request_graphics_pipeline(pipeline_state);
+                bind_pipeline_impl(pipeline_bind_point, pipeline.get_handle(), pipeline_state.get_pipeline_layout());
+
+                return;
+            }
+
+            if (auto* pipeline = compiler->get_graphics_pipeline(pipeline_state))
+            {
+                pipeline_state.clear_dirty();
+                bind_pipeline_impl(pipeline_bind_point, pipeline->get_handle(), pipeline_state.get_pipeline_layout());
+
+                return;
+            }
+
+            // The state stays dirty while the pipeline compiles, so the next draw checks again and swaps it in
+            if (auto* fallback_layout = compiler->get_fallback(pipeline_state.get_pipeline_layout()))
+            {
+                vkb::PipelineState fallback_state = pipeline_state;
+                fallback_state.set_pipeline_layout(*fallback_layout);
+
+                if (auto* fallback = compiler->get_graphics_pipeline(fallback_state))
+                {
+                    compiler->record_fallback_draw();
+                    bind_pipeline_impl(pipeline_bind_point, fallback->get_handle(), *fallback_layout);
+
+                    return;
+                }
+            }
+
+            // Skipping the draw would drop geometry, it compiles the pipeline here or waits for the worker building it
+            compiler->record_waited_draw();
+            pipeline_state.clear_dirty();
+
+            auto& pipeline = device.get_resource_cache().request_graphics_pipeline(pipeline_state);
+            bind_pipeline_impl(pipeline_bind_point, pipeline.get_handle(), pipeline_state.get_pipeline_layout());
         }
         else if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE)
         {
-            auto& pipeline = device.get_resource_cache().request_compute_pipeline(pipeline_state);
+            pipeline_state.clear_dirty();
 
-            vkCmdBindPipeline(this->GetHandle(), pipeline_bind_point, pipeline.get_handle());
+            auto& pipeline = device.get_resource_cache().request_compute_pipeline(pipeline_state);
+            bind_pipeline_impl(pipeline_bind_point, pipeline.get_handle(), pipeline_state.get_pipeline_layout());
         }
         else
         {
+            pipeline_state.clear_dirty();
+
             LOG_WARN("Only graphics and compute pipeline bind points are supported now");
         }
     }
 
+    void CommandBuffer::bind_pipeline_impl(VkPipelineBindPoint pipeline_bind_point, VkPipeline pipeline,
+                                           vkb::PipelineLayout const& pipeline_layout)
+    {
+        bound_pipeline_layout = &pipeline_layout;
+
+        // A fallback stays bound over consecutive draws while the real pipeline compiles
+        if (pipeline == bound_pipeline)
+        {
+            return;
+        }
+
+        bound_pipeline = pipeline;
+        vkCmdBindPipeline(this->GetHandle(), pipeline_bind_point, pipeline);
+    }
+
+    vkb::PipelineLayout const& CommandBuffer::get_bound_pipeline_layout() const
+    {
+        return bound_pipeline_layout ? *bound_pipeline_layout : pipeline_state.get_pipeline_layout();
+    }
+
     void CommandBuffer::flush_push_constants()
     {
         if (stored_push_constants.empty())
@@ -1039,7 +1086,7 @@ namespace vkb
             return;
         }
 
-        auto const& pipeline_layout = pipeline_state.get_pipeline_layout();
+        auto const& pipeline_layout = get_bound_pipeline_layout();
 
         VkShaderStageFlags shader_stage = pipeline_layout.get_push_constant_range_stage(
             to_u32(stored_push_constants.size()));
@@ -1051,8 +1098,8 @@ namespace vkb
                 pipeline_layout.get_handle(), // VkPipelineLayout layout
                 shader_stage, // VkShaderStageFlags stageFlags
                 0, // uint32_t offset
-                sizeof(stored_push_constants), // uint32_t size
-                &stored_push_constants // const void* pValues
+                to_u32(stored_push_constants.size()), // uint32_t size
+                stored_push_constants.data() // const void* pValues
             );
         }
         else
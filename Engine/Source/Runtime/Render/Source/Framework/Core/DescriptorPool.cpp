@@ -152,53 +152,54 @@ namespace vkb
 
 	std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
 	{
-		// Create a new pool
-		if (pools.size() <= search_index)
+		// Skip the full pools
+		while (search_index < pools.size() && pool_sets_count[search_index] >= pool_max_sets)
 		{
-			VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-
-			create_info.poolSizeCount = to_u32(pool_sizes.size());
-			create_info.pPoolSizes = pool_sizes.data();
-			create_info.maxSets = pool_max_sets;
+			++search_index;
+		}
 
-			// We do not set FREE_DESCRIPTOR_SET_BIT as we do not need to free individual descriptor sets
-			create_info.flags = 0;
+		if (search_index < pools.size())
+		{
+			return search_index;
+		}
 
-			// Check descriptor set layout and enable the required flags
-			auto &binding_flags = descriptor_set_layout->get_binding_flags();
-			for (auto binding_flag : binding_flags)
-			{
-				if (binding_flag & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT)
-				{
-					create_info.flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
-				}
-			}
+		// Create a new pool
+		VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
 
-			VkDescriptorPool handle = VK_NULL_HANDLE;
+		create_info.poolSizeCount = to_u32(pool_sizes.size());
+		create_info.pPoolSizes = pool_sizes.data();
+		create_info.maxSets = pool_max_sets;
 
-			// Create the Vulkan descriptor pool
-			auto result = vkCreateDescriptorPool(device.GetHandle(), &create_info, nullptr, &handle);
+		// We do not set FREE_DESCRIPTOR_SET_BIT as we do not need to free individual descriptor sets
+		create_info.flags = 0;
 
-			if (result != VK_SUCCESS)
+		// Check descriptor set layout and enable the required flags
+		auto &binding_flags = descriptor_set_layout->get_binding_flags();
+		for (auto binding_flag : binding_flags)
+		{
+			if (binding_flag & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT)
 			{
-				return 0;
+				create_info.flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
 			}
+		}
 
-			// Store internally the Vulkan handle
-			pools.push_back(handle);
+		VkDescriptorPool handle = VK_NULL_HANDLE;
 
-			// Add set count for the descriptor pool
-			pool_sets_count.push_back(0);
+		// Create the Vulkan descriptor pool
+		auto result = vkCreateDescriptorPool(device.GetHandle(), &create_info, nullptr, &handle);
 
-			return search_index;
-		}
-		else if (pool_sets_count[search_index] < pool_max_sets)
+		if (result != VK_SUCCESS)
 		{
-			return search_index;
+			throw VulkanException{result, "Cannot create DescriptorPool"};
 		}
 
-		// Increment pool index
-		return find_available_pool(++search_index);
+		// Store internally the Vulkan handle
+		pools.push_back(handle);
+
+		// Add set count for the descriptor pool
+		pool_sets_count.push_back(0);
+
+		return to_u32(pools.size() - 1);
 	}
 } // namespace vkb
 
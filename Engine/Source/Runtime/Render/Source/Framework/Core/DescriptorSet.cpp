@@ -1,7 +1,7 @@
 #include "Framework/Core/DescriptorSet.hpp"
 #include "Framework/Core/DescriptorPool.hpp"
 #include "Framework/Core/DescriptorSetLayout.hpp"
-#include "Framework/Common/ResourceCaching.hpp"
+#include "Framework/Common/ResourceKey.hpp"
 #include <algorithm>
 #include <vector>
 #include "Framework/Core/VulkanDevice.hpp"
@@ -9,6 +9,41 @@
 
 namespace vkb
 {
+	namespace
+	{
+		/// Hashes the target and the descriptors of a write, to skip rewriting bindings that did not change
+		uint64_t hash_write_operation(const VkWriteDescriptorSet &write_operation)
+		{
+			ResourceKey key;
+			key.write(write_operation.dstSet);
+			key.write(write_operation.dstBinding);
+			key.write(write_operation.dstArrayElement);
+			key.write(write_operation.descriptorCount);
+			key.write(write_operation.descriptorType);
+
+			for (uint32_t i = 0; i < write_operation.descriptorCount; i++)
+			{
+				if (write_operation.pImageInfo)
+				{
+					key.write(write_operation.pImageInfo[i].sampler);
+					key.write(write_operation.pImageInfo[i].imageView);
+					key.write(write_operation.pImageInfo[i].imageLayout);
+				}
+				if (write_operation.pBufferInfo)
+				{
+					key.write(write_operation.pBufferInfo[i].buffer);
+					key.write(write_operation.pBufferInfo[i].offset);
+					key.write(write_operation.pBufferInfo[i].range);
+				}
+				if (write_operation.pTexelBufferView)
+				{
+					key.write(write_operation.pTexelBufferView[i]);
+				}
+			}
+
+			return key.get_hash();
+		}
+	} // namespace
 
 	DescriptorSet::DescriptorSet(VulkanDevice &device,
 								 const DescriptorSetLayout &descriptor_set_layout,
@@ -136,7 +171,7 @@ namespace vkb
 	void DescriptorSet::update(const std::vector<uint32_t> &bindings_to_update)
 	{
 		std::vector<VkWriteDescriptorSet> write_operations;
-		std::vector<size_t> write_operation_hashes;
+		std::vector<uint64_t> write_operation_hashes;
 
 		// If the 'bindings_to_update' vector is empty, we want to write to all the bindings
 		// (but skipping all to-update bindings that haven't been written yet)
@@ -146,8 +181,7 @@ namespace vkb
 			{
 				const auto &write_operation = write_descriptor_sets[i];
 
-				size_t write_operation_hash = 0;
-				hash_param(write_operation_hash, write_operation);
+				uint64_t write_operation_hash = hash_write_operation(write_operation);
 
 				auto update_pair_it = updated_bindings.find(write_operation.dstBinding);
 				if (update_pair_it == updated_bindings.end() || update_pair_it->second != write_operation_hash)
@@ -167,8 +201,7 @@ namespace vkb
 
 				if (std::find(bindings_to_update.begin(), bindings_to_update.end(), write_operation.dstBinding) != bindings_to_update.end())
 				{
-					size_t write_operation_hash = 0;
-					hash_param(write_operation_hash, write_operation);
+					uint64_t write_operation_hash = hash_write_operation(write_operation);
 
 					auto update_pair_it = updated_bindings.find(write_operation.dstBinding);
 					if (update_pair_it == updated_bindings.end() || update_pair_it->second != write_operation_hash)
@@ -198,6 +231,20 @@ namespace vkb
 		}
 	}
 
+	void DescriptorSet::update_with_template(const DescriptorInfo *descriptor_infos)
+	{
+		assert(descriptor_set_layout.get_update_template() != VK_NULL_HANDLE && "The layout has no update template");
+
+		vkUpdateDescriptorSetWithTemplate(device.GetHandle(), handle, descriptor_set_layout.get_update_template(), descriptor_infos);
+
+		for (auto &write_operation : write_descriptor_sets)
+		{
+			uint64_t write_operation_hash = hash_write_operation(write_operation);
+
+			updated_bindings[write_operation.dstBinding] = write_operation_hash;
+		}
+	}
+
 	void DescriptorSet::apply_writes() const
 	{
 		vkUpdateDescriptorSets(device.GetHandle(),
@@ -229,6 +276,11 @@ namespace vkb
 		return descriptor_set_layout;
 	}
 
+	DescriptorPool &DescriptorSet::get_descriptor_pool() const
+	{
+		return descriptor_pool;
+	}
+
 	BindingMap<VkDescriptorBufferInfo> &DescriptorSet::get_buffer_infos()
 	{
 		return buffer_infos;
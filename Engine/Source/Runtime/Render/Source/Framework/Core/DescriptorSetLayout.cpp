@@ -2,6 +2,7 @@
 #include "Framework/Core/ShaderModule.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
 #include "Framework/Common/VkError.hpp"
+#include "Logging/Logger.hpp"
 #include <algorithm>
 
 namespace vks
@@ -183,6 +184,13 @@ namespace vkb
             {
                 binding_flags.push_back(VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT);
             }
+            else if (resource.mode == ShaderResourceMode::Bindless)
+            {
+                // Sparsely filled arrays, written while frames using other elements are in flight
+                binding_flags.push_back(VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                                        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+                                        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT);
+            }
             else
             {
                 // When creating a descriptor set layout, if we give a structure to create_info.pNext, each binding needs to have a binding flag
@@ -218,7 +226,8 @@ namespace vkb
         VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT};
         if (std::find_if(resource_set.begin(), resource_set.end(),
                          [](const ShaderResource &shader_resource)
-                         { return shader_resource.mode == ShaderResourceMode::UpdateAfterBind; }) != resource_set.end())
+                         { return shader_resource.mode == ShaderResourceMode::UpdateAfterBind ||
+                                  shader_resource.mode == ShaderResourceMode::Bindless; }) != resource_set.end())
         {
             // Spec states you can't have ANY dynamic resources if you have one of the bindings set to update-after-bind
             if (std::find_if(resource_set.begin(), resource_set.end(),
@@ -237,7 +246,11 @@ namespace vkb
             binding_flags_create_info.pBindingFlags = binding_flags.data();
 
             create_info.pNext = &binding_flags_create_info;
-            create_info.flags |= std::find(binding_flags.begin(), binding_flags.end(), VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT) != binding_flags.end() ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT : 0;
+            create_info.flags |= std::find_if(binding_flags.begin(), binding_flags.end(),
+                                              [](VkDescriptorBindingFlagsEXT flags)
+                                              { return (flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT) != 0; }) != binding_flags.end() ?
+                                     VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT :
+                                     0;
         }
 
         // Create the Vulkan descriptor set layout handle
@@ -247,6 +260,77 @@ namespace vkb
         {
             throw VulkanException{result, "Cannot create DescriptorSetLayout"};
         }
+
+        // Lay the descriptors of all bindings out in one array, ordered by binding number
+        std::vector<VkDescriptorSetLayoutBinding> sorted_bindings = bindings;
+        std::sort(sorted_bindings.begin(), sorted_bindings.end(),
+                  [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b)
+                  { return a.binding < b.binding; });
+
+        for (auto &binding : sorted_bindings)
+        {
+            if (binding.binding >= descriptor_ranges.size())
+            {
+                descriptor_ranges.resize(binding.binding + 1);
+            }
+
+            auto &range = descriptor_ranges[binding.binding];
+            range.offset = descriptor_count;
+            range.count = binding.descriptorCount;
+            range.type = binding.descriptorType;
+            range.dynamic_offset = dynamic_offset_count;
+
+            descriptor_count += binding.descriptorCount;
+
+            if (is_dynamic_buffer_descriptor_type(binding.descriptorType))
+            {
+                dynamic_offset_count += binding.descriptorCount;
+            }
+        }
+
+        create_update_template();
+    }
+
+    void DescriptorSetLayout::create_update_template()
+    {
+        // Core in Vulkan 1.1, the loader leaves it null on older devices
+        if (!vkCreateDescriptorUpdateTemplate || bindings.empty())
+        {
+            return;
+        }
+
+        std::vector<VkDescriptorUpdateTemplateEntry> entries;
+        entries.reserve(bindings.size());
+
+        for (auto &binding : bindings)
+        {
+            auto &range = descriptor_ranges[binding.binding];
+
+            VkDescriptorUpdateTemplateEntry entry{};
+            entry.dstBinding = binding.binding;
+            entry.dstArrayElement = 0;
+            entry.descriptorCount = range.count;
+            entry.descriptorType = range.type;
+            entry.offset = range.offset * sizeof(DescriptorInfo);
+            entry.stride = sizeof(DescriptorInfo);
+
+            entries.push_back(entry);
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO};
+        create_info.descriptorUpdateEntryCount = to_u32(entries.size());
+        create_info.pDescriptorUpdateEntries = entries.data();
+        create_info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        create_info.descriptorSetLayout = handle;
+
+        VkResult result = vkCreateDescriptorUpdateTemplate(device.GetHandle(), &create_info, nullptr, &update_template);
+
+        if (result != VK_SUCCESS)
+        {
+            // Sets of this layout are written descriptor by descriptor instead
+            LOGW("Cannot create descriptor update template for set {}: {}", set_index, to_string(result));
+            update_template = VK_NULL_HANDLE;
+        }
     }
 
     DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) : device{other.device},
@@ -257,13 +341,23 @@ namespace vkb
                                                                             binding_flags{std::move(other.binding_flags)},
                                                                             bindings_lookup{std::move(other.bindings_lookup)},
                                                                             binding_flags_lookup{std::move(other.binding_flags_lookup)},
-                                                                            resources_lookup{std::move(other.resources_lookup)}
+                                                                            resources_lookup{std::move(other.resources_lookup)},
+                                                                            descriptor_ranges{std::move(other.descriptor_ranges)},
+                                                                            descriptor_count{other.descriptor_count},
+                                                                            dynamic_offset_count{other.dynamic_offset_count},
+                                                                            update_template{other.update_template}
     {
         other.handle = VK_NULL_HANDLE;
+        other.update_template = VK_NULL_HANDLE;
     }
 
     DescriptorSetLayout::~DescriptorSetLayout()
     {
+        if (update_template != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorUpdateTemplate(device.GetHandle(), update_template, nullptr);
+        }
+
         // Destroy descriptor set layout
         if (handle != VK_NULL_HANDLE)
         {
@@ -332,4 +426,29 @@ namespace vkb
         return shader_modules;
     }
 
+    const DescriptorRange *DescriptorSetLayout::get_descriptor_range(uint32_t binding_index) const
+    {
+        if (binding_index >= descriptor_ranges.size() || descriptor_ranges[binding_index].count == 0)
+        {
+            return nullptr;
+        }
+
+        return &descriptor_ranges[binding_index];
+    }
+
+    uint32_t DescriptorSetLayout::get_descriptor_count() const
+    {
+        return descriptor_count;
+    }
+
+    uint32_t DescriptorSetLayout::get_dynamic_offset_count() const
+    {
+        return dynamic_offset_count;
+    }
+
+    VkDescriptorUpdateTemplate DescriptorSetLayout::get_update_template() const
+    {
+        return update_template;
+    }
+
 } // namespace vkb
@@ -51,6 +51,13 @@ namespace vkb
         view_info.format = format;
         view_info.subresourceRange = subresource_range;
 
+        // BC4 holds greyscale textures, replicate red so they sample like the RGBA source they were cooked from
+        if (format == VK_FORMAT_BC4_UNORM_BLOCK)
+        {
+            view_info.components = {VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R,
+                                    VK_COMPONENT_SWIZZLE_ONE};
+        }
+
         auto result = vkCreateImageView(GetDevice().GetHandle(), &view_info, nullptr, &GetHandle());
 
         if (result != VK_SUCCESS)
@@ -0,0 +1,157 @@
+#include "Framework/Core/PipelineCache.hpp"
+
+#include <cstring>
+
+#include "Framework/Common/VkError.hpp"
+#include "Framework/Core/PhysicalDevice.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Logging/Logger.hpp"
+#include "Misc/Hash.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        /// "CYPC"
+        constexpr uint32_t pipeline_cache_magic = 0x43505943;
+
+        /// Bump when the header layout changes
+        constexpr uint32_t pipeline_cache_version = 1;
+
+        struct PipelineCacheHeader
+        {
+            uint32_t magic;
+
+            uint32_t version;
+
+            uint32_t vendor_id;
+
+            uint32_t device_id;
+
+            uint32_t driver_version;
+
+            uint8_t uuid[VK_UUID_SIZE];
+
+            uint64_t data_size;
+
+            uint64_t data_hash;
+        };
+
+        PipelineCacheHeader make_header(const PhysicalDevice &gpu)
+        {
+            const auto &properties = gpu.get_properties();
+
+            PipelineCacheHeader header{};
+            header.magic = pipeline_cache_magic;
+            header.version = pipeline_cache_version;
+            header.vendor_id = properties.vendorID;
+            header.device_id = properties.deviceID;
+            header.driver_version = properties.driverVersion;
+            std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+            return header;
+        }
+    } // namespace
+
+    PipelineCache::PipelineCache(VulkanDevice &device, const std::vector<uint8_t> &data) : device{device}
+    {
+        VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+
+        if (!data.empty())
+        {
+            if (is_compatible(device.get_gpu(), data))
+            {
+                create_info.initialDataSize = data.size() - sizeof(PipelineCacheHeader);
+                create_info.pInitialData = data.data() + sizeof(PipelineCacheHeader);
+                warm = true;
+            }
+            else
+            {
+                LOGW("Pipeline cache was created by another device or driver, starting empty");
+            }
+        }
+
+        VkResult result = vkCreatePipelineCache(device.GetHandle(), &create_info, nullptr, &handle);
+
+        if (result != VK_SUCCESS && warm)
+        {
+            // Some drivers reject data they wrote themselves after an update without changing the UUID
+            LOGW("Pipeline cache data was rejected by the driver, starting empty");
+            create_info.initialDataSize = 0;
+            create_info.pInitialData = nullptr;
+            warm = false;
+
+            result = vkCreatePipelineCache(device.GetHandle(), &create_info, nullptr, &handle);
+        }
+
+        if (result != VK_SUCCESS)
+        {
+            throw VulkanException{result, "Cannot create PipelineCache"};
+        }
+    }
+
+    PipelineCache::PipelineCache(PipelineCache &&other) : device{other.device},
+                                                          handle{other.handle},
+                                                          warm{other.warm}
+    {
+        other.handle = VK_NULL_HANDLE;
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+        if (handle != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineCache(device.GetHandle(), handle, nullptr);
+        }
+    }
+
+    VkPipelineCache PipelineCache::get_handle() const
+    {
+        return handle;
+    }
+
+    bool PipelineCache::is_warm() const
+    {
+        return warm;
+    }
+
+    std::vector<uint8_t> PipelineCache::serialize() const
+    {
+        size_t data_size = 0;
+        VK_CHECK_RESULT(vkGetPipelineCacheData(device.GetHandle(), handle, &data_size, nullptr));
+
+        std::vector<uint8_t> data(sizeof(PipelineCacheHeader) + data_size);
+        VK_CHECK_RESULT(vkGetPipelineCacheData(device.GetHandle(), handle, &data_size,
+                                               data.data() + sizeof(PipelineCacheHeader)));
+        data.resize(sizeof(PipelineCacheHeader) + data_size);
+
+        auto header = make_header(device.get_gpu());
+        header.data_size = data_size;
+        header.data_hash = Hash::Hash64(data.data() + sizeof(PipelineCacheHeader), data_size);
+        std::memcpy(data.data(), &header, sizeof(header));
+
+        return data;
+    }
+
+    bool PipelineCache::is_compatible(const PhysicalDevice &gpu, const std::vector<uint8_t> &data)
+    {
+        if (data.size() < sizeof(PipelineCacheHeader))
+        {
+            return false;
+        }
+
+        PipelineCacheHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        auto expected = make_header(gpu);
+
+        return header.magic == expected.magic &&
+               header.version == expected.version &&
+               header.vendor_id == expected.vendor_id &&
+               header.device_id == expected.device_id &&
+               header.driver_version == expected.driver_version &&
+               std::memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) == 0 &&
+               header.data_size == data.size() - sizeof(PipelineCacheHeader) &&
+               header.data_hash == Hash::Hash64(data.data() + sizeof(PipelineCacheHeader), header.data_size);
+    }
+} // namespace vkb
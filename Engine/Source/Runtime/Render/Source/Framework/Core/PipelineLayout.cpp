@@ -16,6 +16,7 @@
  */
 
 #include "Framework/Core/PipelineLayout.hpp"
+#include "Framework/Core/BindlessDescriptorTable.hpp"
 #include "Framework/Core/DescriptorSetLayout.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
 #include "Framework/Core/ShaderModule.hpp"
@@ -76,9 +77,18 @@ namespace vkb
 			}
 		}
 
+		auto *bindless_table = device.get_resource_cache().get_bindless_table();
+
 		// Create a descriptor set layout for each shader set in the shader modules
 		for (auto &shader_set_it : shader_sets)
 		{
+			// The bindless set is declared with unsized arrays, it uses the layout of the table instead
+			if (bindless_table && shader_set_it.first == bindless_table->get_set_index())
+			{
+				descriptor_set_layouts.emplace_back(const_cast<DescriptorSetLayout *>(&bindless_table->get_layout()));
+				continue;
+			}
+
 			descriptor_set_layouts.emplace_back(&device.get_resource_cache().request_descriptor_set_layout(shader_set_it.first, shader_modules, shader_set_it.second));
 		}
 
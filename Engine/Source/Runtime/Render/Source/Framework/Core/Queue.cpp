@@ -81,13 +81,18 @@ namespace vkb
         return vkQueueSubmit(handle, to_u32(submit_infos.size()), submit_infos.data(), fence);
     }
 
+    VkResult Queue::submit(const VkSubmitInfo& submit_info, VkFence fence) const
+    {
+        return vkQueueSubmit(handle, 1, &submit_info, fence);
+    }
+
     VkResult Queue::submit(const vkb::CommandBuffer& command_buffer, VkFence fence) const
     {
         VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
         submit_info.commandBufferCount = 1;
         submit_info.pCommandBuffers = &command_buffer.GetHandle();
 
-        return submit({submit_info}, fence);
+        return submit(submit_info, fence);
     }
 
     VkResult Queue::present(const VkPresentInfoKHR& present_info) const
@@ -18,14 +18,119 @@
 #include "Framework/Core/ShaderModule.hpp"
 #include "spdlog/fmt/fmt.h"
 #include <Misc/FileLoader.hpp>
-#include "Framework/Misc/SpirvReflection.hpp"
+#include "Framework/Misc/ShaderReflectionCache.hpp"
+#include "Misc/Hash.hpp"
 #include <algorithm>
+#include <filesystem>
+#include "SubSystems/GlslCompiler.hpp"
 #include "Framework/Common/VkError.hpp"
 #include "Logging/Logger.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
 
 namespace vkb
 {
+    namespace
+    {
+        GlslStage to_glsl_stage(VkShaderStageFlagBits stage)
+        {
+            switch (stage)
+            {
+            case VK_SHADER_STAGE_VERTEX_BIT:
+                return GlslStage::Vertex;
+            case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+                return GlslStage::TessControl;
+            case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+                return GlslStage::TessEvaluation;
+            case VK_SHADER_STAGE_GEOMETRY_BIT:
+                return GlslStage::Geometry;
+            case VK_SHADER_STAGE_FRAGMENT_BIT:
+                return GlslStage::Fragment;
+            case VK_SHADER_STAGE_COMPUTE_BIT:
+                return GlslStage::Compute;
+            case VK_SHADER_STAGE_RAYGEN_BIT_KHR:
+                return GlslStage::RayGen;
+            case VK_SHADER_STAGE_INTERSECTION_BIT_KHR:
+                return GlslStage::Intersect;
+            case VK_SHADER_STAGE_ANY_HIT_BIT_KHR:
+                return GlslStage::AnyHit;
+            case VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR:
+                return GlslStage::ClosestHit;
+            case VK_SHADER_STAGE_MISS_BIT_KHR:
+                return GlslStage::Miss;
+            case VK_SHADER_STAGE_CALLABLE_BIT_KHR:
+                return GlslStage::Callable;
+            case VK_SHADER_STAGE_TASK_BIT_EXT:
+                return GlslStage::Task;
+            case VK_SHADER_STAGE_MESH_BIT_EXT:
+                return GlslStage::Mesh;
+            default:
+                throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Unsupported shader stage"};
+            }
+        }
+
+        bool is_spirv_file(const std::string &filename)
+        {
+            return std::filesystem::path{filename}.extension() == ".spv";
+        }
+    } // namespace
+
+    bool ShaderModule::prepare_compile_job(VkShaderStageFlagBits stage, const ShaderSource &shader_source,
+                                           const std::string &entry_point, const ShaderVariant &shader_variant,
+                                           GlslCompileJob &job, const std::string *glsl_source)
+    {
+        const auto &filename = shader_source.get_filename();
+
+        job.stage = to_glsl_stage(stage);
+        job.entry_point = entry_point;
+        job.preamble = shader_variant.get_preamble();
+
+        if (is_spirv_file(filename))
+        {
+            // Precompiled binaries are used as they are unless the variant adds defines, which needs the GLSL next to it
+            std::filesystem::path glsl_path{filename};
+            glsl_path.replace_extension();
+
+            std::error_code error;
+            if (shader_variant.get_preamble().empty() || !std::filesystem::is_regular_file(glsl_path, error))
+            {
+                return false;
+            }
+
+            job.source = glsl_source ? *glsl_source : FileLoader::ReadTextFile(glsl_path.string());
+            job.source_path = glsl_path;
+        }
+        else
+        {
+            job.source = shader_source.get_source();
+            job.source_path = filename;
+        }
+
+        return true;
+    }
+
+    std::vector<uint32_t> ShaderModule::load_spirv(VkShaderStageFlagBits stage, const ShaderSource &shader_source,
+                                                   const std::string &entry_point, const ShaderVariant &shader_variant)
+    {
+        GlslCompileJob job;
+        if (!prepare_compile_job(stage, shader_source, entry_point, shader_variant, job))
+        {
+            if (!shader_variant.get_preamble().empty())
+            {
+                LOGW("No GLSL source next to {}, the defines of variant {:X} are ignored", shader_source.get_filename(),
+                     shader_variant.get_id());
+            }
+            return FileLoader::ReadShaderBinaryU32(shader_source.get_filename());
+        }
+
+        if (!GlslCompiler::GetInstance().Compile(job))
+        {
+            LOGE("Failed to compile {}:\n{}", job.source_path.string(), job.info_log);
+            throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Shader compilation failed"};
+        }
+
+        return std::move(job.spirv);
+    }
+
     ShaderModule::ShaderModule(VulkanDevice &device, VkShaderStageFlagBits stage, const ShaderSource &shader_source,
                                const std::string &entry_point, const ShaderVariant &shader_variant) : device{device},
                                                                                                       stage{stage},
@@ -34,32 +139,28 @@ namespace vkb
         debug_name = fmt::format("{} [variant {:X}] [entrypoint {}]", shader_source.get_filename(),
                                  shader_variant.get_id(), entry_point);
 
-        // Shaders in binary SPIR-V format can be loaded directly
-        spirv = FileLoader::ReadShaderBinaryU32(shader_source.get_filename());
+        spirv = load_spirv(stage, shader_source, entry_point, shader_variant);
 
-        // Reflection is used to dynamically create descriptor bindings
+        // Hashed once, the reflection cache key and the module id are both derived from it
+        uint64_t spirv_hash = Hash::Hash64(spirv.data(), spirv.size() * sizeof(uint32_t));
 
-        SPIRVReflection spirv_reflection;
-        // Reflect all shader resources
-        if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+        // Reflection is used to dynamically create descriptor bindings, once per unique binary
+        if (!ShaderReflectionCache::GetInstance().reflect(stage, spirv, spirv_hash, shader_variant, resources))
         {
             throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
         }
 
         // Generate a unique id, determined by source and variant
-        std::hash<std::string> hasher{};
-        id = hasher(std::string{
-            reinterpret_cast<const char *>(spirv.data()),
-            reinterpret_cast<const char *>(spirv.data() + spirv.size())});
+        id = static_cast<size_t>(spirv_hash);
     }
 
-    ShaderModule::ShaderModule(ShaderModule &&other) : device{other.device},
-                                                       id{other.id},
-                                                       stage{other.stage},
-                                                       entry_point{other.entry_point},
-                                                       debug_name{other.debug_name},
-                                                       spirv{other.spirv},
-                                                       resources{other.resources}
+    ShaderModule::ShaderModule(ShaderModule &&other) noexcept : device{other.device},
+                                                                id{other.id},
+                                                                stage{other.stage},
+                                                                entry_point{std::move(other.entry_point)},
+                                                                debug_name{std::move(other.debug_name)},
+                                                                spirv{std::move(other.spirv)},
+                                                                resources{std::move(other.resources)}
     {
         other.stage = {};
     }
@@ -220,6 +321,13 @@ namespace vkb
         id = hasher(std::string{this->source.cbegin(), this->source.cend()});
     }
 
+    ShaderSource::ShaderSource(const std::string &filename, std::string source) : filename{filename},
+                                                                                  source{std::move(source)}
+    {
+        std::hash<std::string> hasher{};
+        id = hasher(this->source);
+    }
+
     size_t ShaderSource::get_id() const
     {
         return id;
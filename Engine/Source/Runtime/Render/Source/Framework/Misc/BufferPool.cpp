@@ -1,10 +1,12 @@
 #include "Framework/Misc/BufferPool.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
 
+#include <cstring>
+
 namespace vkb
 {
-    BufferAllocation::BufferAllocation(Buffer& buffer, DeviceSizeType size, DeviceSizeType offset)
-        : buffer(&buffer), offset(offset), size(size)
+    BufferAllocation::BufferAllocation(Buffer& buffer, DeviceSizeType size, DeviceSizeType offset, uint8_t* data)
+        : buffer(&buffer), offset(offset), size(size), data(data)
     {
     }
 
@@ -28,17 +30,34 @@ namespace vkb
         return size;
     }
 
+    uint8_t* BufferAllocation::get_data() const
+    {
+        return data;
+    }
+
     void BufferAllocation::update(const std::vector<uint8_t>& data, uint32_t offset)
+    {
+        copy(data.data(), data.size(), offset);
+    }
+
+    void BufferAllocation::copy(const void* source, size_t data_size, uint32_t offset)
     {
         assert(buffer && "Invalid buffer pointer");
 
-        if (offset + data.size() <= size)
+        if (offset + data_size > size)
+        {
+            // TODO LOGE("Ignore buffer allocation update");
+            return;
+        }
+
+        if (data)
         {
-            buffer->update(data, to_u32(this->offset) + offset);
+            // Mapped by the allocator, which flushes the whole frame at once
+            std::memcpy(data + offset, source, data_size);
         }
         else
         {
-            // TODO LOGE("Ignore buffer allocation update");
+            buffer->update(source, data_size, to_u32(this->offset) + offset);
         }
     }
 
@@ -88,29 +107,33 @@ namespace vkb
 
     VkDeviceSize BufferBlock::determine_alignment(VkBufferUsageFlags usage, VkPhysicalDeviceLimits const& limits) const
     {
-        if (usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        // Used to calculate the offset, required when allocating memory (its value should be power of 2)
+        VkDeviceSize alignment = 0;
+
+        // Combined usages take the strictest alignment of their parts
+        if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
         {
-            return limits.minUniformBufferOffsetAlignment;
+            alignment = std::max(alignment, limits.minUniformBufferOffsetAlignment);
         }
-        else if (usage == VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+        if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
         {
-            return limits.minStorageBufferOffsetAlignment;
+            alignment = std::max(alignment, limits.minStorageBufferOffsetAlignment);
         }
-        else if (usage == VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)
+        if (usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT))
         {
-            return limits.minTexelBufferOffsetAlignment;
+            alignment = std::max(alignment, limits.minTexelBufferOffsetAlignment);
         }
-        else if (usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT ||
-            usage == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT ||
-            usage == VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+        if (usage & (VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT))
         {
-            // Used to calculate the offset, required when allocating memory (its value should be power of 2)
-            return 16;
+            alignment = std::max<VkDeviceSize>(alignment, 16);
         }
-        else
+
+        if (alignment == 0)
         {
             throw std::runtime_error("Usage not recognised");
         }
+
+        return alignment;
     }
 
     BufferPool::BufferPool(DeviceType& device, DeviceSizeType block_size, BufferUsageFlagsType usage,
@@ -0,0 +1,237 @@
+#include "Framework/Misc/GpuProfiler.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/PhysicalDevice.hpp"
+#include "Framework/Core/QueryPool.hpp"
+#include "Framework/Core/Queue.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Logging/Logger.hpp"
+#include "Profiler/Profiler.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        /// The GPU and CPU clocks drift apart, they are measured against each other again this often
+        constexpr uint64_t calibration_interval = 1000000000;
+
+        constexpr uint32_t no_zone = std::numeric_limits<uint32_t>::max();
+    } // namespace
+
+    GpuProfiler::GpuProfiler(VulkanDevice &device, uint32_t frame_count, uint32_t max_zones_per_frame) :
+        device{device},
+        max_zones{std::max(1u, max_zones_per_frame)}
+    {
+        auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+        uint32_t valid_bits = queue.get_properties().timestampValidBits;
+        if (valid_bits == 0)
+        {
+            LOGW("The graphics queue has no timestamps, GPU zones are not profiled");
+            return;
+        }
+
+        timestamp_mask = valid_bits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t{1} << valid_bits) - 1;
+        timestamp_period = device.get_gpu().get_properties().limits.timestampPeriod;
+
+        if (device.is_enabled(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) && vkGetPhysicalDeviceCalibrateableTimeDomainsEXT &&
+            vkGetCalibratedTimestampsEXT)
+        {
+            uint32_t domain_count = 0;
+            vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(device.get_gpu().get_handle(), &domain_count, nullptr);
+
+            std::vector<VkTimeDomainEXT> domains(domain_count);
+            vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(device.get_gpu().get_handle(), &domain_count, domains.data());
+
+            calibrated_timestamps = std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end();
+        }
+
+        VkQueryPoolCreateInfo query_pool_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_info.queryCount = max_zones * 2;
+
+        frames.resize(std::max(1u, frame_count));
+        for (auto &frame : frames)
+        {
+            frame.query_pool = std::make_unique<QueryPool>(device, query_pool_info);
+            frame.zones.reserve(max_zones);
+        }
+
+        results.resize(static_cast<size_t>(max_zones) * 4);
+        track = &Profiler::GetInstance().CreateTrack("GPU");
+
+        calibrate();
+    }
+
+    GpuProfiler::~GpuProfiler() = default;
+
+    bool GpuProfiler::is_supported() const
+    {
+        return !frames.empty();
+    }
+
+    void GpuProfiler::begin_frame(CommandBuffer &command_buffer, uint32_t frame_index)
+    {
+        current_frame = nullptr;
+        open_zones.clear();
+
+        if (!is_supported())
+        {
+            return;
+        }
+
+        auto &frame = frames[frame_index % frames.size()];
+        read_back(frame);
+        frame.zones.clear();
+
+        if (!Profiler::GetInstance().IsEnabled())
+        {
+            return;
+        }
+
+        if (calibrated_timestamps && Profiler::Now() - last_calibration > calibration_interval)
+        {
+            calibrate();
+        }
+
+        frame.cpu_time = Profiler::Now();
+        command_buffer.reset_query_pool(*frame.query_pool, 0, max_zones * 2);
+
+        current_frame = &frame;
+    }
+
+    void GpuProfiler::begin_zone(CommandBuffer &command_buffer, const char *name)
+    {
+        if (!current_frame)
+        {
+            return;
+        }
+
+        // Zones past the capacity are dropped, their end_zone still pops them
+        if (current_frame->zones.size() >= max_zones)
+        {
+            open_zones.push_back(no_zone);
+            return;
+        }
+
+        auto index = static_cast<uint32_t>(current_frame->zones.size());
+        current_frame->zones.push_back({name, index * 2, static_cast<uint16_t>(open_zones.size())});
+        open_zones.push_back(index);
+
+        command_buffer.write_timestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, *current_frame->query_pool, index * 2);
+    }
+
+    void GpuProfiler::end_zone(CommandBuffer &command_buffer)
+    {
+        if (!current_frame || open_zones.empty())
+        {
+            return;
+        }
+
+        uint32_t index = open_zones.back();
+        open_zones.pop_back();
+
+        if (index != no_zone)
+        {
+            command_buffer.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *current_frame->query_pool,
+                                           current_frame->zones[index].query + 1);
+        }
+    }
+
+    void GpuProfiler::read_back(FrameQueries &frame)
+    {
+        if (frame.zones.empty())
+        {
+            return;
+        }
+
+        // Every query is followed by its availability, a zone left open has no end and is skipped
+        auto query_count = static_cast<uint32_t>(frame.zones.size() * 2);
+        VkResult result = frame.query_pool->get_results(0, query_count, query_count * 2 * sizeof(uint64_t), results.data(),
+                                                        2 * sizeof(uint64_t),
+                                                        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY)
+        {
+            return;
+        }
+
+        auto is_available = [this](uint32_t query) { return results[query * 2 + 1] != 0; };
+        auto get_ticks = [this](uint32_t query) { return results[query * 2] & timestamp_mask; };
+
+        uint64_t first_ticks = std::numeric_limits<uint64_t>::max();
+        for (auto &zone : frame.zones)
+        {
+            if (is_available(zone.query))
+            {
+                first_ticks = std::min(first_ticks, get_ticks(zone.query));
+            }
+        }
+
+        auto to_cpu_time = [&](uint64_t ticks) -> uint64_t {
+            if (calibrated_timestamps)
+            {
+                return static_cast<uint64_t>(static_cast<int64_t>(static_cast<double>(ticks) * timestamp_period) + clock_offset);
+            }
+            return frame.cpu_time + static_cast<uint64_t>(static_cast<double>(ticks - first_ticks) * timestamp_period);
+        };
+
+        auto &profiler = Profiler::GetInstance();
+        for (auto &zone : frame.zones)
+        {
+            if (!is_available(zone.query) || !is_available(zone.query + 1))
+            {
+                continue;
+            }
+
+            uint64_t start = to_cpu_time(get_ticks(zone.query));
+            uint64_t end = std::max(start, to_cpu_time(get_ticks(zone.query + 1)));
+            profiler.RecordZone(*track, zone.name, start, end, zone.depth);
+        }
+    }
+
+    void GpuProfiler::calibrate()
+    {
+        if (!calibrated_timestamps)
+        {
+            return;
+        }
+
+        VkCalibratedTimestampInfoEXT timestamp_info{VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT};
+        timestamp_info.timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+
+        uint64_t timestamp = 0;
+        uint64_t max_deviation = 0;
+
+        // The device time is taken between the two CPU times
+        uint64_t before = Profiler::Now();
+        if (vkGetCalibratedTimestampsEXT(device.GetHandle(), 1, &timestamp_info, &timestamp, &max_deviation) != VK_SUCCESS)
+        {
+            return;
+        }
+        uint64_t after = Profiler::Now();
+
+        auto device_time = static_cast<int64_t>(static_cast<double>(timestamp & timestamp_mask) * timestamp_period);
+        clock_offset = static_cast<int64_t>(before + (after - before) / 2) - device_time;
+        last_calibration = after;
+    }
+
+    ScopedGpuZone::ScopedGpuZone(GpuProfiler *profiler, CommandBuffer &command_buffer, const char *name) :
+        profiler{profiler},
+        command_buffer{command_buffer}
+    {
+        if (profiler)
+        {
+            profiler->begin_zone(command_buffer, name);
+        }
+    }
+
+    ScopedGpuZone::~ScopedGpuZone()
+    {
+        if (profiler)
+        {
+            profiler->end_zone(command_buffer);
+        }
+    }
+} // namespace vkb
@@ -0,0 +1,106 @@
+#include "Framework/Misc/MeshArena.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Framework/Core/VulkanDevice.hpp"
+
+namespace vkb
+{
+    MeshArena::MeshArena(VulkanDevice &device, uint32_t vertex_stride, uint32_t max_vertices, uint32_t max_indices, uint32_t max_meshes) :
+        vertex_stride{vertex_stride},
+        max_vertices{max_vertices},
+        max_indices{max_indices},
+        max_meshes{max_meshes}
+    {
+        vertex_buffer = std::make_unique<Buffer>(device, static_cast<VkDeviceSize>(vertex_stride) * max_vertices,
+                                                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        vertex_buffer->SetDebugName("Mesh arena vertices");
+
+        index_buffer = std::make_unique<Buffer>(device, static_cast<VkDeviceSize>(sizeof(uint32_t)) * max_indices,
+                                                VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        index_buffer->SetDebugName("Mesh arena indices");
+
+        mesh_buffer = std::make_unique<Buffer>(device, static_cast<VkDeviceSize>(sizeof(GpuMesh)) * max_meshes,
+                                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        mesh_buffer->SetDebugName("Mesh arena meshes");
+
+        meshes.reserve(max_meshes);
+    }
+
+    uint32_t MeshArena::add_mesh(const void *vertex_data, uint32_t mesh_vertex_count, const std::vector<uint32_t> &indices,
+                                 const glm::vec4 &bounding_sphere)
+    {
+        if (vertex_count + mesh_vertex_count > max_vertices || index_count + indices.size() > max_indices || meshes.size() == max_meshes)
+        {
+            throw std::runtime_error("Mesh arena is full");
+        }
+
+        GpuMesh mesh;
+        mesh.first_index = index_count;
+        mesh.index_count = static_cast<uint32_t>(indices.size());
+        mesh.vertex_offset = static_cast<int32_t>(vertex_count);
+        mesh.bounding_sphere = bounding_sphere;
+
+        vertex_buffer->update(vertex_data, static_cast<size_t>(mesh_vertex_count) * vertex_stride, static_cast<size_t>(vertex_count) * vertex_stride);
+        index_buffer->update(indices.data(), indices.size() * sizeof(uint32_t), static_cast<size_t>(index_count) * sizeof(uint32_t));
+        mesh_buffer->update(&mesh, sizeof(GpuMesh), meshes.size() * sizeof(GpuMesh));
+
+        vertex_count += mesh_vertex_count;
+        index_count += mesh.index_count;
+        meshes.push_back(mesh);
+
+        return static_cast<uint32_t>(meshes.size() - 1);
+    }
+
+    glm::vec4 MeshArena::compute_bounding_sphere(const std::vector<glm::vec3> &positions)
+    {
+        if (positions.empty())
+        {
+            return glm::vec4{0.0f};
+        }
+
+        glm::vec3 min = positions[0];
+        glm::vec3 max = positions[0];
+        for (auto &position : positions)
+        {
+            min = glm::min(min, position);
+            max = glm::max(max, position);
+        }
+
+        glm::vec3 center = (min + max) * 0.5f;
+
+        float radius = 0.0f;
+        for (auto &position : positions)
+        {
+            radius = std::max(radius, glm::length(position - center));
+        }
+
+        return glm::vec4{center, radius};
+    }
+
+    uint32_t MeshArena::get_vertex_stride() const
+    {
+        return vertex_stride;
+    }
+
+    const Buffer &MeshArena::get_vertex_buffer() const
+    {
+        return *vertex_buffer;
+    }
+
+    const Buffer &MeshArena::get_index_buffer() const
+    {
+        return *index_buffer;
+    }
+
+    const Buffer &MeshArena::get_mesh_buffer() const
+    {
+        return *mesh_buffer;
+    }
+
+    const std::vector<GpuMesh> &MeshArena::get_meshes() const
+    {
+        return meshes;
+    }
+} // namespace vkb
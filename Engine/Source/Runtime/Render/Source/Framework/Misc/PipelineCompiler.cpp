@@ -0,0 +1,184 @@
+#include "Framework/Misc/PipelineCompiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Framework/Common/ResourceCaching.hpp"
+#include "Framework/Misc/ResourceCache.hpp"
+#include "Logging/Logger.hpp"
+
+namespace vkb
+{
+    PipelineCompiler::PipelineCompiler(ResourceCache &resource_cache, uint32_t max_concurrency) :
+        resource_cache{resource_cache},
+        max_concurrency{std::max(1u, max_concurrency)}
+    {
+    }
+
+    PipelineCompiler::~PipelineCompiler()
+    {
+        {
+            // Queued jobs are abandoned, their futures report a broken promise
+            std::lock_guard<std::mutex> lock{jobs_mutex};
+            stopping = true;
+            jobs.clear();
+        }
+
+        // The running compilations reference this compiler
+        JobSystem::GetInstance().Wait(drain_counter);
+    }
+
+    std::shared_future<GraphicsPipeline *> PipelineCompiler::request_graphics_pipeline(const PipelineState &pipeline_state)
+    {
+        ResourceKey key;
+        key_param(key, pipeline_state);
+
+        {
+            std::shared_lock<std::shared_mutex> lock{pipelines_mutex};
+
+            auto it = pipelines.find(key);
+            if (it != pipelines.end())
+            {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock{pipelines_mutex};
+
+        auto it = pipelines.find(key);
+        if (it != pipelines.end())
+        {
+            return it->second;
+        }
+
+        Job job{pipeline_state, {}};
+        auto future = job.promise.get_future().share();
+        pipelines.emplace(std::move(key), future);
+
+        bool start_drain = false;
+        {
+            std::lock_guard<std::mutex> jobs_lock{jobs_mutex};
+            jobs.push_back(std::move(job));
+
+            if (draining < max_concurrency)
+            {
+                draining++;
+                start_drain = true;
+            }
+        }
+        queued++;
+
+        if (start_drain)
+        {
+            JobSystem::GetInstance().Run([this]() { drain(); }, &drain_counter);
+        }
+
+        return future;
+    }
+
+    GraphicsPipeline *PipelineCompiler::get_graphics_pipeline(const PipelineState &pipeline_state)
+    {
+        auto future = request_graphics_pipeline(pipeline_state);
+
+        if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return nullptr;
+        }
+
+        // Rethrows a failed compilation, the same as compiling on the recording thread would
+        return future.get();
+    }
+
+    void PipelineCompiler::set_fallback(const PipelineLayout &pipeline_layout, PipelineLayout &fallback_layout)
+    {
+        std::unique_lock<std::shared_mutex> lock{pipelines_mutex};
+        fallbacks[pipeline_layout.get_handle()] = &fallback_layout;
+    }
+
+    PipelineLayout *PipelineCompiler::get_fallback(const PipelineLayout &pipeline_layout) const
+    {
+        std::shared_lock<std::shared_mutex> lock{pipelines_mutex};
+
+        auto it = fallbacks.find(pipeline_layout.get_handle());
+        return it != fallbacks.end() ? it->second : nullptr;
+    }
+
+    void PipelineCompiler::record_fallback_draw()
+    {
+        fallback_draws++;
+    }
+
+    void PipelineCompiler::record_waited_draw()
+    {
+        waited_draws++;
+    }
+
+    PipelineCompiler::FrameStats PipelineCompiler::next_frame()
+    {
+        FrameStats stats;
+        stats.queued = queued.exchange(0);
+        stats.completed = completed.exchange(0);
+        stats.fallback_draws = fallback_draws.exchange(0);
+        stats.waited_draws = waited_draws.exchange(0);
+
+        {
+            std::lock_guard<std::mutex> lock{jobs_mutex};
+            stats.pending = static_cast<uint32_t>(jobs.size()) + compiling;
+        }
+
+        last_frame_stats = stats;
+        return stats;
+    }
+
+    const PipelineCompiler::FrameStats &PipelineCompiler::get_last_frame_stats() const
+    {
+        return last_frame_stats;
+    }
+
+    void PipelineCompiler::wait_idle()
+    {
+        JobSystem::GetInstance().Wait(drain_counter);
+    }
+
+    void PipelineCompiler::clear()
+    {
+        wait_idle();
+
+        std::unique_lock<std::shared_mutex> lock{pipelines_mutex};
+        pipelines.clear();
+        fallbacks.clear();
+    }
+
+    void PipelineCompiler::drain()
+    {
+        while (true)
+        {
+            Job job;
+
+            {
+                std::lock_guard<std::mutex> lock{jobs_mutex};
+                if (stopping || jobs.empty())
+                {
+                    draining--;
+                    return;
+                }
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                compiling++;
+            }
+
+            try
+            {
+                job.promise.set_value(&resource_cache.request_graphics_pipeline(job.pipeline_state));
+            }
+            catch (const std::exception &e)
+            {
+                LOGE("Background pipeline compilation failed: {}", e.what());
+                job.promise.set_exception(std::current_exception());
+            }
+            completed++;
+            compiling--;
+        }
+    }
+} // namespace vkb
@@ -1,5 +1,14 @@
 #include "Framework/Misc/ResourceBindingState.hpp"
 
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "Framework/Common/VkHelpers.hpp"
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Core/ImageView.hpp"
+#include "Framework/Core/Sampler.hpp"
+
 namespace vkb
 {
     // ===================================
@@ -8,55 +17,90 @@ namespace vkb
 
     void ResourceBindingState::reset()
     {
-        clear_dirty();
-        resource_sets.clear();
+        // Only touch the sets that were used, the arrays are large
+        for (uint32_t set = 0; set < max_sets; set++)
+        {
+            if (used_sets & (1u << set))
+            {
+                resource_sets[set].reset();
+            }
+        }
+
+        used_sets = 0;
     }
 
-    bool ResourceBindingState::is_dirty()
+    bool ResourceBindingState::is_dirty() const
     {
-        return dirty;
+        return get_dirty_sets() != 0;
     }
 
     void ResourceBindingState::clear_dirty()
     {
-        dirty = false;
+        for (uint32_t set = 0; set < max_sets; set++)
+        {
+            resource_sets[set].clear_dirty();
+        }
     }
 
     void ResourceBindingState::clear_dirty(uint32_t set)
     {
-        // 使用 at() 可能会在 set 不存在时抛出 std::out_of_range 异常
-        // 使用 operator[] 会在 set 不存在时创建一个新的 ResourceSet
-        // 原始逻辑使用 operator[]，这里予以保留
-        resource_sets[set].clear_dirty();
+        use_resource_set(set).clear_dirty();
+    }
+
+    uint32_t ResourceBindingState::get_dirty_sets() const
+    {
+        uint32_t dirty_sets = 0;
+
+        for (uint32_t set = 0; set < max_sets; set++)
+        {
+            if (resource_sets[set].is_dirty())
+            {
+                dirty_sets |= 1u << set;
+            }
+        }
+
+        return dirty_sets;
     }
 
     void ResourceBindingState::bind_buffer(const vkb::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
     {
-        resource_sets[set].bind_buffer(buffer, offset, range, binding, array_element);
-        dirty = true;
+        use_resource_set(set).bind_buffer(buffer, offset, range, binding, array_element);
     }
 
     void ResourceBindingState::bind_image(const vkb::ImageView &image_view, const vkb::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
     {
-        resource_sets[set].bind_image(image_view, sampler, binding, array_element);
-        dirty = true;
+        use_resource_set(set).bind_image(image_view, sampler, binding, array_element);
     }
 
     void ResourceBindingState::bind_image(const vkb::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
     {
-        resource_sets[set].bind_image(image_view, binding, array_element);
-        dirty = true;
+        use_resource_set(set).bind_image(image_view, binding, array_element);
     }
 
     void ResourceBindingState::bind_input(const vkb::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
     {
-        resource_sets[set].bind_input(image_view, binding, array_element);
-        dirty = true;
+        use_resource_set(set).bind_input(image_view, binding, array_element);
+    }
+
+    const ResourceSet &ResourceBindingState::get_resource_set(uint32_t set) const
+    {
+        if (set >= max_sets)
+        {
+            throw std::runtime_error("Descriptor set " + std::to_string(set) + " exceeds the supported set count");
+        }
+
+        return resource_sets[set];
     }
 
-    const std::unordered_map<uint32_t, ResourceSet> &ResourceBindingState::get_resource_sets()
+    ResourceSet &ResourceBindingState::use_resource_set(uint32_t set)
     {
-        return resource_sets;
+        if (set >= max_sets)
+        {
+            throw std::runtime_error("Descriptor set " + std::to_string(set) + " exceeds the supported set count");
+        }
+
+        used_sets |= 1u << set;
+        return resource_sets[set];
     }
 
     // ===================================
@@ -65,68 +109,216 @@ namespace vkb
 
     void ResourceSet::reset()
     {
-        clear_dirty();
-        resource_bindings.clear();
+        for (uint32_t binding = 0; binding < max_bindings; binding++)
+        {
+            if (bound_bindings & (1u << binding))
+            {
+                bindings[binding] = {};
+            }
+        }
+
+        bound_bindings = 0;
+        dirty_bindings = 0;
     }
 
     bool ResourceSet::is_dirty() const
     {
-        return dirty;
+        return dirty_bindings != 0;
     }
 
     void ResourceSet::clear_dirty()
     {
-        dirty = false;
+        dirty_bindings = 0;
+    }
+
+    uint32_t ResourceSet::get_bound_bindings() const
+    {
+        return bound_bindings;
     }
 
-    void ResourceSet::clear_dirty(uint32_t binding, uint32_t array_element)
+    uint32_t ResourceSet::get_dirty_bindings() const
     {
-        resource_bindings[binding][array_element].dirty = false;
+        return dirty_bindings;
+    }
+
+    const ResourceSet::Binding &ResourceSet::get_binding(uint32_t binding) const
+    {
+        return bindings[binding];
     }
 
     void ResourceSet::bind_buffer(const vkb::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
     {
-        auto &resource_info = resource_bindings[binding][array_element];
-        resource_info.dirty = true;
+        ResourceInfo resource_info;
         resource_info.buffer = &buffer;
         resource_info.offset = offset;
         resource_info.range = range;
 
-        dirty = true;
+        bind(resource_info, binding, array_element);
     }
 
     void ResourceSet::bind_image(const vkb::ImageView &image_view, const vkb::Sampler &sampler, uint32_t binding, uint32_t array_element)
     {
-        auto &resource_info = resource_bindings[binding][array_element];
-        resource_info.dirty = true;
+        ResourceInfo resource_info;
         resource_info.image_view = &image_view;
         resource_info.sampler = &sampler;
 
-        dirty = true;
+        bind(resource_info, binding, array_element);
     }
 
     void ResourceSet::bind_image(const vkb::ImageView &image_view, uint32_t binding, uint32_t array_element)
     {
-        auto &resource_info = resource_bindings[binding][array_element];
-        resource_info.dirty = true;
+        ResourceInfo resource_info;
         resource_info.image_view = &image_view;
-        resource_info.sampler = nullptr;
 
-        dirty = true;
+        bind(resource_info, binding, array_element);
     }
 
     void ResourceSet::bind_input(const vkb::ImageView &image_view, const uint32_t binding, const uint32_t array_element)
     {
-        auto &resource_info = resource_bindings[binding][array_element];
-        resource_info.dirty = true;
+        // Keeps the sampler of an image bound to the same element before
+        ResourceInfo resource_info = get_resource_info(binding, array_element);
+        resource_info.buffer = nullptr;
+        resource_info.offset = 0;
+        resource_info.range = 0;
         resource_info.image_view = &image_view;
 
-        dirty = true;
+        bind(resource_info, binding, array_element);
     }
 
-    const BindingMap<ResourceInfo> &ResourceSet::get_resource_bindings() const
+    ResourceInfo &ResourceSet::get_resource_info(uint32_t binding, uint32_t array_element)
     {
-        return resource_bindings;
+        if (binding >= max_bindings || array_element >= max_array_elements)
+        {
+            throw std::runtime_error("Binding " + std::to_string(binding) + " element " + std::to_string(array_element) +
+                                     " exceeds the supported resource set size");
+        }
+
+        return bindings[binding].elements[array_element];
     }
 
-} // namespace vkb
\ No newline at end of file
+    void ResourceSet::bind(const ResourceInfo &resource_info, uint32_t binding, uint32_t array_element)
+    {
+        auto &bound_info = get_resource_info(binding, array_element);
+        auto &bound_binding = bindings[binding];
+
+        bool bound = bound_binding.bound_elements & (1u << array_element);
+        if (bound &&
+            bound_info.buffer == resource_info.buffer &&
+            bound_info.offset == resource_info.offset &&
+            bound_info.range == resource_info.range &&
+            bound_info.image_view == resource_info.image_view &&
+            bound_info.sampler == resource_info.sampler)
+        {
+            return;
+        }
+
+        bound_info = resource_info;
+        bound_binding.bound_elements |= 1u << array_element;
+        bound_bindings |= 1u << binding;
+        dirty_bindings |= 1u << binding;
+    }
+
+    // ==================================
+    // GatheredDescriptors implementation
+    // ==================================
+
+    void GatheredDescriptors::gather(const ResourceSet &resource_set, const DescriptorSetLayout &descriptor_set_layout)
+    {
+        // A new layout moves every binding, gather all of them. Otherwise only the changed bindings are written again
+        uint32_t bindings_to_gather = resource_set.get_dirty_bindings();
+
+        if (layout != &descriptor_set_layout)
+        {
+            layout = &descriptor_set_layout;
+            // The infos are hashed and compared as bytes by the descriptor set cache, padding included
+            descriptor_infos.resize(descriptor_set_layout.get_descriptor_count());
+            std::memset(descriptor_infos.data(), 0, descriptor_infos.size() * sizeof(DescriptorInfo));
+            dynamic_offsets.assign(descriptor_set_layout.get_dynamic_offset_count(), 0);
+
+            bindings_to_gather = resource_set.get_bound_bindings();
+        }
+
+        for (uint32_t binding_index = 0; bindings_to_gather != 0; binding_index++, bindings_to_gather >>= 1)
+        {
+            if (!(bindings_to_gather & 1u))
+            {
+                continue;
+            }
+
+            // Check if binding exists in the pipeline layout
+            auto range = descriptor_set_layout.get_descriptor_range(binding_index);
+            if (!range)
+            {
+                continue;
+            }
+
+            auto &binding = resource_set.get_binding(binding_index);
+
+            for (uint32_t array_element = 0; array_element < range->count && array_element < ResourceSet::max_array_elements; array_element++)
+            {
+                if (!(binding.bound_elements & (1u << array_element)))
+                {
+                    continue;
+                }
+
+                auto &resource_info = binding.elements[array_element];
+                auto &descriptor_info = descriptor_infos[range->offset + array_element];
+
+                // Zeroed first and written field by field, so equal resources always give equal bytes. Assigning a
+                // whole VkDescriptorImageInfo would also copy its tail padding
+                std::memset(&descriptor_info, 0, sizeof(descriptor_info));
+
+                // Pointer references
+                auto &buffer = resource_info.buffer;
+                auto &sampler = resource_info.sampler;
+                auto &image_view = resource_info.image_view;
+
+                // Get buffer info
+                if (buffer != nullptr && is_buffer_descriptor_type(range->type))
+                {
+                    descriptor_info.buffer.buffer = buffer->GetHandle();
+                    descriptor_info.buffer.offset = resource_info.offset;
+                    descriptor_info.buffer.range = resource_info.range;
+
+                    if (is_dynamic_buffer_descriptor_type(range->type))
+                    {
+                        dynamic_offsets[range->dynamic_offset + array_element] = to_u32(resource_info.offset);
+                        descriptor_info.buffer.offset = 0;
+                    }
+                }
+
+                // Get image info
+                else if (image_view != nullptr || sampler != nullptr)
+                {
+                    // Can be null for input attachments
+                    VkImageLayout image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+                    if (image_view != nullptr)
+                    {
+                        // Add image layout info based on descriptor type
+                        switch (range->type)
+                        {
+                        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                            image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                            break;
+                        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                            image_layout = is_depth_format(image_view->get_format())
+                                                         ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                                                         : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                            break;
+                        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                            image_layout = VK_IMAGE_LAYOUT_GENERAL;
+                            break;
+                        default:
+                            continue;
+                        }
+                    }
+
+                    descriptor_info.image.sampler = sampler ? sampler->GetHandle() : VK_NULL_HANDLE;
+                    descriptor_info.image.imageView = image_view ? image_view->GetHandle() : VK_NULL_HANDLE;
+                    descriptor_info.image.imageLayout = image_layout;
+                }
+            }
+        }
+    }
+} // namespace vkb
@@ -21,37 +21,91 @@
 #include "Framework/Core/VulkanDevice.hpp"
 #include "Logging/Logger.hpp"
 #include "Framework/Core/RenderPass.hpp"
+#include "Framework/Misc/PipelineCompiler.hpp"
+#include "Misc/Hash.hpp"
+
+#include <algorithm>
+#include <cstring>
 
 namespace vkb
 {
     namespace
     {
-        template <class T, class... A>
-        T &request_resource(VulkanDevice &device, ResourceRecord &recorder, std::mutex &resource_mutex,
-                            std::unordered_map<std::size_t, T> &resources, A &...args)
+        /// "CYRS"
+        constexpr uint32_t resource_stream_magic = 0x53525943;
+
+        /// Bump when the layout of the recorded stream changes
+        constexpr uint32_t resource_stream_version = 1;
+
+        struct ResourceStreamHeader
         {
-            std::lock_guard<std::mutex> guard(resource_mutex);
+            uint32_t magic;
 
-            auto &res = request_resource(device, &recorder, resources, args...);
+            uint32_t version;
 
-            return res;
-        }
+            uint64_t data_size;
+
+            uint64_t data_hash;
+        };
     } // namespace
 
     ResourceCache::ResourceCache(VulkanDevice &device) : device{device}
     {
     }
 
-    void ResourceCache::warmup(const std::vector<uint8_t> &data)
+    ResourceCache::~ResourceCache() = default;
+
+    bool ResourceCache::warmup(const std::vector<uint8_t> &data)
     {
-        recorder.set_data(data);
+        if (data.size() < sizeof(ResourceStreamHeader))
+        {
+            return false;
+        }
+
+        ResourceStreamHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        size_t stream_size = data.size() - sizeof(header);
+        const uint8_t *stream = data.data() + sizeof(header);
+
+        if (header.magic != resource_stream_magic || header.version != resource_stream_version ||
+            header.data_size != stream_size || header.data_hash != Hash::Hash64(stream, stream_size))
+        {
+            return false;
+        }
+
+        // Replay from a separate record, recorder only gets the replayed resources the application requests again
+        ResourceRecord stream_record;
+        stream_record.set_data({stream, stream + stream_size});
+
+        try
+        {
+            replayer.play(*this, stream_record);
+        }
+        catch (const std::exception &e)
+        {
+            LOGW("Resource cache warmup stopped: {}", e.what());
+            return false;
+        }
 
-        replayer.play(*this, recorder);
+        return true;
     }
 
     std::vector<uint8_t> ResourceCache::serialize()
     {
-        return recorder.get_data();
+        auto stream = recorder.get_data();
+
+        ResourceStreamHeader header{};
+        header.magic = resource_stream_magic;
+        header.version = resource_stream_version;
+        header.data_size = stream.size();
+        header.data_hash = Hash::Hash64(stream.data(), stream.size());
+
+        std::vector<uint8_t> data(sizeof(header) + stream.size());
+        std::memcpy(data.data(), &header, sizeof(header));
+        std::memcpy(data.data() + sizeof(header), stream.data(), stream.size());
+
+        return data;
     }
 
     void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
@@ -59,64 +113,135 @@ namespace vkb
         pipeline_cache = new_pipeline_cache;
     }
 
+    void ResourceCache::set_async_pipeline_compilation(uint32_t thread_count)
+    {
+        pipeline_compiler.reset();
+
+        if (thread_count > 0)
+        {
+            pipeline_compiler = std::make_unique<PipelineCompiler>(*this, thread_count);
+        }
+    }
+
+    PipelineCompiler *ResourceCache::get_pipeline_compiler()
+    {
+        return pipeline_compiler.get();
+    }
+
+    void ResourceCache::set_bindless_table(BindlessDescriptorTable *table)
+    {
+        bindless_table = table;
+    }
+
+    BindlessDescriptorTable *ResourceCache::get_bindless_table() const
+    {
+        return bindless_table;
+    }
+
+    ShaderVariantUsage &ResourceCache::get_variant_usage()
+    {
+        return variant_usage;
+    }
+
     ShaderModule &ResourceCache::request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source,
                                                        const ShaderVariant &shader_variant)
     {
         std::string entry_point{"main"};
-        return request_resource(device, recorder, shader_module_mutex, state.shader_modules, stage, glsl_source,
-                                entry_point, shader_variant);
+        auto &shader_module = request_resource(device, &recorder, state.shader_modules, stage, glsl_source, entry_point,
+                                               shader_variant);
+
+        // Recorded once the module exists, a variant that fails to compile is not kept for the next run
+        variant_usage.record(stage, glsl_source, entry_point, shader_variant);
+
+        return shader_module;
     }
 
     PipelineLayout &ResourceCache::request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
     {
-        return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, shader_modules);
+        return request_resource(device, &recorder, state.pipeline_layouts, shader_modules);
     }
 
     DescriptorSetLayout &ResourceCache::request_descriptor_set_layout(const uint32_t set_index,
                                                                       const std::vector<ShaderModule *> &shader_modules,
                                                                       const std::vector<ShaderResource> &set_resources)
     {
-        return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, set_index,
-                                shader_modules, set_resources);
+        return request_resource(device, &recorder, state.descriptor_set_layouts, set_index, shader_modules,
+                                set_resources);
     }
 
     GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state)
     {
-        return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, pipeline_cache,
-                                pipeline_state);
+        return request_resource(device, &recorder, state.graphics_pipelines, pipeline_cache, pipeline_state);
     }
 
     ComputePipeline &ResourceCache::request_compute_pipeline(PipelineState &pipeline_state)
     {
-        return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, pipeline_cache,
-                                pipeline_state);
+        return request_resource(device, &recorder, state.compute_pipelines, pipeline_cache, pipeline_state);
     }
 
     DescriptorSet &ResourceCache::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout,
                                                          const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
                                                          const BindingMap<VkDescriptorImageInfo> &image_infos)
     {
-        auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools,
-                                                 descriptor_set_layout);
-        return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, descriptor_set_layout,
-                                descriptor_pool, buffer_infos, image_infos);
+        auto &descriptor_pool = request_resource(device, &recorder, state.descriptor_pools, descriptor_set_layout);
+
+        ResourceKey key;
+        key_param(key, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+        if (auto descriptor_set = state.descriptor_sets.find(key))
+        {
+            return *descriptor_set;
+        }
+
+        std::lock_guard<std::mutex> guard(descriptor_set_mutex);
+        return request_resource(device, &recorder, state.descriptor_sets, descriptor_set_layout, descriptor_pool,
+                                buffer_infos, image_infos);
     }
 
     RenderPass &ResourceCache::request_render_pass(const std::vector<Attachment> &attachments,
                                                    const std::vector<LoadStoreInfo> &load_store_infos,
                                                    const std::vector<SubpassInfo> &subpasses)
     {
-        return request_resource(device, recorder, render_pass_mutex, state.render_passes, attachments, load_store_infos,
-                                subpasses);
+        return request_resource(device, &recorder, state.render_passes, attachments, load_store_infos, subpasses);
     }
 
     Framebuffer &ResourceCache::request_framebuffer(const RenderTarget &render_target, const RenderPass &render_pass)
     {
-        return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, render_target, render_pass);
+        return request_resource(device, &recorder, state.framebuffers, render_target, render_pass);
+    }
+
+    ShaderModule &ResourceCache::replay_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source,
+                                                      const ShaderVariant &shader_variant)
+    {
+        std::string entry_point{"main"};
+        return request_resource(device, &recorder, true, state.shader_modules, stage, glsl_source, entry_point,
+                                shader_variant);
+    }
+
+    PipelineLayout &ResourceCache::replay_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
+    {
+        return request_resource(device, &recorder, true, state.pipeline_layouts, shader_modules);
+    }
+
+    RenderPass &ResourceCache::replay_render_pass(const std::vector<Attachment> &attachments,
+                                                  const std::vector<LoadStoreInfo> &load_store_infos,
+                                                  const std::vector<SubpassInfo> &subpasses)
+    {
+        return request_resource(device, &recorder, true, state.render_passes, attachments, load_store_infos, subpasses);
+    }
+
+    GraphicsPipeline &ResourceCache::replay_graphics_pipeline(PipelineState &pipeline_state)
+    {
+        return request_resource(device, &recorder, true, state.graphics_pipelines, pipeline_cache, pipeline_state);
     }
 
     void ResourceCache::clear_pipelines()
     {
+        if (pipeline_compiler)
+        {
+            pipeline_compiler->clear();
+        }
+
         state.graphics_pipelines.clear();
         state.compute_pipelines.clear();
     }
@@ -126,18 +251,15 @@ namespace vkb
     {
         // Find descriptor sets referring to the old image view
         std::vector<VkWriteDescriptorSet> set_updates;
-        std::set<size_t> matches;
+        std::vector<ResourceKey> matches;
 
         for (size_t i = 0; i < old_views.size(); ++i)
         {
             auto &old_view = old_views[i];
             auto &new_view = new_views[i];
 
-            for (auto &kd_pair : state.descriptor_sets)
+            state.descriptor_sets.for_each([&](const ResourceKey &key, DescriptorSet &descriptor_set)
             {
-                auto &key = kd_pair.first;
-                auto &descriptor_set = kd_pair.second;
-
                 auto &image_infos = descriptor_set.get_image_infos();
 
                 for (auto &ba_pair : image_infos)
@@ -153,7 +275,10 @@ namespace vkb
                         if (image_info.imageView == old_view.GetHandle())
                         {
                             // Save key to remove old descriptor set
-                            matches.insert(key);
+                            if (std::find(matches.begin(), matches.end(), key) == matches.end())
+                            {
+                                matches.push_back(key);
+                            }
 
                             // Update image info with new view
                             image_info.imageView = new_view.GetHandle();
@@ -181,7 +306,7 @@ namespace vkb
                         }
                     }
                 }
-            }
+            });
         }
 
         if (!set_updates.empty())
@@ -190,21 +315,18 @@ namespace vkb
                                    0, nullptr);
         }
 
-        // Delete old entries (moved out descriptor sets)
+        // Re-key the updated descriptor sets
         for (auto &match : matches)
         {
-            // Move out of the map
-            auto it = state.descriptor_sets.find(match);
-            auto descriptor_set = std::move(it->second);
-            state.descriptor_sets.erase(match);
-
-            // Generate new key
-            size_t new_key = 0U;
-            hash_param(new_key, descriptor_set.get_layout(), descriptor_set.get_buffer_infos(),
-                       descriptor_set.get_image_infos());
-
-            // Add (key, resource) to the cache
-            state.descriptor_sets.emplace(new_key, std::move(descriptor_set));
+            auto descriptor_set = state.descriptor_sets.find(match);
+
+            // Generate new key, the same one request_descriptor_set builds for the updated infos
+            ResourceKey new_key;
+            key_param(new_key, descriptor_set->get_layout(), descriptor_set->get_descriptor_pool(),
+                      descriptor_set->get_buffer_infos(), descriptor_set->get_image_infos());
+
+            // Move the resource to the new key
+            state.descriptor_sets.rekey(match, std::move(new_key));
         }
     }
 
@@ -215,6 +337,12 @@ namespace vkb
 
     void ResourceCache::clear()
     {
+        // Background compilations still use the layouts and render passes
+        if (pipeline_compiler)
+        {
+            pipeline_compiler->clear();
+        }
+
         state.shader_modules.clear();
         state.pipeline_layouts.clear();
         state.descriptor_sets.clear();
@@ -46,11 +46,15 @@ namespace vkb
 
     void ResourceRecord::set_data(const std::vector<uint8_t>& data)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         stream.str(std::string{data.begin(), data.end()});
     }
 
     std::vector<uint8_t> ResourceRecord::get_data()
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         std::string str = stream.str();
 
         return std::vector<uint8_t>{str.begin(), str.end()};
@@ -64,9 +68,11 @@ namespace vkb
     size_t ResourceRecord::register_shader_module(VkShaderStageFlagBits stage, const ShaderSource& glsl_source,
                                                   const std::string& entry_point, const ShaderVariant& shader_variant)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         shader_module_indices.push_back(shader_module_indices.size());
 
-        write(stream, ResourceType::ShaderModule, stage, glsl_source.get_source(), entry_point,
+        write(stream, ResourceType::ShaderModule, stage, glsl_source.get_filename(), entry_point,
               shader_variant.get_preamble());
 
         write_processes(stream, shader_variant.get_processes());
@@ -76,6 +82,8 @@ namespace vkb
 
     size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule*>& shader_modules)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         pipeline_layout_indices.push_back(pipeline_layout_indices.size());
 
         std::vector<size_t> shader_indices(shader_modules.size());
@@ -93,6 +101,8 @@ namespace vkb
                                                 const std::vector<LoadStoreInfo>& load_store_infos,
                                                 const std::vector<SubpassInfo>& subpasses)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         render_pass_indices.push_back(render_pass_indices.size());
 
         write(stream,
@@ -107,15 +117,25 @@ namespace vkb
 
     size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState& pipeline_state)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         graphics_pipeline_indices.push_back(graphics_pipeline_indices.size());
 
         auto& pipeline_layout = pipeline_state.get_pipeline_layout();
         auto render_pass = pipeline_state.get_render_pass();
 
+        // Pipelines using a layout or render pass created outside the cache can not be replayed
+        auto pipeline_layout_it = pipeline_layout_to_index.find(&pipeline_layout);
+        auto render_pass_it = render_pass_to_index.find(render_pass);
+        if (pipeline_layout_it == pipeline_layout_to_index.end() || render_pass_it == render_pass_to_index.end())
+        {
+            return graphics_pipeline_indices.back();
+        }
+
         write(stream,
               ResourceType::GraphicsPipeline,
-              pipeline_layout_to_index.at(&pipeline_layout),
-              render_pass_to_index.at(render_pass),
+              pipeline_layout_it->second,
+              render_pass_it->second,
               pipeline_state.get_subpass_index());
 
         auto& specialization_constant_state = pipeline_state.get_specialization_constant_state().
@@ -149,21 +169,29 @@ namespace vkb
 
     void ResourceRecord::set_shader_module(size_t index, const ShaderModule& shader_module)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         shader_module_to_index[&shader_module] = index;
     }
 
     void ResourceRecord::set_pipeline_layout(size_t index, const PipelineLayout& pipeline_layout)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         pipeline_layout_to_index[&pipeline_layout] = index;
     }
 
     void ResourceRecord::set_render_pass(size_t index, const RenderPass& render_pass)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         render_pass_to_index[&render_pass] = index;
     }
 
     void ResourceRecord::set_graphics_pipeline(size_t index, const GraphicsPipeline& graphics_pipeline)
     {
+        std::lock_guard<std::mutex> lock{mutex};
+
         graphics_pipeline_to_index[&graphics_pipeline] = index;
     }
 } // namespace vkb
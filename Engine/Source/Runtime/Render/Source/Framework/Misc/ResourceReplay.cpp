@@ -16,9 +16,12 @@
  */
 
 #include "Framework/Misc/ResourceReplay.hpp"
-#include "Framework/\Rendering/RenderTarget.hpp"
+#include "Framework/Rendering/RenderTarget.hpp"
 #include "Framework/Misc/ResourceCache.hpp"
 #include "Logging/Logger.hpp"
+#include "SubSystems/JobSystem.hpp"
+
+#include <algorithm>
 
 
 namespace vkb
@@ -63,6 +66,14 @@ namespace vkb
 
     void ResourceReplay::play(ResourceCache& resource_cache, ResourceRecord& recorder)
     {
+        // Indices in the stream are local to it
+        shader_modules.clear();
+        pending_shader_modules.clear();
+        pipeline_layouts.clear();
+        render_passes.clear();
+        graphics_pipelines.clear();
+        pending_pipelines.clear();
+
         std::istringstream stream{recorder.get_stream().str()};
 
         while (true)
@@ -88,33 +99,91 @@ namespace vkb
             else
             {
                 LOG_ERROR("Replay command not supported.");
+                break;
             }
         }
+
+        create_pending_shader_modules(resource_cache);
+
+        // Pipeline creation dominates, the cache only locks around its own bookkeeping
+        std::vector<const GraphicsPipeline*> created(pending_pipelines.size(), nullptr);
+
+        JobSystem::GetInstance().ParallelFor(static_cast<uint32_t>(pending_pipelines.size()), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                try
+                {
+                    created[i] = &resource_cache.replay_graphics_pipeline(pending_pipelines[i]);
+                }
+                catch (const std::exception& e)
+                {
+                    LOGW("Failed to replay graphics pipeline #{}: {}", i, e.what());
+                }
+            }
+        });
+
+        for (auto* graphics_pipeline : created)
+        {
+            if (graphics_pipeline)
+            {
+                graphics_pipelines.push_back(graphics_pipeline);
+            }
+        }
+        pending_pipelines.clear();
     }
 
     void ResourceReplay::create_shader_module(ResourceCache& resource_cache, std::istringstream& stream)
     {
         VkShaderStageFlagBits stage{};
-        std::string glsl_source;
+        std::string filename;
         std::string entry_point;
         std::string preamble;
         std::vector<std::string> processes;
 
         read(stream,
              stage,
-             glsl_source,
+             filename,
              entry_point,
              preamble);
 
         read_processes(stream, processes);
 
-        ShaderSource shader_source{};
-        shader_source.set_source(std::move(glsl_source));
+        // The stream holds the file name, a changed file simply results in a new module
+        ShaderSource shader_source{filename};
         ShaderVariant shader_variant(std::move(preamble), std::move(processes));
 
-        auto& shader_module = resource_cache.request_shader_module(stage, shader_source, shader_variant);
+        // Compiling variants dominates, the modules are created together once a pipeline layout needs them
+        pending_shader_modules.push_back({stage, std::move(shader_source), std::move(shader_variant)});
+        shader_modules.push_back(nullptr);
+    }
 
-        shader_modules.push_back(&shader_module);
+    void ResourceReplay::create_pending_shader_modules(ResourceCache& resource_cache)
+    {
+        if (pending_shader_modules.empty())
+        {
+            return;
+        }
+
+        size_t first_index = shader_modules.size() - pending_shader_modules.size();
+
+        JobSystem::GetInstance().ParallelFor(static_cast<uint32_t>(pending_shader_modules.size()), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                auto& pending = pending_shader_modules[i];
+                try
+                {
+                    shader_modules[first_index + i] = &resource_cache.replay_shader_module(pending.stage, pending.source, pending.variant);
+                }
+                catch (const std::exception& e)
+                {
+                    LOGW("Failed to replay shader module {}: {}", pending.source.get_filename(), e.what());
+                }
+            }
+        });
+
+        pending_shader_modules.clear();
     }
 
     void ResourceReplay::create_pipeline_layout(ResourceCache& resource_cache, std::istringstream& stream)
@@ -124,6 +193,8 @@ namespace vkb
         read(stream,
              shader_indices);
 
+        create_pending_shader_modules(resource_cache);
+
         std::vector<ShaderModule*> shader_stages(shader_indices.size());
         std::transform(shader_indices.begin(),
                        shader_indices.end(),
@@ -134,7 +205,12 @@ namespace vkb
                            return shader_modules[shader_index];
                        });
 
-        auto& pipeline_layout = resource_cache.request_pipeline_layout(shader_stages);
+        if (std::find(shader_stages.begin(), shader_stages.end(), nullptr) != shader_stages.end())
+        {
+            throw std::runtime_error("Pipeline layout uses a shader module that failed to replay");
+        }
+
+        auto& pipeline_layout = resource_cache.replay_pipeline_layout(shader_stages);
 
         pipeline_layouts.push_back(&pipeline_layout);
     }
@@ -151,7 +227,7 @@ namespace vkb
 
         read_subpass_info(stream, subpasses);
 
-        auto& render_pass = resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
+        auto& render_pass = resource_cache.replay_render_pass(attachments, load_store_infos, subpasses);
 
         render_passes.push_back(&render_pass);
     }
@@ -217,8 +293,6 @@ namespace vkb
         pipeline_state.set_depth_stencil_state(depth_stencil_state);
         pipeline_state.set_color_blend_state(color_blend_state);
 
-        auto& graphics_pipeline = resource_cache.request_graphics_pipeline(pipeline_state);
-
-        graphics_pipelines.push_back(&graphics_pipeline);
+        pending_pipelines.push_back(pipeline_state);
     }
 } // namespace vkb
@@ -0,0 +1,203 @@
+#include "Framework/Misc/RingBufferAllocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Logging/Logger.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        /// Usages an allocation of each usage class may combine, the ring buffer is created with all of them
+        constexpr VkBufferUsageFlags usage_class_flags[] = {
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT};
+
+        VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        VkDeviceSize next_power_of_two(VkDeviceSize value)
+        {
+            VkDeviceSize result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+    } // namespace
+
+    RingBufferAllocator::RingBufferAllocator(VulkanDevice &device, size_t thread_count, VkDeviceSize thread_capacity) :
+        device{device},
+        thread_count{std::max<size_t>(thread_count, 1)}
+    {
+        auto &limits = device.get_gpu().get_properties().limits;
+
+        // One alignment for every usage class, so an allocation may be bound as any of its usages and flushed
+        // without touching the ranges of other threads
+        alignment = std::max({alignment,
+                              limits.minUniformBufferOffsetAlignment,
+                              limits.minStorageBufferOffsetAlignment,
+                              limits.minTexelBufferOffsetAlignment,
+                              limits.nonCoherentAtomSize});
+
+        for (uint32_t usage_class = 0; usage_class < UsageClassCount; usage_class++)
+        {
+            rings[usage_class].usage = usage_class_flags[usage_class];
+            create_ring(rings[usage_class], thread_capacity);
+        }
+    }
+
+    RingBufferAllocator::UsageClass RingBufferAllocator::get_usage_class(VkBufferUsageFlags usage)
+    {
+        if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT))
+        {
+            return Uniform;
+        }
+        if (usage & (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT))
+        {
+            return Storage;
+        }
+        return Geometry;
+    }
+
+    void RingBufferAllocator::create_ring(Ring &ring, VkDeviceSize thread_capacity)
+    {
+        ring.thread_capacity = align_up(thread_capacity, alignment);
+        ring.buffer = std::make_unique<Buffer>(device, ring.thread_capacity * thread_count, ring.usage, VMA_MEMORY_USAGE_CPU_TO_GPU,
+                                               VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+        ring.data = ring.buffer->map();
+
+        ring.sub_rings = std::vector<SubRing>(thread_count);
+        for (size_t i = 0; i < thread_count; i++)
+        {
+            ring.sub_rings[i].begin = ring.thread_capacity * i;
+        }
+    }
+
+    BufferAllocation RingBufferAllocator::allocate(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index)
+    {
+        assert(thread_index < thread_count && "Thread index is out of bounds");
+        assert(size > 0 && "Allocation size must be greater than zero");
+
+        auto &ring = rings[get_usage_class(usage)];
+        if ((usage & ~ring.usage) != 0)
+        {
+            throw std::runtime_error("Buffer usage cannot be allocated from a ring buffer");
+        }
+
+        auto &sub_ring = ring.sub_rings[thread_index];
+        sub_ring.demand = align_up(sub_ring.demand, alignment) + size;
+
+        if (sub_ring.offset + size > ring.thread_capacity)
+        {
+            return allocate_overflow(ring, sub_ring, size);
+        }
+
+        VkDeviceSize offset = sub_ring.begin + sub_ring.offset;
+        sub_ring.offset = align_up(sub_ring.offset + size, alignment);
+
+        return BufferAllocation{*ring.buffer, size, offset, ring.data + offset};
+    }
+
+    BufferAllocation RingBufferAllocator::allocate_overflow(Ring &ring, SubRing &sub_ring, VkDeviceSize size)
+    {
+        sub_ring.overflow_allocations++;
+
+        if (sub_ring.overflow_buffers.empty() || sub_ring.overflow_offset + size > sub_ring.overflow_buffers.back()->get_size())
+        {
+            sub_ring.overflow_buffers.push_back(std::make_unique<Buffer>(device, std::max(ring.thread_capacity, align_up(size, alignment)), ring.usage,
+                                                                         VMA_MEMORY_USAGE_CPU_TO_GPU,
+                                                                         VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+            sub_ring.overflow_offset = 0;
+        }
+
+        auto &buffer = *sub_ring.overflow_buffers.back();
+        VkDeviceSize offset = sub_ring.overflow_offset;
+        sub_ring.overflow_offset = align_up(offset + size, alignment);
+
+        return BufferAllocation{buffer, size, offset, buffer.map() + offset};
+    }
+
+    void RingBufferAllocator::flush()
+    {
+        for (auto &ring : rings)
+        {
+            for (auto &sub_ring : ring.sub_rings)
+            {
+                if (sub_ring.offset > 0)
+                {
+                    ring.buffer->flush(sub_ring.begin, sub_ring.offset);
+                }
+
+                for (auto &buffer : sub_ring.overflow_buffers)
+                {
+                    buffer->flush();
+                }
+            }
+        }
+    }
+
+    void RingBufferAllocator::reset()
+    {
+        for (auto &ring : rings)
+        {
+            VkDeviceSize frame_demand = 0;
+            for (auto &sub_ring : ring.sub_rings)
+            {
+                frame_demand = std::max(frame_demand, sub_ring.demand);
+
+                sub_ring.offset = 0;
+                sub_ring.overflow_buffers.clear();
+                sub_ring.overflow_offset = 0;
+                sub_ring.demand = 0;
+                sub_ring.overflow_allocations = 0;
+            }
+
+            ring.high_water_mark = std::max(ring.high_water_mark, frame_demand);
+
+            // The frame is idle, grow with headroom so a slowly growing demand does not recreate the ring every frame
+            if (ring.high_water_mark > ring.thread_capacity)
+            {
+                VkDeviceSize thread_capacity = next_power_of_two(ring.high_water_mark);
+                LOGD("Growing ring buffer sub-rings from {} to {} bytes", ring.thread_capacity, thread_capacity);
+
+                create_ring(ring, thread_capacity);
+                grow_count++;
+            }
+        }
+    }
+
+    VkDeviceSize RingBufferAllocator::get_alignment() const
+    {
+        return alignment;
+    }
+
+    RingBufferAllocator::Stats RingBufferAllocator::get_stats() const
+    {
+        Stats stats;
+        stats.grow_count = grow_count;
+
+        for (auto &ring : rings)
+        {
+            stats.capacity += ring.buffer->get_size();
+            stats.high_water_mark = std::max(stats.high_water_mark, ring.high_water_mark);
+
+            for (auto &sub_ring : ring.sub_rings)
+            {
+                stats.used += sub_ring.demand;
+                stats.overflow_allocations += sub_ring.overflow_allocations;
+                stats.high_water_mark = std::max(stats.high_water_mark, sub_ring.demand);
+            }
+        }
+
+        return stats;
+    }
+} // namespace vkb
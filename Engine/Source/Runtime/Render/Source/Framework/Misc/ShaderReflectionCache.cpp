@@ -0,0 +1,183 @@
+#include "Framework/Misc/ShaderReflectionCache.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+
+#include "Framework/Common/VkHelpers.hpp"
+#include "Framework/Misc/SpirvReflection.hpp"
+#include "Logging/Logger.hpp"
+#include "Misc/FileLoader.hpp"
+#include "Misc/Hash.hpp"
+#include "SubSystems/GlslCompiler.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        /// "CYRR"
+        constexpr uint32_t reflection_magic = 0x52525943;
+
+        /// Bump when ShaderResource or SPIRVReflection changes
+        constexpr uint32_t reflection_version = 1;
+
+        uint64_t compute_key(VkShaderStageFlagBits stage, uint64_t spirv_hash, const ShaderVariant &variant)
+        {
+            uint64_t key = Hash::Combine(spirv_hash, static_cast<uint64_t>(stage));
+
+            // Sorted, the map iterates in no particular order
+            std::vector<std::pair<std::string, size_t>> sizes{variant.get_runtime_array_sizes().begin(),
+                                                              variant.get_runtime_array_sizes().end()};
+            std::sort(sizes.begin(), sizes.end());
+
+            for (auto &size : sizes)
+            {
+                key = Hash::Combine(key, Hash::Hash64(size.first.data(), size.first.size()));
+                key = Hash::Combine(key, size.second);
+            }
+
+            return key;
+        }
+
+        std::vector<uint8_t> serialize(const std::vector<ShaderResource> &resources)
+        {
+            std::ostringstream os;
+            write(os, reflection_magic, reflection_version, resources.size());
+
+            for (auto &resource : resources)
+            {
+                write(os,
+                      resource.stages,
+                      resource.type,
+                      resource.mode,
+                      resource.set,
+                      resource.binding,
+                      resource.location,
+                      resource.input_attachment_index,
+                      resource.vec_size,
+                      resource.columns,
+                      resource.array_size,
+                      resource.offset,
+                      resource.size,
+                      resource.constant_id,
+                      resource.qualifiers,
+                      resource.name);
+            }
+
+            auto data = os.str();
+            return {data.begin(), data.end()};
+        }
+
+        bool deserialize(const std::vector<uint8_t> &data, std::vector<ShaderResource> &resources)
+        {
+            std::istringstream is{std::string{data.begin(), data.end()}};
+
+            uint32_t magic{0};
+            uint32_t version{0};
+            size_t count{0};
+            read(is, magic, version, count);
+
+            if (!is || magic != reflection_magic || version != reflection_version)
+            {
+                return false;
+            }
+
+            resources.resize(count);
+            for (auto &resource : resources)
+            {
+                read(is,
+                     resource.stages,
+                     resource.type,
+                     resource.mode,
+                     resource.set,
+                     resource.binding,
+                     resource.location,
+                     resource.input_attachment_index,
+                     resource.vec_size,
+                     resource.columns,
+                     resource.array_size,
+                     resource.offset,
+                     resource.size,
+                     resource.constant_id,
+                     resource.qualifiers,
+                     resource.name);
+            }
+
+            return static_cast<bool>(is);
+        }
+    } // namespace
+
+    bool ShaderReflectionCache::reflect(VkShaderStageFlagBits stage, const std::vector<uint32_t> &spirv, uint64_t spirv_hash,
+                                        const ShaderVariant &variant, std::vector<ShaderResource> &resources)
+    {
+        uint64_t key = compute_key(stage, spirv_hash, variant);
+
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            auto it = resources_by_key.find(key);
+            if (it != resources_by_key.end())
+            {
+                resources = it->second;
+                memory_hits++;
+                return true;
+            }
+        }
+
+        auto directory = GlslCompiler::GetInstance().GetCacheDirectory();
+        std::filesystem::path cache_path = directory.empty() ? std::filesystem::path{} : directory / (Hash::ToHex(key) + ".refl");
+
+        bool loaded = false;
+        std::error_code error;
+        if (!cache_path.empty() && std::filesystem::is_regular_file(cache_path, error))
+        {
+            try
+            {
+                loaded = deserialize(FileLoader::ReadFileBinary(cache_path), resources);
+            }
+            catch (const std::exception &e)
+            {
+                LOGW("Ignoring reflection cache file {}: {}", cache_path.string(), e.what());
+            }
+        }
+
+        if (loaded)
+        {
+            disk_hits++;
+        }
+        else
+        {
+            resources.clear();
+
+            SPIRVReflection spirv_reflection;
+            if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, variant))
+            {
+                return false;
+            }
+
+            reflected++;
+
+            if (!cache_path.empty())
+            {
+                try
+                {
+                    auto data = serialize(resources);
+                    FileLoader::WriteFileBinary(cache_path, data.data(), data.size());
+                }
+                catch (const std::exception &e)
+                {
+                    LOGW("Failed to store reflection cache file {}: {}", cache_path.string(), e.what());
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> guard{mutex};
+        resources_by_key.emplace(key, resources);
+
+        return true;
+    }
+
+    ShaderReflectionCache::Stats ShaderReflectionCache::get_stats() const
+    {
+        return {reflected.load(), memory_hits.load(), disk_hits.load()};
+    }
+} // namespace vkb
@@ -0,0 +1,281 @@
+#include "Framework/Misc/ShaderVariantUsage.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <unordered_map>
+
+#include "Framework/Common/VkHelpers.hpp"
+#include "Framework/Core/ShaderModule.hpp"
+#include "Logging/Logger.hpp"
+#include "Misc/FileLoader.hpp"
+#include "Misc/Hash.hpp"
+#include "SubSystems/GlslCompiler.hpp"
+#include "SubSystems/JobSystem.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        /// "CYRV"
+        constexpr uint32_t variant_usage_magic = 0x56525943;
+
+        /// Bump when the layout of a variant changes
+        constexpr uint32_t variant_usage_version = 1;
+
+        std::string to_text(const MappedFile &file)
+        {
+            return std::string{reinterpret_cast<const char *>(file.Data()), file.Size()};
+        }
+
+        struct VariantUsageHeader
+        {
+            uint32_t magic;
+
+            uint32_t version;
+
+            uint64_t data_size;
+
+            uint64_t data_hash;
+        };
+
+        uint64_t hash_string(const std::string &value)
+        {
+            return Hash::Hash64(value.data(), value.size());
+        }
+
+        uint64_t compute_key(const ShaderVariantUsage::Variant &variant)
+        {
+            uint64_t key = Hash::Combine(static_cast<uint64_t>(variant.stage), hash_string(variant.filename));
+            key = Hash::Combine(key, hash_string(variant.entry_point));
+            key = Hash::Combine(key, hash_string(variant.preamble));
+
+            for (auto &process : variant.processes)
+            {
+                key = Hash::Combine(key, hash_string(process));
+            }
+
+            return key;
+        }
+    } // namespace
+
+    void ShaderVariantUsage::record(VkShaderStageFlagBits stage, const ShaderSource &shader_source,
+                                    const std::string &entry_point, const ShaderVariant &shader_variant)
+    {
+        Variant variant{stage, shader_source.get_filename(), entry_point, shader_variant.get_preamble(),
+                        shader_variant.get_processes()};
+        uint64_t key = compute_key(variant);
+
+        std::lock_guard<std::mutex> guard{mutex};
+        variants.emplace(key, std::move(variant));
+    }
+
+    bool ShaderVariantUsage::load(const std::vector<uint8_t> &data)
+    {
+        if (data.size() < sizeof(VariantUsageHeader))
+        {
+            return false;
+        }
+
+        VariantUsageHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        size_t stream_size = data.size() - sizeof(header);
+        const uint8_t *stream = data.data() + sizeof(header);
+
+        if (header.magic != variant_usage_magic || header.version != variant_usage_version ||
+            header.data_size != stream_size || header.data_hash != Hash::Hash64(stream, stream_size))
+        {
+            return false;
+        }
+
+        std::istringstream is{std::string{stream, stream + stream_size}};
+
+        size_t count{0};
+        read(is, count);
+
+        std::vector<Variant> loaded(count);
+        for (auto &variant : loaded)
+        {
+            size_t process_count{0};
+            read(is, variant.stage, variant.filename, variant.entry_point, variant.preamble, process_count);
+
+            variant.processes.resize(process_count);
+            for (auto &process : variant.processes)
+            {
+                read(is, process);
+            }
+        }
+
+        if (!is)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> guard{mutex};
+        for (auto &variant : loaded)
+        {
+            uint64_t key = compute_key(variant);
+            variants.emplace(key, std::move(variant));
+        }
+
+        return true;
+    }
+
+    std::vector<uint8_t> ShaderVariantUsage::serialize()
+    {
+        std::ostringstream os;
+
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+
+            // Same fields as the shader module record of ResourceRecord
+            write(os, variants.size());
+            for (auto &[key, variant] : variants)
+            {
+                write(os, variant.stage, variant.filename, variant.entry_point, variant.preamble, variant.processes.size());
+                for (auto &process : variant.processes)
+                {
+                    write(os, process);
+                }
+            }
+        }
+
+        auto stream = os.str();
+
+        VariantUsageHeader header{};
+        header.magic = variant_usage_magic;
+        header.version = variant_usage_version;
+        header.data_size = stream.size();
+        header.data_hash = Hash::Hash64(stream.data(), stream.size());
+
+        std::vector<uint8_t> data(sizeof(header) + stream.size());
+        std::memcpy(data.data(), &header, sizeof(header));
+        std::memcpy(data.data() + sizeof(header), stream.data(), stream.size());
+
+        return data;
+    }
+
+    std::vector<ShaderVariantUsage::Variant> ShaderVariantUsage::get_variants()
+    {
+        std::lock_guard<std::mutex> guard{mutex};
+
+        std::vector<Variant> result;
+        result.reserve(variants.size());
+        for (auto &[key, variant] : variants)
+        {
+            result.push_back(variant);
+        }
+
+        return result;
+    }
+
+    uint32_t ShaderVariantUsage::precompile()
+    {
+        auto variants_to_compile = get_variants();
+
+        // The variants share few files, each is read once and all of them in parallel before the jobs are prepared
+        std::vector<std::filesystem::path> paths;
+        std::unordered_map<std::string, size_t> path_indices;
+        auto add_path = [&](const std::filesystem::path &path)
+        {
+            std::error_code error;
+            if (std::filesystem::is_regular_file(path, error) && path_indices.try_emplace(path.string(), paths.size()).second)
+            {
+                paths.push_back(path);
+            }
+        };
+
+        for (auto &variant : variants_to_compile)
+        {
+            add_path(variant.filename);
+
+            std::filesystem::path glsl_path{variant.filename};
+            if (glsl_path.extension() == ".spv" && !variant.preamble.empty())
+            {
+                add_path(glsl_path.replace_extension());
+            }
+        }
+
+        std::vector<MappedFile> files;
+        try
+        {
+            JobCounter counter;
+            FileLoader::ReadFilesAsync(paths, files, counter);
+            JobSystem::GetInstance().Wait(counter);
+        }
+        catch (const std::exception &e)
+        {
+            LOGW("Reading the shader sources ahead failed, the rest are read one by one: {}", e.what());
+        }
+
+        // Files that were not read ahead are read by ShaderSource and prepare_compile_job
+        auto find_file = [&](const std::filesystem::path &path) -> const MappedFile *
+        {
+            auto it = path_indices.find(path.string());
+            if (it == path_indices.end() || it->second >= files.size() || files[it->second].Empty())
+            {
+                return nullptr;
+            }
+            return &files[it->second];
+        };
+
+        std::vector<GlslCompileJob> jobs;
+        std::vector<uint64_t> missing;
+
+        for (auto &variant : variants_to_compile)
+        {
+            try
+            {
+                auto *file = find_file(variant.filename);
+                ShaderSource shader_source = file ? ShaderSource{variant.filename, to_text(*file)} : ShaderSource{variant.filename};
+                ShaderVariant shader_variant{std::string{variant.preamble}, std::vector<std::string>{variant.processes}};
+
+                std::string glsl_source;
+                std::filesystem::path glsl_path{variant.filename};
+                if (glsl_path.extension() == ".spv")
+                {
+                    if (auto *glsl_file = find_file(glsl_path.replace_extension()))
+                    {
+                        glsl_source = to_text(*glsl_file);
+                    }
+                }
+
+                GlslCompileJob job;
+                if (ShaderModule::prepare_compile_job(variant.stage, shader_source, variant.entry_point, shader_variant, job,
+                                                      glsl_source.empty() ? nullptr : &glsl_source))
+                {
+                    jobs.push_back(std::move(job));
+                }
+            }
+            catch (const std::exception &e)
+            {
+                LOGW("Dropping shader variant of {}: {}", variant.filename, e.what());
+                missing.push_back(compute_key(variant));
+            }
+        }
+
+        if (!missing.empty())
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            for (auto key : missing)
+            {
+                variants.erase(key);
+            }
+        }
+
+        GlslCompiler::GetInstance().CompileAll(jobs);
+
+        uint32_t failed = 0;
+        for (auto &job : jobs)
+        {
+            if (!job.success)
+            {
+                LOGE("Failed to precompile {}:\n{}", job.source_path.string(), job.info_log);
+                failed++;
+            }
+        }
+
+        return failed;
+    }
+} // namespace vkb
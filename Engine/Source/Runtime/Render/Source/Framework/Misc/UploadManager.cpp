@@ -0,0 +1,560 @@
+#include "Framework/Misc/UploadManager.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "Framework/Common/VkError.hpp"
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/CommandPool.hpp"
+#include "Framework/Core/Image.hpp"
+#include "Framework/Core/Queue.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    } // namespace
+
+    UploadManager::UploadManager(VulkanDevice &device, VkDeviceSize ring_size) :
+        device{device}
+    {
+        // The device command pool and the render frames use this family
+        const Queue &graphics_queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0);
+        graphics_family = graphics_queue.get_family_index();
+
+        // Prefers a family with transfer only, then compute without graphics
+        transfer_family = device.get_queue_family_index(VK_QUEUE_TRANSFER_BIT);
+        if (transfer_family == graphics_family)
+        {
+            transfer_queue = &graphics_queue;
+        }
+        else
+        {
+            transfer_queue = &device.get_queue(transfer_family, 0);
+        }
+
+        LOGI("Uploads use queue family {}{}", transfer_family,
+             has_dedicated_transfer_queue() ? " (dedicated transfer)" : "");
+
+        const auto &limits = device.get_gpu().get_properties().limits;
+        ring_alignment = std::max<VkDeviceSize>({16, limits.optimalBufferCopyOffsetAlignment, limits.nonCoherentAtomSize});
+
+        BufferBuilder builder{ring_size};
+        builder.with_vma_flags(VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT)
+               .with_usage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+               .with_vma_usage(VMA_MEMORY_USAGE_AUTO);
+
+        ring = std::make_unique<Buffer>(device, builder);
+        ring->SetDebugName("Upload staging ring");
+        ring_data = ring->map();
+    }
+
+    UploadManager::~UploadManager()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        try
+        {
+            submit();
+            while (!in_flight.empty())
+            {
+                retire(true);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            LOGE("Uploads did not complete: {}", e.what());
+            device.wait_idle();
+        }
+
+        // Batches that failed to retire are released like the rest once the device is idle
+        for (auto &batch : in_flight)
+        {
+            free_batches.push_back(std::move(batch));
+        }
+        if (recording)
+        {
+            free_batches.push_back(std::move(recording));
+        }
+
+        // Futures of uploads that were never acquired report a broken promise
+        std::vector<std::unique_ptr<Batch>> batches = std::move(free_batches);
+        std::move(completed.begin(), completed.end(), std::back_inserter(batches));
+        std::move(acquiring.begin(), acquiring.end(), std::back_inserter(batches));
+
+        for (auto &batch : batches)
+        {
+            vkDestroyFence(device.GetHandle(), batch->fence, nullptr);
+            vkDestroyEvent(device.GetHandle(), batch->event, nullptr);
+        }
+    }
+
+    std::future<void> UploadManager::upload_buffer(const Buffer &buffer, VkDeviceSize offset, const void *data,
+                                                   VkDeviceSize size, VkPipelineStageFlags dst_stage,
+                                                   VkAccessFlags dst_access)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto &batch = get_recording_batch();
+        auto staging = stage(batch, data, size);
+
+        VkCommandBuffer command_buffer = batch.command_buffer->GetHandle();
+
+        VkBufferCopy region{staging.second, offset, size};
+        vkCmdCopyBuffer(command_buffer, staging.first, buffer.GetHandle(), 1, &region);
+
+        VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer.GetHandle();
+        barrier.offset = offset;
+        barrier.size = size;
+
+        if (has_dedicated_transfer_queue())
+        {
+            // Release, the graphics queue acquires in acquire()
+            barrier.srcQueueFamilyIndex = transfer_family;
+            barrier.dstQueueFamilyIndex = graphics_family;
+
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+            Acquire acquire;
+            acquire.buffer = buffer.GetHandle();
+            acquire.offset = offset;
+            acquire.size = size;
+            acquire.dst_stage = dst_stage;
+            acquire.dst_access = dst_access;
+            batch.acquires.push_back(acquire);
+        }
+        else
+        {
+            barrier.dstAccessMask = dst_access;
+
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, 0, 0, nullptr, 1,
+                                 &barrier, 0, nullptr);
+        }
+
+        batch.promises.emplace_back();
+        return batch.promises.back().get_future();
+    }
+
+    std::future<void> UploadManager::upload_image(const Image &image, const void *data, VkDeviceSize size,
+                                                  const std::vector<VkBufferImageCopy> &regions, VkImageLayout layout,
+                                                  VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto &batch = get_recording_batch();
+        auto staging = stage(batch, data, size);
+
+        VkCommandBuffer command_buffer = batch.command_buffer->GetHandle();
+
+        VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image.GetHandle();
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+
+        // The previous contents are discarded, so no ownership transfer to the transfer queue is needed
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                             nullptr, 0, nullptr, 1, &barrier);
+
+        std::vector<VkBufferImageCopy> staged_regions = regions;
+        for (auto &region : staged_regions)
+        {
+            region.bufferOffset += staging.second;
+        }
+        vkCmdCopyBufferToImage(command_buffer, staging.first, image.GetHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               to_u32(staged_regions.size()), staged_regions.data());
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = layout;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+
+        if (has_dedicated_transfer_queue())
+        {
+            // Release with the layout transition, the acquire repeats the same transition
+            barrier.srcQueueFamilyIndex = transfer_family;
+            barrier.dstQueueFamilyIndex = graphics_family;
+
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            Acquire acquire;
+            acquire.image = image.GetHandle();
+            acquire.range = barrier.subresourceRange;
+            acquire.layout = layout;
+            acquire.dst_stage = dst_stage;
+            acquire.dst_access = dst_access;
+            batch.acquires.push_back(acquire);
+        }
+        else
+        {
+            barrier.dstAccessMask = dst_access;
+
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, 0, 0, nullptr, 0, nullptr,
+                                 1, &barrier);
+        }
+
+        batch.promises.emplace_back();
+        return batch.promises.back().get_future();
+    }
+
+    void UploadManager::flush()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        submit();
+        retire(false);
+        resolve_acquired();
+    }
+
+    void UploadManager::acquire(CommandBuffer &command_buffer)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        resolve_acquired();
+        retire(false);
+        record_acquires(command_buffer);
+    }
+
+    void UploadManager::finish()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        submit();
+        while (!in_flight.empty())
+        {
+            retire(true);
+        }
+
+        if (completed.empty())
+        {
+            return;
+        }
+
+        if (!graphics_command_pool)
+        {
+            graphics_command_pool = std::make_unique<CommandPool>(device, graphics_family);
+        }
+
+        auto command_buffer = graphics_command_pool->request_command_buffer();
+        command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        record_acquires(*command_buffer);
+        command_buffer->end();
+
+        VkFenceCreateInfo fence_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        VkFence fence;
+        VK_CHECK_RESULT(vkCreateFence(device.GetHandle(), &fence_info, nullptr, &fence));
+
+        auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0);
+        VkResult result = queue.submit(*command_buffer, fence);
+        if (result == VK_SUCCESS)
+        {
+            result = vkWaitForFences(device.GetHandle(), 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+
+        vkDestroyFence(device.GetHandle(), fence, nullptr);
+        graphics_command_pool->reset_pool();
+
+        if (result != VK_SUCCESS)
+        {
+            throw VulkanException{result, "Failed to acquire uploaded resources"};
+        }
+
+        resolve_acquired();
+    }
+
+    bool UploadManager::has_dedicated_transfer_queue() const
+    {
+        return transfer_family != graphics_family;
+    }
+
+    VkDeviceSize UploadManager::get_ring_usage() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return ring_used;
+    }
+
+    std::pair<VkBuffer, VkDeviceSize> UploadManager::stage(Batch &batch, const void *data, VkDeviceSize size)
+    {
+        retire(false);
+
+        VkDeviceSize offset = 0;
+        VkDeviceSize consumed = 0;
+
+        bool fits = allocate_ring(size, offset, consumed);
+
+        // Space held by earlier submissions comes back when they complete, space of the recording batch does not
+        while (!fits && !in_flight.empty() && size <= ring->get_size())
+        {
+            retire(true);
+            fits = allocate_ring(size, offset, consumed);
+        }
+
+        if (!fits)
+        {
+            batch.staging_buffers.push_back(Buffer::create_staging_buffer(device, size, data));
+            return {batch.staging_buffers.back().GetHandle(), 0};
+        }
+
+        std::memcpy(ring_data + offset, data, static_cast<size_t>(size));
+        ring->flush(offset, size);
+
+        ring_head = offset + size;
+        ring_used += consumed;
+        batch.ring_bytes += consumed;
+        batch.ring_end = ring_head;
+
+        return {ring->GetHandle(), offset};
+    }
+
+    bool UploadManager::allocate_ring(VkDeviceSize size, VkDeviceSize &offset, VkDeviceSize &consumed)
+    {
+        VkDeviceSize ring_size = ring->get_size();
+
+        if (ring_used == 0)
+        {
+            ring_head = 0;
+            ring_tail = 0;
+        }
+        else if (ring_head == ring_tail)
+        {
+            return false;
+        }
+
+        VkDeviceSize aligned = align_up(ring_head, ring_alignment);
+
+        if (ring_used == 0 || ring_head > ring_tail)
+        {
+            // Free space is [head, end) followed by [0, tail)
+            if (aligned + size <= ring_size)
+            {
+                offset = aligned;
+                consumed = aligned + size - ring_head;
+                return true;
+            }
+
+            if (size <= ring_tail)
+            {
+                offset = 0;
+                consumed = ring_size - ring_head + size;
+                return true;
+            }
+
+            return false;
+        }
+
+        // Wrapped, free space is [head, tail)
+        if (aligned + size <= ring_tail)
+        {
+            offset = aligned;
+            consumed = aligned + size - ring_head;
+            return true;
+        }
+
+        return false;
+    }
+
+    UploadManager::Batch &UploadManager::get_recording_batch()
+    {
+        if (recording)
+        {
+            return *recording;
+        }
+
+        if (!free_batches.empty())
+        {
+            recording = std::move(free_batches.back());
+            free_batches.pop_back();
+        }
+        else
+        {
+            recording = std::make_unique<Batch>();
+            recording->command_pool = std::make_unique<CommandPool>(device, transfer_family);
+
+            VkFenceCreateInfo fence_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+            VK_CHECK_RESULT(vkCreateFence(device.GetHandle(), &fence_info, nullptr, &recording->fence));
+
+            VkEventCreateInfo event_info{VK_STRUCTURE_TYPE_EVENT_CREATE_INFO};
+            VK_CHECK_RESULT(vkCreateEvent(device.GetHandle(), &event_info, nullptr, &recording->event));
+        }
+
+        recording->command_buffer = recording->command_pool->request_command_buffer();
+        recording->command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+        return *recording;
+    }
+
+    void UploadManager::retire(bool wait)
+    {
+        while (!in_flight.empty())
+        {
+            auto &batch = in_flight.front();
+
+            VkResult result = vkGetFenceStatus(device.GetHandle(), batch->fence);
+            if (result == VK_NOT_READY && wait)
+            {
+                result = vkWaitForFences(device.GetHandle(), 1, &batch->fence, VK_TRUE,
+                                         std::numeric_limits<uint64_t>::max());
+                wait = false;
+            }
+
+            if (result == VK_NOT_READY)
+            {
+                break;
+            }
+            if (result != VK_SUCCESS)
+            {
+                throw VulkanException{result, "Failed to wait for an upload"};
+            }
+
+            // Batches complete in submission order, so the tail only ever moves forward
+            if (batch->ring_bytes > 0)
+            {
+                ring_used -= batch->ring_bytes;
+                ring_tail = batch->ring_end;
+            }
+            batch->staging_buffers.clear();
+
+            if (batch->acquires.empty())
+            {
+                for (auto &promise : batch->promises)
+                {
+                    promise.set_value();
+                }
+                recycle(std::move(batch));
+            }
+            else
+            {
+                completed.push_back(std::move(batch));
+            }
+
+            in_flight.pop_front();
+        }
+    }
+
+    void UploadManager::submit()
+    {
+        if (!recording)
+        {
+            return;
+        }
+
+        recording->command_buffer->end();
+
+        VkResult result = transfer_queue->submit(*recording->command_buffer, recording->fence);
+        if (result != VK_SUCCESS)
+        {
+            throw VulkanException{result, "Failed to submit uploads"};
+        }
+
+        in_flight.push_back(std::move(recording));
+    }
+
+    void UploadManager::recycle(std::unique_ptr<Batch> batch)
+    {
+        VK_CHECK_RESULT(vkResetFences(device.GetHandle(), 1, &batch->fence));
+        VK_CHECK_RESULT(vkResetEvent(device.GetHandle(), batch->event));
+        batch->command_pool->reset_pool();
+        batch->command_buffer.reset();
+        batch->ring_bytes = 0;
+        batch->ring_end = 0;
+        batch->staging_buffers.clear();
+        batch->acquires.clear();
+        batch->promises.clear();
+
+        free_batches.push_back(std::move(batch));
+    }
+
+    void UploadManager::record_acquires(CommandBuffer &command_buffer)
+    {
+        std::vector<VkBufferMemoryBarrier> buffer_barriers;
+        std::vector<VkImageMemoryBarrier> image_barriers;
+        VkPipelineStageFlags dst_stage = 0;
+
+        for (auto &batch : completed)
+        {
+            for (auto &acquire : batch->acquires)
+            {
+                if (acquire.image != VK_NULL_HANDLE)
+                {
+                    VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+                    barrier.dstAccessMask = acquire.dst_access;
+                    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                    barrier.newLayout = acquire.layout;
+                    barrier.srcQueueFamilyIndex = transfer_family;
+                    barrier.dstQueueFamilyIndex = graphics_family;
+                    barrier.image = acquire.image;
+                    barrier.subresourceRange = acquire.range;
+                    image_barriers.push_back(barrier);
+                }
+                else
+                {
+                    VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+                    barrier.dstAccessMask = acquire.dst_access;
+                    barrier.srcQueueFamilyIndex = transfer_family;
+                    barrier.dstQueueFamilyIndex = graphics_family;
+                    barrier.buffer = acquire.buffer;
+                    barrier.offset = acquire.offset;
+                    barrier.size = acquire.size;
+                    buffer_barriers.push_back(barrier);
+                }
+
+                dst_stage |= acquire.dst_stage;
+            }
+        }
+
+        if (!buffer_barriers.empty() || !image_barriers.empty())
+        {
+            vkCmdPipelineBarrier(command_buffer.GetHandle(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dst_stage, 0, 0,
+                                 nullptr, to_u32(buffer_barriers.size()), buffer_barriers.data(),
+                                 to_u32(image_barriers.size()), image_barriers.data());
+        }
+
+        // The futures promise the data is usable on the graphics queue, which is only true once it ran the acquires
+        for (auto &batch : completed)
+        {
+            vkCmdSetEvent(command_buffer.GetHandle(), batch->event, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+            acquiring.push_back(std::move(batch));
+        }
+        completed.clear();
+    }
+
+    void UploadManager::resolve_acquired()
+    {
+        auto it = acquiring.begin();
+        while (it != acquiring.end())
+        {
+            VkResult result = vkGetEventStatus(device.GetHandle(), (*it)->event);
+            if (result == VK_EVENT_RESET)
+            {
+                ++it;
+                continue;
+            }
+            if (result != VK_EVENT_SET)
+            {
+                throw VulkanException{result, "Failed to query an upload acquire"};
+            }
+
+            for (auto &promise : (*it)->promises)
+            {
+                promise.set_value();
+            }
+            recycle(std::move(*it));
+            it = acquiring.erase(it);
+        }
+    }
+} // namespace vkb
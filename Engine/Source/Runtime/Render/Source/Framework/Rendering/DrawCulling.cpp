@@ -0,0 +1,207 @@
+#include "Framework/Rendering/DrawCulling.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace vkb
+{
+    std::array<glm::vec4, 6> extract_frustum_planes(const glm::mat4 &view_projection)
+    {
+        auto row = [&view_projection](int i) {
+            return glm::vec4{view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]};
+        };
+
+        std::array<glm::vec4, 6> planes{
+            row(3) + row(0),
+            row(3) - row(0),
+            row(3) + row(1),
+            row(3) - row(1),
+            row(2),
+            row(3) - row(2)};
+
+        for (auto &plane : planes)
+        {
+            plane /= glm::length(glm::vec3{plane});
+        }
+
+        return planes;
+    }
+
+    CpuDepthPyramid::CpuDepthPyramid(const std::vector<float> &depth, uint32_t width, uint32_t height)
+    {
+        assert(depth.size() >= static_cast<size_t>(width) * height);
+
+        // Level 0 halves the depth buffer, like every following level halves the previous one
+        const std::vector<float> *source = &depth;
+        glm::uvec2 source_size{width, height};
+
+        while (true)
+        {
+            glm::uvec2 size{std::max(1u, (source_size.x + 1) / 2), std::max(1u, (source_size.y + 1) / 2)};
+
+            std::vector<float> level(static_cast<size_t>(size.x) * size.y);
+            for (uint32_t y = 0; y < size.y; y++)
+            {
+                for (uint32_t x = 0; x < size.x; x++)
+                {
+                    float farthest = 1.0f;
+                    for (uint32_t sy = y * 2; sy < std::min(y * 2 + 2, source_size.y); sy++)
+                    {
+                        for (uint32_t sx = x * 2; sx < std::min(x * 2 + 2, source_size.x); sx++)
+                        {
+                            farthest = std::min(farthest, (*source)[static_cast<size_t>(sy) * source_size.x + sx]);
+                        }
+                    }
+                    level[static_cast<size_t>(y) * size.x + x] = farthest;
+                }
+            }
+
+            sizes.push_back(size);
+            levels.push_back(std::move(level));
+
+            if (size.x == 1 && size.y == 1)
+            {
+                break;
+            }
+
+            source = &levels.back();
+            source_size = size;
+        }
+    }
+
+    uint32_t CpuDepthPyramid::get_level_count() const
+    {
+        return static_cast<uint32_t>(levels.size());
+    }
+
+    glm::uvec2 CpuDepthPyramid::get_level_size(uint32_t level) const
+    {
+        return sizes[level];
+    }
+
+    float CpuDepthPyramid::fetch(uint32_t level, int32_t x, int32_t y) const
+    {
+        const auto &size = sizes[level];
+        x = std::clamp(x, 0, static_cast<int32_t>(size.x) - 1);
+        y = std::clamp(y, 0, static_cast<int32_t>(size.y) - 1);
+        return levels[level][static_cast<size_t>(y) * size.x + x];
+    }
+
+    glm::vec4 CpuDrawCuller::transform_sphere(const glm::vec4 &sphere, const glm::mat4 &model)
+    {
+        glm::vec3 center = glm::vec3{model * glm::vec4{glm::vec3{sphere}, 1.0f}};
+
+        float scale = std::max({glm::length(glm::vec3{model[0]}), glm::length(glm::vec3{model[1]}), glm::length(glm::vec3{model[2]})});
+
+        return glm::vec4{center, sphere.w * scale};
+    }
+
+    bool CpuDrawCuller::is_in_frustum(const CullUniform &uniform, const glm::vec4 &sphere)
+    {
+        for (auto &plane : uniform.frustum_planes)
+        {
+            if (glm::dot(glm::vec3{plane}, glm::vec3{sphere}) + plane.w < -sphere.w)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool CpuDrawCuller::is_unoccluded(const CullUniform &uniform, const glm::vec4 &sphere, const CpuDepthPyramid &pyramid)
+    {
+        // Screen rectangle and nearest depth of the box around the sphere in the previous frame
+        glm::vec2 uv_min{1.0f};
+        glm::vec2 uv_max{0.0f};
+        float nearest = 0.0f;
+
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            glm::vec3 offset{corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f};
+            glm::vec4 clip = uniform.previous_view_projection * glm::vec4{glm::vec3{sphere} + offset * sphere.w, 1.0f};
+
+            // Crosses the camera plane, the rectangle is unbounded
+            if (clip.w <= 0.0f)
+            {
+                return true;
+            }
+
+            glm::vec3 ndc = glm::vec3{clip} / clip.w;
+            glm::vec2 uv = glm::vec2{ndc} * 0.5f + 0.5f;
+
+            uv_min = glm::min(uv_min, uv);
+            uv_max = glm::max(uv_max, uv);
+            nearest = std::max(nearest, ndc.z);
+        }
+
+        // Outside of the previous frame there is nothing to test against
+        if (uv_max.x < 0.0f || uv_max.y < 0.0f || uv_min.x > 1.0f || uv_min.y > 1.0f)
+        {
+            return true;
+        }
+
+        uv_min = glm::clamp(uv_min, 0.0f, 1.0f);
+        uv_max = glm::clamp(uv_max, 0.0f, 1.0f);
+
+        // The level where the rectangle is at most one texel wide, so four texels cover it
+        glm::vec2 size = (uv_max - uv_min) * uniform.pyramid_size;
+        float level_f = std::ceil(std::log2(std::max({size.x, size.y, 1.0f})));
+        uint32_t level = std::min(static_cast<uint32_t>(level_f), std::min(uniform.pyramid_levels, pyramid.get_level_count()) - 1);
+
+        glm::vec2 level_size = glm::vec2{pyramid.get_level_size(level)};
+        glm::ivec2 texel_min = glm::ivec2{glm::floor(uv_min * level_size)};
+        glm::ivec2 texel_max = glm::ivec2{glm::floor(uv_max * level_size)};
+
+        float farthest = std::min({pyramid.fetch(level, texel_min.x, texel_min.y),
+                                   pyramid.fetch(level, texel_max.x, texel_min.y),
+                                   pyramid.fetch(level, texel_min.x, texel_max.y),
+                                   pyramid.fetch(level, texel_max.x, texel_max.y)});
+
+        // Reversed depth, nearer is larger
+        return nearest >= farthest;
+    }
+
+    uint32_t CpuDrawCuller::cull(const CullUniform &uniform, const std::vector<GpuMesh> &meshes, const std::vector<GpuInstance> &instances,
+                                 const CpuDepthPyramid *pyramid, std::vector<VkDrawIndexedIndirectCommand> &draws)
+    {
+        stats = {};
+        draws.clear();
+
+        uint32_t instance_count = std::min(uniform.instance_count, static_cast<uint32_t>(instances.size()));
+
+        for (uint32_t i = 0; i < instance_count; i++)
+        {
+            const auto &instance = instances[i];
+            const auto &mesh = meshes[instance.mesh];
+
+            stats.tested++;
+
+            glm::vec4 sphere = transform_sphere(mesh.bounding_sphere, instance.model);
+
+            if (!is_in_frustum(uniform, sphere))
+            {
+                stats.frustum_culled++;
+                continue;
+            }
+
+            if (uniform.occlusion_enabled && pyramid && !is_unoccluded(uniform, sphere, *pyramid))
+            {
+                stats.occlusion_culled++;
+                continue;
+            }
+
+            draws.push_back({mesh.index_count, 1, mesh.first_index, mesh.vertex_offset, i});
+        }
+
+        stats.drawn = static_cast<uint32_t>(draws.size());
+
+        return stats.drawn;
+    }
+
+    const CpuDrawCuller::Stats &CpuDrawCuller::get_stats() const
+    {
+        return stats;
+    }
+} // namespace vkb
@@ -0,0 +1,68 @@
+#include "Framework/Rendering/ParallelCommandRecorder.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/CommandPool.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Rendering/RenderFrame.hpp"
+#include "Memory/FrameAllocator.hpp"
+#include "Profiler/Profiler.hpp"
+#include "SubSystems/JobSystem.hpp"
+
+namespace vkb
+{
+    ParallelCommandRecorder::ParallelCommandRecorder(uint32_t thread_count, uint32_t min_draws_per_chunk) :
+        thread_count{std::max(1u, thread_count)},
+        min_draws_per_chunk{std::max(1u, min_draws_per_chunk)}
+    {
+    }
+
+    uint32_t ParallelCommandRecorder::get_thread_count() const
+    {
+        return thread_count;
+    }
+
+    void ParallelCommandRecorder::record(CommandBuffer &primary, uint32_t draw_count, const RecordFunc &record_draws)
+    {
+        auto &primary_pool = primary.get_command_pool();
+        auto *render_frame = primary_pool.get_render_frame();
+        assert(render_frame && "The primary command buffer must be allocated from a render frame");
+        assert(primary_pool.get_thread_index() == 0 && "Chunk 0 is recorded with the resources of thread 0");
+
+        uint32_t max_chunks = std::min(thread_count, static_cast<uint32_t>(render_frame->get_thread_count()));
+        uint32_t chunk_count = std::clamp((draw_count + min_draws_per_chunk - 1) / min_draws_per_chunk, 1u, max_chunks);
+
+        // Command pools are created on their first request, which is not thread safe, so all are fetched here.
+        // Secondaries use the reset mode of the primary, a different one would recreate the pools of the frame.
+        auto &queue = render_frame->get_device().get_queue(primary_pool.get_queue_family_index(), 0);
+
+        std::pmr::vector<CommandPool *> command_pools(chunk_count, FrameAllocator::GetResource());
+        for (uint32_t chunk = 0; chunk < chunk_count; chunk++)
+        {
+            command_pools[chunk] = &render_frame->get_command_pool(queue, primary_pool.get_reset_mode(), chunk);
+        }
+
+        secondary_command_buffers.resize(chunk_count);
+
+        JobSystem::GetInstance().ParallelFor(chunk_count, 1, [&](uint32_t chunk, uint32_t)
+        {
+            PROFILE_SCOPE("Record chunk");
+
+            uint32_t first_draw = static_cast<uint32_t>(static_cast<uint64_t>(draw_count) * chunk / chunk_count);
+            uint32_t end_draw = static_cast<uint32_t>(static_cast<uint64_t>(draw_count) * (chunk + 1) / chunk_count);
+
+            auto command_buffer = command_pools[chunk]->request_command_buffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &primary);
+
+            record_draws(*command_buffer, first_draw, end_draw - first_draw);
+
+            command_buffer->end();
+            secondary_command_buffers[chunk] = std::move(command_buffer);
+        });
+
+        primary.execute_commands(secondary_command_buffers);
+        secondary_command_buffers.clear();
+    }
+} // namespace vkb
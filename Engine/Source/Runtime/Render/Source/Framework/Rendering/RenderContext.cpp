@@ -23,6 +23,7 @@
 #include "Framework/Core/CommandPool.hpp"
 #include "Framework/Core/Queue.hpp"
 #include "Framework/Core/CommandBuffer.hpp"
+#include "Memory/FrameAllocator.hpp"
 
 namespace vkb
 {
@@ -240,6 +241,8 @@ namespace vkb
         }
 
         device.get_resource_cache().clear_framebuffers();
+
+        swapchain_generation++;
     }
 
     bool RenderContext::handle_surface_changes(bool force_update)
@@ -300,8 +303,9 @@ namespace vkb
 
     void RenderContext::submit(std::shared_ptr<vkb::CommandBuffer> command_buffer)
     {
-        std::vector<std::shared_ptr<vkb::CommandBuffer>> command_buffers(1, command_buffer);
-        submit(command_buffers);
+        single_submit.assign(1, std::move(command_buffer));
+        submit(single_submit);
+        single_submit.clear();
     }
 
     void RenderContext::submit(const std::vector<std::shared_ptr<vkb::CommandBuffer>>& command_buffers)
@@ -374,6 +378,9 @@ namespace vkb
         // Now the frame is active again
         frame_active = true;
 
+        // Temporaries of the previous frame were all consumed by its submit
+        FrameAllocator::BeginFrame();
+
         // Wait on all resource to be freed from the previous render to this frame
         wait_frame();
     }
@@ -383,7 +390,8 @@ namespace vkb
                                       VkSemaphore wait_semaphore,
                                       VkPipelineStageFlags wait_pipeline_stage)
     {
-        std::vector<VkCommandBuffer> cmd_buf_handles(command_buffers.size(), VK_NULL_HANDLE);
+        std::pmr::vector<VkCommandBuffer> cmd_buf_handles(command_buffers.size(), VK_NULL_HANDLE,
+                                                          FrameAllocator::GetResource());
         std::transform(command_buffers.begin(), command_buffers.end(), cmd_buf_handles.begin(),
                        [](auto const& cmd_buf)
                        {
@@ -408,9 +416,12 @@ namespace vkb
         submit_info.signalSemaphoreCount = 1;
         submit_info.pSignalSemaphores = &signal_semaphore;
 
+        // Uniforms written through the mapped ring buffers become visible to the device
+        frame.flush_buffers();
+
         VkFence fence = frame.get_fence_pool().request_fence();
 
-        VK_CHECK_RESULT(queue.submit({submit_info}, fence));
+        VK_CHECK_RESULT(queue.submit(submit_info, fence));
 
         return signal_semaphore;
     }
@@ -418,7 +429,8 @@ namespace vkb
     void RenderContext::submit(const Queue& queue,
                                const std::vector<std::shared_ptr<vkb::CommandBuffer>>& command_buffers)
     {
-        std::vector<VkCommandBuffer> cmd_buf_handles(command_buffers.size(), VK_NULL_HANDLE);
+        std::pmr::vector<VkCommandBuffer> cmd_buf_handles(command_buffers.size(), VK_NULL_HANDLE,
+                                                          FrameAllocator::GetResource());
         std::transform(command_buffers.begin(), command_buffers.end(), cmd_buf_handles.begin(),
                        [](auto const& cmd_buf)
                        {
@@ -432,9 +444,12 @@ namespace vkb
         submit_info.commandBufferCount = to_u32(cmd_buf_handles.size());
         submit_info.pCommandBuffers = cmd_buf_handles.data();
 
+        // Uniforms written through the mapped ring buffers become visible to the device
+        frame.flush_buffers();
+
         VkFence fence = frame.get_fence_pool().request_fence();
 
-        VK_CHECK_RESULT(queue.submit({submit_info}, fence));
+        VK_CHECK_RESULT(queue.submit(submit_info, fence));
     }
 
     void RenderContext::wait_frame()
@@ -582,6 +597,11 @@ namespace vkb
         return active_frame_index;
     }
 
+    uint32_t RenderContext::get_swapchain_generation() const
+    {
+        return swapchain_generation;
+    }
+
     std::vector<std::unique_ptr<vkb::RenderFrame>>& RenderContext::get_render_frames()
     {
         return frames;
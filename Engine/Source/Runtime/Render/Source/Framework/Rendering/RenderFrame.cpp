@@ -1,88 +1,147 @@
 #include "Framework/Rendering/RenderFrame.hpp"
 #include "Framework/Core/CommandPool.hpp"
 #include "Framework/Core/Queue.hpp"
-#include "Framework/Common/ResourceCaching.hpp"
 #include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Rendering/RenderTarget.hpp"
+
+#include <cstring>
 
 namespace vkb
 {
-    RenderFrame::RenderFrame(vkb::VulkanDevice& device_, std::unique_ptr<RenderTarget>&& render_target,
-                             size_t thread_count)
-        : device(device_),
-          fence_pool{device},
-          semaphore_pool{device},
-          thread_count{thread_count},
-          descriptor_pools(thread_count),
-          descriptor_sets(thread_count)
+    namespace
     {
-        static constexpr uint32_t BUFFER_POOL_BLOCK_SIZE = 256; // Block size of a buffer pool in kilobytes
+        /// Reads the member of the union the descriptor type uses, the bytes past it are padding
+        bool is_empty(const DescriptorInfo& descriptor_info, VkDescriptorType type)
+        {
+            if (vkb::is_buffer_descriptor_type(type))
+            {
+                return descriptor_info.buffer.buffer == VK_NULL_HANDLE;
+            }
 
-        // A map of the supported usages to a multiplier for the BUFFER_POOL_BLOCK_SIZE
-        static const std::unordered_map<VkBufferUsageFlags, uint32_t> supported_usage_map = {
-            {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 1},
-            {VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 2},
-            // x2 the size of BUFFER_POOL_BLOCK_SIZE since SSBOs are normally much larger than other types of buffers
-            {VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 1},
-            {VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 1}
-        };
+            return descriptor_info.image.sampler == VK_NULL_HANDLE && descriptor_info.image.imageView == VK_NULL_HANDLE;
+        }
 
-        update_render_target(std::move(render_target));
-        for (auto& usage_it : supported_usage_map)
+        bool is_bound(const DescriptorSetLayout& descriptor_set_layout,
+                      const std::vector<DescriptorInfo>& descriptor_infos, uint32_t binding_index)
         {
-            auto [buffer_pools_it, inserted] = buffer_pools.emplace(usage_it.first,
-                                                                    std::vector<std::pair<
-                                                                        vkb::BufferPool, vkb::BufferBlock*>>{});
-            if (!inserted)
+            auto range = descriptor_set_layout.get_descriptor_range(binding_index);
+
+            for (uint32_t i = 0; range && i < range->count; i++)
             {
-                // throw std::runtime_error("Failed to insert buffer pool");
-                // TODO: LOG("Failed to insert buffer pool");
-                return;
+                if (!is_empty(descriptor_infos[range->offset + i], range->type))
+                {
+                    return true;
+                }
             }
 
-            for (size_t i = 0; i < thread_count; ++i)
+            return false;
+        }
+
+        /**
+         * @brief Converts the flat descriptors of a set into the binding maps a DescriptorSet keeps
+         */
+        void to_binding_maps(const DescriptorSetLayout& descriptor_set_layout,
+                             const std::vector<DescriptorInfo>& descriptor_infos,
+                             BindingMap<VkDescriptorBufferInfo>& buffer_infos,
+                             BindingMap<VkDescriptorImageInfo>& image_infos)
+        {
+            for (auto& binding : descriptor_set_layout.get_bindings())
             {
-                buffer_pools_it->second.push_back(
-                    std::make_pair(vkb::BufferPool{
-                                       device, BUFFER_POOL_BLOCK_SIZE * 1024 * usage_it.second, usage_it.first
-                                   }, nullptr));
+                auto range = descriptor_set_layout.get_descriptor_range(binding.binding);
+
+                for (uint32_t array_element = 0; range && array_element < range->count; array_element++)
+                {
+                    auto& descriptor_info = descriptor_infos[range->offset + array_element];
+
+                    if (is_empty(descriptor_info, range->type))
+                    {
+                        continue;
+                    }
+
+                    if (vkb::is_buffer_descriptor_type(range->type))
+                    {
+                        buffer_infos[binding.binding][array_element] = descriptor_info.buffer;
+                    }
+                    else
+                    {
+                        image_infos[binding.binding][array_element] = descriptor_info.image;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief The update template writes every descriptor of the set as is, so it only applies to sets that
+         *        bind all of them and need none of the buffer ranges clipped by DescriptorSet::prepare()
+         */
+        bool can_use_update_template(vkb::VulkanDevice& device, const DescriptorSetLayout& descriptor_set_layout,
+                                     const std::vector<DescriptorInfo>& descriptor_infos)
+        {
+            if (descriptor_set_layout.get_update_template() == VK_NULL_HANDLE)
+            {
+                return false;
+            }
+
+            auto& limits = device.get_gpu().get_properties().limits;
+
+            for (auto& binding : descriptor_set_layout.get_bindings())
+            {
+                auto range = descriptor_set_layout.get_descriptor_range(binding.binding);
+
+                for (uint32_t i = 0; range && i < range->count; i++)
+                {
+                    auto& descriptor_info = descriptor_infos[range->offset + i];
+
+                    if (is_empty(descriptor_info, range->type))
+                    {
+                        return false;
+                    }
+
+                    bool is_uniform = range->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+                        range->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                    bool is_storage = range->type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+                        range->type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+                    if ((is_uniform && descriptor_info.buffer.range > limits.maxUniformBufferRange) ||
+                        (is_storage && descriptor_info.buffer.range > limits.maxStorageBufferRange))
+                    {
+                        return false;
+                    }
+                }
             }
+
+            return true;
         }
+    } // namespace
+
+    RenderFrame::RenderFrame(vkb::VulkanDevice& device_, std::unique_ptr<RenderTarget>&& render_target,
+                             size_t thread_count)
+        : device(device_),
+          buffer_allocator{device_, thread_count},
+          fence_pool{device},
+          semaphore_pool{device},
+          thread_count{thread_count},
+          descriptor_pools(thread_count),
+          descriptor_sets(thread_count),
+          descriptor_set_keys(thread_count)
+    {
+        update_render_target(std::move(render_target));
     }
 
     vkb::BufferAllocation RenderFrame::allocate_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index)
     {
         assert(thread_index < thread_count && "Thread index is out of bounds");
-        return allocate_buffer_impl(usage, size, thread_index);
+        return buffer_allocator.allocate(usage, size, thread_index);
     }
 
-    vkb::BufferAllocation RenderFrame::allocate_buffer_impl(VkBufferUsageFlags usage, VkDeviceSize size,
-                                                            size_t thread_index)
+    void RenderFrame::flush_buffers()
     {
-        // Find a pool for this usage
-        auto buffer_pool_it = buffer_pools.find(usage);
-        if (buffer_pool_it == buffer_pools.end())
-        {
-            // vk::to_string 是 vh::cpp 的一部分，已移除。
-            // LOGE("No buffer pool for buffer usage {} ", vk::to_string(usage));
-            // TODO: LOG("No buffer pool found for the specified usage flags.");
-            return vkb::BufferAllocation{}; // 返回一个空的 Allocation 对象
-        }
-
-        assert(thread_index < buffer_pool_it->second.size());
-        // 类型已更新为 vkb::BufferPool 和 vkb::BufferBlock
-        auto& buffer_pool = buffer_pool_it->second[thread_index].first;
-        auto& buffer_block = buffer_pool_it->second[thread_index].second;
-
-        bool want_minimal_block = (buffer_allocation_strategy == BufferAllocationStrategy::OneAllocationPerBuffer);
-
-        if (want_minimal_block || !buffer_block || !buffer_block->can_allocate(size))
-        {
-            // If we are creating a buffer for each allocation of there is no block associated with the pool or the current block is too small
-            // for this allocation, request a new buffer block
-            buffer_block = &buffer_pool.request_buffer_block(size, want_minimal_block);
-        }
+        buffer_allocator.flush();
+    }
 
-        return buffer_block->allocate(static_cast<uint32_t>(size));
+    const vkb::RingBufferAllocator& RenderFrame::get_buffer_allocator() const
+    {
+        return buffer_allocator;
     }
 
     // 不再需要模板
@@ -174,6 +233,11 @@ namespace vkb
         return fence_pool;
     }
 
+    size_t RenderFrame::get_thread_count() const
+    {
+        return thread_count;
+    }
+
     vkb::RenderTarget& RenderFrame::get_render_target()
     {
         return *swapchain_render_target;
@@ -197,59 +261,96 @@ namespace vkb
         return semaphore_pool;
     }
 
-    // request_descriptor_set 函数合并了 _impl 的实现，并全面转向 C-API
-    // 返回类型和参数类型都已更新
     VkDescriptorSet RenderFrame::request_descriptor_set(const vkb::DescriptorSetLayout& descriptor_set_layout,
-                                                        const BindingMap<VkDescriptorBufferInfo>& buffer_infos,
-                                                        const BindingMap<VkDescriptorImageInfo>& image_infos,
+                                                        const std::vector<DescriptorInfo>& descriptor_infos,
                                                         bool update_after_bind,
                                                         size_t thread_index)
     {
         assert(thread_index < thread_count && "Thread index is out of bounds");
         assert(thread_index < descriptor_pools.size());
+        assert(descriptor_infos.size() == descriptor_set_layout.get_descriptor_count());
 
-        auto& descriptor_pool = vkb::request_resource(device, nullptr, descriptor_pools[thread_index],
-                                                      descriptor_set_layout);
+        // Layouts are unique in the resource cache, their handle identifies the pool of the thread
+        auto& thread_descriptor_pools = descriptor_pools[thread_index];
+        auto descriptor_pool_it = thread_descriptor_pools.find(descriptor_set_layout.get_handle());
+        if (descriptor_pool_it == thread_descriptor_pools.end())
+        {
+            descriptor_pool_it = thread_descriptor_pools.try_emplace(descriptor_set_layout.get_handle(), device,
+                                                                     descriptor_set_layout).first;
+        }
+        auto& descriptor_pool = descriptor_pool_it->second;
         if (descriptor_management_strategy == DescriptorManagementStrategy::StoreInCache)
         {
+            // The layout and the flat descriptors identify the set, cache hits build no binding maps
+            assert(thread_index < descriptor_sets.size());
+            auto& key = descriptor_set_keys[thread_index];
+            key.clear();
+            key.write(descriptor_set_layout.get_handle());
+            key.write_bytes(descriptor_infos.data(), descriptor_infos.size() * sizeof(DescriptorInfo));
+
+            auto& thread_descriptor_sets = descriptor_sets[thread_index];
+            auto descriptor_set_it = thread_descriptor_sets.find(key);
+
+            if (descriptor_set_it == thread_descriptor_sets.end())
+            {
+                BindingMap<VkDescriptorBufferInfo> buffer_infos;
+                BindingMap<VkDescriptorImageInfo> image_infos;
+                to_binding_maps(descriptor_set_layout, descriptor_infos, buffer_infos, image_infos);
+
+                descriptor_set_it = thread_descriptor_sets.emplace(
+                    key, vkb::DescriptorSet{device, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos}).first;
+
+                if (!update_after_bind && can_use_update_template(device, descriptor_set_layout, descriptor_infos))
+                {
+                    descriptor_set_it->second.update_with_template(descriptor_infos.data());
+                    return descriptor_set_it->second.get_handle();
+                }
+            }
+            else if (!update_after_bind)
+            {
+                // Written when it was created
+                return descriptor_set_it->second.get_handle();
+            }
+
             // The bindings we want to update before binding, if empty we update all bindings
-            std::set<uint32_t> bindings_to_update;
+            std::vector<uint32_t> bindings_to_update;
             // If update after bind is enabled, we store the binding index of each binding that need to be updated before being bound
             if (update_after_bind)
             {
-                auto aggregate_binding_to_update = [&bindings_to_update, &descriptor_set_layout](const auto& infos_map)
+                for (auto& binding : descriptor_set_layout.get_bindings())
                 {
-                    for (const auto& [binding_index, ignored] : infos_map)
+                    if (!(descriptor_set_layout.get_layout_binding_flag(binding.binding) &
+                        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) &&
+                        is_bound(descriptor_set_layout, descriptor_infos, binding.binding))
                     {
-                        // 使用 Vulkan C-API 的标志位
-                        if (!(descriptor_set_layout.get_layout_binding_flag(binding_index) &
-                            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT))
-                        {
-                            bindings_to_update.insert(binding_index);
-                        }
+                        bindings_to_update.push_back(binding.binding);
                     }
-                };
-                aggregate_binding_to_update(buffer_infos);
-                aggregate_binding_to_update(image_infos);
+                }
             }
 
-            // Request a descriptor set from the render frame, and write the buffer infos and image infos of all the specified bindings
-            assert(thread_index < descriptor_sets.size());
-            // 假设 vkb::common::request_resource 和 vkb::DescriptorSet 也已更新为使用 C-API 类型
-            auto& descriptor_set =
-                vkb::request_resource(device, nullptr, descriptor_sets[thread_index], descriptor_set_layout,
-                                      descriptor_pool, buffer_infos, image_infos);
-            descriptor_set.update({bindings_to_update.begin(), bindings_to_update.end()});
+            auto& descriptor_set = descriptor_set_it->second;
+            descriptor_set.update(bindings_to_update);
             return descriptor_set.get_handle();
         }
         else
         {
             // Request a descriptor pool, allocate a descriptor set, write buffer and image data to it
-            // 使用去除 HPP 前缀和 Cpp 后缀的统一类型
+            BindingMap<VkDescriptorBufferInfo> buffer_infos;
+            BindingMap<VkDescriptorImageInfo> image_infos;
+            to_binding_maps(descriptor_set_layout, descriptor_infos, buffer_infos, image_infos);
+
             vkb::DescriptorSet descriptor_set{
                 device, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos
             };
-            descriptor_set.apply_writes();
+
+            if (can_use_update_template(device, descriptor_set_layout, descriptor_infos))
+            {
+                descriptor_set.update_with_template(descriptor_infos.data());
+            }
+            else
+            {
+                descriptor_set.apply_writes();
+            }
             return descriptor_set.get_handle();
         }
     }
@@ -267,14 +368,7 @@ namespace vkb
             }
         }
 
-        for (auto& buffer_pools_per_usage : buffer_pools)
-        {
-            for (auto& buffer_pool : buffer_pools_per_usage.second)
-            {
-                buffer_pool.first.reset();
-                buffer_pool.second = nullptr;
-            }
-        }
+        buffer_allocator.reset();
 
         semaphore_pool.reset();
 
@@ -284,11 +378,6 @@ namespace vkb
         }
     }
 
-    void RenderFrame::set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy)
-    {
-        buffer_allocation_strategy = new_strategy;
-    }
-
     void RenderFrame::set_descriptor_management_strategy(DescriptorManagementStrategy new_strategy)
     {
         descriptor_management_strategy = new_strategy;
@@ -0,0 +1,1143 @@
+#include "Framework/Rendering/RenderGraph.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "Framework/Core/Allocated.hpp"
+#include "Framework/Core/Buffer.hpp"
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/Debug.hpp"
+#include "Framework/Core/FrameBuffer.hpp"
+#include "Framework/Core/Image.hpp"
+#include "Framework/Core/ImageView.hpp"
+#include "Framework/Core/RenderPass.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Misc/GpuProfiler.hpp"
+#include "Framework/Misc/ResourceCache.hpp"
+#include "Framework/Rendering/RenderTarget.hpp"
+#include "Logging/Logger.hpp"
+#include "Profiler/Profiler.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        constexpr VkAccessFlags write_access_mask =
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+        struct AccessInfo
+        {
+            VkPipelineStageFlags stages;
+            VkAccessFlags access;
+            VkImageLayout layout;
+            VkImageUsageFlags image_usage;
+            VkBufferUsageFlags buffer_usage;
+            bool write;
+        };
+
+        AccessInfo get_access_info(RenderGraphAccess access, RenderGraphPass::Type type)
+        {
+            VkPipelineStageFlags shader_stages = type == RenderGraphPass::Type::Compute ?
+                                                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT :
+                                                     VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+            switch (access)
+            {
+                case RenderGraphAccess::ColorAttachment:
+                    return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0, true};
+                case RenderGraphAccess::DepthStencilAttachment:
+                    return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, true};
+                case RenderGraphAccess::SampledImage:
+                    return {shader_stages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            VK_IMAGE_USAGE_SAMPLED_BIT, 0, false};
+                case RenderGraphAccess::StorageImageRead:
+                    return {shader_stages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, 0, false};
+                case RenderGraphAccess::StorageImageWrite:
+                    return {shader_stages, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL,
+                            VK_IMAGE_USAGE_STORAGE_BIT, 0, true};
+                case RenderGraphAccess::TransferSrc:
+                    return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                            VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false};
+                case RenderGraphAccess::TransferDst:
+                    return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true};
+                case RenderGraphAccess::UniformBuffer:
+                    return {shader_stages, VK_ACCESS_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false};
+                case RenderGraphAccess::StorageBufferRead:
+                    return {shader_stages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false};
+                case RenderGraphAccess::StorageBufferWrite:
+                    return {shader_stages, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true};
+                case RenderGraphAccess::VertexBuffer:
+                    return {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, false};
+                case RenderGraphAccess::IndexBuffer:
+                    return {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                            VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false};
+                case RenderGraphAccess::IndirectBuffer:
+                    return {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false};
+            }
+
+            throw std::runtime_error("Unknown render graph access");
+        }
+
+        /// What the compiler knows about a resource between two passes
+        struct ResourceState
+        {
+            VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+            /// Stages of the last write, or of the last layout transition
+            VkPipelineStageFlags write_stages{0};
+
+            /// Writes not made available yet
+            VkAccessFlags write_access{0};
+
+            /// Stages that read since the last write
+            VkPipelineStageFlags read_stages{0};
+
+            /// Stages and accesses the last write is visible to
+            VkPipelineStageFlags visible_stages{0};
+
+            VkAccessFlags visible_access{0};
+        };
+
+        /// The accesses of one pass to one resource, merged
+        struct PassAccess
+        {
+            uint32_t resource;
+            AccessInfo info;
+            bool reads_contents;
+        };
+
+        void merge_access(std::vector<PassAccess> &accesses, uint32_t resource, const AccessInfo &info, bool reads_contents,
+                          const std::string &pass_name)
+        {
+            for (auto &access : accesses)
+            {
+                if (access.resource == resource)
+                {
+                    if (access.info.layout != info.layout)
+                    {
+                        throw std::runtime_error("Pass " + pass_name + " uses a resource in two layouts");
+                    }
+                    access.info.stages |= info.stages;
+                    access.info.access |= info.access;
+                    access.info.write |= info.write;
+                    access.reads_contents |= reads_contents;
+                    return;
+                }
+            }
+
+            accesses.push_back({resource, info, reads_contents});
+        }
+
+        /**
+         * @brief Adds the barrier needed before an access to a resource to the batch of the pass
+         * @return True if an image or buffer barrier is needed, its masks are returned through src_access and dst_access
+         */
+        bool transition(ResourceState &state, const AccessInfo &info, bool is_image, VkPipelineStageFlags &src_stages,
+                        VkPipelineStageFlags &dst_stages, VkAccessFlags &src_access, VkAccessFlags &dst_access)
+        {
+            bool layout_change = is_image && state.layout != info.layout;
+            bool memory_barrier = false;
+
+            if (layout_change || info.write)
+            {
+                // Writes wait for the reads since the last write (WAR) and for the last write (WAW)
+                VkPipelineStageFlags wait_stages = state.write_stages | state.read_stages;
+                memory_barrier = layout_change || state.write_access != 0;
+
+                if (wait_stages != 0 || memory_barrier)
+                {
+                    src_stages |= wait_stages;
+                    dst_stages |= info.stages;
+                }
+
+                // The contents of an undefined image are discarded, nothing has to be made available
+                src_access = state.layout == VK_IMAGE_LAYOUT_UNDEFINED && is_image ? 0 : state.write_access;
+                dst_access = info.access;
+
+                state.layout = info.layout;
+                state.write_stages = info.stages;
+                state.write_access = info.write ? info.access & write_access_mask : 0;
+                state.read_stages = info.write ? 0 : info.stages;
+                state.visible_stages = info.stages;
+                state.visible_access = info.access;
+            }
+            else
+            {
+                // Reads wait for the last write unless it is visible to them already (RAW)
+                bool visible = (info.stages & ~state.visible_stages) == 0 && (info.access & ~state.visible_access) == 0;
+                if (state.write_stages != 0 && !visible)
+                {
+                    src_stages |= state.write_stages;
+                    dst_stages |= info.stages;
+
+                    memory_barrier = state.write_access != 0;
+                    src_access = state.write_access;
+                    dst_access = info.access;
+
+                    state.visible_stages |= info.stages;
+                    state.visible_access |= info.access;
+                }
+
+                state.read_stages |= info.stages;
+            }
+
+            return memory_barrier;
+        }
+
+        VkImageAspectFlags get_aspect_mask(VkFormat format)
+        {
+            if (is_depth_stencil_format(format))
+            {
+                return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+            }
+            if (is_depth_format(format))
+            {
+                return VK_IMAGE_ASPECT_DEPTH_BIT;
+            }
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    } // namespace
+
+    // ===================================
+    // RenderGraphPass implementation
+    // ===================================
+
+    RenderGraphPass::RenderGraphPass(std::string name, Type type) :
+        name{std::move(name)},
+        profile_name{Profiler::GetInstance().Intern(this->name)},
+        type{type}
+    {
+    }
+
+    RenderGraphPass &RenderGraphPass::add_color_attachment(RenderGraphImage image, const LoadStoreInfo &load_store, const VkClearValue &clear_value)
+    {
+        if (has_depth_attachment)
+        {
+            throw std::runtime_error("Pass " + name + " adds a color attachment after its depth attachment");
+        }
+
+        attachments.push_back({image.index, load_store});
+        clear_values.push_back(clear_value);
+        return *this;
+    }
+
+    RenderGraphPass &RenderGraphPass::set_depth_attachment(RenderGraphImage image, const LoadStoreInfo &load_store, const VkClearValue &clear_value)
+    {
+        if (has_depth_attachment)
+        {
+            attachments.back() = {image.index, load_store};
+            clear_values.back() = clear_value;
+        }
+        else
+        {
+            attachments.push_back({image.index, load_store});
+            clear_values.push_back(clear_value);
+            has_depth_attachment = true;
+        }
+        return *this;
+    }
+
+    RenderGraphPass &RenderGraphPass::use(RenderGraphImage image, RenderGraphAccess access)
+    {
+        image_uses.push_back({image.index, access});
+        return *this;
+    }
+
+    RenderGraphPass &RenderGraphPass::use(RenderGraphBuffer buffer, RenderGraphAccess access)
+    {
+        buffer_uses.push_back({buffer.index, access});
+        return *this;
+    }
+
+    RenderGraphPass &RenderGraphPass::set_side_effect(bool side_effect_)
+    {
+        side_effect = side_effect_;
+        return *this;
+    }
+
+    RenderGraphPass &RenderGraphPass::set_execute(ExecuteFunc execute_)
+    {
+        execute = std::move(execute_);
+        return *this;
+    }
+
+    const std::string &RenderGraphPass::get_name() const
+    {
+        return name;
+    }
+
+    RenderGraphPass::Type RenderGraphPass::get_type() const
+    {
+        return type;
+    }
+
+    // ===================================
+    // RenderGraph implementation
+    // ===================================
+
+    RenderGraph::RenderGraph(VulkanDevice &device, uint32_t frames_in_flight) :
+        device{device},
+        frames_in_flight{frames_in_flight}
+    {
+    }
+
+    RenderGraph::~RenderGraph()
+    {
+        retire_resources();
+        destroy_retired_resources(true);
+    }
+
+    void RenderGraph::reset()
+    {
+        passes.clear();
+        images.clear();
+        buffers.clear();
+
+        frame_index++;
+        destroy_retired_resources(false);
+    }
+
+    RenderGraphImage RenderGraph::create_image(const std::string &name, const RenderGraphImageDesc &desc)
+    {
+        ImageResource resource;
+        resource.name = name;
+        resource.desc = desc;
+        images.push_back(std::move(resource));
+
+        return {static_cast<uint32_t>(images.size() - 1)};
+    }
+
+    RenderGraphImage RenderGraph::import_image(const std::string &name, const ImageView &view,
+                                               VkImageLayout initial_layout, VkImageLayout final_layout,
+                                               VkPipelineStageFlags initial_stages)
+    {
+        const auto &image = view.get_image();
+
+        ImageResource resource;
+        resource.name = name;
+        resource.desc.extent = {image.get_extent().width, image.get_extent().height};
+        resource.desc.format = image.get_format();
+        resource.desc.samples = image.get_sample_count();
+        resource.desc.usage = image.get_usage();
+        resource.imported_view = &view;
+        resource.initial_layout = initial_layout;
+        resource.final_layout = final_layout;
+        resource.initial_stages = initial_stages;
+        images.push_back(std::move(resource));
+
+        return {static_cast<uint32_t>(images.size() - 1)};
+    }
+
+    RenderGraphBuffer RenderGraph::create_buffer(const std::string &name, const RenderGraphBufferDesc &desc)
+    {
+        BufferResource resource;
+        resource.name = name;
+        resource.desc = desc;
+        buffers.push_back(std::move(resource));
+
+        return {static_cast<uint32_t>(buffers.size() - 1)};
+    }
+
+    RenderGraphBuffer RenderGraph::import_buffer(const std::string &name, const Buffer &buffer)
+    {
+        BufferResource resource;
+        resource.name = name;
+        resource.desc.size = buffer.get_size();
+        resource.imported_buffer = &buffer;
+        buffers.push_back(std::move(resource));
+
+        return {static_cast<uint32_t>(buffers.size() - 1)};
+    }
+
+    RenderGraphPass &RenderGraph::add_pass(const std::string &name, RenderGraphPass::Type type)
+    {
+        passes.emplace_back(name, type);
+        return passes.back();
+    }
+
+    void RenderGraph::build_topology_key(ResourceKey &key) const
+    {
+        key.clear();
+
+        // Imported resources change between frames, only what the compiled barriers and render passes depend on is part of the key
+        key.write(static_cast<uint32_t>(images.size()));
+        for (auto &image : images)
+        {
+            key.write(image.imported_view != nullptr);
+            key.write(image.desc.extent.width);
+            key.write(image.desc.extent.height);
+            key.write(image.desc.format);
+            key.write(image.desc.samples);
+            key.write(image.desc.usage);
+            key.write(image.initial_layout);
+            key.write(image.final_layout);
+            key.write(image.initial_stages);
+        }
+
+        key.write(static_cast<uint32_t>(buffers.size()));
+        for (auto &buffer : buffers)
+        {
+            key.write(buffer.imported_buffer != nullptr);
+            key.write(buffer.desc.size);
+            key.write(buffer.desc.usage);
+        }
+
+        key.write(static_cast<uint32_t>(passes.size()));
+        for (auto &pass : passes)
+        {
+            key.write(pass.type);
+            key.write(pass.side_effect);
+            key.write(pass.has_depth_attachment);
+
+            key.write(static_cast<uint32_t>(pass.attachments.size()));
+            for (auto &attachment : pass.attachments)
+            {
+                key.write(attachment.image);
+                key.write(attachment.load_store.load_op);
+                key.write(attachment.load_store.store_op);
+            }
+
+            key.write(static_cast<uint32_t>(pass.image_uses.size()));
+            for (auto &use : pass.image_uses)
+            {
+                key.write(use.image);
+                key.write(use.access);
+            }
+
+            key.write(static_cast<uint32_t>(pass.buffer_uses.size()));
+            for (auto &use : pass.buffer_uses)
+            {
+                key.write(use.buffer);
+                key.write(use.access);
+            }
+        }
+    }
+
+    std::vector<bool> RenderGraph::cull_passes() const
+    {
+        std::vector<bool> kept(passes.size(), false);
+
+        // A resource is needed if a kept pass later in the graph reads it, imported ones are always needed
+        std::vector<bool> image_needed(images.size(), false);
+        std::vector<bool> buffer_needed(buffers.size(), false);
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            image_needed[i] = images[i].imported_view != nullptr;
+        }
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            buffer_needed[i] = buffers[i].imported_buffer != nullptr;
+        }
+
+        for (size_t p = passes.size(); p-- > 0;)
+        {
+            const auto &pass = passes[p];
+
+            bool keep = pass.side_effect;
+            for (auto &attachment : pass.attachments)
+            {
+                keep = keep || image_needed[attachment.image];
+            }
+            for (auto &use : pass.image_uses)
+            {
+                keep = keep || (get_access_info(use.access, pass.type).write && image_needed[use.image]);
+            }
+            for (auto &use : pass.buffer_uses)
+            {
+                keep = keep || (get_access_info(use.access, pass.type).write && buffer_needed[use.buffer]);
+            }
+
+            if (!keep)
+            {
+                continue;
+            }
+            kept[p] = true;
+
+            // Attachments that are not loaded overwrite what earlier passes wrote, everything else reads it
+            for (auto &attachment : pass.attachments)
+            {
+                if (images[attachment.image].imported_view == nullptr)
+                {
+                    image_needed[attachment.image] = attachment.load_store.load_op == VK_ATTACHMENT_LOAD_OP_LOAD;
+                }
+            }
+            for (auto &use : pass.image_uses)
+            {
+                image_needed[use.image] = true;
+            }
+            for (auto &use : pass.buffer_uses)
+            {
+                buffer_needed[use.buffer] = true;
+            }
+        }
+
+        return kept;
+    }
+
+    bool RenderGraph::compile()
+    {
+        build_topology_key(topology_key);
+
+        if (compiled && topology_key == compiled_key)
+        {
+            return false;
+        }
+
+        // The transient resources of the previous compilation may still be in use by the frames in flight
+        retire_resources();
+
+        uint32_t compilations = stats.compilations + 1;
+        stats = {};
+        stats.compilations = compilations;
+        stats.passes = static_cast<uint32_t>(passes.size());
+
+        auto kept = cull_passes();
+
+        std::vector<uint32_t> pass_order;
+        for (uint32_t p = 0; p < passes.size(); p++)
+        {
+            if (kept[p])
+            {
+                pass_order.push_back(p);
+            }
+            else
+            {
+                LOGD("Render graph culled pass {}", passes[p].name);
+            }
+        }
+        stats.culled_passes = stats.passes - static_cast<uint32_t>(pass_order.size());
+
+        create_transient_resources(pass_order);
+
+        std::vector<ResourceState> image_states(images.size());
+        std::vector<ResourceState> buffer_states(buffers.size());
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            if (images[i].imported_view)
+            {
+                image_states[i].layout = images[i].initial_layout;
+                image_states[i].write_stages = images[i].initial_stages;
+                image_states[i].write_access = VK_ACCESS_MEMORY_WRITE_BIT;
+            }
+        }
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            if (buffers[i].imported_buffer)
+            {
+                buffer_states[i].write_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                buffer_states[i].write_access = VK_ACCESS_MEMORY_WRITE_BIT;
+            }
+        }
+
+        // The first barrier of a transient resource also waits for the last use of the memory it is bound to,
+        // which is patched in once the last uses are known
+        std::vector<std::pair<size_t, size_t>> first_image_barriers(images.size(), {~size_t{0}, 0});
+        std::vector<std::pair<size_t, AccessInfo>> first_buffer_uses(buffers.size(), {~size_t{0}, AccessInfo{}});
+
+        std::vector<PassAccess> image_accesses;
+        std::vector<PassAccess> buffer_accesses;
+
+        for (uint32_t p : pass_order)
+        {
+            auto &pass = passes[p];
+
+            image_accesses.clear();
+            buffer_accesses.clear();
+
+            for (size_t a = 0; a < pass.attachments.size(); a++)
+            {
+                bool is_depth = pass.has_depth_attachment && a + 1 == pass.attachments.size();
+                auto access = is_depth ? RenderGraphAccess::DepthStencilAttachment : RenderGraphAccess::ColorAttachment;
+                merge_access(image_accesses, pass.attachments[a].image, get_access_info(access, pass.type),
+                             pass.attachments[a].load_store.load_op == VK_ATTACHMENT_LOAD_OP_LOAD, pass.name);
+            }
+            for (auto &use : pass.image_uses)
+            {
+                merge_access(image_accesses, use.image, get_access_info(use.access, pass.type), true, pass.name);
+            }
+            for (auto &use : pass.buffer_uses)
+            {
+                merge_access(buffer_accesses, use.buffer, get_access_info(use.access, pass.type), true, pass.name);
+            }
+
+            CompiledPass compiled_pass{p};
+            auto &batch = compiled_pass.barriers;
+
+            for (auto &access : image_accesses)
+            {
+                // Contents that are cleared or not loaded need no transition from the old layout
+                auto &state = image_states[access.resource];
+                if (!access.reads_contents && images[access.resource].imported_view == nullptr)
+                {
+                    state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                }
+
+                ImageBarrier barrier{access.resource};
+                barrier.old_layout = state.layout;
+                barrier.new_layout = access.info.layout;
+
+                if (transition(state, access.info, true, batch.src_stages, batch.dst_stages, barrier.src_access, barrier.dst_access))
+                {
+                    if (images[access.resource].imported_view == nullptr && first_image_barriers[access.resource].first == ~size_t{0})
+                    {
+                        first_image_barriers[access.resource] = {compiled_passes.size(), batch.image_barriers.size()};
+                    }
+                    batch.image_barriers.push_back(barrier);
+                }
+            }
+
+            for (auto &access : buffer_accesses)
+            {
+                BufferBarrier barrier{access.resource};
+
+                if (buffers[access.resource].imported_buffer == nullptr && first_buffer_uses[access.resource].first == ~size_t{0})
+                {
+                    first_buffer_uses[access.resource] = {compiled_passes.size(), access.info};
+                }
+
+                if (transition(buffer_states[access.resource], access.info, false, batch.src_stages, batch.dst_stages, barrier.src_access, barrier.dst_access))
+                {
+                    batch.buffer_barriers.push_back(barrier);
+                }
+            }
+
+            // Graphics passes with attachments get a render pass whose attachments are already in their layouts
+            if (pass.type == RenderGraphPass::Type::Graphics && !pass.attachments.empty())
+            {
+                std::vector<vkb::Attachment> attachments;
+                std::vector<LoadStoreInfo> load_store_infos;
+
+                SubpassInfo subpass_info{};
+                subpass_info.disable_depth_stencil_attachment = !pass.has_depth_attachment;
+                subpass_info.depth_stencil_resolve_attachment = VK_ATTACHMENT_UNUSED;
+                subpass_info.depth_stencil_resolve_mode = VK_RESOLVE_MODE_NONE;
+                subpass_info.debug_name = pass.name;
+
+                for (uint32_t a = 0; a < pass.attachments.size(); a++)
+                {
+                    const auto &image = get_image(pass.attachments[a].image);
+                    bool is_depth = pass.has_depth_attachment && a + 1 == pass.attachments.size();
+
+                    vkb::Attachment attachment{image.get_format(), image.get_sample_count(), image.get_usage()};
+                    attachment.initial_layout = is_depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                    attachments.push_back(attachment);
+                    load_store_infos.push_back(pass.attachments[a].load_store);
+
+                    if (!is_depth)
+                    {
+                        subpass_info.output_attachments.push_back(a);
+                    }
+                }
+
+                compiled_pass.render_pass = &device.get_resource_cache().request_render_pass(attachments, load_store_infos, {subpass_info});
+            }
+
+            if (batch.src_stages != 0 || batch.dst_stages != 0)
+            {
+                stats.barrier_batches++;
+            }
+            stats.image_barriers += static_cast<uint32_t>(batch.image_barriers.size());
+            stats.buffer_barriers += static_cast<uint32_t>(batch.buffer_barriers.size());
+
+            compiled_passes.push_back(std::move(compiled_pass));
+        }
+
+        // Leave the imported resources in their final layouts, visible to whatever uses them next
+        for (uint32_t i = 0; i < images.size(); i++)
+        {
+            auto &state = image_states[i];
+            if (!images[i].imported_view || (state.write_stages == 0 && state.read_stages == 0))
+            {
+                continue;
+            }
+
+            bool present = images[i].final_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            VkImageLayout final_layout = images[i].final_layout == VK_IMAGE_LAYOUT_UNDEFINED ? state.layout : images[i].final_layout;
+
+            if (final_layout != state.layout || state.write_access != 0)
+            {
+                final_barriers.src_stages |= state.write_stages | state.read_stages;
+                final_barriers.dst_stages |= present ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                final_barriers.image_barriers.push_back({i, state.write_access,
+                                                         present ? 0u : VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+                                                         state.layout, final_layout});
+            }
+        }
+        for (uint32_t i = 0; i < buffers.size(); i++)
+        {
+            auto &state = buffer_states[i];
+            if (buffers[i].imported_buffer && state.write_access != 0)
+            {
+                final_barriers.src_stages |= state.write_stages;
+                final_barriers.dst_stages |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                final_barriers.buffer_barriers.push_back({i, state.write_access, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT});
+            }
+        }
+
+        // The next frame reuses the transient memory, its first use waits for the last use in this frame.
+        // Aliased images wait for the last use of the image they share memory with.
+        for (uint32_t i = 0; i < images.size(); i++)
+        {
+            auto &first = first_image_barriers[i];
+            if (first.first == ~size_t{0})
+            {
+                continue;
+            }
+
+            auto &previous = image_states[aliased_predecessors[i]];
+            auto &batch = compiled_passes[first.first].barriers;
+            batch.src_stages |= previous.write_stages | previous.read_stages;
+            batch.image_barriers[first.second].src_access |= previous.write_access;
+        }
+        for (uint32_t i = 0; i < buffers.size(); i++)
+        {
+            auto &first = first_buffer_uses[i];
+            if (first.first == ~size_t{0})
+            {
+                continue;
+            }
+
+            auto &state = buffer_states[i];
+            auto &batch = compiled_passes[first.first].barriers;
+            if (state.write_stages != 0 || state.read_stages != 0)
+            {
+                batch.src_stages |= state.write_stages | state.read_stages;
+                batch.dst_stages |= first.second.stages;
+            }
+
+            // The last write of the previous frame is made available before the first use overwrites it (WAW)
+            if (state.write_access != 0)
+            {
+                auto barrier = std::find_if(batch.buffer_barriers.begin(), batch.buffer_barriers.end(),
+                                            [i](const BufferBarrier &barrier) { return barrier.buffer == i; });
+                if (barrier != batch.buffer_barriers.end())
+                {
+                    barrier->src_access |= state.write_access;
+                }
+                else
+                {
+                    batch.buffer_barriers.push_back({i, state.write_access, first.second.access});
+                }
+            }
+        }
+
+        compiled_key = topology_key;
+        compiled = true;
+
+        LOGD("Render graph compiled: {} passes, {} culled, {} barrier batches, {} transient images in {} of {} bytes",
+             stats.passes, stats.culled_passes, stats.barrier_batches, stats.transient_images, stats.transient_memory,
+             stats.unaliased_memory);
+
+        return true;
+    }
+
+    void RenderGraph::create_transient_resources(const std::vector<uint32_t> &pass_order)
+    {
+        // Lifetimes in compiled pass order and the usage each transient resource needs
+        std::vector<std::pair<uint32_t, uint32_t>> lifetimes(images.size(), {~0u, 0});
+        std::vector<VkImageUsageFlags> image_usage(images.size(), 0);
+        std::vector<VkBufferUsageFlags> buffer_usage(buffers.size(), 0);
+        std::vector<bool> buffer_used(buffers.size(), false);
+
+        for (uint32_t order = 0; order < pass_order.size(); order++)
+        {
+            auto &pass = passes[pass_order[order]];
+
+            auto use_image = [&](uint32_t image, VkImageUsageFlags usage)
+            {
+                lifetimes[image].first = std::min(lifetimes[image].first, order);
+                lifetimes[image].second = std::max(lifetimes[image].second, order);
+                image_usage[image] |= usage;
+            };
+
+            for (size_t a = 0; a < pass.attachments.size(); a++)
+            {
+                bool is_depth = pass.has_depth_attachment && a + 1 == pass.attachments.size();
+                use_image(pass.attachments[a].image, is_depth ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+            }
+            for (auto &use : pass.image_uses)
+            {
+                use_image(use.image, get_access_info(use.access, pass.type).image_usage);
+            }
+            for (auto &use : pass.buffer_uses)
+            {
+                buffer_usage[use.buffer] |= get_access_info(use.access, pass.type).buffer_usage;
+                buffer_used[use.buffer] = true;
+            }
+        }
+
+        transient_images.resize(images.size());
+        aliased_predecessors.resize(images.size());
+        std::iota(aliased_predecessors.begin(), aliased_predecessors.end(), 0u);
+
+        std::vector<uint32_t> transient;
+        std::vector<VkMemoryRequirements> requirements(images.size());
+
+        for (uint32_t i = 0; i < images.size(); i++)
+        {
+            auto &resource = images[i];
+            if (resource.imported_view || lifetimes[i].first == ~0u)
+            {
+                continue;
+            }
+
+            VkImageCreateInfo create_info{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+            create_info.imageType = VK_IMAGE_TYPE_2D;
+            create_info.format = resource.desc.format;
+            create_info.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+            create_info.mipLevels = 1;
+            create_info.arrayLayers = 1;
+            create_info.samples = resource.desc.samples;
+            create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            create_info.usage = resource.desc.usage | image_usage[i];
+            create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            auto &transient_image = transient_images[i];
+            VK_CHECK_RESULT(vkCreateImage(device.GetHandle(), &create_info, nullptr, &transient_image.handle));
+            vkGetImageMemoryRequirements(device.GetHandle(), transient_image.handle, &requirements[i]);
+
+            transient.push_back(i);
+            stats.unaliased_memory += requirements[i].size;
+        }
+
+        // Largest first, each image joins the first block it is compatible with and whose images are all dead
+        // during its lifetime
+        std::sort(transient.begin(), transient.end(), [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+        struct Block
+        {
+            VkMemoryRequirements requirements;
+            std::vector<uint32_t> images;
+        };
+        std::vector<Block> blocks;
+
+        for (uint32_t i : transient)
+        {
+            auto overlaps = [&](uint32_t other)
+            {
+                return lifetimes[i].first <= lifetimes[other].second && lifetimes[other].first <= lifetimes[i].second;
+            };
+
+            auto block_it = std::find_if(blocks.begin(), blocks.end(), [&](const Block &block)
+            {
+                return (block.requirements.memoryTypeBits & requirements[i].memoryTypeBits) != 0 &&
+                       std::none_of(block.images.begin(), block.images.end(), overlaps);
+            });
+
+            if (block_it == blocks.end())
+            {
+                blocks.push_back({requirements[i], {i}});
+                continue;
+            }
+
+            block_it->requirements.size = std::max(block_it->requirements.size, requirements[i].size);
+            block_it->requirements.alignment = std::max(block_it->requirements.alignment, requirements[i].alignment);
+            block_it->requirements.memoryTypeBits &= requirements[i].memoryTypeBits;
+            block_it->images.push_back(i);
+        }
+
+        for (auto &block : blocks)
+        {
+            VmaAllocationCreateInfo allocation_info{};
+            allocation_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+            VmaAllocation allocation{VK_NULL_HANDLE};
+            VK_CHECK_RESULT(vmaAllocateMemory(get_memory_allocator(), &block.requirements, &allocation_info, &allocation, nullptr));
+            memory_blocks.push_back(allocation);
+            stats.transient_memory += block.requirements.size;
+
+            std::sort(block.images.begin(), block.images.end(), [&](uint32_t a, uint32_t b) { return lifetimes[a].first < lifetimes[b].first; });
+
+            for (size_t k = 0; k < block.images.size(); k++)
+            {
+                uint32_t i = block.images[k];
+                auto &resource = images[i];
+                auto &transient_image = transient_images[i];
+
+                VK_CHECK_RESULT(vmaBindImageMemory(get_memory_allocator(), allocation, transient_image.handle));
+
+                transient_image.image = std::make_unique<Image>(device, transient_image.handle,
+                                                                VkExtent3D{resource.desc.extent.width, resource.desc.extent.height, 1},
+                                                                resource.desc.format, resource.desc.usage | image_usage[i], resource.desc.samples);
+                transient_image.view = std::make_unique<ImageView>(*transient_image.image, VK_IMAGE_VIEW_TYPE_2D);
+
+                // The image that used the memory last, in this frame or in the previous one
+                aliased_predecessors[i] = block.images[(k + block.images.size() - 1) % block.images.size()];
+            }
+        }
+        stats.transient_images = static_cast<uint32_t>(transient.size());
+
+        transient_buffers.resize(buffers.size());
+        for (uint32_t i = 0; i < buffers.size(); i++)
+        {
+            if (!buffers[i].imported_buffer && buffer_used[i])
+            {
+                transient_buffers[i] = std::make_unique<Buffer>(device, buffers[i].desc.size, buffers[i].desc.usage | buffer_usage[i],
+                                                                VMA_MEMORY_USAGE_GPU_ONLY, 0);
+            }
+        }
+    }
+
+    void RenderGraph::retire_resources()
+    {
+        compiled_passes.clear();
+        final_barriers = {};
+        compiled = false;
+
+        if (transient_images.empty() && transient_buffers.empty() && memory_blocks.empty() && render_targets.empty())
+        {
+            return;
+        }
+
+        retired_resources.push_back({frame_index, std::move(transient_images), std::move(transient_buffers),
+                                     std::move(memory_blocks), std::move(render_targets)});
+
+        transient_images.clear();
+        transient_buffers.clear();
+        memory_blocks.clear();
+        render_targets.clear();
+    }
+
+    void RenderGraph::destroy_retired_resources(bool all)
+    {
+        // A frame waits for the one frames_in_flight frames before it, which used the resources last
+        while (!retired_resources.empty() && (all || retired_resources.front().frame + frames_in_flight <= frame_index))
+        {
+            auto &resources = retired_resources.front();
+
+            // The framebuffers and the views of the render targets go before the images they point at
+            resources.render_targets.clear();
+
+            for (auto &transient_image : resources.transient_images)
+            {
+                transient_image.view.reset();
+                transient_image.image.reset();
+                if (transient_image.handle != VK_NULL_HANDLE)
+                {
+                    vkDestroyImage(device.GetHandle(), transient_image.handle, nullptr);
+                }
+            }
+            resources.transient_buffers.clear();
+
+            for (auto allocation : resources.memory_blocks)
+            {
+                vmaFreeMemory(get_memory_allocator(), allocation);
+            }
+
+            retired_resources.pop_front();
+        }
+    }
+
+    void RenderGraph::clear()
+    {
+        device.wait_idle();
+        retire_resources();
+        destroy_retired_resources(true);
+    }
+
+    void RenderGraph::execute(CommandBuffer &command_buffer)
+    {
+        if (!compiled)
+        {
+            throw std::runtime_error("Render graph is executed before it is compiled");
+        }
+
+        for (auto &compiled_pass : compiled_passes)
+        {
+            auto &pass = passes[compiled_pass.pass];
+
+            record_barriers(command_buffer, compiled_pass.barriers);
+
+            ScopedDebugLabel pass_debug_label{command_buffer, pass.name.c_str()};
+
+            ProfileZone pass_zone{pass.profile_name};
+            ScopedGpuZone pass_gpu_zone{gpu_profiler, command_buffer, pass.profile_name};
+
+            if (compiled_pass.render_pass)
+            {
+                auto &pass_render_target = request_render_target(compiled_pass);
+                auto &render_target = *pass_render_target.render_target;
+
+                command_buffer.begin_render_pass(render_target, *compiled_pass.render_pass, *pass_render_target.framebuffer, pass.clear_values);
+
+                const auto &extent = render_target.get_extent();
+
+                VkViewport viewport{0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f};
+                command_buffer.set_viewport(0, {viewport});
+
+                VkRect2D scissor{{0, 0}, extent};
+                command_buffer.set_scissor(0, {scissor});
+
+                if (pass.execute)
+                {
+                    pass.execute(command_buffer);
+                }
+
+                command_buffer.end_render_pass();
+            }
+            else if (pass.execute)
+            {
+                pass.execute(command_buffer);
+            }
+        }
+
+        record_barriers(command_buffer, final_barriers);
+    }
+
+    void RenderGraph::record_barriers(CommandBuffer &command_buffer, const BarrierBatch &batch)
+    {
+        if (batch.src_stages == 0 && batch.dst_stages == 0)
+        {
+            return;
+        }
+
+        image_barrier_scratch.clear();
+        for (auto &barrier : batch.image_barriers)
+        {
+            const auto &image = get_image(barrier.image);
+
+            VkImageMemoryBarrier image_barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+            image_barrier.srcAccessMask = barrier.src_access;
+            image_barrier.dstAccessMask = barrier.dst_access;
+            image_barrier.oldLayout = barrier.old_layout;
+            image_barrier.newLayout = barrier.new_layout;
+            image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            image_barrier.image = image.GetHandle();
+            image_barrier.subresourceRange = {get_aspect_mask(image.get_format()), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+            image_barrier_scratch.push_back(image_barrier);
+        }
+
+        buffer_barrier_scratch.clear();
+        for (auto &barrier : batch.buffer_barriers)
+        {
+            VkBufferMemoryBarrier buffer_barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+            buffer_barrier.srcAccessMask = barrier.src_access;
+            buffer_barrier.dstAccessMask = barrier.dst_access;
+            buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            buffer_barrier.buffer = get_buffer({barrier.buffer}).GetHandle();
+            buffer_barrier.offset = 0;
+            buffer_barrier.size = VK_WHOLE_SIZE;
+            buffer_barrier_scratch.push_back(buffer_barrier);
+        }
+
+        vkCmdPipelineBarrier(command_buffer.GetHandle(),
+                             batch.src_stages ? batch.src_stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+                             batch.dst_stages ? batch.dst_stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT),
+                             0,
+                             0, nullptr,
+                             static_cast<uint32_t>(buffer_barrier_scratch.size()), buffer_barrier_scratch.data(),
+                             static_cast<uint32_t>(image_barrier_scratch.size()), image_barrier_scratch.data());
+    }
+
+    RenderGraph::PassRenderTarget &RenderGraph::request_render_target(const CompiledPass &compiled_pass)
+    {
+        auto &pass = passes[compiled_pass.pass];
+
+        render_target_key.clear();
+        render_target_key.write(compiled_pass.pass);
+        for (auto &attachment : pass.attachments)
+        {
+            render_target_key.write(get_image_view({attachment.image}).GetHandle());
+        }
+
+        auto it = render_targets.find(render_target_key);
+        if (it != render_targets.end())
+        {
+            return it->second;
+        }
+
+        std::vector<ImageView> views;
+        std::vector<uint32_t> output_attachments;
+        for (uint32_t a = 0; a < pass.attachments.size(); a++)
+        {
+            views.emplace_back(const_cast<Image &>(get_image(pass.attachments[a].image)), VK_IMAGE_VIEW_TYPE_2D);
+
+            bool is_depth = pass.has_depth_attachment && a + 1 == pass.attachments.size();
+            if (!is_depth)
+            {
+                output_attachments.push_back(a);
+            }
+        }
+
+        auto render_target = std::make_unique<RenderTarget>(std::move(views));
+        render_target->set_output_attachments(output_attachments);
+
+        for (uint32_t a = 0; a < pass.attachments.size(); a++)
+        {
+            bool is_depth = pass.has_depth_attachment && a + 1 == pass.attachments.size();
+            render_target->set_layout(a, is_depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        }
+
+        auto framebuffer = std::make_unique<Framebuffer>(device, *render_target, *compiled_pass.render_pass);
+
+        return render_targets.emplace(render_target_key, PassRenderTarget{std::move(render_target), std::move(framebuffer)}).first->second;
+    }
+
+    const Image &RenderGraph::get_image(uint32_t image) const
+    {
+        return get_image_view({image}).get_image();
+    }
+
+    const ImageView &RenderGraph::get_image_view(RenderGraphImage image) const
+    {
+        if (image.index >= images.size())
+        {
+            throw std::runtime_error("Invalid render graph image");
+        }
+
+        if (images[image.index].imported_view)
+        {
+            return *images[image.index].imported_view;
+        }
+
+        if (image.index >= transient_images.size() || !transient_images[image.index].view)
+        {
+            throw std::runtime_error("Render graph image " + images[image.index].name + " is not used by any pass");
+        }
+
+        return *transient_images[image.index].view;
+    }
+
+    const Buffer &RenderGraph::get_buffer(RenderGraphBuffer buffer) const
+    {
+        if (buffer.index >= buffers.size())
+        {
+            throw std::runtime_error("Invalid render graph buffer");
+        }
+
+        if (buffers[buffer.index].imported_buffer)
+        {
+            return *buffers[buffer.index].imported_buffer;
+        }
+
+        if (buffer.index >= transient_buffers.size() || !transient_buffers[buffer.index])
+        {
+            throw std::runtime_error("Render graph buffer " + buffers[buffer.index].name + " is not used by any pass");
+        }
+
+        return *transient_buffers[buffer.index];
+    }
+
+    const RenderGraph::Stats &RenderGraph::get_stats() const
+    {
+        return stats;
+    }
+
+    void RenderGraph::set_gpu_profiler(GpuProfiler *profiler)
+    {
+        gpu_profiler = profiler;
+    }
+} // namespace vkb
@@ -16,9 +16,13 @@
  */
 
 #include "Framework/Rendering/RenderPipeline.hpp"
+
+#include <algorithm>
+
 #include "Framework/Rendering/RenderTarget.hpp"
 #include "Framework/Core/CommandBuffer.hpp"
 #include "Framework/Core/Debug.hpp"
+#include "Framework/Rendering/ParallelCommandRecorder.hpp"
 #include "Framework/Rendering/Subpass.hpp"
 
 namespace vkb
@@ -81,11 +85,23 @@ namespace vkb
         clear_value = cv;
     }
 
+    void RenderPipeline::set_command_recorder(ParallelCommandRecorder* command_recorder_)
+    {
+        command_recorder = command_recorder_;
+    }
+
     void RenderPipeline::draw(vkb::CommandBuffer& command_buffer, RenderTarget& render_target,
                               VkSubpassContents contents)
     {
         assert(!subpasses.empty() && "Render pipeline should contain at least one sub-pass");
 
+        // Callers asking for secondary contents record the subpasses themselves
+        bool parallel = command_recorder && contents == VK_SUBPASS_CONTENTS_INLINE;
+        if (parallel)
+        {
+            contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+        }
+
         // Pad clear values if they're less than render target attachments
         while (clear_value.size() < render_target.get_attachments().size())
         {
@@ -106,21 +122,64 @@ namespace vkb
             }
             else
             {
-                command_buffer.next_subpass();
+                command_buffer.next_subpass(contents);
             }
 
             if (subpass->get_debug_name().empty())
             {
                 subpass->set_debug_name(fmt::format("RP subpass #{}", i));
             }
-            ScopedDebugLabel subpass_debug_label{command_buffer, subpass->get_debug_name().c_str()};
 
-            subpass->draw(command_buffer);
+            if (parallel)
+            {
+                draw_parallel(command_buffer, render_target, *subpass);
+            }
+            else
+            {
+                ScopedDebugLabel subpass_debug_label{command_buffer, subpass->get_debug_name().c_str()};
+
+                subpass->draw(command_buffer);
+            }
         }
 
         active_subpass_index = 0;
     }
 
+    void RenderPipeline::draw_parallel(vkb::CommandBuffer& command_buffer, RenderTarget& render_target, Subpass& subpass)
+    {
+        const auto& extent = render_target.get_extent();
+
+        VkViewport viewport{};
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+
+        VkRect2D scissor{};
+        scissor.extent = extent;
+
+        uint32_t draw_count = subpass.get_draw_count();
+
+        command_recorder->record(command_buffer, std::max(draw_count, 1u),
+                                 [&](vkb::CommandBuffer& secondary, uint32_t first_draw, uint32_t chunk_draw_count)
+                                 {
+                                     // Dynamic state is not inherited from the primary
+                                     secondary.set_viewport(0, {viewport});
+                                     secondary.set_scissor(0, {scissor});
+
+                                     ScopedDebugLabel subpass_debug_label{secondary, subpass.get_debug_name().c_str()};
+
+                                     if (draw_count == 0)
+                                     {
+                                         subpass.draw(secondary);
+                                     }
+                                     else
+                                     {
+                                         subpass.draw_range(secondary, first_draw, chunk_draw_count);
+                                     }
+                                 });
+    }
+
     std::unique_ptr<vkb::Subpass>& RenderPipeline::get_active_subpass()
     {
         return subpasses[active_subpass_index];
@@ -1,6 +1,8 @@
 #include "Framework/Rendering/Subpass.hpp"
 #include "Framework/Rendering/RenderTarget.hpp"
 
+#include <stdexcept>
+
 namespace vkb
 {
 
@@ -11,6 +13,16 @@ namespace vkb
     {
     }
 
+    uint32_t Subpass::get_draw_count() const
+    {
+        return 0;
+    }
+
+    void Subpass::draw_range(vkb::CommandBuffer & /*command_buffer*/, uint32_t /*first_draw*/, uint32_t /*draw_count*/)
+    {
+        throw std::runtime_error("Subpass " + debug_name + " does not split its draws");
+    }
+
     const std::vector<uint32_t> &Subpass::get_input_attachments() const
     {
         return input_attachments;
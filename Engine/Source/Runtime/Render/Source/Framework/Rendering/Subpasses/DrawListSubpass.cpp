@@ -0,0 +1,224 @@
+#include "Framework/Rendering/Subpasses/DrawListSubpass.hpp"
+
+#include <limits>
+
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/CommandPool.hpp"
+#include "Framework/Core/PipelineLayout.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Misc/ResourceCache.hpp"
+#include "Logging/Logger.hpp"
+#include "Memory/FrameAllocator.hpp"
+#include "Misc/Paths.hpp"
+#include "Profiler/Profiler.hpp"
+
+namespace vkb
+{
+    DrawListSubpass::DrawListSubpass(vkb::RenderContext &render_context) :
+        Subpass{render_context,
+                ShaderSource{Paths::GetShaderFullPath("Default/BlinnPhong/BlinnPhong.vert.spv")},
+                ShaderSource{Paths::GetShaderFullPath("Default/BlinnPhong/BlinnPhong.frag.spv")}}
+    {
+    }
+
+    void DrawListSubpass::set_bindless_textures(bool enabled)
+    {
+        bindless_textures = enabled;
+    }
+
+    void DrawListSubpass::prepare()
+    {
+        auto &resource_cache = get_render_context().get_device().get_resource_cache();
+
+        if (bindless_textures && !resource_cache.get_bindless_table())
+        {
+            LOGW("No bindless descriptor table, the scene is drawn without textures");
+            bindless_textures = false;
+        }
+
+        ShaderVariant variant;
+        if (bindless_textures)
+        {
+            variant.add_define("BINDLESS_TEXTURES");
+        }
+
+        auto &vertex_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+        auto &fragment_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+
+        pipeline_layout = &resource_cache.request_pipeline_layout({&vertex_module, &fragment_module});
+
+        vertex_input_state.bindings = {{0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX}};
+        vertex_input_state.attributes = {
+            {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)},
+            {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
+            {2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)}};
+
+        prepared = true;
+
+        mesh_layouts.resize(meshes.size());
+        for (uint32_t mesh = 0; mesh < meshes.size(); mesh++)
+        {
+            prepare_mesh(mesh);
+        }
+    }
+
+    void DrawListSubpass::prepare_mesh(uint32_t mesh)
+    {
+        auto variant = meshes[mesh].shader_variant;
+        if (variant.get_processes().empty())
+        {
+            mesh_layouts[mesh] = pipeline_layout;
+            return;
+        }
+
+        // The variant is compiled from BlinnPhong.vert next to the .spv, with the decode of its formats
+        auto &resource_cache = get_render_context().get_device().get_resource_cache();
+
+        ShaderVariant fragment_variant;
+        if (bindless_textures)
+        {
+            variant.add_define("BINDLESS_TEXTURES");
+            fragment_variant.add_define("BINDLESS_TEXTURES");
+        }
+
+        auto &vertex_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+        auto &fragment_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), fragment_variant);
+
+        mesh_layouts[mesh] = &resource_cache.request_pipeline_layout({&vertex_module, &fragment_module});
+    }
+
+    void DrawListSubpass::draw(vkb::CommandBuffer &command_buffer)
+    {
+        draw_range(command_buffer, 0, get_draw_count());
+    }
+
+    uint32_t DrawListSubpass::get_draw_count() const
+    {
+        return static_cast<uint32_t>(draw_items.size());
+    }
+
+    void DrawListSubpass::draw_range(vkb::CommandBuffer &command_buffer, uint32_t first_draw, uint32_t draw_count)
+    {
+        if (draw_count == 0)
+        {
+            return;
+        }
+
+        PROFILE_COUNT("Draw calls", draw_count);
+
+        // Uniforms come from the buffer pools of the recording thread
+        auto &command_pool = command_buffer.get_command_pool();
+        auto *render_frame = command_pool.get_render_frame();
+        size_t thread_index = command_pool.get_thread_index();
+
+        auto scene_buffer = render_frame->allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(SceneUniform), thread_index);
+        scene_buffer.update(scene);
+
+        auto light_buffer = render_frame->allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(LightUniform), thread_index);
+        light_buffer.update(light);
+
+        command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+
+        command_buffer.bind_buffer(scene_buffer.get_buffer(), scene_buffer.get_offset(), scene_buffer.get_size(), 0, 0, 0);
+        command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 1, 0, 0);
+
+        // Materials used by the chunk are uploaded once per chunk
+        std::pmr::vector<BufferAllocation> material_buffers(materials.size(), FrameAllocator::GetResource());
+
+        uint32_t bound_mesh = std::numeric_limits<uint32_t>::max();
+        uint32_t bound_material = std::numeric_limits<uint32_t>::max();
+        const PipelineLayout *bound_layout = nullptr;
+        const VertexInputState *bound_vertex_input = nullptr;
+
+        for (uint32_t i = first_draw; i < first_draw + draw_count; i++)
+        {
+            const auto &item = draw_items[i];
+
+            if (item.material != bound_material)
+            {
+                auto &material_buffer = material_buffers[item.material];
+                if (material_buffer.empty())
+                {
+                    material_buffer = render_frame->allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(MaterialUniform), thread_index);
+                    material_buffer.update(materials[item.material]);
+                }
+
+                command_buffer.bind_buffer(material_buffer.get_buffer(), material_buffer.get_offset(), material_buffer.get_size(), 2, 0, 0);
+                bound_material = item.material;
+            }
+
+            const auto &mesh = meshes[item.mesh];
+            if (item.mesh != bound_mesh)
+            {
+                // The bindings survive a layout change with the same set layouts, so they are set once per chunk
+                auto *layout = mesh_layouts[item.mesh];
+                if (layout != bound_layout)
+                {
+                    command_buffer.bind_pipeline_layout(*layout);
+                    bound_layout = layout;
+                }
+
+                const auto *mesh_vertex_input = mesh.vertex_input_state.bindings.empty() ? &vertex_input_state : &mesh.vertex_input_state;
+                if (mesh_vertex_input != bound_vertex_input)
+                {
+                    command_buffer.set_vertex_input_state(*mesh_vertex_input);
+                    bound_vertex_input = mesh_vertex_input;
+                }
+
+                command_buffer.bind_vertex_buffers(0, *mesh.vertex_buffer, 0);
+                for (uint32_t binding = 0; binding < mesh.extra_vertex_buffers.size(); binding++)
+                {
+                    command_buffer.bind_vertex_buffers(binding + 1, *mesh.extra_vertex_buffers[binding], 0);
+                }
+                command_buffer.bind_index_buffer(*mesh.index_buffer, 0, mesh.index_type);
+                bound_mesh = item.mesh;
+            }
+
+            const auto &textures = material_textures[item.material];
+            command_buffer.push_constants(DrawPushConstants{item.model, glm::vec4{mesh.position_offset, 0.0f}, glm::vec4{mesh.position_scale, 0.0f},
+                                                            textures.base_color, textures.sampler, {}});
+            command_buffer.draw_indexed(mesh.index_count, 1, 0, 0, 0);
+        }
+    }
+
+    uint32_t DrawListSubpass::add_mesh(const Mesh &mesh)
+    {
+        meshes.push_back(mesh);
+        auto index = static_cast<uint32_t>(meshes.size() - 1);
+
+        if (prepared)
+        {
+            mesh_layouts.resize(meshes.size());
+            prepare_mesh(index);
+        }
+
+        return index;
+    }
+
+    uint32_t DrawListSubpass::add_material(const MaterialUniform &material)
+    {
+        materials.push_back(material);
+        material_textures.emplace_back();
+        return static_cast<uint32_t>(materials.size() - 1);
+    }
+
+    void DrawListSubpass::set_material_textures(uint32_t material, const MaterialTextures &textures)
+    {
+        material_textures[material] = textures;
+    }
+
+    void DrawListSubpass::set_scene(const SceneUniform &scene_)
+    {
+        scene = scene_;
+    }
+
+    void DrawListSubpass::set_light(const LightUniform &light_)
+    {
+        light = light_;
+    }
+
+    std::vector<DrawListSubpass::DrawItem> &DrawListSubpass::get_draw_items()
+    {
+        return draw_items;
+    }
+} // namespace vkb
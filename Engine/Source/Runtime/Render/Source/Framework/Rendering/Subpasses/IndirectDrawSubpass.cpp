@@ -0,0 +1,544 @@
+#include "Framework/Rendering/Subpasses/IndirectDrawSubpass.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Framework/Core/CommandBuffer.hpp"
+#include "Framework/Core/CommandPool.hpp"
+#include "Framework/Core/PhysicalDevice.hpp"
+#include "Framework/Core/PipelineLayout.hpp"
+#include "Framework/Core/VulkanDevice.hpp"
+#include "Framework/Misc/MeshArena.hpp"
+#include "Framework/Misc/ResourceCache.hpp"
+#include "Framework/Rendering/RenderContext.hpp"
+#include "Misc/Paths.hpp"
+
+namespace vkb
+{
+    namespace
+    {
+        /// Push constants of DepthPyramid.comp
+        struct PyramidPushConstants
+        {
+            glm::uvec2 source_size;
+            glm::uvec2 destination_size;
+        };
+
+        constexpr uint32_t cull_group_size = 64;
+
+        constexpr uint32_t pyramid_group_size = 8;
+
+        /// The GPU and the CPU may round spheres touching a frustum plane differently
+        bool is_on_frustum_boundary(const CullUniform &uniform, const glm::vec4 &sphere)
+        {
+            float epsilon = 1e-3f * std::max(1.0f, sphere.w);
+
+            for (auto &plane : uniform.frustum_planes)
+            {
+                if (std::abs(glm::dot(glm::vec3{plane}, glm::vec3{sphere}) + plane.w + sphere.w) < epsilon)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    } // namespace
+
+    bool IndirectDrawSubpass::request_features(PhysicalDevice &gpu)
+    {
+        const auto &features = gpu.get_features();
+        if (!features.multiDrawIndirect || !features.drawIndirectFirstInstance)
+        {
+            return false;
+        }
+
+        auto &requested_features = gpu.get_mutable_requested_features();
+        requested_features.multiDrawIndirect = VK_TRUE;
+        requested_features.drawIndirectFirstInstance = VK_TRUE;
+
+        return true;
+    }
+
+    IndirectDrawSubpass::IndirectDrawSubpass(vkb::RenderContext &render_context, MeshArena &mesh_arena) :
+        Subpass{render_context,
+                ShaderSource{Paths::GetShaderFullPath("Default/GpuDriven/IndirectDraw.vert.spv")},
+                ShaderSource{Paths::GetShaderFullPath("Default/GpuDriven/IndirectDraw.frag.spv")}},
+        mesh_arena{mesh_arena}
+    {
+    }
+
+    void IndirectDrawSubpass::prepare()
+    {
+        auto &device = get_render_context().get_device();
+        auto &resource_cache = device.get_resource_cache();
+
+        auto &vertex_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+        auto &fragment_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader());
+        pipeline_layout = &resource_cache.request_pipeline_layout({&vertex_module, &fragment_module});
+
+        auto &cull_module = resource_cache.request_shader_module(
+            VK_SHADER_STAGE_COMPUTE_BIT, ShaderSource{Paths::GetShaderFullPath("Default/GpuDriven/Cull.comp.spv")});
+        cull_layout = &resource_cache.request_pipeline_layout({&cull_module});
+
+        auto &pyramid_module = resource_cache.request_shader_module(
+            VK_SHADER_STAGE_COMPUTE_BIT, ShaderSource{Paths::GetShaderFullPath("Default/GpuDriven/DepthPyramid.comp.spv")});
+        pyramid_layout = &resource_cache.request_pipeline_layout({&pyramid_module});
+
+        draw_indirect_count = device.is_enabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+        count_buffer = std::make_unique<Buffer>(device, sizeof(uint32_t),
+                                                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                VMA_MEMORY_USAGE_GPU_ONLY, 0);
+        count_buffer->SetDebugName("Indirect draw count");
+
+        // The pyramid is read with texelFetch, the sampler only completes the descriptor
+        VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        sampler_info.magFilter = VK_FILTER_NEAREST;
+        sampler_info.minFilter = VK_FILTER_NEAREST;
+        sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+        pyramid_sampler = std::make_unique<Sampler>(device, sampler_info);
+
+        create_depth_pyramid({2, 2, 1});
+    }
+
+    void IndirectDrawSubpass::cull(vkb::CommandBuffer &command_buffer)
+    {
+        auto instance_count = static_cast<uint32_t>(instances.size());
+        if (instance_count == 0)
+        {
+            return;
+        }
+
+        prepare_draw_buffer(instance_count);
+
+        CullReadback *readback = nullptr;
+        if (cull_validation)
+        {
+            auto &render_context = get_render_context();
+            cull_readbacks.resize(render_context.get_render_frames().size());
+            readback = &cull_readbacks[render_context.get_active_frame_index()];
+
+            // begin_frame() waited for the last submission of this frame, its copy has completed
+            if (readback->pending)
+            {
+                validate_cull(*readback);
+                readback->pending = false;
+            }
+        }
+
+        auto &command_pool = command_buffer.get_command_pool();
+        auto *render_frame = command_pool.get_render_frame();
+        size_t thread_index = command_pool.get_thread_index();
+
+        instance_buffer = render_frame->allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(GpuInstance) * instances.size(), thread_index);
+        std::memcpy(instance_buffer.get_data(), instances.data(), sizeof(GpuInstance) * instances.size());
+
+        CullUniform cull_uniform;
+        cull_uniform.view_projection = scene.projection * scene.view;
+        cull_uniform.previous_view_projection = pyramid_view_projection;
+        auto planes = extract_frustum_planes(cull_uniform.view_projection);
+        std::copy(planes.begin(), planes.end(), cull_uniform.frustum_planes);
+        const auto &pyramid_extent = depth_pyramid->get_extent();
+        cull_uniform.pyramid_size = glm::vec2{pyramid_extent.width, pyramid_extent.height};
+        cull_uniform.pyramid_levels = static_cast<uint32_t>(pyramid_level_views.size());
+        cull_uniform.instance_count = instance_count;
+        cull_uniform.occlusion_enabled = occlusion_culling && pyramid_valid ? 1 : 0;
+
+        auto cull_buffer = render_frame->allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(CullUniform), thread_index);
+        cull_buffer.update(cull_uniform);
+
+        if (!pyramid_ready)
+        {
+            ImageMemoryBarrier barrier;
+            barrier.src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            barrier.dst_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            command_buffer.image_memory_barrier(*pyramid_view, barrier);
+            pyramid_ready = true;
+        }
+
+        // The previous frame may still read the draws, or copy them back for the validation
+        VkDeviceSize draw_size = sizeof(VkDrawIndexedIndirectCommand) * instance_count;
+        VkPipelineStageFlags read_stages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+        command_buffer.buffer_memory_barrier(*count_buffer, 0, VK_WHOLE_SIZE,
+                                             {read_stages, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                              VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT});
+        command_buffer.fill_buffer(*count_buffer, 0, VK_WHOLE_SIZE, 0);
+
+        // Without a GPU count every instance is drawn, culled ones with zero indices
+        if (!draw_indirect_count)
+        {
+            command_buffer.buffer_memory_barrier(*draw_buffer, 0, draw_size,
+                                                 {read_stages, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                  VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT});
+            command_buffer.fill_buffer(*draw_buffer, 0, draw_size, 0);
+        }
+
+        command_buffer.buffer_memory_barrier(*count_buffer, 0, VK_WHOLE_SIZE,
+                                             {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                              VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT});
+        command_buffer.buffer_memory_barrier(*draw_buffer, 0, draw_size,
+                                             {draw_indirect_count ? read_stages : VkPipelineStageFlags{VK_PIPELINE_STAGE_TRANSFER_BIT},
+                                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                              draw_indirect_count ? VkAccessFlags{VK_ACCESS_INDIRECT_COMMAND_READ_BIT} : VkAccessFlags{VK_ACCESS_TRANSFER_WRITE_BIT},
+                                              VK_ACCESS_SHADER_WRITE_BIT});
+
+        const auto &mesh_buffer = mesh_arena.get_mesh_buffer();
+
+        command_buffer.bind_pipeline_layout(*cull_layout);
+        command_buffer.bind_buffer(cull_buffer.get_buffer(), cull_buffer.get_offset(), cull_buffer.get_size(), 0, 0, 0);
+        command_buffer.bind_buffer(mesh_buffer, 0, mesh_buffer.get_size(), 0, 1, 0);
+        command_buffer.bind_buffer(instance_buffer.get_buffer(), instance_buffer.get_offset(), instance_buffer.get_size(), 0, 2, 0);
+        command_buffer.bind_buffer(*draw_buffer, 0, draw_size, 0, 3, 0);
+        command_buffer.bind_buffer(*count_buffer, 0, count_buffer->get_size(), 0, 4, 0);
+        command_buffer.bind_image(*pyramid_view, *pyramid_sampler, 0, 5, 0);
+        command_buffer.dispatch((instance_count + cull_group_size - 1) / cull_group_size, 1, 1);
+
+        if (readback)
+        {
+            // The slot is only reused once its frame has completed
+            if (readback->capacity < instance_count)
+            {
+                BufferBuilder builder{sizeof(uint32_t) + sizeof(VkDrawIndexedIndirectCommand) * instance_count};
+                builder.with_vma_flags(VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT)
+                       .with_vma_required_flags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+                       .with_usage(VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                       .with_vma_usage(VMA_MEMORY_USAGE_AUTO);
+                readback->buffer = std::make_unique<Buffer>(get_render_context().get_device(), builder);
+                readback->buffer->SetDebugName("Indirect draw readback");
+                readback->capacity = instance_count;
+            }
+
+            command_buffer.buffer_memory_barrier(*draw_buffer, 0, draw_size,
+                                                 {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                  VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT});
+            command_buffer.buffer_memory_barrier(*count_buffer, 0, VK_WHOLE_SIZE,
+                                                 {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                  VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT});
+
+            // The count first, then the draws
+            VkBufferCopy count_copy{0, 0, sizeof(uint32_t)};
+            vkCmdCopyBuffer(command_buffer.GetHandle(), count_buffer->GetHandle(), readback->buffer->GetHandle(), 1, &count_copy);
+            VkBufferCopy draw_copy{0, sizeof(uint32_t), draw_size};
+            vkCmdCopyBuffer(command_buffer.GetHandle(), draw_buffer->GetHandle(), readback->buffer->GetHandle(), 1, &draw_copy);
+
+            // The host reads the copy after the fence of the frame
+            command_buffer.buffer_memory_barrier(*readback->buffer, 0, VK_WHOLE_SIZE,
+                                                 {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                                                  VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT});
+
+            readback->uniform = cull_uniform;
+            readback->instances = instances;
+            readback->pending = true;
+        }
+
+        command_buffer.buffer_memory_barrier(*draw_buffer, 0, draw_size,
+                                             {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                                              VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT});
+        command_buffer.buffer_memory_barrier(*count_buffer, 0, VK_WHOLE_SIZE,
+                                             {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                                              VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT});
+    }
+
+    void IndirectDrawSubpass::draw(vkb::CommandBuffer &command_buffer)
+    {
+        auto instance_count = static_cast<uint32_t>(instances.size());
+        if (instance_count == 0 || instance_buffer.empty())
+        {
+            return;
+        }
+
+        auto &command_pool = command_buffer.get_command_pool();
+        auto *render_frame = command_pool.get_render_frame();
+        size_t thread_index = command_pool.get_thread_index();
+
+        auto scene_buffer = render_frame->allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(DrawListSubpass::SceneUniform), thread_index);
+        scene_buffer.update(scene);
+
+        auto light_buffer = render_frame->allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(DrawListSubpass::LightUniform), thread_index);
+        light_buffer.update(light);
+
+        // One storage buffer holds every material, the vertex shader forwards the index of the instance
+        auto material_buffer = render_frame->allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                             sizeof(DrawListSubpass::MaterialUniform) * std::max<size_t>(materials.size(), 1), thread_index);
+        if (!materials.empty())
+        {
+            std::memcpy(material_buffer.get_data(), materials.data(), sizeof(DrawListSubpass::MaterialUniform) * materials.size());
+        }
+
+        command_buffer.bind_pipeline_layout(*pipeline_layout);
+        command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+
+        VertexInputState vertex_input_state;
+        vertex_input_state.bindings = {{0, mesh_arena.get_vertex_stride(), VK_VERTEX_INPUT_RATE_VERTEX}};
+        vertex_input_state.attributes = {
+            {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(DrawListSubpass::Vertex, position)},
+            {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(DrawListSubpass::Vertex, normal)},
+            {2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(DrawListSubpass::Vertex, uv)}};
+        command_buffer.set_vertex_input_state(vertex_input_state);
+
+        command_buffer.bind_buffer(scene_buffer.get_buffer(), scene_buffer.get_offset(), scene_buffer.get_size(), 0, 0, 0);
+        command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 1, 0, 0);
+        command_buffer.bind_buffer(material_buffer.get_buffer(), material_buffer.get_offset(), material_buffer.get_size(), 2, 0, 0);
+        command_buffer.bind_buffer(instance_buffer.get_buffer(), instance_buffer.get_offset(), instance_buffer.get_size(), 2, 1, 0);
+
+        command_buffer.bind_vertex_buffers(0, mesh_arena.get_vertex_buffer(), 0);
+        command_buffer.bind_index_buffer(mesh_arena.get_index_buffer(), 0, VK_INDEX_TYPE_UINT32);
+
+        if (draw_indirect_count)
+        {
+            command_buffer.draw_indexed_indirect_count(*draw_buffer, 0, *count_buffer, 0, instance_count, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else
+        {
+            command_buffer.draw_indexed_indirect(*draw_buffer, 0, instance_count, sizeof(VkDrawIndexedIndirectCommand));
+        }
+
+        instance_buffer = {};
+    }
+
+    void IndirectDrawSubpass::build_depth_pyramid(vkb::CommandBuffer &command_buffer, const ImageView &depth)
+    {
+        const auto &depth_extent = depth.get_image().get_extent();
+        const auto &pyramid_extent = depth_pyramid->get_extent();
+
+        if (!pyramid_valid || pyramid_extent.width != std::max(1u, (depth_extent.width + 1) / 2) ||
+            pyramid_extent.height != std::max(1u, (depth_extent.height + 1) / 2))
+        {
+            get_render_context().get_device().wait_idle();
+            create_depth_pyramid(depth_extent);
+            pyramid_ready = false;
+        }
+
+        // Every level is written, the previous contents are discarded
+        ImageMemoryBarrier to_general;
+        to_general.src_stage_mask = pyramid_ready ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        to_general.dst_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        to_general.src_access_mask = 0;
+        to_general.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+        to_general.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        to_general.new_layout = VK_IMAGE_LAYOUT_GENERAL;
+        command_buffer.image_memory_barrier(*pyramid_view, to_general);
+
+        command_buffer.bind_pipeline_layout(*pyramid_layout);
+
+        glm::uvec2 source_size{depth_extent.width, depth_extent.height};
+        const ImageView *source = &depth;
+
+        for (auto &level_view : pyramid_level_views)
+        {
+            auto level = level_view.get_subresource_range().baseMipLevel;
+            glm::uvec2 destination_size{std::max(1u, pyramid_extent.width >> level), std::max(1u, pyramid_extent.height >> level)};
+
+            command_buffer.bind_image(*source, *pyramid_sampler, 0, 0, 0);
+            command_buffer.bind_image(level_view, 0, 1, 0);
+            command_buffer.push_constants(PyramidPushConstants{source_size, destination_size});
+            command_buffer.dispatch((destination_size.x + pyramid_group_size - 1) / pyramid_group_size,
+                                    (destination_size.y + pyramid_group_size - 1) / pyramid_group_size, 1);
+
+            // The level is the source of the next one and of the culling
+            ImageMemoryBarrier to_read;
+            to_read.src_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            to_read.dst_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            to_read.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+            to_read.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+            to_read.old_layout = VK_IMAGE_LAYOUT_GENERAL;
+            to_read.new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            command_buffer.image_memory_barrier(level_view, to_read);
+
+            source = &level_view;
+            source_size = destination_size;
+        }
+
+        pyramid_ready = true;
+        pyramid_valid = true;
+        pyramid_view_projection = scene.projection * scene.view;
+    }
+
+    uint32_t IndirectDrawSubpass::add_material(const DrawListSubpass::MaterialUniform &material)
+    {
+        materials.push_back(material);
+        return static_cast<uint32_t>(materials.size() - 1);
+    }
+
+    void IndirectDrawSubpass::set_scene(const DrawListSubpass::SceneUniform &scene_)
+    {
+        scene = scene_;
+    }
+
+    void IndirectDrawSubpass::set_light(const DrawListSubpass::LightUniform &light_)
+    {
+        light = light_;
+    }
+
+    void IndirectDrawSubpass::set_occlusion_culling(bool enabled)
+    {
+        occlusion_culling = enabled;
+    }
+
+    void IndirectDrawSubpass::set_cull_validation(bool enabled)
+    {
+        cull_validation = enabled;
+        if (!enabled)
+        {
+            cull_readbacks.clear();
+        }
+    }
+
+    void IndirectDrawSubpass::validate_cull(const CullReadback &readback) const
+    {
+        const uint8_t *data = readback.buffer->get_data();
+        uint32_t instance_count = readback.uniform.instance_count;
+
+        uint32_t draw_count = 0;
+        std::memcpy(&draw_count, data, sizeof(uint32_t));
+
+        if (draw_count > instance_count)
+        {
+            LOGE("Cull.comp wrote {} draws for {} instances", draw_count, instance_count);
+            return;
+        }
+
+        std::vector<VkDrawIndexedIndirectCommand> gpu_draws(draw_count);
+        std::memcpy(gpu_draws.data(), data + sizeof(uint32_t), sizeof(VkDrawIndexedIndirectCommand) * draw_count);
+
+        // The GPU appends the draws in any order, the CPU in instance order
+        std::sort(gpu_draws.begin(), gpu_draws.end(), [](const auto &a, const auto &b) { return a.firstInstance < b.firstInstance; });
+
+        CullUniform frustum_uniform = readback.uniform;
+        frustum_uniform.occlusion_enabled = 0;
+
+        const auto &meshes = mesh_arena.get_meshes();
+
+        std::vector<VkDrawIndexedIndirectCommand> cpu_draws;
+        CpuDrawCuller culler;
+        culler.cull(frustum_uniform, meshes, readback.instances, nullptr, cpu_draws);
+
+        auto sphere_of = [&](uint32_t instance) {
+            const auto &gpu_instance = readback.instances[instance];
+            return CpuDrawCuller::transform_sphere(meshes[gpu_instance.mesh].bounding_sphere, gpu_instance.model);
+        };
+
+        uint32_t malformed = 0;
+        uint32_t unexpected = 0;
+        uint32_t missing = 0;
+
+        auto cpu_it = cpu_draws.begin();
+        for (size_t i = 0; i < gpu_draws.size(); i++)
+        {
+            const auto &draw = gpu_draws[i];
+
+            if (draw.firstInstance >= instance_count || (i > 0 && gpu_draws[i - 1].firstInstance == draw.firstInstance))
+            {
+                malformed++;
+                continue;
+            }
+
+            const auto &mesh = meshes[readback.instances[draw.firstInstance].mesh];
+            if (draw.indexCount != mesh.index_count || draw.instanceCount != 1 || draw.firstIndex != mesh.first_index ||
+                draw.vertexOffset != mesh.vertex_offset)
+            {
+                malformed++;
+            }
+
+            // Instances only the CPU draws were occluded or disagree with the GPU
+            for (; cpu_it != cpu_draws.end() && cpu_it->firstInstance < draw.firstInstance; ++cpu_it)
+            {
+                if (!readback.uniform.occlusion_enabled && !is_on_frustum_boundary(frustum_uniform, sphere_of(cpu_it->firstInstance)))
+                {
+                    missing++;
+                }
+            }
+
+            if (cpu_it != cpu_draws.end() && cpu_it->firstInstance == draw.firstInstance)
+            {
+                ++cpu_it;
+            }
+            else if (!is_on_frustum_boundary(frustum_uniform, sphere_of(draw.firstInstance)))
+            {
+                unexpected++;
+            }
+        }
+
+        for (; cpu_it != cpu_draws.end(); ++cpu_it)
+        {
+            if (!readback.uniform.occlusion_enabled && !is_on_frustum_boundary(frustum_uniform, sphere_of(cpu_it->firstInstance)))
+            {
+                missing++;
+            }
+        }
+
+        if (malformed || unexpected || missing)
+        {
+            LOGE("Cull.comp drew {} of {} instances where CpuDrawCuller drew {}: {} malformed, {} outside the frustum, {} missing",
+                 draw_count, instance_count, cpu_draws.size(), malformed, unexpected, missing);
+        }
+    }
+
+    std::vector<GpuInstance> &IndirectDrawSubpass::get_instances()
+    {
+        return instances;
+    }
+
+    void IndirectDrawSubpass::prepare_draw_buffer(uint32_t instance_count)
+    {
+        if (instance_count <= draw_capacity)
+        {
+            return;
+        }
+
+        uint32_t capacity = std::max(draw_capacity, 64u);
+        while (capacity < instance_count)
+        {
+            capacity *= 2;
+        }
+
+        // The draws of frames in flight are still read
+        auto &device = get_render_context().get_device();
+        if (draw_buffer)
+        {
+            device.wait_idle();
+        }
+
+        draw_buffer = std::make_unique<Buffer>(device, sizeof(VkDrawIndexedIndirectCommand) * capacity,
+                                               VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                               VMA_MEMORY_USAGE_GPU_ONLY, 0);
+        draw_buffer->SetDebugName("Indirect draws");
+        draw_capacity = capacity;
+    }
+
+    void IndirectDrawSubpass::create_depth_pyramid(const VkExtent3D &depth_extent)
+    {
+        VkExtent3D extent{std::max(1u, (depth_extent.width + 1) / 2), std::max(1u, (depth_extent.height + 1) / 2), 1};
+
+        uint32_t level_count = 1;
+        while ((std::max(extent.width, extent.height) >> level_count) > 0)
+        {
+            level_count++;
+        }
+
+        pyramid_level_views.clear();
+        pyramid_view.reset();
+
+        auto &device = get_render_context().get_device();
+        depth_pyramid = std::make_unique<Image>(device, extent, VK_FORMAT_R32_SFLOAT,
+                                                VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                                                VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, level_count);
+        depth_pyramid->SetDebugName("Depth pyramid");
+
+        pyramid_view = std::make_unique<ImageView>(*depth_pyramid, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R32_SFLOAT, 0, 0, level_count, 1);
+
+        pyramid_level_views.reserve(level_count);
+        for (uint32_t level = 0; level < level_count; level++)
+        {
+            pyramid_level_views.emplace_back(*depth_pyramid, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R32_SFLOAT, level, 0, 1, 1);
+        }
+    }
+} // namespace vkb